@@ -51,6 +51,38 @@ public:
         return Eigen::MatrixXd(0, 0);
     }
 
+    /**
+     * @brief Add distortion to a batch of points (one point per column), in place.
+     * The default implementation loops over addDistortion, distortion models override it
+     * with a devirtualized loop.
+     */
+    virtual void addDistortions(Mat2X& pts) const
+    {
+        for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+            pts.col(i) = addDistortion(pts.col(i));
+    }
+
+    /**
+     * @brief Remove distortion from a batch of points (one point per column), in place.
+     */
+    virtual void removeDistortions(Mat2X& pts) const
+    {
+        for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+            pts.col(i) = removeDistortion(pts.col(i));
+    }
+
+    /**
+     * @brief Derivatives of addDistortion wrt the point for a batch of points.
+     * @param[in] pts the points, one per column
+     * @param[out] out_derivatives the 2x2 Jacobian of the i-th point in columns [2i, 2i+1]
+     */
+    virtual void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const
+    {
+        out_derivatives.resize(2, 2 * pts.cols());
+        for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+            out_derivatives.block<2, 2>(0, 2 * i) = getDerivativeAddDistoWrtPt(pts.col(i));
+    }
+
     virtual Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2& p) const
     {
         return Eigen::Matrix2d::Identity();
@@ -65,6 +65,18 @@ public:
         return d;
     }
 
+    void addDistortions(Mat2X& pts) const override
+    {
+        for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+            pts.col(i) = DistortionBrown::addDistortion(pts.col(i));
+    }
+
+    void removeDistortions(Mat2X& pts) const override
+    {
+        for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+            pts.col(i) = DistortionBrown::removeDistortion(pts.col(i));
+    }
+
     ~DistortionBrown() override = default;
 };
 
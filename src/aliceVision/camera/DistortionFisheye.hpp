@@ -223,6 +223,25 @@ public:
     return ret;
   }
 
+  void addDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionFisheye::addDistortion(pts.col(i));
+  }
+
+  void removeDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionFisheye::removeDistortion(pts.col(i));
+  }
+
+  void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const override
+  {
+    out_derivatives.resize(2, 2 * pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_derivatives.block<2, 2>(0, 2 * i) = DistortionFisheye::getDerivativeAddDistoWrtPt(pts.col(i));
+  }
+
   ~DistortionFisheye() override = default;
 };
 
@@ -45,6 +45,18 @@ public:
     return  p * coef;
   }
 
+  void addDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionFisheye1::addDistortion(pts.col(i));
+  }
+
+  void removeDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionFisheye1::removeDistortion(pts.col(i));
+  }
+
   ~DistortionFisheye1() override  = default;
 };
 
@@ -199,6 +199,35 @@ public:
     return r2 * Square(1.+r2*k1);
   }
 
+  /// Add distortion to a batch of points, the coefficient is read once for all the points
+  void addDistortions(Mat2X& pts) const override
+  {
+    const double k1 = _distortionParams[0];
+    double* data = pts.data();
+    const Mat2X::Index nbPts = pts.cols();
+    for(Mat2X::Index i = 0; i < nbPts; ++i)
+    {
+      const double x = data[2 * i];
+      const double y = data[2 * i + 1];
+      const double r_coeff = 1. + k1 * (x * x + y * y);
+      data[2 * i] = x * r_coeff;
+      data[2 * i + 1] = y * r_coeff;
+    }
+  }
+
+  void removeDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionRadialK1::removeDistortion(pts.col(i));
+  }
+
+  void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const override
+  {
+    out_derivatives.resize(2, 2 * pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_derivatives.block<2, 2>(0, 2 * i) = DistortionRadialK1::getDerivativeAddDistoWrtPt(pts.col(i));
+  }
+
   ~DistortionRadialK1() override = default;
 };
 
@@ -385,6 +414,38 @@ public:
     return r2 * Square(1.+r2*(k1+r2*(k2+r2*k3)));
   }
 
+  /// Add distortion to a batch of points, the coefficients are read once for all the points
+  void addDistortions(Mat2X& pts) const override
+  {
+    const double k1 = _distortionParams[0];
+    const double k2 = _distortionParams[1];
+    const double k3 = _distortionParams[2];
+    double* data = pts.data();
+    const Mat2X::Index nbPts = pts.cols();
+    for(Mat2X::Index i = 0; i < nbPts; ++i)
+    {
+      const double x = data[2 * i];
+      const double y = data[2 * i + 1];
+      const double r2 = x * x + y * y;
+      const double r_coeff = 1. + r2 * (k1 + r2 * (k2 + r2 * k3));
+      data[2 * i] = x * r_coeff;
+      data[2 * i + 1] = y * r_coeff;
+    }
+  }
+
+  void removeDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionRadialK3::removeDistortion(pts.col(i));
+  }
+
+  void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const override
+  {
+    out_derivatives.resize(2, 2 * pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_derivatives.block<2, 2>(0, 2 * i) = DistortionRadialK3::getDerivativeAddDistoWrtPt(pts.col(i));
+  }
+
   ~DistortionRadialK3() override = default;
 };
 
@@ -589,6 +650,25 @@ public:
     return r2 * Square(r_coeff);
   }
 
+  void addDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionRadialK3PT::addDistortion(pts.col(i));
+  }
+
+  void removeDistortions(Mat2X& pts) const override
+  {
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      pts.col(i) = DistortionRadialK3PT::removeDistortion(pts.col(i));
+  }
+
+  void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const override
+  {
+    out_derivatives.resize(2, 2 * pts.cols());
+    for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+      out_derivatives.block<2, 2>(0, 2 * i) = DistortionRadialK3PT::getDerivativeAddDistoWrtPt(pts.col(i));
+  }
+
   ~DistortionRadialK3PT() override = default;
 };
 
@@ -96,6 +96,33 @@ public:
     return pt_ima;
   }
 
+  void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const override
+  {
+    const double rsensor = std::min(sensorWidth(), sensorHeight());
+    const double rscale = sensorWidth() / std::max(w(), h());
+    const double fmm = _scale(0) * rscale;
+    const double fov = rsensor / fmm;
+
+    const Mat3X X = pose(pts3D);
+    out_pts2D.resize(2, X.cols());
+
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      const double angle_Z = std::atan2(sqrt(X(0, i) * X(0, i) + X(1, i) * X(1, i)), X(2, i));
+      const double angle_radial = std::atan2(X(1, i), X(0, i));
+      const double radius = angle_Z / (0.5 * fov);
+
+      out_pts2D(0, i) = cos(angle_radial) * radius;
+      out_pts2D(1, i) = sin(angle_radial) * radius;
+    }
+
+    if(applyDistortion && _pDistortion != nullptr)
+    {
+      _pDistortion->addDistortions(out_pts2D);
+    }
+    cam2imaPoints(out_pts2D);
+  }
+
   Eigen::Matrix<double, 2, 9> getDerivativeProjectWrtRotation(const geometry::Pose3& pose, const Vec3 & pt) 
   {
     const Vec3 X = pose(pt);
@@ -401,6 +428,18 @@ public:
     return (p - _offset) / _circleRadius;
   }
 
+  void cam2imaPoints(Mat2X& pts) const override
+  {
+    pts *= _circleRadius;
+    pts.colwise() += _offset;
+  }
+
+  void ima2camPoints(Mat2X& pts) const override
+  {
+    pts.colwise() -= _offset;
+    pts /= _circleRadius;
+  }
+
   Eigen::Matrix2d getDerivativeIma2CamWrtPoint() const override
   {
     return Eigen::Matrix2d::Identity() * (1.0 / _circleRadius);
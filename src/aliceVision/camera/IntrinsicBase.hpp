@@ -191,13 +191,51 @@ public:
   inline Mat2X residuals(const geometry::Pose3& pose, const Mat3X& X, const Mat2X& x) const
   {
     assert(X.cols() == x.cols());
-    const std::size_t numPts = x.cols();
-    Mat2X residuals = Mat2X::Zero(2, numPts);
-    for(std::size_t i = 0; i < numPts; ++i)
-    {
-      residuals.col(i) = residual(pose, X.col(i), x.col(i));
-    }
-    return residuals;
+    Mat2X proj;
+    projectPoints(pose, X, proj);
+    return x - proj;
+  }
+
+  /**
+   * @brief Projection of a batch of 3D points seen by the same pose (one point per column)
+   * The default implementation loops over project, camera models override it to apply
+   * the pose and the intrinsics on the whole batch without a virtual call per point.
+   * @param[in] pose The pose
+   * @param[in] pts3D The 3d points
+   * @param[out] out_pts2D The 2d projections in the camera plane
+   * @param[in] applyDistortion If true apply distortion if any
+   */
+  virtual void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const
+  {
+    out_pts2D.resize(2, pts3D.cols());
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      out_pts2D.col(i) = project(pose, pts3D.col(i), applyDistortion);
+  }
+
+  /**
+   * @brief Derivatives of the projection wrt the pose for a batch of 3D points
+   * @param[in] pose The pose
+   * @param[in] pts3D The 3d points
+   * @param[out] out_derivatives the 2x16 Jacobian of the i-th point in columns [16i, 16i+15]
+   */
+  virtual void getDerivativesProjectWrtPose(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_derivatives) const
+  {
+    out_derivatives.resize(2, 16 * pts3D.cols());
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      out_derivatives.block<2, 16>(0, 16 * i) = getDerivativeProjectWrtPose(pose, pts3D.col(i));
+  }
+
+  /**
+   * @brief Derivatives of the projection wrt the point for a batch of 3D points
+   * @param[in] pose The pose
+   * @param[in] pts3D The 3d points
+   * @param[out] out_derivatives the 2x3 Jacobian of the i-th point in columns [3i, 3i+2]
+   */
+  virtual void getDerivativesProjectWrtPoint(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_derivatives) const
+  {
+    out_derivatives.resize(2, 3 * pts3D.cols());
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      out_derivatives.block<2, 3>(0, 3 * i) = getDerivativeProjectWrtPoint(pose, pts3D.col(i));
   }
 
   /**
@@ -354,6 +392,18 @@ public:
    */
   virtual Vec2 get_ud_pixel(const Vec2& p) const = 0;
 
+  /**
+   * @brief Return the un-distorted pixels of a batch of pixels (one pixel per column)
+   * @param[in] pixels the distorted pixels
+   * @param[out] out_pixels the un-distorted pixels
+   */
+  virtual void get_ud_pixels(const Mat2X& pixels, Mat2X& out_pixels) const
+  {
+    out_pixels.resize(2, pixels.cols());
+    for(Mat2X::Index i = 0; i < pixels.cols(); ++i)
+      out_pixels.col(i) = get_ud_pixel(pixels.col(i));
+  }
+
   /**
    * @brief Return the distorted pixel (with added distortion)
    * @param[in] p The undistorted point
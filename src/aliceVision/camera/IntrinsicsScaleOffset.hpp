@@ -76,6 +76,20 @@ public:
     return (p - _offset) / _scale(0);
   }
 
+  // Transform a batch of points from the camera plane to the image plane, in place
+  virtual void cam2imaPoints(Mat2X& pts) const
+  {
+    pts.array().colwise() *= _scale.array();
+    pts.colwise() += _offset;
+  }
+
+  // Transform a batch of points from the image plane to the camera plane, in place
+  virtual void ima2camPoints(Mat2X& pts) const
+  {
+    pts.colwise() -= _offset;
+    pts /= _scale(0);
+  }
+
   virtual Eigen::Matrix<double, 2, 1> getDerivativeIma2CamWrtScale(const Vec2& p) const
   {
       return -(p - _offset) / (_scale(0) * _scale(0));
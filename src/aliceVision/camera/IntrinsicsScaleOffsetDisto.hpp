@@ -62,6 +62,18 @@ public:
     return cam2ima(removeDistortion(ima2cam(p)));
   }
 
+  /// Return the un-distorted pixels of a batch of pixels, with a single call to the distortion model
+  void get_ud_pixels(const Mat2X& pixels, Mat2X& out_pixels) const override
+  {
+    out_pixels = pixels;
+    ima2camPoints(out_pixels);
+    if(_pDistortion != nullptr)
+    {
+      _pDistortion->removeDistortions(out_pixels);
+    }
+    cam2imaPoints(out_pixels);
+  }
+
   /// Return the distorted pixel (with added distortion)
   Vec2 get_d_pixel(const Vec2& p) const override
   {
@@ -157,6 +169,19 @@ public:
     return this->_pDistortion->getDerivativeAddDistoWrtPt(pt);
   }
 
+  /// Derivatives of addDistortion wrt the point for a batch of points, the i-th 2x2 Jacobian is in columns [2i, 2i+1]
+  void getDerivativesAddDistoWrtPt(const Mat2X& pts, Mat2X& out_derivatives) const
+  {
+    if (this->_pDistortion == nullptr)
+    {
+      out_derivatives.resize(2, 2 * pts.cols());
+      for(Mat2X::Index i = 0; i < pts.cols(); ++i)
+        out_derivatives.block<2, 2>(0, 2 * i).setIdentity();
+      return;
+    }
+    this->_pDistortion->getDerivativesAddDistoWrtPt(pts, out_derivatives);
+  }
+
   Eigen::Matrix<double, 2, 2> getDerivativeRemoveDistoWrtPt(const Vec2 & pt) const
   {
     if (this->_pDistortion == nullptr)
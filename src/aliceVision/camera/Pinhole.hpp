@@ -93,12 +93,24 @@ public:
     const Vec3 X = pose(pt); // apply pose
     const Vec2 P = X.head<2>() / X(2);
 
-    const Vec2 distorted = this->addDistortion(P);
+    const Vec2 distorted = applyDistortion ? this->addDistortion(P) : P;
     const Vec2 impt = this->cam2ima(distorted);
 
     return impt;
   }
 
+  void projectPoints(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_pts2D, bool applyDistortion = true) const override
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    out_pts2D = X.topRows<2>().array().rowwise() / X.row(2).array();
+
+    if(applyDistortion && _pDistortion != nullptr)
+    {
+      _pDistortion->addDistortions(out_pts2D);
+    }
+    cam2imaPoints(out_pts2D);
+  }
+
   Eigen::Matrix<double, 2, 9> getDerivativeProjectWrtRotation(const geometry::Pose3& pose, const Vec3 & pt)
   {
     const Vec3 X = pose(pt); // apply pose
@@ -160,6 +172,57 @@ public:
     return getDerivativeCam2ImaWrtPoint() * getDerivativeAddDistoWrtPt(P) * d_P_d_X * d_X_d_P;
   }
 
+  void getDerivativesProjectWrtPose(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_derivatives) const override
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    const Mat2X P = X.topRows<2>().array().rowwise() / X.row(2).array();
+
+    Mat2X d_D_d_P;
+    getDerivativesAddDistoWrtPt(P, d_D_d_P);
+
+    Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+    T.block<3, 3>(0, 0) = pose.rotation();
+    T.block<3, 1>(0, 3) = pose.translation();
+
+    const double scale = _scale(0);
+    out_derivatives.resize(2, 16 * X.cols());
+
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      const Eigen::Matrix<double, 4, 16> d_X_d_T = getJacobian_AB_wrt_A<4, 4, 1>(T, pts3D.col(i).homogeneous());
+
+      const double invZ = 1.0 / X(2, i);
+      Eigen::Matrix<double, 2, 3> d_P_d_X;
+      d_P_d_X << invZ, 0, -P(0, i) * invZ,
+                 0, invZ, -P(1, i) * invZ;
+
+      out_derivatives.block<2, 16>(0, 16 * i) = scale * d_D_d_P.block<2, 2>(0, 2 * i) * d_P_d_X * d_X_d_T.block<3, 16>(0, 0);
+    }
+  }
+
+  void getDerivativesProjectWrtPoint(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& out_derivatives) const override
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    const Mat2X P = X.topRows<2>().array().rowwise() / X.row(2).array();
+
+    Mat2X d_D_d_P;
+    getDerivativesAddDistoWrtPt(P, d_D_d_P);
+
+    const Mat3& d_X_d_P = pose.rotation();
+    const double scale = _scale(0);
+    out_derivatives.resize(2, 3 * X.cols());
+
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      const double invZ = 1.0 / X(2, i);
+      Eigen::Matrix<double, 2, 3> d_P_d_X;
+      d_P_d_X << invZ, 0, -P(0, i) * invZ,
+                 0, invZ, -P(1, i) * invZ;
+
+      out_derivatives.block<2, 3>(0, 3 * i) = scale * d_D_d_P.block<2, 2>(0, 2 * i) * d_P_d_X * d_X_d_P;
+    }
+  }
+
   Eigen::Matrix<double, 2, Eigen::Dynamic> getDerivativeProjectWrtDisto(const geometry::Pose3& pose, const Vec3 & pt) const
   {
     const Vec3 X = pose(pt); // apply pose
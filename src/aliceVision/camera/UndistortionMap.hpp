@@ -0,0 +1,416 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/Sampler.hpp>
+#include <aliceVision/camera/cameraCommon.hpp>
+#include <aliceVision/camera/IntrinsicBase.hpp>
+#include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace aliceVision {
+namespace camera {
+
+/**
+ * @brief Lookup table of the distorted position of each pixel of an undistorted image.
+ *
+ * The distortion is evaluated once per intrinsic and image size, then the bilinear weights
+ * and the index of the top-left source pixel are stored per pixel (structure of arrays),
+ * so undistorting an image is a single pass without virtual calls nor iterative solvers.
+ */
+class UndistortionMap
+{
+public:
+  /**
+   * @brief Compute the map of an image of size width x height.
+   * @param[in] intrinsic the camera intrinsic
+   * @param[in] correctPrincipalPoint move the principal point to the image center (pinhole cameras only)
+   * @param[in] subsampling evaluate the distortion every subsampling pixels and interpolate in between (1: every pixel)
+   */
+  UndistortionMap(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint = false, int subsampling = 1)
+    : _width(width)
+    , _height(height)
+  {
+    const Vec2 center(width * 0.5, height * 0.5);
+    Vec2 ppCorrection(0.0, 0.0);
+
+    if(correctPrincipalPoint && camera::isPinhole(intrinsic.getType()))
+    {
+      const camera::Pinhole& pinhole = dynamic_cast<const camera::Pinhole&>(intrinsic);
+      ppCorrection = pinhole.getPrincipalPoint() - center;
+    }
+
+    subsampling = std::max(1, subsampling);
+
+    // distorted positions on the subsampled grid, the last row and column are always evaluated
+    const int gridWidth = (width - 1) / subsampling + 2;
+    const int gridHeight = (height - 1) / subsampling + 2;
+    std::vector<Vec2> grid(gridWidth * gridHeight);
+
+    #pragma omp parallel for
+    for(int gj = 0; gj < gridHeight; ++gj)
+    {
+      for(int gi = 0; gi < gridWidth; ++gi)
+      {
+        const Vec2 undisto_pix(std::min(gi * subsampling, width - 1), std::min(gj * subsampling, height - 1));
+        grid[gj * gridWidth + gi] = intrinsic.get_d_pixel(undisto_pix) + ppCorrection;
+      }
+    }
+
+    const std::size_t nbPixels = std::size_t(width) * height;
+    _offsets.resize(nbPixels);
+    _weightsX.resize(nbPixels);
+    _weightsY.resize(nbPixels);
+
+    std::vector<std::vector<BorderPixel>> rowsBorderPixels(height);
+
+    #pragma omp parallel for
+    for(int j = 0; j < height; ++j)
+    {
+      const int gj = std::min(j / subsampling, gridHeight - 2);
+      const int j0 = gj * subsampling;
+      const int j1 = std::min((gj + 1) * subsampling, height - 1);
+      const double ty = (j1 > j0) ? double(j - j0) / double(j1 - j0) : 0.0;
+
+      for(int i = 0; i < width; ++i)
+      {
+        Vec2 disto_pix;
+        if(subsampling == 1)
+        {
+          disto_pix = grid[j * gridWidth + i];
+        }
+        else
+        {
+          const int gi = std::min(i / subsampling, gridWidth - 2);
+          const int i0 = gi * subsampling;
+          const int i1 = std::min((gi + 1) * subsampling, width - 1);
+          const double tx = (i1 > i0) ? double(i - i0) / double(i1 - i0) : 0.0;
+          const Vec2& a = grid[gj * gridWidth + gi];
+          const Vec2& b = grid[gj * gridWidth + gi + 1];
+          const Vec2& c = grid[(gj + 1) * gridWidth + gi];
+          const Vec2& d = grid[(gj + 1) * gridWidth + gi + 1];
+          disto_pix = (1.0 - ty) * ((1.0 - tx) * a + tx * b) + ty * ((1.0 - tx) * c + tx * d);
+        }
+
+        const std::size_t index = std::size_t(j) * width + i;
+        _offsets[index] = -1;
+
+        // same domain test and float precision as the per pixel undistortion
+        const float x = static_cast<float>(disto_pix(0));
+        const float y = static_cast<float>(disto_pix(1));
+        const int xi = static_cast<int>(x);
+        const int yi = static_cast<int>(y);
+        if(xi < 0 || xi >= width || yi < 0 || yi >= height)
+          continue;
+
+        const float x0 = std::floor(x);
+        const float y0 = std::floor(y);
+        if(x0 < 0 || y0 < 0 || x0 + 1 >= width || y0 + 1 >= height)
+        {
+          // the 4 neighbors are not all in the image, sampled with renormalized weights
+          rowsBorderPixels[j].push_back({index, x, y});
+          continue;
+        }
+
+        _offsets[index] = static_cast<std::int32_t>(y0) * width + static_cast<std::int32_t>(x0);
+        _weightsX[index] = x - x0;
+        _weightsY[index] = y - y0;
+      }
+    }
+
+    for(const auto& rowBorderPixels : rowsBorderPixels)
+      _borderPixels.insert(_borderPixels.end(), rowBorderPixels.begin(), rowBorderPixels.end());
+  }
+
+  int width() const { return _width; }
+  int height() const { return _height; }
+
+  /**
+   * @brief Memory used by the map in bytes.
+   */
+  std::size_t memorySize() const
+  {
+    return _offsets.size() * (sizeof(std::int32_t) + 2 * sizeof(float)) + _borderPixels.size() * sizeof(BorderPixel);
+  }
+
+  /**
+   * @brief Undistort an image with the bilinear interpolation of image::SamplerLinear.
+   * @param[in] imageIn the distorted image, of the size of the map
+   * @param[out] image_ud the undistorted image
+   * @param[in] fillcolor the color of the pixels outside of imageIn
+   */
+  template <typename T>
+  void apply(const image::Image<T>& imageIn, image::Image<T>& image_ud, T fillcolor) const
+  {
+    if(imageIn.Width() != _width || imageIn.Height() != _height)
+      throw std::invalid_argument("UndistortionMap: the image size does not match the map size.");
+
+    using RealT = typename image::RealPixel<T>::real_type;
+
+    image_ud.resize(_width, _height, false);
+
+    const T* src = imageIn.data();
+    T* dst = image_ud.data();
+
+    #pragma omp parallel for
+    for(int j = 0; j < _height; ++j)
+    {
+      const std::size_t rowBegin = std::size_t(j) * _width;
+      const std::size_t rowEnd = rowBegin + _width;
+      for(std::size_t index = rowBegin; index < rowEnd; ++index)
+      {
+        const std::int32_t offset = _offsets[index];
+        if(offset < 0)
+        {
+          dst[index] = fillcolor;
+          continue;
+        }
+        const double fx = _weightsX[index];
+        const double fy = _weightsY[index];
+        const T* topLeft = src + offset;
+        const RealT top = image::RealPixel<T>::convert_to_real(topLeft[0]) * (1.0 - fx) +
+                          image::RealPixel<T>::convert_to_real(topLeft[1]) * fx;
+        const RealT bottom = image::RealPixel<T>::convert_to_real(topLeft[_width]) * (1.0 - fx) +
+                             image::RealPixel<T>::convert_to_real(topLeft[_width + 1]) * fx;
+        dst[index] = image::RealPixel<T>::convert_from_real(top * (1.0 - fy) + bottom * fy);
+      }
+    }
+
+    const image::Sampler2d<image::SamplerLinear> sampler;
+    for(const BorderPixel& pixel : _borderPixels)
+      dst[pixel.index] = sampler(imageIn, pixel.y, pixel.x);
+  }
+
+private:
+  struct BorderPixel
+  {
+    std::size_t index;
+    float x;
+    float y;
+  };
+
+  int _width;
+  int _height;
+  /// index in the source image of the top-left neighbor of each pixel, -1 if outside of the image
+  std::vector<std::int32_t> _offsets;
+  /// bilinear weights of the right and bottom neighbors
+  std::vector<float> _weightsX;
+  std::vector<float> _weightsY;
+  /// pixels sampled on the border of the source image
+  std::vector<BorderPixel> _borderPixels;
+};
+
+/**
+ * @brief Thread-safe cache of the undistortion maps, shared by the views of the same intrinsic.
+ *
+ * The maps are computed outside of the lock: the first request of an intrinsic registers a
+ * shared future that the concurrent requests of the same intrinsic wait for, while the
+ * requests of other intrinsics are not blocked.
+ * The memory of the cached maps is bounded: when it exceeds the maximum memory size, the least
+ * recently used maps are evicted (the requests holding them keep them alive until released).
+ */
+class UndistortionMapCache
+{
+public:
+  /// Default maximum memory size of the cached maps
+  static constexpr std::size_t defaultMaxMemorySize = std::size_t(2) << 30;
+
+  /**
+   * @param[in] subsampling the subsampling of the distortion evaluation (see UndistortionMap)
+   * @param[in] maxMemorySize the maximum memory size of the cached maps in bytes,
+   *            the last computed map is always kept
+   */
+  explicit UndistortionMapCache(int subsampling = 1, std::size_t maxMemorySize = defaultMaxMemorySize)
+    : _subsampling(subsampling)
+    , _maxMemorySize(maxMemorySize)
+  {}
+
+  /**
+   * @brief Get the map of an intrinsic for an image size, computed on the first request.
+   */
+  std::shared_ptr<const UndistortionMap> get(const IntrinsicBase& intrinsic, int width, int height,
+                                             bool correctPrincipalPoint = false)
+  {
+    const Key key{intrinsic.hashValue(), width, height, correctPrincipalPoint};
+    bool computeMap = false;
+
+    std::promise<std::shared_ptr<const UndistortionMap>> promise;
+    std::shared_future<std::shared_ptr<const UndistortionMap>> map;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      std::vector<Entry>& entries = _maps[key];
+      // the intrinsics are compared to not share the map of a hash collision
+      for(Entry& entry : entries)
+      {
+        if(*entry.intrinsic == intrinsic)
+        {
+          entry.lastUse = ++_useCounter;
+          map = entry.map;
+          break;
+        }
+      }
+      if(!map.valid())
+      {
+        map = promise.get_future().share();
+        entries.push_back(Entry{std::shared_ptr<const IntrinsicBase>(intrinsic.clone()), map, ++_useCounter, 0});
+        computeMap = true;
+      }
+    }
+    // wait for the map computed by another request
+    if(!computeMap)
+      return map.get();
+
+    // the waits of the other requests of this intrinsic are released by the promise
+    std::shared_ptr<const UndistortionMap> computedMap;
+    try
+    {
+      computedMap = std::make_shared<const UndistortionMap>(intrinsic, width, height, correctPrincipalPoint, _subsampling);
+    }
+    catch(...)
+    {
+      promise.set_exception(std::current_exception());
+      erase(key, intrinsic);
+      throw;
+    }
+    promise.set_value(computedMap);
+    setMemorySize(key, intrinsic, computedMap->memorySize());
+    return computedMap;
+  }
+
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::size_t nbMaps = 0;
+    for(const auto& entries : _maps)
+      nbMaps += entries.second.size();
+    return nbMaps;
+  }
+
+  /**
+   * @brief Memory used by the cached maps in bytes.
+   */
+  std::size_t memorySize() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _memorySize;
+  }
+
+  std::size_t maxMemorySize() const { return _maxMemorySize; }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maps.clear();
+    _memorySize = 0;
+  }
+
+private:
+  struct Key
+  {
+    std::size_t hash;
+    int width;
+    int height;
+    bool correctPrincipalPoint;
+
+    bool operator<(const Key& other) const
+    {
+      return std::tie(hash, width, height, correctPrincipalPoint) <
+             std::tie(other.hash, other.width, other.height, other.correctPrincipalPoint);
+    }
+  };
+
+  struct Entry
+  {
+    std::shared_ptr<const IntrinsicBase> intrinsic;
+    std::shared_future<std::shared_ptr<const UndistortionMap>> map;
+    /// use counter of the last request
+    std::uint64_t lastUse;
+    /// memory size of the map, 0 while it is computed
+    std::size_t memorySize;
+  };
+
+  void erase(const Key& key, const IntrinsicBase& intrinsic)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto mapIt = _maps.find(key);
+    if(mapIt == _maps.end())
+      return;
+    std::vector<Entry>& entries = mapIt->second;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&](const Entry& entry) { return *entry.intrinsic == intrinsic; }),
+                  entries.end());
+    if(entries.empty())
+      _maps.erase(mapIt);
+  }
+
+  /// Account the memory of a computed map, then evict the least recently used maps over the budget
+  void setMemorySize(const Key& key, const IntrinsicBase& intrinsic, std::size_t memorySize)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // the entry is missing if the cache was cleared during the computation
+    const auto mapIt = _maps.find(key);
+    if(mapIt == _maps.end())
+      return;
+    const auto entryIt = std::find_if(mapIt->second.begin(), mapIt->second.end(),
+                                      [&](const Entry& entry) { return *entry.intrinsic == intrinsic; });
+    if(entryIt == mapIt->second.end())
+      return;
+    entryIt->memorySize = memorySize;
+    _memorySize += memorySize;
+
+    while(_memorySize > _maxMemorySize)
+    {
+      // computed maps only, except the one just added
+      auto lruMap = _maps.end();
+      std::size_t lruIndex = 0;
+      for(auto it = _maps.begin(); it != _maps.end(); ++it)
+      {
+        for(std::size_t i = 0; i < it->second.size(); ++i)
+        {
+          const Entry& entry = it->second[i];
+          if(entry.memorySize == 0 || (!(it->first < key) && !(key < it->first) && *entry.intrinsic == intrinsic))
+            continue;
+          if(lruMap == _maps.end() || entry.lastUse < lruMap->second[lruIndex].lastUse)
+          {
+            lruMap = it;
+            lruIndex = i;
+          }
+        }
+      }
+      if(lruMap == _maps.end())
+        break;
+
+      _memorySize -= lruMap->second[lruIndex].memorySize;
+      lruMap->second.erase(lruMap->second.begin() + lruIndex);
+      if(lruMap->second.empty())
+        _maps.erase(lruMap);
+    }
+  }
+
+  int _subsampling;
+  std::size_t _maxMemorySize;
+  mutable std::mutex _mutex;
+  std::map<Key, std::vector<Entry>> _maps;
+  std::size_t _memorySize = 0;
+  std::uint64_t _useCounter = 0;
+};
+
+} // namespace camera
+} // namespace aliceVision
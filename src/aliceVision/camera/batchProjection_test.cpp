@@ -0,0 +1,107 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE batchProjection
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+namespace {
+
+/**
+ * @brief Random 3D points in front of the camera, seen inside the image domain
+ */
+Mat3X generatePoints(const IntrinsicBase& cam, const geometry::Pose3& pose, std::size_t nbPoints)
+{
+  Mat3X pts3D(3, nbPoints);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    const Vec2 ptImage = (Vec2::Random() * 0.4 + Vec2(0.5, 0.5)).cwiseProduct(Vec2(cam.w(), cam.h()));
+    const double depth = 1.0 + std::abs(Vec2::Random()(0)) * 10.0;
+    pts3D.col(i) = cam.backproject(ptImage, true, pose, depth);
+  }
+  return pts3D;
+}
+
+/**
+ * @brief Check the batch API against the per point API
+ */
+void checkBatch(const IntrinsicBase& cam)
+{
+  const double epsilon = 1e-6;
+  const geometry::Pose3 pose(geometry::randomPose());
+  const Mat3X pts3D = generatePoints(cam, pose, 50);
+
+  Mat2X pts2D;
+  cam.projectPoints(pose, pts3D, pts2D);
+  Mat2X pts2DNoDisto;
+  cam.projectPoints(pose, pts3D, pts2DNoDisto, false);
+  Mat2X dPose;
+  cam.getDerivativesProjectWrtPose(pose, pts3D, dPose);
+  Mat2X dPoint;
+  cam.getDerivativesProjectWrtPoint(pose, pts3D, dPoint);
+  Mat2X udPixels;
+  cam.get_ud_pixels(pts2D, udPixels);
+
+  BOOST_CHECK_EQUAL(pts2D.cols(), pts3D.cols());
+  BOOST_CHECK_EQUAL(dPose.cols(), 16 * pts3D.cols());
+  BOOST_CHECK_EQUAL(dPoint.cols(), 3 * pts3D.cols());
+
+  for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+  {
+    const Vec3 pt3D = pts3D.col(i);
+    EXPECT_MATRIX_NEAR(cam.project(pose, pt3D, true), pts2D.col(i), epsilon);
+    EXPECT_MATRIX_NEAR(cam.project(pose, pt3D, false), pts2DNoDisto.col(i), epsilon);
+    const Eigen::Matrix<double, 2, 16> dPose_i = dPose.block<2, 16>(0, 16 * i);
+    const Eigen::Matrix<double, 2, 3> dPoint_i = dPoint.block<2, 3>(0, 3 * i);
+    EXPECT_MATRIX_NEAR(cam.getDerivativeProjectWrtPose(pose, pt3D), dPose_i, epsilon);
+    EXPECT_MATRIX_NEAR(cam.getDerivativeProjectWrtPoint(pose, pt3D), dPoint_i, epsilon);
+    EXPECT_MATRIX_NEAR(cam.get_ud_pixel(pts2D.col(i)), udPixels.col(i), epsilon);
+  }
+
+  const Mat2X residuals = cam.residuals(pose, pts3D, pts2D);
+  BOOST_CHECK_SMALL(residuals.norm(), epsilon);
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a camera of each model
+// - Project a batch of random points, compute the batch Jacobians and undistort the batch
+// - Assert that the results match the per point API
+//-----------------
+BOOST_AUTO_TEST_CASE(batchProjection_models)
+{
+  std::vector<std::pair<std::string, std::shared_ptr<IntrinsicBase>>> cameras = {
+    {"Pinhole", std::make_shared<Pinhole>(1000, 1000, 1000, 500, 500)},
+    {"PinholeRadialK1", std::make_shared<PinholeRadialK1>(1000, 1000, 1000, 500, 500, 0.1)},
+    {"PinholeRadialK3", std::make_shared<PinholeRadialK3>(1000, 1000, 1000, 500, 500, -0.245539, 0.255195, 0.163773)},
+    {"PinholeBrownT2", std::make_shared<PinholeBrownT2>(1000, 1000, 1000, 500, 500, -0.054, 0.014, 0.006, 0.001, -0.001)},
+    {"PinholeFisheye", std::make_shared<PinholeFisheye>(1000, 1000, 1000, 500, 500, -0.054, 0.014, 0.006, 0.011)},
+    {"PinholeFisheye1", std::make_shared<PinholeFisheye1>(1000, 1000, 1000, 500, 500, 0.1)},
+    {"EquiDistantRadialK3", std::make_shared<EquiDistantRadialK3>(1000, 800, 800, 500, 400, 0.0, 0.3, 0.2, 0.1)},
+  };
+
+  for(const auto& camera : cameras)
+  {
+    BOOST_TEST_CONTEXT(camera.first)
+    {
+      checkBatch(*camera.second);
+    }
+  }
+}
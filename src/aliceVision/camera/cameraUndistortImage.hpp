@@ -14,6 +14,7 @@
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/camera/UndistortionMap.hpp>
 
 #include <memory>
 
@@ -66,6 +67,17 @@ void UndistortImage(
   }
 }
 
+/// Undistort an image with a precomputed undistortion map (see UndistortionMapCache to share it between views)
+template <typename T>
+void UndistortImage(
+  const image::Image<T>& imageIn,
+  const camera::UndistortionMap& undistortionMap,
+  image::Image<T>& image_ud,
+  T fillcolor)
+{
+  undistortionMap.apply(imageIn, image_ud, fillcolor);
+}
+
 } // namespace camera
 } // namespace aliceVision
 
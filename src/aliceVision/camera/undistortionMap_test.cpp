@@ -0,0 +1,211 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+
+#define BOOST_TEST_MODULE undistortionMap
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+namespace {
+
+image::Image<float> createRandomImage(int width, int height)
+{
+  image::Image<float> image(width, height);
+  for(int j = 0; j < height; ++j)
+    for(int i = 0; i < width; ++i)
+      image(j, i) = static_cast<float>(std::rand()) / RAND_MAX;
+  return image;
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera and a random image
+// - Undistort the image per pixel and with an undistortion map
+// - Assert that both undistorted images are the same
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_sameAsPerPixelUndistortion)
+{
+  const int width = 320;
+  const int height = 240;
+  const PinholeRadialK3 cam(width, height, 300, 165, 118, -0.2, 0.1, -0.02);
+  const image::Image<float> image = createRandomImage(width, height);
+
+  for(bool correctPrincipalPoint : {false, true})
+  {
+    image::Image<float> image_ud;
+    UndistortImage(image, &cam, image_ud, -1.0f, correctPrincipalPoint);
+
+    const UndistortionMap undistortionMap(cam, width, height, correctPrincipalPoint);
+    image::Image<float> imageMap_ud;
+    UndistortImage(image, undistortionMap, imageMap_ud, -1.0f);
+
+    BOOST_CHECK_EQUAL(imageMap_ud.Width(), width);
+    BOOST_CHECK_EQUAL(imageMap_ud.Height(), height);
+    for(int j = 0; j < height; ++j)
+      for(int i = 0; i < width; ++i)
+        BOOST_CHECK_SMALL(imageMap_ud(j, i) - image_ud(j, i), 1e-5f);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Undistort an image with a subsampled undistortion map
+// - Assert that it is close to the per pixel undistortion
+// - Assert that the cache returns the same map for the same intrinsic
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_subsamplingAndCache)
+{
+  const int width = 320;
+  const int height = 240;
+  const PinholeRadialK3 cam(width, height, 300, 160, 120, -0.2, 0.1, -0.02);
+
+  // a smooth image, so the interpolation error of the positions is small
+  image::Image<float> image(width, height);
+  for(int j = 0; j < height; ++j)
+    for(int i = 0; i < width; ++i)
+      image(j, i) = std::sin(i * 0.05f) * std::cos(j * 0.05f);
+
+  image::Image<float> image_ud;
+  UndistortImage(image, &cam, image_ud, 0.0f);
+
+  UndistortionMapCache cache(8);
+  const std::shared_ptr<const UndistortionMap> undistortionMap = cache.get(cam, width, height);
+  image::Image<float> imageMap_ud;
+  UndistortImage(image, *undistortionMap, imageMap_ud, 0.0f);
+
+  // skip the image border where the pixels may be in or out of the image
+  for(int j = 8; j < height - 8; ++j)
+    for(int i = 8; i < width - 8; ++i)
+      BOOST_CHECK_SMALL(imageMap_ud(j, i) - image_ud(j, i), 1e-2f);
+
+  const PinholeRadialK3 sameCam(cam);
+  BOOST_CHECK(cache.get(sameCam, width, height) == undistortionMap);
+  BOOST_CHECK(cache.get(cam, width / 2, height / 2) != undistortionMap);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Request the maps of two intrinsics from several threads at once
+// - Assert that each intrinsic has a single map, shared by all its requests
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_concurrentCache)
+{
+  const int width = 320;
+  const int height = 240;
+  const PinholeRadialK3 camA(width, height, 300, 160, 120, -0.2, 0.1, -0.02);
+  const PinholeRadialK3 camB(width, height, 300, 160, 120, 0.1, -0.05, 0.01);
+
+  UndistortionMapCache cache;
+  const int nbThreads = 8;
+  std::vector<std::shared_ptr<const UndistortionMap>> maps(nbThreads);
+  std::vector<std::thread> threads;
+  for(int i = 0; i < nbThreads; ++i)
+    threads.emplace_back([&, i]() { maps[i] = cache.get((i % 2 == 0) ? camA : camB, width, height); });
+  for(std::thread& thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  for(int i = 0; i < nbThreads; ++i)
+  {
+    BOOST_REQUIRE(maps[i]);
+    BOOST_CHECK(maps[i] == maps[i % 2]);
+  }
+  BOOST_CHECK(maps[0] != maps[1]);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Request the maps of three intrinsics in a cache that holds two of them
+// - Assert that the least recently used map is evicted and recomputed on request
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_cacheEviction)
+{
+  const int width = 320;
+  const int height = 240;
+  const PinholeRadialK3 camA(width, height, 300, 160, 120, -0.2, 0.1, -0.02);
+  const PinholeRadialK3 camB(width, height, 300, 160, 120, 0.1, -0.05, 0.01);
+  const PinholeRadialK3 camC(width, height, 300, 160, 120, 0.05, 0.0, 0.0);
+
+  const std::size_t mapMemorySize = UndistortionMap(camA, width, height).memorySize();
+  UndistortionMapCache cache(1, 2 * mapMemorySize + mapMemorySize / 2);
+
+  const std::shared_ptr<const UndistortionMap> mapA = cache.get(camA, width, height);
+  const std::shared_ptr<const UndistortionMap> mapB = cache.get(camB, width, height);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+
+  // A is used after B, so B is the least recently used
+  BOOST_CHECK(cache.get(camA, width, height) == mapA);
+  cache.get(camC, width, height);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.memorySize() <= cache.maxMemorySize());
+
+  BOOST_CHECK(cache.get(camA, width, height) == mapA);
+  BOOST_CHECK(cache.get(camB, width, height) != mapB);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Clear the cache while maps are computed by other threads
+// - Assert that the maps are returned and that the cleared maps are not accounted
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_clearDuringComputation)
+{
+  const int width = 320;
+  const int height = 240;
+  const PinholeRadialK3 camA(width, height, 300, 160, 120, -0.2, 0.1, -0.02);
+  const PinholeRadialK3 camB(width, height, 300, 160, 120, 0.1, -0.05, 0.01);
+
+  UndistortionMapCache cache;
+  const int nbThreads = 8;
+  const int nbRequests = 20;
+  std::vector<char> mapsValid(nbThreads * nbRequests, 1);
+  std::atomic<int> nbFinishedThreads(0);
+  std::vector<std::thread> threads;
+  for(int i = 0; i < nbThreads; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      if(i == 0)
+      {
+        while(nbFinishedThreads < nbThreads - 1)
+          cache.clear();
+        return;
+      }
+      for(int r = 0; r < nbRequests; ++r)
+        mapsValid[i * nbRequests + r] = (cache.get((i % 2 == 0) ? camA : camB, width, height) != nullptr);
+      ++nbFinishedThreads;
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+
+  BOOST_CHECK(std::all_of(mapsValid.begin(), mapsValid.end(), [](char valid) { return valid != 0; }));
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+  BOOST_CHECK_EQUAL(cache.memorySize(), 0);
+
+  const std::shared_ptr<const UndistortionMap> mapA = cache.get(camA, width, height);
+  BOOST_CHECK_EQUAL(cache.memorySize(), mapA->memorySize());
+}
@@ -117,6 +117,15 @@ public:
    */
   virtual const void * DescriptorRawData() const = 0;
 
+  /// Number of bytes of one descriptor in the descriptors array
+  virtual std::size_t DescriptorByteLength() const = 0;
+
+  /**
+   * @brief Resize the descriptors array, to fill it from raw memory.
+   * @return a pointer to the first value of the descriptor array
+   */
+  virtual void * ResizeDescriptors(std::size_t count) = 0;
+
   virtual void clearDescriptors() = 0;
 
   /// Return the squared distance between two descriptors
@@ -218,6 +227,14 @@ public:
 
   inline const void* DescriptorRawData() const override { return &_vec_descs[0];}
 
+  inline std::size_t DescriptorByteLength() const override { return sizeof(DescriptorT); }
+
+  inline void* ResizeDescriptors(std::size_t count) override
+  {
+    _vec_descs.resize(count);
+    return _vec_descs.data();
+  }
+
   inline void clearDescriptors() override { _vec_descs.clear(); }
 
   inline void swap(This& other)
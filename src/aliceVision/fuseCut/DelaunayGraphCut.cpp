@@ -17,6 +17,8 @@
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
 
 #include "nanoflann.hpp"
 
@@ -397,7 +399,17 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp)
     saveTemporaryBinFiles = mp->userParams.get<bool>("LargeScale.saveTemporaryBinFiles", false);
 
     GEO::initialize();
-    _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
+    // PDEL: multithreaded Delaunay (available if geogram is built with it), BDEL: sequential Delaunay.
+    // PDEL inserts the points concurrently, so the order of the cells (and therefore the order in which the
+    // graph-cut weights are accumulated and the cut ties are resolved) changes from one run to another.
+    // BDEL is the default for reproducible results, PDEL is opt-in.
+    std::string delaunayAlgorithm = mp->userParams.get<std::string>("delaunaycut.delaunayAlgorithm", "BDEL");
+    if(!GEO::DelaunayFactory::has_creator(delaunayAlgorithm))
+    {
+        ALICEVISION_LOG_WARNING("GEOGRAM Delaunay algorithm \"" << delaunayAlgorithm << "\" is not available, use BDEL.");
+        delaunayAlgorithm = "BDEL";
+    }
+    _tetrahedralization = GEO::Delaunay::create(3, delaunayAlgorithm);
     // _tetrahedralization->set_keeps_infinite(true);
     _tetrahedralization->set_stores_neighbors(true);
     // _tetrahedralization->set_stores_cicl(true);
@@ -464,17 +476,127 @@ void DelaunayGraphCut::computeDelaunay()
 
     assert(_verticesCoords.size() == _verticesAttr.size());
 
-    long tall = clock();
+    ALICEVISION_LOG_INFO("GEOGRAM Delaunay tetrahedralization of " << _verticesCoords.size() << " vertices with "
+                         << omp_get_max_threads() << " threads.");
+    ALICEVISION_LOG_INFO("Memory before tetrahedralization:\n" << system::getMemoryInfo());
+
+    system::Timer timer;
     _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
-    mvsUtils::printfElapsedTime(tall, "GEOGRAM Delaunay tetrahedralization ");
+    ALICEVISION_LOG_INFO("GEOGRAM Delaunay tetrahedralization done in " << timer.elapsed() << " s: "
+                         << _tetrahedralization->nb_cells() << " cells.");
 
+    timer.reset();
     initCells();
-
     updateVertexToCellsCache();
+    updateCellsAdjacencyCache();
+    ALICEVISION_LOG_INFO("Cells initialized in " << timer.elapsed() << " s.");
+
+    // cells vertices and neighbors, cells attributes and vertex to cells cache
+    const std::size_t nbCells = _tetrahedralization->nb_cells();
+    const std::size_t cellsMemSize = nbCells * (8 * sizeof(GEO::index_t) + sizeof(GC_cellInfo))
+                                   + _neighboringCellsPerVertex.size() * sizeof(CellIndex)
+                                   + _neighboringCellsPerVertexOffsets.size() * sizeof(std::size_t)
+                                   + _cellsMirrorLocalIndex.size() * sizeof(std::uint8_t);
+    ALICEVISION_LOG_INFO("Tetrahedralization memory: " << cellsMemSize / (1024 * 1024) << " MB.");
+    ALICEVISION_LOG_INFO("Memory after tetrahedralization:\n" << system::getMemoryInfo());
 
     ALICEVISION_LOG_DEBUG("computeDelaunay done\n");
 }
 
+void DelaunayGraphCut::updateVertexToCellsCache()
+{
+    const std::size_t nbVertices = _verticesCoords.size();
+    const GEO::index_t nbCells = _tetrahedralization->nb_cells();
+
+    _neighboringCellsPerVertexOffsets.assign(nbVertices + 1, 0);
+    _neighboringCellsPerVertex.clear();
+
+    // count the cells of each vertex
+    int coutInvalidVertices = 0;
+
+    #pragma omp parallel for reduction(+:coutInvalidVertices)
+    for(int ci = 0; ci < int(nbCells); ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const GEO::signed_index_t vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi < 0 || std::size_t(vi) >= nbVertices)
+            {
+                ++coutInvalidVertices;
+                continue;
+            }
+            #pragma omp atomic
+            ++_neighboringCellsPerVertexOffsets[vi];
+        }
+    }
+    ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
+
+    std::size_t nbEntries = 0;
+    for(std::size_t& offset : _neighboringCellsPerVertexOffsets)
+    {
+        const std::size_t count = offset;
+        offset = nbEntries;
+        nbEntries += count;
+    }
+    _neighboringCellsPerVertex.resize(nbEntries);
+
+    // fill, then sort the cells of each vertex to be independent of the threads scheduling
+    {
+        std::vector<std::size_t> cursors(_neighboringCellsPerVertexOffsets.begin(), _neighboringCellsPerVertexOffsets.end() - 1);
+
+        #pragma omp parallel for
+        for(int ci = 0; ci < int(nbCells); ++ci)
+        {
+            for(VertexIndex k = 0; k < 4; ++k)
+            {
+                const GEO::signed_index_t vi = _tetrahedralization->cell_vertex(ci, k);
+                if(vi < 0 || std::size_t(vi) >= nbVertices)
+                    continue;
+                std::size_t position;
+                #pragma omp atomic capture
+                position = cursors[vi]++;
+                _neighboringCellsPerVertex[position] = ci;
+            }
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(int vi = 0; vi < int(nbVertices); ++vi)
+    {
+        std::sort(_neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi],
+                  _neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi + 1]);
+    }
+}
+
+void DelaunayGraphCut::updateCellsAdjacencyCache()
+{
+    const GEO::index_t nbCells = _tetrahedralization->nb_cells();
+
+    _cellsMirrorLocalIndex.assign(nbCells, 0);
+
+    #pragma omp parallel for
+    for(int ci = 0; ci < int(nbCells); ++ci)
+    {
+        std::uint8_t mirrorLocalIndices = 0;
+        for(int lvi = 0; lvi < 4; ++lvi)
+        {
+            const GEO::signed_index_t adjCellIndex = _tetrahedralization->cell_adjacent(ci, lvi);
+            if(adjCellIndex < 0)
+                continue;
+            // the shared facet is the one of the adjacent cell whose neighbor is the cell ci
+            for(int k = 0; k < 4; ++k)
+            {
+                if(_tetrahedralization->cell_adjacent(adjCellIndex, k) == ci)
+                {
+                    mirrorLocalIndices |= std::uint8_t(k << (2 * lvi));
+                    break;
+                }
+            }
+        }
+        _cellsMirrorLocalIndex[ci] = mirrorLocalIndices;
+    }
+}
+
 void DelaunayGraphCut::initCells()
 {
     ALICEVISION_LOG_DEBUG("initCells ...\n");
@@ -1613,11 +1735,59 @@ float DelaunayGraphCut::weightFcn(float nrc, bool labatutWeights, int  /*ncams*/
     return weight;
 }
 
+DelaunayGraphCut::Facet DelaunayGraphCut::rayWalkStep(const Point3d& origin, const Point3d& dir, double camDist,
+                                                      bool towardCam, CellIndex ci, int entryLocalVertexIndex,
+                                                      double& inout_t) const
+{
+    Facet out;
+    if(isInfiniteCell(ci))
+        return out;
+
+    const std::array<const Point3d*, 4> cellPoints = {{
+        &_verticesCoords[_tetrahedralization->cell_vertex(ci, 0)],
+        &_verticesCoords[_tetrahedralization->cell_vertex(ci, 1)],
+        &_verticesCoords[_tetrahedralization->cell_vertex(ci, 2)],
+        &_verticesCoords[_tetrahedralization->cell_vertex(ci, 3)]
+    }};
+    // facet vertices, the facet i is opposite to the vertex i
+    static const int facetsVertices[4][3] = {{1, 2, 3}, {0, 2, 3}, {0, 1, 3}, {0, 1, 2}};
+
+    // distance to the camera of the current point, the crossed facet has to be nearer (or farther) from the camera
+    double bestDist = std::abs(camDist - inout_t);
+    double bestT = inout_t;
+
+    for(int i = 0; i < 4; ++i)
+    {
+        // the ray cannot leave the cell by the facet it entered
+        if(i == entryLocalVertexIndex)
+            continue;
+
+        Point3d lpi;
+        if(!isLineInTriangle(&lpi, cellPoints[facetsVertices[i][0]], cellPoints[facetsVertices[i][1]],
+                             cellPoints[facetsVertices[i][2]], &origin, &dir))
+            continue;
+
+        const double t = dot(lpi - origin, dir);
+        const double dist = std::abs(camDist - t);
+        if(towardCam ? (dist < bestDist) : (dist > bestDist))
+        {
+            bestDist = dist;
+            bestT = t;
+            out.cellIndex = ci;
+            out.localVertexIndex = i;
+        }
+    }
+
+    inout_t = bestT;
+    return out;
+}
+
 void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind,
                                bool labatutWeights, bool fillOut, float distFcnHeight) // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 labatutWeights=0 fillOut=1 distFcnHeight=0
 {
     ALICEVISION_LOG_INFO("Computing s-t graph weights.");
     long t1 = clock();
+    system::Timer timer;
 
     setIsOnSurface();
 
@@ -1635,6 +1805,19 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
+    // Each thread accumulates the weights in its own copy of the cells attributes if they fit in memory,
+    // otherwise all threads update the shared cells attributes with atomic operations.
+    const int nbThreads = omp_get_max_threads();
+    const std::size_t cellsAttrMemSize = _cellsAttr.size() * sizeof(GC_cellInfo);
+    const double maxThreadsCellsMemRatio = mp->userParams.get<double>("delaunaycut.fillGraphMaxThreadsCellsMemRatio", 0.5);
+    const bool threadsCellsAttr = (nbThreads > 1) &&
+        (double(nbThreads - 1) * cellsAttrMemSize < maxThreadsCellsMemRatio * system::getMemoryInfo().freeRam);
+    // the first thread works directly on _cellsAttr
+    std::vector<std::vector<GC_cellInfo>> localCellsAttr(threadsCellsAttr ? nbThreads - 1 : 0);
+
+    ALICEVISION_LOG_INFO("s-t graph weights accumulated " << (threadsCellsAttr ? "per thread" : "with atomic updates")
+                         << " (" << nbThreads << " threads, " << cellsAttrMemSize / (1024 * 1024) << " MB of cells attributes).");
+
     // choose random order to prevent waiting
     StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
 
@@ -1645,7 +1828,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
     for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
     {
         int iV = (*vetexesToProcessIdsRand)[i];
@@ -1653,24 +1836,28 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
         if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
         {
-            for(int c = 0; c < v.cams.size(); c++)
+            GC_cellInfo* cellsAttr = _cellsAttr.data();
+            const int threadId = omp_get_thread_num();
+            if(threadsCellsAttr && threadId > 0)
             {
-                // "weight" is called alpha(p) in the paper
-                float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
+                std::vector<GC_cellInfo>& threadCellsAttr = localCellsAttr[threadId - 1];
+                if(threadCellsAttr.empty())
+                    threadCellsAttr.resize(_cellsAttr.size());
+                cellsAttr = threadCellsAttr.data();
+            }
 
-                assert(v.cams[c] >= 0);
-                assert(v.cams[c] < mp->ncams);
+            // "weight" is called alpha(p) in the paper
+            const float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
 
-                int nstepsFront = 0;
-                int nstepsBehind = 0;
-                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+            int nstepsFront = 0;
+            int nstepsBehind = 0;
+            fillGraphPartPt(nstepsFront, nstepsBehind, iV, weight, fixesSigma, nPixelSizeBehind, allPoints, behind,
+                            fillOut, distFcnHeight, cellsAttr, !threadsCellsAttr);
 
-                avStepsFront += nstepsFront;
-                aAvStepsFront += 1;
-                avStepsBehind += nstepsBehind;
-                nAvStepsBehind += 1;
-            } // for c
+            avStepsFront += nstepsFront;
+            aAvStepsFront += v.cams.size();
+            avStepsBehind += nstepsBehind;
+            nAvStepsBehind += v.cams.size();
 
             avCams += v.cams.size();
             nAvCams += 1;
@@ -1679,17 +1866,60 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
     delete vetexesToProcessIdsRand;
 
+    if(!localCellsAttr.empty())
+    {
+        // reduce the weights of all threads
+#pragma omp parallel for
+        for(int ci = 0; ci < int(_cellsAttr.size()); ++ci)
+        {
+            GC_cellInfo& c = _cellsAttr[ci];
+            for(const std::vector<GC_cellInfo>& threadCellsAttr : localCellsAttr)
+            {
+                if(threadCellsAttr.empty())
+                    continue;
+                const GC_cellInfo& tc = threadCellsAttr[ci];
+                c.cellSWeight = std::max(c.cellSWeight, tc.cellSWeight);
+                c.cellTWeight += tc.cellTWeight;
+                c.in += tc.in;
+                c.out += tc.out;
+                c.on += tc.on;
+                for(int s = 0; s < 4; ++s)
+                    c.gEdgeVisWeight[s] += tc.gEdgeVisWeight[s];
+            }
+        }
+    }
+
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
     ALICEVISION_LOG_DEBUG("avStepsBehind = " << mvsUtils::num2str(avStepsBehind) << " // " << mvsUtils::num2str(nAvStepsBehind));
     ALICEVISION_LOG_DEBUG("avCams = " << mvsUtils::num2str(avCams) << " // " << mvsUtils::num2str(nAvCams));
+    ALICEVISION_LOG_INFO("s-t graph weights: " << aAvStepsFront << " rays, " << avStepsFront + avStepsBehind
+                         << " cells crossed in " << timer.elapsed() << " s.");
 
     mvsUtils::printfElapsedTime(t1, "s-t graph weights computed : ");
 }
 
-void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
+namespace {
+
+inline void addCellWeight(float& inout_value, float weight, bool atomicUpdate)
+{
+    if(atomicUpdate)
+    {
+#pragma OMP_ATOMIC_UPDATE
+        inout_value += weight;
+    }
+    else
+    {
+        inout_value += weight;
+    }
+}
+
+} // namespace
+
+void DelaunayGraphCut::fillGraphPartPt(int& out_nstepsFront, int& out_nstepsBehind, VertexIndex vertexIndex,
                                        float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+                                       bool behind, bool fillOut, float distFcnHeight, GC_cellInfo* cellsAttr,
+                                       bool atomicUpdates) const // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1697,141 +1927,158 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
     int maxint = 1000000; // std::numeric_limits<int>::std::max()
 
     const Point3d& po = _verticesCoords[vertexIndex];
-    const float pixSize = mp->getCamPixelSize(po, cam);
-    float maxDist = nPixelSizeBehind * pixSize;
-    if(fixesSigma)
+    const GC_vertexInfo& v = _verticesAttr[vertexIndex];
+
+    // finite cells around the vertex, the first cells of the rays to all the cameras
+    std::vector<CellIndex> vertexCells;
+    vertexCells.reserve(_neighboringCellsPerVertexOffsets[vertexIndex + 1] - _neighboringCellsPerVertexOffsets[vertexIndex]);
+    for(std::size_t k = _neighboringCellsPerVertexOffsets[vertexIndex]; k < _neighboringCellsPerVertexOffsets[vertexIndex + 1]; ++k)
     {
-        maxDist = nPixelSizeBehind;
+        const CellIndex ci = _neighboringCellsPerVertex[k];
+        if(!isInfiniteCell(ci))
+            vertexCells.push_back(ci);
     }
 
-    assert(cam >= 0);
-    assert(cam < mp->ncams);
-
-    // printf("%f %f %f\n",po.x,po.y,po.z);
-
-    int nsteps = 0;
-
-    if(fillOut)
+    for(int c = 0; c < v.cams.size(); ++c)
     {
-        out_nstepsFront = 0;
-        // tetrahedron connected to the point p and which intersect the ray from camera c to point p
-        CellIndex ci = getFacetInFrontVertexOnTheRayToTheCam(vertexIndex, cam).cellIndex;
+        const int cam = v.cams[c];
+        assert(cam >= 0);
+        assert(cam < mp->ncams);
 
-        Point3d p = po;
-        CellIndex lastFinite = GEO::NO_CELL;
-        bool ok = ci != GEO::NO_CELL;
-        while(ok)
+        const float pixSize = mp->getCamPixelSize(po, cam);
+        float maxDist = nPixelSizeBehind * pixSize;
+        if(fixesSigma)
         {
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].out += weight;
-            }
+            maxDist = nPixelSizeBehind;
+        }
 
-            ++out_nstepsFront;
-            ++nsteps;
+        // the ray goes through the vertex toward the camera, its abscissa is the distance to the vertex
+        const Point3d& camC = mp->CArr[cam];
+        const double camDist = (camC - po).size();
+        const Point3d dir = (camC - po).normalize();
 
-            Point3d pold = p;
-            Facet f1, f2;
-            Point3d lpi;
-            // find cell which is nearest to the cam and which is intersected with cam-p ray
-            if(!nearestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi))
+        // facets of the cells around the vertex crossed by the ray in front of and behind the vertex
+        Facet frontFacet;
+        Facet behindFacet;
+        double frontT = 0.0;
+        double behindT = 0.0;
+        for(const CellIndex ci : vertexCells)
+        {
+            double t = frontT;
+            const Facet f = rayWalkStep(po, dir, camDist, true, ci, -1, t);
+            if(f.cellIndex != GEO::NO_CELL)
             {
-                ok = false;
+                frontFacet = f;
+                frontT = t;
             }
-            else
+            t = behindT;
+            const Facet b = rayWalkStep(po, dir, camDist, false, ci, -1, t);
+            if(b.cellIndex != GEO::NO_CELL)
             {
-                float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
-
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
-                }
-
-                if(f2.cellIndex == GEO::NO_CELL)
-                    ok = false;
-                ci = f2.cellIndex;
-                lastFinite = f2.cellIndex;
+                behindFacet = b;
+                behindT = t;
             }
         }
 
-        // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
-        if(lastFinite != GEO::NO_CELL)
+        if(fillOut)
         {
-#pragma OMP_ATOMIC_WRITE
-            _cellsAttr[lastFinite].cellSWeight = (float)maxint;
-        }
-    }
+            // walk toward the camera from the tetrahedron connected to the point p and which intersect the ray
+            CellIndex ci = frontFacet.cellIndex;
+            Facet f1 = frontFacet;
+            double t = frontT;
+            double tEntry = 0.0;
+            CellIndex lastFinite = GEO::NO_CELL;
+            while(ci != GEO::NO_CELL)
+            {
+                addCellWeight(cellsAttr[ci].out, weight, atomicUpdates);
+                ++out_nstepsFront;
 
-    {
-        out_nstepsBehind = 0;
-        // get the tetrahedron next to point p on the ray from c
-        Facet f1 = getFacetBehindVertexOnTheRayToTheCam(vertexIndex, cam);
-        Facet f2;
+                // no facet nearer to the camera
+                if(f1.cellIndex == GEO::NO_CELL)
+                    break;
 
-        CellIndex ci = f1.cellIndex;
-        if(ci != GEO::NO_CELL)
-        {
-#pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
-        }
+                const float dist = distFcn(maxDist, std::abs(tEntry), distFcnHeight);
+                addCellWeight(cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex], weight * dist, atomicUpdates);
 
-        Point3d p = po; // HAS TO BE HERE !!!
+                const Facet f2 = mirrorFacet(f1);
+                ci = f2.cellIndex;
+                lastFinite = f2.cellIndex;
+                if(ci != GEO::NO_CELL)
+                {
+                    tEntry = t;
+                    f1 = rayWalkStep(po, dir, camDist, true, ci, f2.localVertexIndex, t);
+                }
+            }
 
-        bool ok = (ci != GEO::NO_CELL) && allPoints;
-        while(ok)
-        {
-            GC_cellInfo& c = _cellsAttr[ci];
+            // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
+            if(lastFinite != GEO::NO_CELL)
             {
-                if(behind)
+                if(atomicUpdates)
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    c.cellTWeight += weight;
+#pragma OMP_ATOMIC_WRITE
+                    cellsAttr[lastFinite].cellSWeight = (float)maxint;
+                }
+                else
+                {
+                    cellsAttr[lastFinite].cellSWeight = (float)maxint;
                 }
-#pragma OMP_ATOMIC_UPDATE
-                c.in += weight;
             }
+        }
 
-            ++out_nstepsBehind;
-            ++nsteps;
-
-            Point3d pold = p;
-            Point3d lpi;
-            // find cell which is farest to the cam and which intersect cam-p ray
-            if((!farestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi)) ||
-               ((po - pold).size() >= maxDist) || (!allPoints))
+        {
+            // walk away from the camera from the tetrahedron next to point p on the ray from c
+            CellIndex ci = behindFacet.cellIndex;
+            Facet f1 = behindFacet;
+            double t = behindT;
+            double tEntry = 0.0;
+            if(ci != GEO::NO_CELL)
             {
-                ok = false;
+                addCellWeight(cellsAttr[ci].on, weight, atomicUpdates);
             }
-            else
+
+            bool ok = (ci != GEO::NO_CELL) && allPoints;
+            while(ok)
             {
-                // float dist = 1.0f;
-                // float dist = distFcn(maxDist,(po-pold).size()); // not sure if it is OK ... TODO
-                // check ... with, without, and so on ....
-                // because labatutCFG09 with 32 gives much better result than nrc
-                // but when using just nrc and not using distFcn then the result is the same as labatutCGF09
+                if(behind)
+                {
+                    addCellWeight(cellsAttr[ci].cellTWeight, weight, atomicUpdates);
+                }
+                addCellWeight(cellsAttr[ci].in, weight, atomicUpdates);
 
-                float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
+                ++out_nstepsBehind;
 
-                if(f2.cellIndex == GEO::NO_CELL)
+                if((f1.cellIndex == GEO::NO_CELL) || (std::abs(tEntry) >= maxDist))
                 {
                     ok = false;
                 }
                 else
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                    const float dist = distFcn(maxDist, std::abs(tEntry), distFcnHeight);
+
+                    const Facet f2 = mirrorFacet(f1);
+                    if(f2.cellIndex == GEO::NO_CELL)
+                    {
+                        ok = false;
+                    }
+                    else
+                    {
+                        addCellWeight(cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex], weight * dist, atomicUpdates);
+                        tEntry = t;
+                        // the next facet is only needed within the distance maxDist behind the point
+                        if(std::abs(tEntry) < maxDist)
+                            f1 = rayWalkStep(po, dir, camDist, false, f2.cellIndex, f2.localVertexIndex, t);
+                    }
+                    ci = f2.cellIndex;
                 }
-                ci = f2.cellIndex;
             }
-        }
 
-        // cv: is the tetrahedron in distance 2*sigma behind the point p in the direction of the camera c (called Lcp in the paper)
-        if(!behind)
-        {
-            if(ci != GEO::NO_CELL)
+            // cv: is the tetrahedron in distance 2*sigma behind the point p in the direction of the camera c (called Lcp in the paper)
+            if(!behind)
             {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].cellTWeight += weight;
+                if(ci != GEO::NO_CELL)
+                {
+                    addCellWeight(cellsAttr[ci].cellTWeight, weight, atomicUpdates);
+                }
             }
         }
     }
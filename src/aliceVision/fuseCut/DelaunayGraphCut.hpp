@@ -21,6 +21,7 @@
 #include <geogram/mesh/mesh.h>
 #include <geogram/basic/geometry_nd.h>
 
+#include <cstdint>
 #include <map>
 #include <set>
 
@@ -88,12 +89,22 @@ public:
     std::vector<bool> _cellIsFull;
 
     std::vector<int> _camsVertexes;
-    std::vector<std::vector<CellIndex>> _neighboringCellsPerVertex;
+    /// cells of the vertex vi are _neighboringCellsPerVertex[_neighboringCellsPerVertexOffsets[vi], _neighboringCellsPerVertexOffsets[vi+1]),
+    /// in ascending order (compressed sparse row layout)
+    std::vector<std::size_t> _neighboringCellsPerVertexOffsets;
+    std::vector<CellIndex> _neighboringCellsPerVertex;
+    /// local index in the adjacent cell of the vertex opposite to each facet, 2 bits per facet (see updateCellsAdjacencyCache)
+    std::vector<std::uint8_t> _cellsMirrorLocalIndex;
 
     bool saveTemporaryBinFiles;
 
     static const GEO::index_t NO_TETRAHEDRON = GEO::NO_CELL;
 
+    /**
+     * @brief The tetrahedralization uses the geogram algorithm of the "delaunaycut.delaunayAlgorithm" user parameter
+     * (BDEL by default). BDEL is sequential and reproducible. PDEL is multithreaded and opt-in: the order of the cells
+     * and therefore the graph-cut result may differ between runs on the same input.
+     */
     DelaunayGraphCut(mvsUtils::MultiViewParams* _mp);
     virtual ~DelaunayGraphCut();
 
@@ -162,16 +173,21 @@ public:
 
     inline Facet mirrorFacet(const Facet& f) const
     {
-        const std::array<VertexIndex, 3> facetVertices = {
-            getVertexIndex(f, 0),
-            getVertexIndex(f, 1),
-            getVertexIndex(f, 2)
-        };
-        
         Facet out;
         out.cellIndex = _tetrahedralization->cell_adjacent(f.cellIndex, f.localVertexIndex);
+        if(out.cellIndex != GEO::NO_CELL && !_cellsMirrorLocalIndex.empty())
+        {
+            out.localVertexIndex = (_cellsMirrorLocalIndex[f.cellIndex] >> (2 * f.localVertexIndex)) & 3;
+            return out;
+        }
         if(out.cellIndex != GEO::NO_CELL)
         {
+            const std::array<VertexIndex, 3> facetVertices = {
+                getVertexIndex(f, 0),
+                getVertexIndex(f, 1),
+                getVertexIndex(f, 2)
+            };
+
             // Search for the vertex in adjacent cell which doesn't exist in input facet.
             for(int k = 0; k < 4; ++k)
             {
@@ -186,36 +202,15 @@ public:
         return out;
     }
 
-    void updateVertexToCellsCache()
-    {
-        _neighboringCellsPerVertex.clear();
+    /**
+     * @brief Build the cells around each vertex from the tetrahedralization.
+     */
+    void updateVertexToCellsCache();
 
-        std::map<VertexIndex, std::set<CellIndex>> neighboringCellsPerVertexTmp;
-        int coutInvalidVertices = 0;
-        for(CellIndex ci = 0, nbCells = _tetrahedralization->nb_cells(); ci < nbCells; ++ci)
-        {
-            for(VertexIndex k = 0; k < 4; ++k)
-            {
-                CellIndex vi = _tetrahedralization->cell_vertex(ci, k);
-                if(vi == GEO::NO_VERTEX || vi >= _verticesCoords.size())
-                {
-                    ++coutInvalidVertices;
-                    continue;
-                }
-                neighboringCellsPerVertexTmp[vi].insert(ci);
-            }
-        }
-        ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
-        ALICEVISION_LOG_INFO("neighboringCellsPerVertexTmp: " << neighboringCellsPerVertexTmp.size());
-        _neighboringCellsPerVertex.resize(_verticesCoords.size());
-        ALICEVISION_LOG_INFO("verticesCoords: " << _verticesCoords.size());
-        for(const auto& it: neighboringCellsPerVertexTmp)
-        {
-            const std::set<CellIndex>& input = it.second;
-            std::vector<CellIndex>& output = _neighboringCellsPerVertex[it.first];
-            output.assign(input.begin(), input.end());
-        }
-    }
+    /**
+     * @brief Store the local index of the mirror facet of each facet, used by mirrorFacet.
+     */
+    void updateCellsAdjacencyCache();
 
     /**
      * @brief vertexToCells
@@ -228,10 +223,10 @@ public:
      */
     CellIndex vertexToCells(VertexIndex vi, int lvi) const
     {
-        const std::vector<CellIndex>& localCells = _neighboringCellsPerVertex.at(vi);
-        if(lvi >= localCells.size())
+        const std::size_t index = _neighboringCellsPerVertexOffsets.at(vi) + lvi;
+        if(index >= _neighboringCellsPerVertexOffsets[vi + 1])
             return GEO::NO_CELL;
-        return localCells[lvi];
+        return _neighboringCellsPerVertex[index];
     }
 
     void initVertices();
@@ -291,9 +286,28 @@ public:
 
     virtual void fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool labatutWeights,
                            bool fillOut, float distFcnHeight = 0.0f);
-    void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
-                           bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+
+    /**
+     * @brief Next facet crossed by a ray walking from cell to cell.
+     * The ray starts at origin with the unit direction dir to the camera at the distance camDist.
+     * @param[in] ci the current cell
+     * @param[in] entryLocalVertexIndex the facet of the cell by which the ray entered (-1 if none)
+     * @param[in] towardCam walk toward the camera or away from it
+     * @param[in,out] inout_t the abscissa along the ray of the current point, updated to the crossing point
+     * @return the crossed facet of the cell ci or a facet with GEO::NO_CELL if there is none
+     */
+    Facet rayWalkStep(const Point3d& origin, const Point3d& dir, double camDist, bool towardCam, CellIndex ci,
+                      int entryLocalVertexIndex, double& inout_t) const;
+
+    /**
+     * @brief Add the weights of the rays from a vertex to all its cameras.
+     * The cells around the vertex are loaded once for all the rays.
+     * @param[in,out] cellsAttr the cells weights to update
+     * @param[in] atomicUpdates true if cellsAttr is shared between threads
+     */
+    void fillGraphPartPt(int& out_nstepsFront, int& out_nstepsBehind, VertexIndex vertexIndex, float weight,
+                         bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
+                         float distFcnHeight, GC_cellInfo* cellsAttr, bool atomicUpdates) const;
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -9,12 +9,19 @@
 #include <aliceVision/mvsData/Rgb.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
 #include <aliceVision/mesh/meshPostProcessing.hpp>
 #include <aliceVision/fuseCut/VoxelsGrid.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
 namespace aliceVision {
 namespace fuseCut {
 
@@ -166,7 +173,7 @@ bool ReconstructionPlan::divideBox(Voxel& LU1o, Voxel& RD1o, Voxel& LU2o, Voxel&
     return false;
 }
 
-StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(unsigned long maxTracks)
+StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(unsigned long maxTracks, float inflateFactor)
 {
     Voxel actHexahLU = Voxel(0, 0, 0);
     Voxel actHexahRD = voxelDim - Voxel(1, 1, 1);
@@ -229,7 +236,7 @@ StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(un
             */
 
             getHexah(hexah, actHexahLU, actHexahRD);
-            mvsUtils::inflateHexahedron(hexah, hexahinf, 1.05);
+            mvsUtils::inflateHexahedron(hexah, hexahinf, inflateFactor);
             for(int k = 0; k < 8; k++)
             {
                 hexahsToReconstruct->push_back(hexahinf[k]);
@@ -248,23 +255,25 @@ void ReconstructionPlan::getHexahedronForID(float dist, int id, Point3d* out)
     mvsUtils::inflateHexahedron(&(*voxels)[id * 8], out, dist);
 }
 
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls)
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls, int rangeStart,
+                                            int rangeSize)
 {
     StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
 
     ReconstructionPlan* rp =
         new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->spaceVoxelsFolderName);
 
-    StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = new StaticVector<Point3d>();
-    hexahsToExcludeFromResultingMesh->reserve(voxelsArray->size());
+    const int nbVoxels = voxelsArray->size() / 8;
+    const int rangeEnd = (rangeSize < 0) ? nbVoxels : std::min(rangeStart + rangeSize, nbVoxels);
 
-    for(int i = 0; i < voxelsArray->size() / 8; i++)
+    for(int i = rangeStart; i < rangeEnd; i++)
     {
-        ALICEVISION_LOG_INFO("Reconstructing " << (voxelsArray->size() / 8) << "-th Voxel of " <<  i << ".");
+        ALICEVISION_LOG_INFO("Reconstructing voxel " << i << " of " << nbVoxels << ".");
 
         const std::string folderName = ls->getReconstructionVoxelFolder(i);
         bfs::create_directory(folderName);
 
+        // mesh.bin is written last: it marks the voxel as done
         const std::string meshBinFilepath = folderName + "mesh.bin";
         if(!mvsUtils::FileExists(meshBinFilepath))
         {
@@ -286,29 +295,16 @@ void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileNa
             StaticVector<StaticVector<int>> ptsCams;
             delaunayGC.createPtsCams(ptsCams);
 
-            mesh::meshPostProcessing(mesh, ptsCams, *ls->mp, folderName, hexahsToExcludeFromResultingMesh, hexah);
-            mesh->saveToBin(folderName + "mesh.bin");
-            mesh->saveToObj(folderName + "mesh.obj");
+            // the voxels are independent: the overlaps are resolved when the meshes are stitched
+            mesh::meshPostProcessing(mesh, ptsCams, *ls->mp, folderName, nullptr, hexah);
 
             saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
+            mesh->saveToObj(folderName + "mesh.obj");
+            mesh->saveToBin(meshBinFilepath + ".tmp");
+            bfs::rename(meshBinFilepath + ".tmp", meshBinFilepath);
 
             delete mesh;
         }
-
-        /*
-        if(doComputeColoredMeshes)
-        {
-            std::string resultFolderName = folderName + "/";
-            computeColoredMesh(resultFolderName, ls);
-        }
-        */
-        Point3d hexahThin[8];
-        mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexahThin, 0.9);
-        for(int k = 0; k < 8; k++)
-        {
-            hexahsToExcludeFromResultingMesh->push_back(hexahThin[k]);
-        }
-        delete hexahsToExcludeFromResultingMesh;
     }
     delete rp;
     delete voxelsArray;
@@ -356,192 +352,233 @@ void loadLargeScalePtsCams(const std::vector<std::string>& recsDirs, StaticVecto
     }
 }
 
-StaticVector<rgb>* getTrisColorsRgb(mesh::Mesh* me, StaticVector<rgb>* ptsColors)
+namespace {
+
+std::string getVoxelsArrayInflateFactorFileName(const std::string& voxelsArrayFileName)
 {
-    StaticVector<rgb>* trisColors = new StaticVector<rgb>();
-    trisColors->resize(me->tris.size());
-    for(int i = 0; i < me->tris.size(); i++)
-    {
-        float r = 0.0f;
-        float g = 0.0f;
-        float b = 0.0f;
-        for(int j = 0; j < 3; j++)
-        {
-            r += (float)(*ptsColors)[me->tris[i].v[j]].r;
-            g += (float)(*ptsColors)[me->tris[i].v[j]].g;
-            b += (float)(*ptsColors)[me->tris[i].v[j]].b;
-        }
-        (*trisColors)[i].r = (unsigned char)(r / 3.0f);
-        (*trisColors)[i].g = (unsigned char)(g / 3.0f);
-        (*trisColors)[i].b = (unsigned char)(b / 3.0f);
-    }
-    return trisColors;
+    return (bfs::path(voxelsArrayFileName).parent_path() / (bfs::path(voxelsArrayFileName).stem().string() + "InflateFactor.txt")).string();
 }
 
-mesh::Mesh* joinMeshes(const std::vector<std::string>& recsDirs, StaticVector<Point3d>* voxelsArray,
-                    LargeScale* ls)
+struct WeldCell
 {
-    ReconstructionPlan rp(ls->dimensions, &ls->space[0], ls->mp, ls->spaceVoxelsFolderName);
+    int x, y, z;
 
-    ALICEVISION_LOG_DEBUG("Detecting size of merged mesh.");
-    int npts = 0;
-    int ntris = 0;
-    for(int i = 0; i < recsDirs.size(); i++)
-    {
-        std::string folderName = recsDirs[i];
+    bool operator==(const WeldCell& other) const { return x == other.x && y == other.y && z == other.z; }
+};
 
-        std::string fileName = folderName + "mesh.bin";
-        if(mvsUtils::FileExists(fileName))
-        {
-            mesh::Mesh* mei = new mesh::Mesh();
-            mei->loadFromBin(fileName);
-            npts += mei->pts.size();
-            ntris += mei->tris.size();
+struct WeldCellHash
+{
+    std::size_t operator()(const WeldCell& c) const
+    {
+        return (std::size_t(c.x) * 73856093) ^ (std::size_t(c.y) * 19349663) ^ (std::size_t(c.z) * 83492791);
+    }
+};
 
-            ALICEVISION_LOG_DEBUG("npts: " << npts << " " << mei->pts.size());
-            ALICEVISION_LOG_DEBUG("ntris: " << ntris << " " << mei->tris.size());
+/**
+ * @brief Flag the vertices on the border of the mesh, i.e. on an edge with a single triangle.
+ */
+void getBorderPoints(const mesh::Mesh& me, std::vector<bool>& out_isBorder)
+{
+    const std::shared_ptr<const mesh::MeshTopology> topology = me.getTopology();
 
-            delete mei;
+    out_isBorder.assign(me.pts.size(), false);
+    for(int edgeId = 0; edgeId < topology->getNbEdges(); ++edgeId)
+    {
+        if(topology->getEdgeTriangles(edgeId).size() == 1)
+        {
+            const Pixel& edge = topology->getEdgePoints(edgeId);
+            out_isBorder[edge.x] = true;
+            out_isBorder[edge.y] = true;
         }
     }
+}
 
-    ALICEVISION_LOG_DEBUG("Creating mesh.");
+} // namespace
 
-    mesh::Mesh* me = new mesh::Mesh();
+void saveVoxelsArrayInflateFactor(const std::string& voxelsArrayFileName, float inflateFactor)
+{
+    const std::string fileName = getVoxelsArrayInflateFactorFileName(voxelsArrayFileName);
+    FILE* f = fopen(fileName.c_str(), "w");
+    if(f == nullptr)
+        throw std::runtime_error("Unable to write the inflate factor of the voxels array: " + fileName);
+    fprintf(f, "%.9g\n", inflateFactor);
+    fclose(f);
+}
 
-    me->pts = StaticVector<Point3d>();
-    me->pts.reserve(npts);
-    me->tris = StaticVector<mesh::Mesh::triangle>();
-    me->tris.reserve(ntris);
+bool loadVoxelsArrayInflateFactor(const std::string& voxelsArrayFileName, float& out_inflateFactor)
+{
+    const std::string fileName = getVoxelsArrayInflateFactorFileName(voxelsArrayFileName);
+    FILE* f = fopen(fileName.c_str(), "r");
+    if(f == nullptr)
+        return false;
+    const bool valid = (fscanf(f, "%f", &out_inflateFactor) == 1) && out_inflateFactor >= 1.0f;
+    fclose(f);
+    return valid;
+}
 
-    StaticVector<rgb>* trisCols = new StaticVector<rgb>();
-    trisCols->reserve(ntris);
-    StaticVector<rgb>* ptsCols = new StaticVector<rgb>();
-    ptsCols->reserve(npts);
+mesh::Mesh* stitchMeshes(const std::vector<std::string>& recsDirs, const StaticVector<Point3d>& voxelsArray,
+                         float inflateFactor, double weldDist, StaticVector<StaticVector<int>>& out_ptsCams)
+{
+    ALICEVISION_LOG_INFO("Stitching the meshes of " << recsDirs.size() << " voxels.");
 
-    ALICEVISION_LOG_DEBUG("Merging part to one mesh without connecting them.");
-    for(int i = 0; i < recsDirs.size(); i++)
-    {
-        if(ls->mp->verbose)
-            ALICEVISION_LOG_DEBUG("Merging part: " << i);
-        std::string folderName = recsDirs[i];
+    mesh::Mesh* me = new mesh::Mesh();
+    out_ptsCams.clear();
 
-        std::string fileName = folderName + "mesh.bin";
-        if(mvsUtils::FileExists(fileName))
-        {
-            mesh::Mesh* mei = new mesh::Mesh();
-            mei->loadFromBin(fileName);
+    // voxel and border flag of each vertex of the joined mesh
+    std::vector<int> ptsVoxel;
+    std::vector<bool> ptsIsBorder;
 
-            // to remove artefacts on the border
-            Point3d hexah[8];
-            float inflateFactor = 0.96;
-            mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexah, inflateFactor);
-            mei->removeTrianglesOutsideHexahedron(hexah);
+    for(int i = 0; i < recsDirs.size(); ++i)
+    {
+        const std::string meshBinFilepath = recsDirs[i] + "mesh.bin";
+        if(!mvsUtils::FileExists(meshBinFilepath))
+        {
+            ALICEVISION_LOG_WARNING("Missing mesh of voxel " << i << ": " << meshBinFilepath);
+            continue;
+        }
 
-            ALICEVISION_LOG_DEBUG("Adding mesh part "<< i << " to mesh");
-            me->addMesh(*mei);
+        mesh::Mesh mei;
+        if(!mei.loadFromBin(meshBinFilepath))
+        {
+            delete me;
+            throw std::runtime_error("Unable to load the mesh of voxel " + std::to_string(i) + ": " + meshBinFilepath);
+        }
+        StaticVector<StaticVector<int>> ptsCamsi;
+        loadArrayOfArraysFromFile<int>(ptsCamsi, recsDirs[i] + "meshPtsCamsFromDGC.bin");
+        ptsCamsi.resize(mei.pts.size());
+
+        // keep the triangles owned by the voxel core
+        Point3d core[8];
+        mvsUtils::inflateHexahedron(&voxelsArray[i * 8], core, 1.0f / inflateFactor);
+        StaticVector<int> coreTris;
+        coreTris.reserve(mei.tris.size());
+        for(int t = 0; t < mei.tris.size(); ++t)
+        {
+            if(mvsUtils::isPointInHexahedron(mei.computeTriangleCenterOfGravity(t), core))
+                coreTris.push_back(t);
+        }
 
-            ALICEVISION_LOG_DEBUG("Merging colors of part: s" << i);
-            fileName = folderName + "meshAvImgCol.ply.ptsColors";
-            if(mvsUtils::FileExists(fileName))
-            {
-                StaticVector<rgb>* ptsColsi = loadArrayFromFile<rgb>(fileName);
-                StaticVector<rgb>* trisColsi = getTrisColorsRgb(mei, ptsColsi);
+        mesh::Mesh part;
+        StaticVector<int> ptIdToNewPtId;
+        mei.generateMeshFromTrianglesSubset(coreTris, part, ptIdToNewPtId);
 
-                for(int j = 0; j < trisColsi->size(); j++)
-                {
-                    trisCols->push_back((*trisColsi)[j]);
-                }
-                for(int j = 0; j < ptsColsi->size(); j++)
-                {
-                    ptsCols->push_back((*ptsColsi)[j]);
-                }
-                delete ptsColsi;
-                delete trisColsi;
-            }
+        std::vector<bool> isBorder;
+        getBorderPoints(part, isBorder);
 
-            delete mei;
+        const int npts = me->pts.size();
+        out_ptsCams.resize(npts + part.pts.size());
+        for(int p = 0; p < ptIdToNewPtId.size(); ++p)
+        {
+            if(ptIdToNewPtId[p] > -1)
+                out_ptsCams[npts + ptIdToNewPtId[p]] = ptsCamsi[p];
         }
-    }
-
-    // int gridLevel = ls->mp->_ini.get<int>("LargeScale.gridLevel0", 0);
-    ALICEVISION_LOG_DEBUG("Deleting...");
-    delete ptsCols;
-    delete trisCols;
+        me->addMesh(part);
+        ptsVoxel.resize(me->pts.size(), i);
+        ptsIsBorder.insert(ptsIsBorder.end(), isBorder.begin(), isBorder.end());
 
-    //if(ls->mp->verbose)
-    //    printf("Creating QS\n");
-    // createQSfileFromMesh(ls->spaceFolderName + "reconstructedSpaceLevelJoinedMesh"+num2str(gridLevel)+".bin",
-    // ls->spaceFolderName+"meshAvImgCol.ply.ptsColors", ls->spaceFolderName +
-    // "reconstructedSpaceLevelJoinedMesh"+num2str(gridLevel)+".qs");
-#ifdef QSPLAT
-    createQSfileFromMesh(spaceBinFileName, spacePtsColsBinFileName, outDir + "mesh.qs");
-#endif
-
-    return me;
-}
+        ALICEVISION_LOG_DEBUG("Voxel " << i << ": " << part.tris.size() << " triangles kept of " << mei.tris.size() << ".");
+    }
 
-mesh::Mesh* joinMeshes(int gl, LargeScale* ls)
-{
-    ReconstructionPlan* rp =
-        new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->spaceVoxelsFolderName);
-    std::string param = "LargeScale:gridLevel" + mvsUtils::num2str(gl);
-    int gridLevel = ls->mp->userParams.get<int>(param.c_str(), gl * 300);
+    // weld the border vertices of different voxels, using a grid of cell size weldDist
+    std::vector<int> ptIdToWeldedPtId(me->pts.size());
+    std::unordered_map<WeldCell, std::vector<int>, WeldCellHash> grid;
+    // voxels already welded to each vertex of the grid, to keep the weld one-to-one between two voxels
+    std::unordered_map<int, std::vector<int>> weldedVoxels;
+    int nbWelded = 0;
+    for(int p = 0; p < me->pts.size(); ++p)
+    {
+        ptIdToWeldedPtId[p] = p;
+        if(!ptsIsBorder[p])
+            continue;
 
-    std::string optimalReconstructionPlanFileName =
-        ls->spaceFolderName + "optimalReconstructionPlan" + mvsUtils::num2str(gridLevel) + ".bin";
-    StaticVector<SortedId>* optimalReconstructionPlan = loadArrayFromFile<SortedId>(optimalReconstructionPlanFileName);
+        const Point3d& pt = me->pts[p];
+        const WeldCell cell{int(std::floor(pt.x / weldDist)), int(std::floor(pt.y / weldDist)), int(std::floor(pt.z / weldDist))};
 
-    auto subFolderName = ls->mp->userParams.get<std::string>("LargeScale.subFolderName", "");
-    if(subFolderName.empty())
-    {
-        if(ls->mp->userParams.get<bool>("global.LabatutCFG09", false))
+        int nearest = -1;
+        double nearestDist = weldDist;
+        for(int dx = -1; dx <= 1; ++dx)
         {
-            subFolderName = "LabatutCFG09";
+            for(int dy = -1; dy <= 1; ++dy)
+            {
+                for(int dz = -1; dz <= 1; ++dz)
+                {
+                    const auto it = grid.find(WeldCell{cell.x + dx, cell.y + dy, cell.z + dz});
+                    if(it == grid.end())
+                        continue;
+                    for(int q : it->second)
+                    {
+                        if(ptsVoxel[q] == ptsVoxel[p])
+                            continue;
+                        const auto weldedIt = weldedVoxels.find(q);
+                        if(weldedIt != weldedVoxels.end() &&
+                           std::find(weldedIt->second.begin(), weldedIt->second.end(), ptsVoxel[p]) != weldedIt->second.end())
+                            continue;
+                        const double dist = (me->pts[q] - pt).size();
+                        if(dist < nearestDist)
+                        {
+                            nearest = q;
+                            nearestDist = dist;
+                        }
+                    }
+                }
+            }
         }
-        if(ls->mp->userParams.get<bool>("global.JancosekCVPR11", true))
+
+        if(nearest == -1)
         {
-            subFolderName = "JancosekCVPR11";
+            grid[cell].push_back(p);
+            continue;
         }
-    }
-    subFolderName = subFolderName + "/";
-
-    StaticVector<Point3d>* voxelsArray = new StaticVector<Point3d>();
-    voxelsArray->reserve(optimalReconstructionPlan->size() * 8);
 
-    std::vector<std::string> recsDirs;
-    for(int i = 0; i < optimalReconstructionPlan->size(); i++)
-    {
-        int id = (*optimalReconstructionPlan)[i].id;
-        float inflateFactor = (*optimalReconstructionPlan)[i].value;
-        std::string folderName = ls->spaceFolderName + "reconstructedSpacePart" + mvsUtils::num2strFourDecimal(id) + "/";
-        folderName +=  "GL_" + mvsUtils::num2str(gridLevel) + "_IF_" + mvsUtils::num2str((int)inflateFactor) + "/";
-
-        Point3d hexah[8];
-        rp->getHexahedronForID(inflateFactor, id, hexah);
-        for(int k = 0; k < 8; k++)
+        ptIdToWeldedPtId[p] = nearest;
+        weldedVoxels[nearest].push_back(ptsVoxel[p]);
+        for(int cam : out_ptsCams[p])
         {
-            voxelsArray->push_back(hexah[k]);
+            out_ptsCams[nearest].push_back_distinct(cam);
         }
+        ++nbWelded;
+    }
 
-        recsDirs.push_back(folderName);
+    // remap the triangles and remove the degenerated ones
+    StaticVector<int> trisIdsToStay;
+    trisIdsToStay.reserve(me->tris.size());
+    for(int t = 0; t < me->tris.size(); ++t)
+    {
+        mesh::Mesh::triangle& tri = me->tris[t];
+        for(int k = 0; k < 3; ++k)
+            tri.v[k] = ptIdToWeldedPtId[tri.v[k]];
+        if(tri.v[0] != tri.v[1] && tri.v[1] != tri.v[2] && tri.v[2] != tri.v[0])
+            trisIdsToStay.push_back(t);
     }
-    delete optimalReconstructionPlan;
-    delete rp;
+    me->letJustTringlesIdsInMesh(trisIdsToStay);
 
-    mesh::Mesh* me = joinMeshes(recsDirs, voxelsArray, ls);
-    delete voxelsArray;
+    StaticVector<int> ptIdToNewPtId;
+    me->removeFreePointsFromMesh(ptIdToNewPtId);
 
-    return me;
-}
+    StaticVector<StaticVector<int>> ptsCams;
+    ptsCams.resize(me->pts.size());
+    for(int p = 0; p < ptIdToNewPtId.size(); ++p)
+    {
+        if(ptIdToNewPtId[p] > -1)
+            ptsCams[ptIdToNewPtId[p]].swap(out_ptsCams[p]);
+    }
+    out_ptsCams.swap(ptsCams);
 
-mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls)
-{
-    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
-    std::vector<std::string> recsDirs = ls->getRecsDirs(voxelsArray);
+    // the seams are not guaranteed to be manifold, report the edges shared by more than two triangles
+    {
+        const std::shared_ptr<const mesh::MeshTopology> topology = me->getTopology();
+        int nbNonManifoldEdges = 0;
+        for(int edgeId = 0; edgeId < topology->getNbEdges(); ++edgeId)
+        {
+            if(topology->getEdgeTriangles(edgeId).size() > 2)
+                ++nbNonManifoldEdges;
+        }
+        if(nbNonManifoldEdges > 0)
+            ALICEVISION_LOG_WARNING("Stitched mesh: " << nbNonManifoldEdges << " non-manifold edges along the voxels seams.");
+    }
 
-    mesh::Mesh* me = joinMeshes(recsDirs, voxelsArray, ls);
-    delete voxelsArray;
+    ALICEVISION_LOG_INFO("Meshes stitched: " << me->pts.size() << " vertices (" << nbWelded << " welded), "
+                         << me->tris.size() << " triangles.");
 
     return me;
 }
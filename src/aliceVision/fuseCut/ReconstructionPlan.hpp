@@ -26,17 +26,45 @@ public:
     unsigned long getNTracks(const Voxel& LU, const Voxel& RD);
     bool divideBox(Voxel& LU1o, Voxel& RD1o, Voxel& LU2o, Voxel& RD2o, const Voxel& LUi, const Voxel& RDi,
                    unsigned long maxTracks);
-    StaticVector<Point3d>* computeReconstructionPlanBinSearch(unsigned long maxTracks);
+    /**
+     * @brief Divide the space into voxels of less than maxTracks tracks.
+     * @param[in] inflateFactor scale of the returned voxels, so that the neighboring voxels overlap
+     * @return the 8 corners of each inflated voxel
+     */
+    StaticVector<Point3d>* computeReconstructionPlanBinSearch(unsigned long maxTracks, float inflateFactor = 1.05f);
 
     StaticVector<int>* voxelsIdsIntersectingHexah(Point3d* hexah);
     void getHexahedronForID(float dist, int id, Point3d* out);
 };
 
 void reconstructAccordingToOptimalReconstructionPlan(int gl, LargeScale* ls);
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls);
-mesh::Mesh* joinMeshes(const std::vector<std::string>& recsDirs, StaticVector<Point3d>* voxelsArray, LargeScale* ls);
-mesh::Mesh* joinMeshes(int gl, LargeScale* ls);
-mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls);
+/**
+ * @brief Mesh independently the voxels [rangeStart, rangeStart + rangeSize) of the voxels array (all of them if rangeSize is -1).
+ * The voxels already meshed are skipped, so ranges can be run as separate jobs sharing the same LargeScale folder.
+ */
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls, int rangeStart = 0,
+                                            int rangeSize = -1);
+/**
+ * @brief Save the inflate factor used to compute the voxels array next to it, the stitching of the voxels needs it.
+ */
+void saveVoxelsArrayInflateFactor(const std::string& voxelsArrayFileName, float inflateFactor);
+/**
+ * @brief Load the inflate factor saved next to the voxels array.
+ * @return false if the voxels array has no inflate factor
+ */
+bool loadVoxelsArrayInflateFactor(const std::string& voxelsArrayFileName, float& out_inflateFactor);
+/**
+ * @brief Join the meshes of overlapping voxels and weld them along the overlaps.
+ * Each triangle is kept by the voxel whose core (the voxel deflated by inflateFactor) contains its center of gravity,
+ * then the border vertices of different voxels closer than weldDist are merged with their visibilities.
+ * A vertex receives at most one vertex of each other voxel, so the weld never collapses the vertices of a voxel together,
+ * but the seams may still have non-manifold edges where the borders of the voxels cross, their number is logged.
+ * Throw if the mesh of a voxel cannot be loaded.
+ * @param[in] voxelsArray the 8 corners of each voxel, inflated by inflateFactor
+ * @param[out] out_ptsCams the cameras of each vertex of the returned mesh
+ */
+mesh::Mesh* stitchMeshes(const std::vector<std::string>& recsDirs, const StaticVector<Point3d>& voxelsArray,
+                         float inflateFactor, double weldDist, StaticVector<StaticVector<int>>& out_ptsCams);
 
 StaticVector<StaticVector<int>*>* loadLargeScalePtsCams(const std::vector<std::string>& recsDirs);
 void loadLargeScalePtsCams(const std::vector<std::string>& recsDirs, StaticVector<StaticVector<int>>& out_ptsCams);
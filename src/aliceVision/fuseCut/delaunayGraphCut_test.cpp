@@ -0,0 +1,255 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE delaunayGraphCut
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace {
+
+/**
+ * @brief Add pinhole cameras looking along +Z at the given centers, without images.
+ */
+void addCameras(mvsUtils::MultiViewParams& mp, const std::vector<Point3d>& centers)
+{
+    mp.ncams = centers.size();
+    for(const Point3d& c : centers)
+    {
+        Matrix3x3 K;
+        K.m11 = 1000.0; K.m12 = 0.0;    K.m13 = 500.0;
+        K.m21 = 0.0;    K.m22 = 1000.0; K.m23 = 500.0;
+        K.m31 = 0.0;    K.m32 = 0.0;    K.m33 = 1.0;
+        Matrix3x3 R;
+        R.m11 = 1.0; R.m12 = 0.0; R.m13 = 0.0;
+        R.m21 = 0.0; R.m22 = 1.0; R.m23 = 0.0;
+        R.m31 = 0.0; R.m32 = 0.0; R.m33 = 1.0;
+
+        mp.KArr.push_back(K);
+        mp.iKArr.push_back(K.inverse());
+        mp.RArr.push_back(R);
+        mp.iRArr.push_back(R);
+        mp.CArr.push_back(c);
+        mp.iCamArr.push_back(R * K.inverse());
+        mp.camArr.push_back(K * (R | (Point3d(0.0, 0.0, 0.0) - R * c)));
+        mp.FocK1K2Arr.push_back(Point3d(1000.0, 0.0, 0.0));
+    }
+}
+
+/**
+ * @brief Random points in a box in front of the cameras, each one seen by a fixed subset of the cameras.
+ */
+void addVertices(DelaunayGraphCut& delaunayGC, int nbVertices, int nbCameras)
+{
+    std::mt19937 randomNumberGenerator(42);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    for(int i = 0; i < nbVertices; ++i)
+    {
+        const Point3d p(distribution(randomNumberGenerator), distribution(randomNumberGenerator),
+                        distribution(randomNumberGenerator));
+        delaunayGC._verticesCoords.push_back(p);
+
+        GC_vertexInfo v;
+        for(int c = 0; c < nbCameras; ++c)
+        {
+            if((i + c) % 3 != 0)
+                v.cams.push_back(c);
+        }
+        v.nrc = v.cams.size();
+        delaunayGC._verticesAttr.push_back(v);
+    }
+}
+
+/**
+ * @brief Previous ray walk of DelaunayGraphCut::fillGraph, one ray at a time from a vertex to one camera,
+ *        with the cell intersection helpers.
+ * The previous walk could go back to the cell it came from when rounding errors made it miss the exit facet
+ * of a cell (ray grazing an edge). The new walk never crosses its entry facet again and stops there,
+ * so the reference also stops when it would step back.
+ */
+std::vector<GC_cellInfo> referenceFillGraph(DelaunayGraphCut& delaunayGC, bool fixesSigma, float nPixelSizeBehind,
+                                            bool allPoints, bool behind, bool labatutWeights, bool fillOut,
+                                            float distFcnHeight)
+{
+    using Facet = DelaunayGraphCut::Facet;
+    using CellIndex = DelaunayGraphCut::CellIndex;
+
+    std::vector<GC_cellInfo> cellsAttr(delaunayGC._cellsAttr.size());
+    const int maxint = 1000000;
+    const mvsUtils::MultiViewParams* mp = delaunayGC.mp;
+
+    for(int vertexIndex = 0; vertexIndex < delaunayGC._verticesAttr.size(); ++vertexIndex)
+    {
+        const GC_vertexInfo& v = delaunayGC._verticesAttr[vertexIndex];
+        if(!(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0)))
+            continue;
+
+        for(int c = 0; c < v.cams.size(); ++c)
+        {
+            const int cam = v.cams[c];
+            const float weight = delaunayGC.weightFcn((float)v.nrc, labatutWeights, v.getNbCameras());
+
+            const Point3d& po = delaunayGC._verticesCoords[vertexIndex];
+            float maxDist = nPixelSizeBehind * mp->getCamPixelSize(po, cam);
+            if(fixesSigma)
+                maxDist = nPixelSizeBehind;
+
+            if(fillOut)
+            {
+                CellIndex ci = delaunayGC.getFacetInFrontVertexOnTheRayToTheCam(vertexIndex, cam).cellIndex;
+                Point3d p = po;
+                CellIndex lastFinite = GEO::NO_CELL;
+                CellIndex previousCell = GEO::NO_CELL;
+                bool ok = ci != GEO::NO_CELL;
+                while(ok)
+                {
+                    cellsAttr[ci].out += weight;
+
+                    Point3d pold = p;
+                    Facet f1, f2;
+                    Point3d lpi;
+                    if(!delaunayGC.nearestNeighCellToTheCamOnTheRay(mp->CArr[cam], p, ci, f1, f2, lpi) ||
+                       (previousCell != GEO::NO_CELL && f2.cellIndex == previousCell))
+                    {
+                        ok = false;
+                    }
+                    else
+                    {
+                        previousCell = ci;
+                        const float dist = delaunayGC.distFcn(maxDist, (po - pold).size(), distFcnHeight);
+                        cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
+                        if(f2.cellIndex == GEO::NO_CELL)
+                            ok = false;
+                        ci = f2.cellIndex;
+                        lastFinite = f2.cellIndex;
+                    }
+                }
+                if(lastFinite != GEO::NO_CELL)
+                    cellsAttr[lastFinite].cellSWeight = (float)maxint;
+            }
+
+            {
+                Facet f1 = delaunayGC.getFacetBehindVertexOnTheRayToTheCam(vertexIndex, cam);
+                Facet f2;
+                CellIndex ci = f1.cellIndex;
+                if(ci != GEO::NO_CELL)
+                    cellsAttr[ci].on += weight;
+
+                Point3d p = po;
+                CellIndex previousCell = GEO::NO_CELL;
+                bool ok = (ci != GEO::NO_CELL) && allPoints;
+                while(ok)
+                {
+                    if(behind)
+                        cellsAttr[ci].cellTWeight += weight;
+                    cellsAttr[ci].in += weight;
+
+                    Point3d pold = p;
+                    Point3d lpi;
+                    if((!delaunayGC.farestNeighCellToTheCamOnTheRay(delaunayGC.mp->CArr[cam], p, ci, f1, f2, lpi)) ||
+                       ((po - pold).size() >= maxDist) || (!allPoints) ||
+                       (previousCell != GEO::NO_CELL && f2.cellIndex == previousCell))
+                    {
+                        ok = false;
+                    }
+                    else
+                    {
+                        previousCell = ci;
+                        const float dist = delaunayGC.distFcn(maxDist, (po - pold).size(), distFcnHeight);
+                        if(f2.cellIndex == GEO::NO_CELL)
+                            ok = false;
+                        else
+                            cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                        ci = f2.cellIndex;
+                    }
+                }
+
+                if(!behind && ci != GEO::NO_CELL)
+                    cellsAttr[ci].cellTWeight += weight;
+            }
+        }
+    }
+    return cellsAttr;
+}
+
+void checkCloseWeight(float value, float reference)
+{
+    // the weights are accumulated in a different order
+    BOOST_CHECK_SMALL(value - reference, 1e-4f * std::max(1.0f, std::abs(reference)));
+}
+
+void checkCellsAttr(const std::vector<GC_cellInfo>& cellsAttr, const std::vector<GC_cellInfo>& reference)
+{
+    BOOST_REQUIRE_EQUAL(cellsAttr.size(), reference.size());
+    for(std::size_t ci = 0; ci < reference.size(); ++ci)
+    {
+        BOOST_CHECK_EQUAL(cellsAttr[ci].cellSWeight, reference[ci].cellSWeight);
+        checkCloseWeight(cellsAttr[ci].cellTWeight, reference[ci].cellTWeight);
+        checkCloseWeight(cellsAttr[ci].in, reference[ci].in);
+        checkCloseWeight(cellsAttr[ci].out, reference[ci].out);
+        checkCloseWeight(cellsAttr[ci].on, reference[ci].on);
+        for(int s = 0; s < 4; ++s)
+            checkCloseWeight(cellsAttr[ci].gEdgeVisWeight[s], reference[ci].gEdgeVisWeight[s]);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(delaunayGraphCut_fillGraph)
+{
+    const sfmData::SfMData sfmData;
+    mvsUtils::MultiViewParams mp(sfmData);
+    addCameras(mp, {Point3d(0.0, 0.0, -6.0), Point3d(3.0, 1.0, -5.0), Point3d(-2.5, -2.0, -5.5)});
+
+    DelaunayGraphCut delaunayGC(&mp);
+    addVertices(delaunayGC, 300, mp.ncams);
+    delaunayGC.computeDelaunay();
+    BOOST_REQUIRE(delaunayGC._cellsAttr.size() > 0);
+
+    const int maxNbThreads = std::max(2, omp_get_num_procs());
+
+    // fixesSigma, nPixelSizeBehind, allPoints, behind, labatutWeights, fillOut, distFcnHeight
+    // as in createGraphCut and with the options that change the walks
+    for(const bool behind : {false, true})
+    {
+        for(const float distFcnHeight : {0.0f, 0.5f})
+        {
+            const float nPixelSizeBehind = 0.3f;
+            const std::vector<GC_cellInfo> reference =
+                referenceFillGraph(delaunayGC, true, nPixelSizeBehind, true, behind, false, true, distFcnHeight);
+
+            // 1 thread, several threads with per thread weights and several threads with atomic updates
+            for(const double maxThreadsCellsMemRatio : {0.5, 0.0})
+            {
+                mp.userParams.put("delaunaycut.fillGraphMaxThreadsCellsMemRatio", maxThreadsCellsMemRatio);
+                for(const int nbThreads : {1, maxNbThreads})
+                {
+                    omp_set_num_threads(nbThreads);
+                    delaunayGC.fillGraph(true, nPixelSizeBehind, true, behind, false, true, distFcnHeight);
+                    checkCellsAttr(delaunayGC._cellsAttr, reference);
+                }
+            }
+        }
+    }
+    omp_set_num_threads(omp_get_num_procs());
+
+    // the rays crossed the tetrahedralization in front of and behind the vertices
+    const auto isCrossed = [](const GC_cellInfo& c) { return c.out > 0.0f && c.in > 0.0f; };
+    BOOST_CHECK(std::any_of(delaunayGC._cellsAttr.begin(), delaunayGC._cellsAttr.end(), isCrossed));
+}
@@ -192,46 +192,81 @@ bool CCTagLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sfm_
   return true;
 }
 
-bool CCTagLocalizer::localize(const image::Image<float> & imageGrey,
-                              const LocalizerParameters *parameters,
-                              bool useInputIntrinsics,
-                              camera::PinholeRadialK3 &queryIntrinsics,
-                              LocalizationResult & localizationResult, 
-                              const std::string& imagePath)
+std::vector<std::unique_ptr<feature::ImageDescriber>> CCTagLocalizer::createImageDescribers() const
+{
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  imageDescribers.push_back(std::unique_ptr<feature::ImageDescriber>(new feature::ImageDescriber_CCTAG()));
+  return imageDescribers;
+}
+
+void CCTagLocalizer::extractFeatures(const image::Image<float> & imageGrey,
+                                     const LocalizerParameters *parameters,
+                                     const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                     feature::MapRegionsPerDesc &queryRegions,
+                                     const std::string& imagePath) const
 {
-  namespace bfs = boost::filesystem;
-  
   const CCTagLocalizer::Parameters *param = static_cast<const CCTagLocalizer::Parameters *>(parameters);
   if(!param)
   {
     throw std::invalid_argument("The CCTag localizer parameters are not in the right format.");
   }
+  if(imageDescribers.size() != 1)
+  {
+    throw std::invalid_argument("The CCTag localizer expects a single CCTag image describer.");
+  }
+  extractFeatures(imageGrey, *param, *imageDescribers.front(), queryRegions, imagePath);
+}
+
+void CCTagLocalizer::extractFeatures(const image::Image<float> & imageGrey,
+                                     const Parameters &param,
+                                     feature::ImageDescriber &imageDescriber,
+                                     feature::MapRegionsPerDesc &queryRegions,
+                                     const std::string& imagePath) const
+{
+  namespace bfs = boost::filesystem;
+
   // extract descriptors and features from image
   ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image");
 
   image::Image<unsigned char> imageGrayUChar; // cctag image describer don't support float image
   imageGrayUChar = (imageGrey.GetMat() * 255.f).cast<unsigned char>();
 
-  feature::MapRegionsPerDesc tmpQueryRegions;
+  imageDescriber.setCudaPipe( _cudaPipe );
+  imageDescriber.setConfigurationPreset(param._featurePreset);
+  imageDescriber.describe(imageGrayUChar, queryRegions[_cctagDescType]);
+  ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " << queryRegions.at(_cctagDescType)->RegionCount() << " features");
 
-  _imageDescriber.setCudaPipe( _cudaPipe );
-  _imageDescriber.setConfigurationPreset(param->_featurePreset);
-  _imageDescriber.describe(imageGrayUChar, tmpQueryRegions[_cctagDescType]);
-  ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " << tmpQueryRegions.at(_cctagDescType)->RegionCount() << " features");
-  
-  std::pair<std::size_t, std::size_t> imageSize = std::make_pair(imageGrey.Width(),imageGrey.Height());
-  
-  if(!param->_visualDebug.empty() && !imagePath.empty())
+  if(!param._visualDebug.empty() && !imagePath.empty())
   {
     // it automatically throws an exception if the cast does not work
-    const feature::CCTAG_Regions & cctagQueryRegions = tmpQueryRegions.getRegions<feature::CCTAG_Regions>(_cctagDescType);
-    
+    const feature::CCTAG_Regions & cctagQueryRegions = queryRegions.getRegions<feature::CCTAG_Regions>(_cctagDescType);
+
     // just debugging -- save the svg image with detected cctag
-    feature::saveCCTag2SVG(imagePath, 
-                            imageSize, 
+    feature::saveCCTag2SVG(imagePath,
+                            std::make_pair(imageGrey.Width(), imageGrey.Height()),
                             cctagQueryRegions,
-                            param->_visualDebug+"/"+bfs::path(imagePath).stem().string()+".svg");
+                            param._visualDebug+"/"+bfs::path(imagePath).stem().string()+".svg");
+  }
+}
+
+bool CCTagLocalizer::localize(const image::Image<float> & imageGrey,
+                              const LocalizerParameters *parameters,
+                              bool useInputIntrinsics,
+                              camera::PinholeRadialK3 &queryIntrinsics,
+                              LocalizationResult & localizationResult, 
+                              const std::string& imagePath)
+{
+  const CCTagLocalizer::Parameters *param = static_cast<const CCTagLocalizer::Parameters *>(parameters);
+  if(!param)
+  {
+    throw std::invalid_argument("The CCTag localizer parameters are not in the right format.");
   }
+
+  feature::MapRegionsPerDesc tmpQueryRegions;
+  extractFeatures(imageGrey, *param, _imageDescriber, tmpQueryRegions, imagePath);
+
+  std::pair<std::size_t, std::size_t> imageSize = std::make_pair(imageGrey.Width(),imageGrey.Height());
+
   return localize(tmpQueryRegions,
                   imageSize,
                   parameters,
@@ -254,14 +289,22 @@ bool CCTagLocalizer::localize(const feature::MapRegionsPerDesc & genQueryRegions
                               LocalizationResult & localizationResult,
                               const std::string& imagePath)
 {
-  namespace bfs = boost::filesystem;
-
   const CCTagLocalizer::Parameters *param = dynamic_cast<const CCTagLocalizer::Parameters *>(parameters);
   if(!param)
   {
     throw std::invalid_argument("The CCTag localizer parameters are not in the right format.");
   }
-  
+  return localizeQuery(genQueryRegions, imageSize, *param, useInputIntrinsics, queryIntrinsics, localizationResult, imagePath);
+}
+
+bool CCTagLocalizer::localizeQuery(const feature::MapRegionsPerDesc & genQueryRegions,
+                                   const std::pair<std::size_t, std::size_t> &imageSize,
+                                   const CCTagLocalizer::Parameters &param,
+                                   bool useInputIntrinsics,
+                                   camera::PinholeRadialK3 &queryIntrinsics,
+                                   LocalizationResult & localizationResult,
+                                   const std::string& imagePath) const
+{
   // it automatically throws an exception if the cast does not work
   const feature::CCTAG_Regions &queryRegions = genQueryRegions.getRegions<feature::CCTAG_Regions>(_cctagDescType);
   
@@ -273,7 +316,7 @@ bool CCTagLocalizer::localize(const feature::MapRegionsPerDesc & genQueryRegions
 
   std::vector<voctree::DocMatch> matchedImages;
   system::Timer timer;
-  getAllAssociations(queryRegions, imageSize, *param, occurences, resectionData.pt2D, resectionData.pt3D, matchedImages, imagePath);
+  getAllAssociations(queryRegions, imageSize, param, occurences, resectionData.pt2D, resectionData.pt3D, matchedImages, imagePath);
   
   resectionData.vec_descType.resize(resectionData.pt2D.cols(), _cctagDescType);
   ALICEVISION_LOG_DEBUG("[Matching]\tRetrieving associations took " << timer.elapsedMs() << "ms");
@@ -298,19 +341,19 @@ bool CCTagLocalizer::localize(const feature::MapRegionsPerDesc & genQueryRegions
   
   timer.reset();
   // estimate the pose
-  resectionData.error_max = param->_errorMax;
+  resectionData.error_max = param._errorMax;
   ALICEVISION_LOG_DEBUG("[poseEstimation]\tEstimating camera pose...");
   const bool bResection = sfm::SfMLocalizer::Localize(imageSize,
                                                       // pass the input intrinsic if they are valid, null otherwise
                                                       (useInputIntrinsics) ? &queryIntrinsics : nullptr,
                                                       resectionData,
                                                       pose,
-                                                      param->_resectionEstimator);
+                                                      param._resectionEstimator);
   
   if(!bResection)
   {
     ALICEVISION_LOG_DEBUG("[poseEstimation]\tResection failed");
-    if(!param->_visualDebug.empty() && !imagePath.empty())
+    if(!param._visualDebug.empty() && !imagePath.empty())
     {
 //      namespace bfs = boost::filesystem;
 //      feature::saveFeatures2SVG(imagePath,
@@ -350,11 +393,11 @@ bool CCTagLocalizer::localize(const feature::MapRegionsPerDesc & genQueryRegions
                                                             pose,
                                                             resectionData,
                                                             b_refine_pose,
-                                                            param->_refineIntrinsics);
+                                                            param._refineIntrinsics);
   if(!refineStatus)
     ALICEVISION_LOG_DEBUG("Refine pose failed.");
 
-  if(!param->_visualDebug.empty() && !imagePath.empty())
+  if(!param._visualDebug.empty() && !imagePath.empty())
   {
     //@todo save image with cctag with different code color for inliers
   }
@@ -405,21 +448,24 @@ bool CCTagLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_im
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
-  
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
+
+  // extract the cctags of the cameras concurrently, each camera uses its own
+  // image describer. A CUDA pipe cannot be shared, so it stays sequential with CUDA.
+  const bool useCuda = _imageDescriber.useCuda();
+  if(!useCuda)
   {
-    image::Image<unsigned char> imageGrayUChar; // cctag image describer don't support float image
-    imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
+    while(_rigImageDescribers.size() < numCams)
+      _rigImageDescribers.emplace_back(new feature::ImageDescriber_CCTAG());
+  }
 
-    // extract descriptors and features from each image
-    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image...");
-    _imageDescriber.setConfigurationPreset(param->_featurePreset);
-    _imageDescriber.describe(imageGrayUChar, vec_queryRegions[i][_imageDescriber.getDescriberType()]);
-    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " <<  vec_queryRegions[i].at(_imageDescriber.getDescriberType())->RegionCount() << " features");
+  #pragma omp parallel for if(!useCuda)
+  for(int i = 0; i < numCams; ++i)
+  {
+    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image of camera " << i << "...");
+    extractFeatures(vec_imageGrey[i], *param, useCuda ? _imageDescriber : *_rigImageDescribers[i], vec_queryRegions[i], std::string());
     // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+    vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
   }
   assert(vec_imageSize.size() == vec_queryRegions.size());
           
@@ -497,10 +543,10 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
   std::vector<Mat> vec_pts2D(numCams);
   std::vector<std::vector<voctree::DocMatch> > vec_matchedImages(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for( size_t i = 0; i < numCams; ++i )
+  // for each camera retrieve the associations,
+  // the cameras are matched concurrently against the database
+  #pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
     // this map is used to collect the 2d-3d associations as we go through the images
     // the key is a pair <Id3D, Id2d>
@@ -511,8 +557,11 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
     Mat &pts2D = vec_pts2D[i];
     const feature::CCTAG_Regions &queryRegions = vec_queryRegions[i].getRegions<feature::CCTAG_Regions>(_cctagDescType);
     getAllAssociations(queryRegions, imageSize[i],*param, occurrences, pts2D, pts3D, matchedImages);
-    numAssociations += occurrences.size();
   }
+
+  std::size_t numAssociations = 0;
+  for(const auto& occurrences : vec_occurrences)
+    numAssociations += occurrences.size();
   
   // @todo Here it could be possible to filter the associations according to their
   // occurrences, eg giving priority to those associations that are more frequent
@@ -676,12 +725,16 @@ bool CCTagLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPerD
 
   vec_localizationResults.resize(numCams);
     
-  // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // this is basic, just localize each camera alone, the cameras are localized concurrently
+  std::vector<char> isLocalized(numCams, false);
+  #pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
+  {
+    isLocalized[i] = localizeQuery(vec_queryRegions[i], imageSize[i], *param, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i], std::string());
+  }
+
+  for(std::size_t i = 0; i < numCams; ++i)
   {
-    isLocalized[i] = localize(vec_queryRegions[i], imageSize[i], param, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     if(!isLocalized[i])
     {
       ALICEVISION_CERR("Could not localize camera " << i);
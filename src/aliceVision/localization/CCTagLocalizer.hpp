@@ -18,6 +18,8 @@
 #include <aliceVision/voctree/Database.hpp>
 
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <bitset>
 
 namespace aliceVision {
@@ -47,6 +49,14 @@ public:
    
   void setCudaPipe(int i) override;
 
+  std::vector<std::unique_ptr<feature::ImageDescriber>> createImageDescribers() const override;
+
+  void extractFeatures(const image::Image<float> & imageGrey,
+                       const LocalizerParameters *parameters,
+                       const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                       feature::MapRegionsPerDesc &queryRegions,
+                       const std::string& imagePath = std::string()) const override;
+
  /**
    * @brief Just a wrapper around the different localization algorithm, the algorith
    * used to localized is chosen using \p param._algorithm
@@ -149,7 +159,29 @@ public:
   virtual ~CCTagLocalizer();
 
 private:
+
+  /**
+   * @brief Extract the CCTags of a query image with the given extractor.
+   */
+  void extractFeatures(const image::Image<float> & imageGrey,
+                       const Parameters &param,
+                       feature::ImageDescriber &imageDescriber,
+                       feature::MapRegionsPerDesc &queryRegions,
+                       const std::string& imagePath) const;
   
+  /**
+   * @brief Localize a query image from its regions. It does not modify the localizer,
+   * so that the cameras of a rig can be localized concurrently.
+   * @see localize
+   */
+  bool localizeQuery(const feature::MapRegionsPerDesc &queryRegions,
+                     const std::pair<std::size_t, std::size_t> &imageSize,
+                     const CCTagLocalizer::Parameters &param,
+                     bool useInputIntrinsics,
+                     camera::PinholeRadialK3 &queryIntrinsics,
+                     LocalizationResult & localizationResult,
+                     const std::string& imagePath) const;
+
   bool loadReconstructionDescriptors(
     const sfmData::SfMData & sfm_data,
     const std::string & feat_directory);
@@ -161,6 +193,8 @@ private:
 
   // the feature extractor
   feature::ImageDescriber_CCTAG _imageDescriber;
+  // the feature extractors of each camera of a rig, created once to extract the cameras concurrently
+  std::vector<std::unique_ptr<feature::ImageDescriber_CCTAG>> _rigImageDescribers;
   /// @warning: descType needs to be a CCTAG_Regions
   feature::EImageDescriberType _cctagDescType = feature::EImageDescriberType::CCTAG3;
 
@@ -13,6 +13,10 @@
 #include <aliceVision/robustEstimation/estimators.hpp>
 #include <aliceVision/localization/LocalizationResult.hpp>
 
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace aliceVision {
 namespace localization {
 
@@ -68,6 +72,29 @@ public:
     bool isInit() const {return _isInit;}
     
     const sfmData::SfMData& getSfMData() const {return _sfm_data; }
+
+  /**
+   * @brief Create a new set of the feature extractors used for the query images.
+   * Each thread extracting features concurrently needs its own extractors.
+   * @return the feature extractors, one per describer type
+   */
+  virtual std::vector<std::unique_ptr<feature::ImageDescriber>> createImageDescribers() const = 0;
+
+  /**
+   * @brief Extract the features of a query image, independently of the localization
+   * so that it can run concurrently on several frames.
+   *
+   * @param[in] imageGrey The input greyscale image.
+   * @param[in] param The parameters for the localization.
+   * @param[in] imageDescribers The feature extractors, created by createImageDescribers().
+   * @param[out] queryRegions The features of the query image for each describer type.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   */
+  virtual void extractFeatures(const image::Image<float> & imageGrey,
+                               const LocalizerParameters *param,
+                               const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                               feature::MapRegionsPerDesc &queryRegions,
+                               const std::string& imagePath = std::string()) const = 0;
     
     /**
    * @brief Localize one image
@@ -0,0 +1,377 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LandmarksIndex.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <typeinfo>
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+/// Magic number and version of the landmarks index format
+const char indexMagic[4] = {'A', 'V', 'L', 'I'};
+const std::uint32_t indexVersion = 2;
+
+/// Number of nearest descriptors retrieved for each query feature, so that the
+/// ratio test is done against the nearest descriptor of another landmark
+const std::size_t nbNeighbours = 4;
+
+void writeData(std::FILE* file, const void* data, std::size_t size)
+{
+  if(size > 0 && std::fwrite(data, 1, size, file) != size)
+    throw std::runtime_error("Cannot write the landmarks index.");
+}
+
+void readData(std::FILE* file, void* data, std::size_t size)
+{
+  if(size > 0 && std::fread(data, 1, size, file) != size)
+    throw std::runtime_error("Unexpected end of the landmarks index.");
+}
+
+template<typename T>
+void write(std::FILE* file, const T& value)
+{
+  writeData(file, &value, sizeof(T));
+}
+
+template<typename T>
+T read(std::FILE* file)
+{
+  T value;
+  readData(file, &value, sizeof(T));
+  return value;
+}
+
+void writeString(std::FILE* file, const std::string& str)
+{
+  write<std::uint32_t>(file, str.size());
+  writeData(file, str.data(), str.size());
+}
+
+std::string readString(std::FILE* file)
+{
+  std::string str(read<std::uint32_t>(file), '\0');
+  readData(file, &str[0], str.size());
+  return str;
+}
+
+/**
+ * @brief Append the descriptors of scalar regions to a float array.
+ * @return false if the descriptor type is not supported
+ */
+bool appendDescriptors(const feature::Regions& regions, std::vector<float>& descriptors)
+{
+  if(!regions.IsScalar())
+    return false;
+
+  const std::size_t nbValues = regions.RegionCount() * regions.DescriptorLength();
+  if(nbValues == 0)
+    return true;
+
+  const std::size_t offset = descriptors.size();
+  descriptors.resize(offset + nbValues);
+
+  if(regions.Type_id() == typeid(unsigned char).name())
+  {
+    const unsigned char* data = static_cast<const unsigned char*>(regions.DescriptorRawData());
+    std::copy(data, data + nbValues, descriptors.begin() + offset);
+  }
+  else if(regions.Type_id() == typeid(float).name())
+  {
+    const float* data = static_cast<const float*>(regions.DescriptorRawData());
+    std::copy(data, data + nbValues, descriptors.begin() + offset);
+  }
+  else if(regions.Type_id() == typeid(double).name())
+  {
+    const double* data = static_cast<const double*>(regions.DescriptorRawData());
+    std::copy(data, data + nbValues, descriptors.begin() + offset);
+  }
+  else
+  {
+    descriptors.resize(offset);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+void LandmarksIndex::build(const feature::RegionsPerView& regionsPerView,
+                           const ReconstructedRegionsMappingPerView& mappingPerView,
+                           int nbTrees)
+{
+  _indexPerDesc.clear();
+
+  for(const auto& regionsPerDesc : regionsPerView.getData())
+  {
+    const ReconstructedRegionsMappingPerDesc& mappingPerDesc = mappingPerView.at(regionsPerDesc.first);
+
+    for(const auto& regionsIt : regionsPerDesc.second)
+    {
+      const feature::Regions& regions = *regionsIt.second;
+      DescTypeIndex& descIndex = _indexPerDesc[regionsIt.first];
+
+      if(!appendDescriptors(regions, descIndex.descriptors))
+      {
+        ALICEVISION_LOG_WARNING("The landmarks index does not support the describer type "
+                                << feature::EImageDescriberType_enumToString(regionsIt.first) << ".");
+        _indexPerDesc.erase(regionsIt.first);
+        continue;
+      }
+      const std::vector<IndexT>& associated3dPoint = mappingPerDesc.at(regionsIt.first)._associated3dPoint;
+      descIndex.dimension = regions.DescriptorLength();
+      descIndex.landmarkIds.insert(descIndex.landmarkIds.end(), associated3dPoint.begin(), associated3dPoint.end());
+    }
+  }
+
+  for(auto it = _indexPerDesc.begin(); it != _indexPerDesc.end();)
+  {
+    DescTypeIndex& descIndex = it->second;
+    if(descIndex.landmarkIds.empty())
+    {
+      it = _indexPerDesc.erase(it);
+      continue;
+    }
+    const flann::Matrix<float> dataset(descIndex.descriptors.data(), descIndex.landmarkIds.size(), descIndex.dimension);
+    descIndex.index.reset(new KDTreeIndex(dataset, flann::KDTreeIndexParams(nbTrees)));
+    descIndex.index->buildIndex();
+
+    ALICEVISION_LOG_DEBUG("[landmarksIndex]\t" << descIndex.landmarkIds.size() << " "
+                          << feature::EImageDescriberType_enumToString(it->first) << " descriptors indexed");
+    ++it;
+  }
+}
+
+bool LandmarksIndex::save(const std::string& filepath, std::uint64_t fingerprint) const
+{
+  namespace bfs = boost::filesystem;
+
+  // write in a temporary file, renamed once complete
+  const bfs::path tmpFilepath = bfs::path(filepath).parent_path() / bfs::unique_path(bfs::path(filepath).filename().string() + ".%%%%-%%%%.tmp");
+
+  std::FILE* file = std::fopen(tmpFilepath.string().c_str(), "wb");
+  if(file == nullptr)
+  {
+    ALICEVISION_LOG_ERROR("Unable to write the landmarks index: " << tmpFilepath.string());
+    return false;
+  }
+
+  try
+  {
+    writeData(file, indexMagic, sizeof(indexMagic));
+    write<std::uint32_t>(file, indexVersion);
+    write<std::uint64_t>(file, fingerprint);
+    write<std::uint32_t>(file, _indexPerDesc.size());
+
+    for(const auto& descIndexIt : _indexPerDesc)
+    {
+      const DescTypeIndex& descIndex = descIndexIt.second;
+      writeString(file, feature::EImageDescriberType_enumToString(descIndexIt.first));
+      write<std::uint64_t>(file, descIndex.landmarkIds.size());
+      write<std::uint64_t>(file, descIndex.dimension);
+      writeData(file, descIndex.descriptors.data(), descIndex.descriptors.size() * sizeof(float));
+      writeData(file, descIndex.landmarkIds.data(), descIndex.landmarkIds.size() * sizeof(IndexT));
+    }
+
+    // the kd-trees are written last, FLANN reads them sequentially from the file
+    for(const auto& descIndexIt : _indexPerDesc)
+      descIndexIt.second.index->saveIndex(file);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Error while writing the landmarks index '" << tmpFilepath.string() << "': " << e.what());
+    std::fclose(file);
+    bfs::remove(tmpFilepath);
+    return false;
+  }
+
+  if(std::fclose(file) != 0)
+  {
+    ALICEVISION_LOG_ERROR("Error while writing the landmarks index: " << tmpFilepath.string());
+    bfs::remove(tmpFilepath);
+    return false;
+  }
+
+  boost::system::error_code ec;
+  bfs::rename(tmpFilepath, filepath, ec);
+  if(ec)
+  {
+    ALICEVISION_LOG_ERROR("Unable to rename the landmarks index to " << filepath << ": " << ec.message());
+    bfs::remove(tmpFilepath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool LandmarksIndex::load(const std::string& filepath,
+                          const sfmData::SfMData& sfmData,
+                          std::uint64_t fingerprint,
+                          const std::vector<feature::EImageDescriberType>& descTypes)
+{
+  std::FILE* file = std::fopen(filepath.c_str(), "rb");
+  if(file == nullptr)
+  {
+    ALICEVISION_LOG_WARNING("Cannot open the landmarks index: " << filepath);
+    return false;
+  }
+
+  std::map<feature::EImageDescriberType, DescTypeIndex> indexPerDesc;
+
+  try
+  {
+    char magic[4];
+    readData(file, magic, sizeof(magic));
+    if(std::memcmp(magic, indexMagic, sizeof(indexMagic)) != 0)
+      throw std::runtime_error("Not a landmarks index.");
+    const std::uint32_t version = read<std::uint32_t>(file);
+    if(version != indexVersion)
+      throw std::runtime_error("Unsupported landmarks index version: " + std::to_string(version) + ".");
+    if(read<std::uint64_t>(file) != fingerprint)
+      throw std::runtime_error("The landmarks index has been built from another reconstruction or other features.");
+
+    const std::uint32_t nbDescTypes = read<std::uint32_t>(file);
+    std::vector<feature::EImageDescriberType> indexDescTypes;
+    for(std::uint32_t i = 0; i < nbDescTypes; ++i)
+    {
+      const feature::EImageDescriberType descType = feature::EImageDescriberType_stringToEnum(readString(file));
+      if(std::find(descTypes.begin(), descTypes.end(), descType) == descTypes.end())
+        throw std::runtime_error("The landmarks index has been built with other describer types.");
+      indexDescTypes.push_back(descType);
+
+      DescTypeIndex& descIndex = indexPerDesc[descType];
+      const std::size_t nbDescriptors = read<std::uint64_t>(file);
+      descIndex.dimension = read<std::uint64_t>(file);
+      descIndex.descriptors.resize(nbDescriptors * descIndex.dimension);
+      descIndex.landmarkIds.resize(nbDescriptors);
+      readData(file, descIndex.descriptors.data(), descIndex.descriptors.size() * sizeof(float));
+      readData(file, descIndex.landmarkIds.data(), descIndex.landmarkIds.size() * sizeof(IndexT));
+
+      for(const IndexT landmarkId : descIndex.landmarkIds)
+      {
+        if(sfmData.getLandmarks().count(landmarkId) == 0)
+          throw std::runtime_error("The landmark " + std::to_string(landmarkId) + " of the landmarks index is not in the reconstruction.");
+      }
+    }
+
+    for(const feature::EImageDescriberType descType : indexDescTypes)
+    {
+      DescTypeIndex& descIndex = indexPerDesc.at(descType);
+      const flann::Matrix<float> dataset(descIndex.descriptors.data(), descIndex.landmarkIds.size(), descIndex.dimension);
+      descIndex.index.reset(new KDTreeIndex(dataset));
+      descIndex.index->loadIndex(file);
+    }
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Cannot load the landmarks index '" << filepath << "': " << e.what());
+    std::fclose(file);
+    return false;
+  }
+
+  std::fclose(file);
+  _indexPerDesc = std::move(indexPerDesc);
+  return true;
+}
+
+void LandmarksIndex::match(const feature::MapRegionsPerDesc& queryRegions,
+                           float distRatio,
+                           int nbChecks,
+                           std::vector<IndMatch3D2D>& out_matches) const
+{
+  out_matches.clear();
+
+  // the distances are squared L2 distances
+  const float sqDistRatio = distRatio * distRatio;
+
+  for(const auto& descIndexIt : _indexPerDesc)
+  {
+    const feature::EImageDescriberType descType = descIndexIt.first;
+    const DescTypeIndex& descIndex = descIndexIt.second;
+
+    const auto queryRegionsIt = queryRegions.find(descType);
+    if(queryRegionsIt == queryRegions.end() || queryRegionsIt->second->RegionCount() == 0)
+      continue;
+
+    const feature::Regions& regions = *queryRegionsIt->second;
+    std::vector<float> queries;
+    if(regions.DescriptorLength() != descIndex.dimension || !appendDescriptors(regions, queries))
+    {
+      ALICEVISION_LOG_WARNING("[landmarksIndex]\tThe " << feature::EImageDescriberType_enumToString(descType)
+                              << " query descriptors do not match the landmarks index.");
+      continue;
+    }
+
+    const std::size_t nbQueries = regions.RegionCount();
+    const std::size_t knn = std::min(nbNeighbours, descIndex.landmarkIds.size());
+
+    std::vector<std::size_t> indices(nbQueries * knn);
+    std::vector<float> distances(nbQueries * knn);
+    const flann::Matrix<float> queriesMatrix(queries.data(), nbQueries, descIndex.dimension);
+    flann::Matrix<std::size_t> indicesMatrix(indices.data(), nbQueries, knn);
+    flann::Matrix<float> distancesMatrix(distances.data(), nbQueries, knn);
+
+    // prioritized search: at most nbChecks leaves are visited for each query
+    flann::SearchParams params(nbChecks);
+    params.cores = omp_get_max_threads();
+    descIndex.index->knnSearch(queriesMatrix, indicesMatrix, distancesMatrix, knn, params);
+
+    // keep the best query feature for each landmark
+    std::map<IndexT, std::pair<float, IndexT>> bestPerLandmark;
+
+    for(std::size_t i = 0; i < nbQueries; ++i)
+    {
+      const std::size_t* neighbours = &indices[i * knn];
+      const float* neighbourDistances = &distances[i * knn];
+      const IndexT landmarkId = descIndex.landmarkIds[neighbours[0]];
+
+      // ratio test against the nearest descriptor of another landmark,
+      // if all the neighbours belong to the same landmark the match is not ambiguous
+      bool ambiguous = false;
+      for(std::size_t j = 1; j < knn; ++j)
+      {
+        if(descIndex.landmarkIds[neighbours[j]] != landmarkId)
+        {
+          ambiguous = (neighbourDistances[0] >= sqDistRatio * neighbourDistances[j]);
+          break;
+        }
+      }
+      if(ambiguous)
+        continue;
+
+      const auto best = bestPerLandmark.emplace(landmarkId, std::make_pair(neighbourDistances[0], static_cast<IndexT>(i)));
+      if(!best.second && neighbourDistances[0] < best.first->second.first)
+        best.first->second = std::make_pair(neighbourDistances[0], static_cast<IndexT>(i));
+    }
+
+    for(const auto& best : bestPerLandmark)
+      out_matches.emplace_back(best.first, descType, best.second.second);
+
+    ALICEVISION_LOG_DEBUG("[landmarksIndex]\tFound " << bestPerLandmark.size() << " "
+                          << feature::EImageDescriberType_enumToString(descType) << " 2D-3D matches");
+  }
+}
+
+std::size_t LandmarksIndex::size() const
+{
+  std::size_t size = 0;
+  for(const auto& descIndex : _indexPerDesc)
+    size += descIndex.second.landmarkIds.size();
+  return size;
+}
+
+} // namespace localization
+} // namespace aliceVision
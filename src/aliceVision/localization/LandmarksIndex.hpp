@@ -0,0 +1,120 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/localization/reconstructed_regions.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+
+#include "flann/flann.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief Approximate nearest neighbour index over the descriptors of the
+ * reconstructed landmarks, for the direct 2D-3D matching of a query image.
+ *
+ * All the descriptors associated to a landmark (one per observation) are indexed
+ * in a FLANN randomized kd-tree forest, one forest per describer type. A query
+ * feature is matched with the landmark of its nearest descriptor if it passes the
+ * ratio test against the nearest descriptor of another landmark.
+ *
+ * Index file:
+ * -- Header
+ * magic "AVLI", version (uint32), fingerprint of the reconstruction (uint64), number of describer types (uint32)
+ * -- For each describer type
+ * describer type (string), number of descriptors (uint64), dimension (uint64)
+ * descriptors [float], landmark ids [uint32]
+ * -- For each describer type
+ * FLANN kd-tree forest (without the dataset)
+ */
+class LandmarksIndex
+{
+public:
+
+  /**
+   * @brief Build the index from the reconstructed regions of the views.
+   * @param[in] regionsPerView The regions of each view that have an associated 3D point
+   * @param[in] mappingPerView The associations of the regions of each view
+   * @param[in] nbTrees The number of randomized kd-trees
+   */
+  void build(const feature::RegionsPerView& regionsPerView,
+             const ReconstructedRegionsMappingPerView& mappingPerView,
+             int nbTrees = 4);
+
+  /**
+   * @brief Save the index.
+   * The file is written next to \p filepath then renamed, so that concurrent
+   * processes never read a partial file.
+   * @param[in] filepath The index file
+   * @param[in] fingerprint The fingerprint of the reconstruction and features the index
+   * is built from, see computeReconstructionFingerprint()
+   * @return true if completed
+   */
+  bool save(const std::string& filepath, std::uint64_t fingerprint) const;
+
+  /**
+   * @brief Load an index saved with save().
+   * The index is rejected if it does not match the fingerprint, the describer
+   * types or the landmarks of the reconstruction.
+   * @param[in] filepath The index file
+   * @param[in] sfmData The reconstruction
+   * @param[in] fingerprint The fingerprint of the reconstruction and features, see computeReconstructionFingerprint()
+   * @param[in] descTypes The describer types used for matching
+   * @return true if completed
+   */
+  bool load(const std::string& filepath,
+            const sfmData::SfMData& sfmData,
+            std::uint64_t fingerprint,
+            const std::vector<feature::EImageDescriberType>& descTypes);
+
+  /**
+   * @brief Match the features of a query image with the landmarks.
+   * @param[in] queryRegions The regions of the query image
+   * @param[in] distRatio The ratio of the distance to the nearest descriptor of
+   * another landmark a match must pass
+   * @param[in] nbChecks The number of leaves visited by the prioritized search
+   * @param[out] out_matches The 2D-3D matches, at most one per landmark
+   */
+  void match(const feature::MapRegionsPerDesc& queryRegions,
+             float distRatio,
+             int nbChecks,
+             std::vector<IndMatch3D2D>& out_matches) const;
+
+  /// Return true if no descriptor is indexed
+  bool empty() const { return _indexPerDesc.empty(); }
+
+  /// Return the number of indexed descriptors
+  std::size_t size() const;
+
+private:
+
+  using KDTreeIndex = flann::KDTreeIndex<flann::L2<float>>;
+
+  struct DescTypeIndex
+  {
+    std::size_t dimension = 0;
+    /// the descriptors, one row per landmark observation
+    std::vector<float> descriptors;
+    /// the landmark of each row
+    std::vector<IndexT> landmarkIds;
+    std::unique_ptr<KDTreeIndex> index;
+  };
+
+  std::map<feature::EImageDescriberType, DescTypeIndex> _indexPerDesc;
+};
+
+} // namespace localization
+} // namespace aliceVision
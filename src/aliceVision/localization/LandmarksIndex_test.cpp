@@ -0,0 +1,150 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/LandmarksIndex.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE LandmarksIndex
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const std::size_t nbLandmarks = 200;
+const std::size_t nbViews = 3;
+
+using DescriptorT = feature::SIFT_Regions::DescriptorT;
+
+/**
+ * @brief Generate a descriptor per landmark and the reconstructed regions of the views,
+ * each view observes all the landmarks with a noisy descriptor.
+ */
+void generateReconstruction(std::mt19937& generator,
+                            sfmData::SfMData& sfmData,
+                            std::vector<DescriptorT>& landmarkDescriptors,
+                            feature::RegionsPerView& regionsPerView,
+                            localization::ReconstructedRegionsMappingPerView& mappingPerView)
+{
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> noise(-3, 3);
+
+  landmarkDescriptors.resize(nbLandmarks);
+  for(IndexT landmarkId = 0; landmarkId < nbLandmarks; ++landmarkId)
+  {
+    sfmData.structure[landmarkId] = sfmData::Landmark(Vec3::Random(), feature::EImageDescriberType::SIFT);
+    for(std::size_t j = 0; j < DescriptorT::static_size; ++j)
+      landmarkDescriptors[landmarkId][j] = static_cast<unsigned char>(byte(generator));
+  }
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions());
+    localization::ReconstructedRegionsMapping& mapping = mappingPerView[viewId][feature::EImageDescriberType::SIFT];
+    for(IndexT landmarkId = 0; landmarkId < nbLandmarks; ++landmarkId)
+    {
+      DescriptorT descriptor;
+      for(std::size_t j = 0; j < DescriptorT::static_size; ++j)
+        descriptor[j] = static_cast<unsigned char>(std::min(255, std::max(0, landmarkDescriptors[landmarkId][j] + noise(generator))));
+      regions->Features().emplace_back(0.f, 0.f, 1.f, 0.f);
+      regions->Descriptors().push_back(descriptor);
+      mapping._associated3dPoint.push_back(landmarkId);
+    }
+    regionsPerView.addRegions(viewId, feature::EImageDescriberType::SIFT, regions.release());
+  }
+}
+
+/**
+ * @brief Generate a query image observing every other landmark.
+ */
+void generateQuery(std::mt19937& generator,
+                   const std::vector<DescriptorT>& landmarkDescriptors,
+                   feature::MapRegionsPerDesc& queryRegions)
+{
+  std::uniform_int_distribution<int> noise(-3, 3);
+  std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions());
+  for(IndexT landmarkId = 0; landmarkId < nbLandmarks; landmarkId += 2)
+  {
+    DescriptorT descriptor;
+    for(std::size_t j = 0; j < DescriptorT::static_size; ++j)
+      descriptor[j] = static_cast<unsigned char>(std::min(255, std::max(0, landmarkDescriptors[landmarkId][j] + noise(generator))));
+    regions->Features().emplace_back(0.f, 0.f, 1.f, 0.f);
+    regions->Descriptors().push_back(descriptor);
+  }
+  queryRegions[feature::EImageDescriberType::SIFT].reset(regions.release());
+}
+
+void checkMatches(const std::vector<localization::IndMatch3D2D>& matches)
+{
+  BOOST_CHECK_EQUAL(matches.size(), nbLandmarks / 2);
+  for(const localization::IndMatch3D2D& match : matches)
+  {
+    // the query feature i observes the landmark 2i
+    BOOST_CHECK_EQUAL(match.landmarkId, 2 * match.featId);
+    BOOST_CHECK(match.descType == feature::EImageDescriberType::SIFT);
+  }
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Index the descriptors of the landmarks observed in several views
+// - Assert that the features of a query image are matched with their landmark
+// - Save and load the index, assert that the matches are the same
+//-----------------
+BOOST_AUTO_TEST_CASE(LandmarksIndex_match)
+{
+  std::mt19937 generator(42);
+  sfmData::SfMData sfmData;
+  std::vector<DescriptorT> landmarkDescriptors;
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+  generateReconstruction(generator, sfmData, landmarkDescriptors, regionsPerView, mappingPerView);
+
+  localization::LandmarksIndex index;
+  index.build(regionsPerView, mappingPerView);
+  BOOST_CHECK_EQUAL(index.size(), nbLandmarks * nbViews);
+
+  feature::MapRegionsPerDesc queryRegions;
+  generateQuery(generator, landmarkDescriptors, queryRegions);
+
+  std::vector<localization::IndMatch3D2D> matches;
+  index.match(queryRegions, 0.8f, 256, matches);
+  checkMatches(matches);
+
+  const std::string filepath = (bfs::temp_directory_path() / bfs::unique_path("landmarksIndex_%%%%-%%%%.avli")).string();
+  const std::uint64_t fingerprint = 42;
+  BOOST_REQUIRE(index.save(filepath, fingerprint));
+
+  localization::LandmarksIndex loadedIndex;
+  BOOST_REQUIRE(loadedIndex.load(filepath, sfmData, fingerprint, {feature::EImageDescriberType::SIFT}));
+  BOOST_CHECK_EQUAL(loadedIndex.size(), index.size());
+
+  std::vector<localization::IndMatch3D2D> loadedMatches;
+  loadedIndex.match(queryRegions, 0.8f, 256, loadedMatches);
+  checkMatches(loadedMatches);
+
+  // the index does not match another reconstruction or features with the same landmark ids
+  localization::LandmarksIndex rejectedIndex;
+  BOOST_CHECK(!rejectedIndex.load(filepath, sfmData, fingerprint + 1, {feature::EImageDescriberType::SIFT}));
+  BOOST_CHECK(rejectedIndex.empty());
+
+  // the index does not match a reconstruction without its landmarks
+  sfmData.structure.erase(0);
+  BOOST_CHECK(!rejectedIndex.load(filepath, sfmData, fingerprint, {feature::EImageDescriberType::SIFT}));
+  BOOST_CHECK(rejectedIndex.empty());
+
+  bfs::remove(filepath);
+}
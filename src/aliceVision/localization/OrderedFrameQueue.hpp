@@ -0,0 +1,149 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief This class implements the queue between the stages of a frame pipeline:
+ * several producers prepare the frames concurrently (decoding, feature extraction)
+ * and a single consumer gets them back in the order of their frame index.
+ *
+ * The number of frames in flight (acquired by a producer and not yet consumed)
+ * is bounded, so the producers wait for the consumer instead of filling the memory.
+ * The frame indices must be contiguous from 0, each acquired slot is either
+ * pushed with its frame or released.
+ */
+template<class T>
+class OrderedFrameQueue
+{
+public:
+
+  /**
+   * @brief Build a queue.
+   * @param[in] maxFramesInFlight The maximum number of frames in flight (at least 1).
+   * @param[in] nbProducers The number of producers, the queue ends when all of them are done.
+   */
+  OrderedFrameQueue(std::size_t maxFramesInFlight, std::size_t nbProducers)
+    : _maxFramesInFlight(std::max<std::size_t>(1, maxFramesInFlight))
+    , _nbProducers(nbProducers)
+  {}
+
+  /**
+   * @brief Wait for a free slot before preparing a new frame.
+   * @return false if the queue has been cancelled
+   */
+  bool acquireSlot()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _slotReleased.wait(lock, [&]{ return _cancelled || _nbFramesInFlight < _maxFramesInFlight; });
+    if(_cancelled)
+      return false;
+    ++_nbFramesInFlight;
+    return true;
+  }
+
+  /**
+   * @brief Give back an acquired slot without a frame (e.g. the end of the feed is reached).
+   */
+  void releaseSlot()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_nbFramesInFlight;
+    }
+    _slotReleased.notify_one();
+  }
+
+  /**
+   * @brief Add a prepared frame.
+   * @param[in] frameIndex The index of the frame in the sequence.
+   * @param[in] frame The frame data.
+   */
+  void push(std::size_t frameIndex, T frame)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_cancelled)
+        return;
+      _frames.emplace(frameIndex, std::move(frame));
+    }
+    _framePushed.notify_all();
+  }
+
+  /**
+   * @brief To be called by each producer when it has no more frames.
+   */
+  void producerDone()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_nbProducers;
+    }
+    _framePushed.notify_all();
+  }
+
+  /**
+   * @brief Get the next frame of the sequence, it waits until it is prepared.
+   * @param[out] frame The next frame.
+   * @return false if there is no more frame or if the queue has been cancelled
+   */
+  bool pop(T& frame)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _framePushed.wait(lock, [&]{ return _cancelled || _frames.count(_nextFrameIndex) || _nbProducers == 0; });
+      const auto it = _frames.find(_nextFrameIndex);
+      if(_cancelled || it == _frames.end())
+        return false;
+      frame = std::move(it->second);
+      _frames.erase(it);
+      ++_nextFrameIndex;
+      --_nbFramesInFlight;
+    }
+    _slotReleased.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Stop the pipeline: drop the pending frames and wake up all the waiting threads.
+   */
+  void cancel()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cancelled = true;
+      _frames.clear();
+    }
+    _slotReleased.notify_all();
+    _framePushed.notify_all();
+  }
+
+private:
+
+  const std::size_t _maxFramesInFlight;
+  std::size_t _nbProducers;
+  std::size_t _nbFramesInFlight = 0;
+  std::size_t _nextFrameIndex = 0;
+  bool _cancelled = false;
+  /// the prepared frames waiting for the consumer
+  std::map<std::size_t, T> _frames;
+  std::mutex _mutex;
+  std::condition_variable _slotReleased;
+  std::condition_variable _framePushed;
+};
+
+}
+}
@@ -0,0 +1,110 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "OrderedFrameQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE OrderedFrameQueue
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+//-----------------
+// Test summary:
+//-----------------
+// - Several producers prepare the frames with random durations
+// - Assert that the consumer gets all the frames in order
+// - Assert that the number of frames in flight never exceeds the bound
+//-----------------
+BOOST_AUTO_TEST_CASE(OrderedFrameQueue_order)
+{
+  const std::size_t nbFrames = 200;
+  const std::size_t nbProducers = 4;
+  const std::size_t maxFramesInFlight = 6;
+
+  localization::OrderedFrameQueue<std::size_t> queue(maxFramesInFlight, nbProducers);
+  std::mutex feedMutex;
+  std::size_t nbReadFrames = 0;
+  // the greatest frame index read by the producers
+  std::atomic<std::size_t> maxReadFrameIndex(0);
+
+  const auto produce = [&](unsigned int seed)
+  {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> duration(0, 500);
+    while(queue.acquireSlot())
+    {
+      std::size_t frameIndex;
+      {
+        std::lock_guard<std::mutex> lock(feedMutex);
+        if(nbReadFrames == nbFrames)
+        {
+          queue.releaseSlot();
+          break;
+        }
+        frameIndex = nbReadFrames++;
+        maxReadFrameIndex = frameIndex;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(duration(generator)));
+      queue.push(frameIndex, frameIndex * 10);
+    }
+    queue.producerDone();
+  };
+
+  std::vector<std::thread> producers;
+  for(std::size_t i = 0; i < nbProducers; ++i)
+    producers.emplace_back(produce, i);
+
+  std::size_t nbConsumedFrames = 0;
+  std::size_t frame;
+  while(queue.pop(frame))
+  {
+    BOOST_CHECK_EQUAL(frame, nbConsumedFrames * 10);
+    // until the next pop, the frames in flight are the ones after the consumed frame
+    BOOST_CHECK_LE(maxReadFrameIndex.load(), nbConsumedFrames + maxFramesInFlight);
+    ++nbConsumedFrames;
+  }
+
+  for(std::thread& producer : producers)
+    producer.join();
+
+  BOOST_CHECK_EQUAL(nbConsumedFrames, nbFrames);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - A producer waits for a free slot while the queue is full
+// - Cancel the queue
+// - Assert that the producer and the consumer are released
+//-----------------
+BOOST_AUTO_TEST_CASE(OrderedFrameQueue_cancel)
+{
+  localization::OrderedFrameQueue<int> queue(1, 1);
+
+  // the frame 0 is never pushed, the frame 1 waits for a slot
+  BOOST_CHECK(queue.acquireSlot());
+
+  std::thread producer([&]()
+  {
+    BOOST_CHECK(!queue.acquireSlot());
+    queue.producerDone();
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.cancel();
+  producer.join();
+
+  int frame;
+  BOOST_CHECK(!queue.pop(frame));
+}
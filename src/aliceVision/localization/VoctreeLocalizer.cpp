@@ -7,6 +7,7 @@
 #include "VoctreeLocalizer.hpp"
 #include "rigResection.hpp"
 #include "optimization.hpp"
+#include "reconstructionDatabaseIO.hpp"
 #include <aliceVision/config.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/sfm/pipeline/RelativePoseInfo.hpp>
@@ -57,6 +58,8 @@ std::ostream& operator<<(std::ostream& os, VoctreeLocalizer::Algorithm a)
     break;
   case VoctreeLocalizer::Algorithm::Cluster: os << "Cluster";
     break;
+  case VoctreeLocalizer::Algorithm::Direct: os << "Direct";
+    break;
   default: 
     os << "Unknown algorithm!";
     throw std::invalid_argument("Unrecognized algorithm!");
@@ -109,6 +112,8 @@ VoctreeLocalizer::Algorithm VoctreeLocalizer::initFromString(const std::string &
     return VoctreeLocalizer::Algorithm::FirstBest;
   else if(value=="AllResults")
     return VoctreeLocalizer::Algorithm::AllResults;
+  else if(value=="Direct")
+    return VoctreeLocalizer::Algorithm::Direct;
   else if(value=="BestResult")
     throw std::invalid_argument("BestResult not yet implemented");
   else if(value=="Cluster")
@@ -122,7 +127,8 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
                                    const std::string &descriptorsFolder,
                                    const std::string &vocTreeFilepath,
                                    const std::string &weightsFilepath,
-                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes)
+                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                                   const std::string &reconstructionDatabaseFilepath)
   : ILocalizer()
   , _frameBuffer(5)
 {
@@ -142,7 +148,35 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
   // then we can store only those associated to 3D points
   //? can we use Feature_Provider to load the features and filter them later?
 
-  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder);
+  _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder, reconstructionDatabaseFilepath);
+}
+
+bool VoctreeLocalizer::initLandmarksIndex(const std::string &landmarksIndexFilepath)
+{
+  std::vector<feature::EImageDescriberType> descTypes;
+  for(const auto& imageDescriber : _imageDescribers)
+    descTypes.push_back(imageDescriber->getDescriberType());
+
+  // use the precompiled landmarks index if it is up to date
+  if(!landmarksIndexFilepath.empty() && boost::filesystem::exists(landmarksIndexFilepath))
+  {
+    ALICEVISION_LOG_INFO("Loading the landmarks index: " << landmarksIndexFilepath);
+    if(_landmarksIndex.load(landmarksIndexFilepath, _sfm_data, _reconstructionFingerprint, descTypes))
+      return !_landmarksIndex.empty();
+    ALICEVISION_LOG_WARNING("The landmarks index will be rebuilt.");
+  }
+
+  ALICEVISION_LOG_INFO("Building the landmarks index...");
+  system::Timer timer;
+  _landmarksIndex.build(_regionsPerView, _reconstructedRegionsMappingPerView);
+  ALICEVISION_LOG_INFO("Landmarks index built with " << _landmarksIndex.size() << " descriptors in " << timer.elapsedMs() << " [ms]");
+
+  if(!landmarksIndexFilepath.empty() && !_landmarksIndex.empty())
+  {
+    if(_landmarksIndex.save(landmarksIndexFilepath, _reconstructionFingerprint))
+      ALICEVISION_LOG_INFO("Landmarks index saved: " << landmarksIndexFilepath);
+  }
+  return !_landmarksIndex.empty();
 }
 
 bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
@@ -159,13 +193,45 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
     // error!
     throw std::invalid_argument("The parameters are not in the right format!!");
   }
-  
-  switch(voctreeParam->_algorithm)
+
+  // track the frame from the last one and only fall back on the algorithm if it is lost
+  bool isLocalized = voctreeParam->_usePoseTracking &&
+                     localizeTracking(queryRegions,
+                                      imageSize,
+                                      *voctreeParam,
+                                      useInputIntrinsics,
+                                      queryIntrinsics,
+                                      localizationResult,
+                                      imagePath);
+  if(!isLocalized)
+  {
+    isLocalized = localizeQuery(queryRegions,
+                                imageSize,
+                                *voctreeParam,
+                                useInputIntrinsics,
+                                queryIntrinsics,
+                                localizationResult,
+                                imagePath);
+  }
+  addToFrameBuffer(*voctreeParam, localizationResult, queryRegions);
+  updateTracking(*voctreeParam, localizationResult, queryRegions);
+  return isLocalized;
+}
+
+bool VoctreeLocalizer::localizeQuery(const feature::MapRegionsPerDesc & queryRegions,
+                                     const std::pair<std::size_t, std::size_t> &imageSize,
+                                     const Parameters &param,
+                                     bool useInputIntrinsics,
+                                     camera::PinholeRadialK3 &queryIntrinsics,
+                                     LocalizationResult & localizationResult,
+                                     const std::string& imagePath) const
+{
+  switch(param._algorithm)
   {
     case Algorithm::FirstBest:
     return localizeFirstBestResult(queryRegions,
                                    imageSize,
-                                   *voctreeParam,
+                                   param,
                                    useInputIntrinsics,
                                    queryIntrinsics,
                                    localizationResult,
@@ -174,30 +240,166 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
     case Algorithm::AllResults:
     return localizeAllResults(queryRegions,
                               imageSize,
-                              *voctreeParam,
+                              param,
                               useInputIntrinsics,
                               queryIntrinsics,
                               localizationResult,
                               imagePath);
     case Algorithm::Cluster: throw std::invalid_argument("Cluster not yet implemented");
+    case Algorithm::Direct:
+    return localizeDirect(queryRegions,
+                          imageSize,
+                          param,
+                          useInputIntrinsics,
+                          queryIntrinsics,
+                          localizationResult,
+                          imagePath);
     default: throw std::invalid_argument("Unknown algorithm type");
   }
 }
 
-bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
-                                const LocalizerParameters *param,
-                                bool useInputIntrinsics,
-                                camera::PinholeRadialK3 &queryIntrinsics,
-                                LocalizationResult &localizationResult,
-                                const std::string& imagePath /* = std::string() */)
+void VoctreeLocalizer::addToFrameBuffer(const Parameters &param,
+                                        const LocalizationResult &localizationResult,
+                                        const feature::MapRegionsPerDesc &queryRegions)
+{
+  // only the AllResults algorithm matches with the past frames
+  if(param._algorithm == Algorithm::AllResults && param._nbFrameBufferMatching > 0)
+  {
+    // add everything to the buffer
+    _frameBuffer.emplace_back(localizationResult, queryRegions);
+  }
+}
+
+bool VoctreeLocalizer::localizeTracking(const feature::MapRegionsPerDesc &queryRegions,
+                                        const std::pair<std::size_t, std::size_t> &imageSize,
+                                        const Parameters &param,
+                                        bool useInputIntrinsics,
+                                        camera::PinholeRadialK3 &queryIntrinsics,
+                                        LocalizationResult &localizationResult,
+                                        const std::string& imagePath) const
+{
+  if(!_trackedFrame)
+    return false;
+
+  const LocalizationResult& trackedResult = _trackedFrame->_locResult;
+
+  // A. predict the pose of the frame with a constant velocity model
+  geometry::Pose3 predictedPose = trackedResult.getPose();
+  if(_hasPreviousTrackedPose)
+  {
+    const geometry::Pose3 velocity = trackedResult.getPose() * _previousTrackedPose.inverse();
+    predictedPose = velocity * trackedResult.getPose();
+  }
+
+  // B. project the inlier landmarks of the last frame and match them in a window
+  ALICEVISION_LOG_DEBUG("[tracking]	Guided matching with the landmarks of the last frame");
+  system::Timer timer;
+  OccurenceMap occurences;
+  for(const auto& trackedRegionsIt : _trackedFrame->_regions)
+  {
+    const feature::EImageDescriberType descType = trackedRegionsIt.first;
+    const auto queryRegionsIt = queryRegions.find(descType);
+    if(queryRegionsIt == queryRegions.end())
+      continue;
+
+    const std::vector<IndexT>& landmarkIds = _trackedFrame->_regionsWith3D.at(descType)._associated3dPoint;
+    Mat3X points(3, landmarkIds.size());
+    for(std::size_t i = 0; i < landmarkIds.size(); ++i)
+      points.col(i) = _sfm_data.getLandmarks().at(landmarkIds[i]).X;
+
+    matching::IndMatches matches;
+    matching::guidedMatchingProjection(trackedResult.getIntrinsics(),
+                                       predictedPose,
+                                       points,
+                                       *trackedRegionsIt.second,
+                                       *queryRegionsIt->second,
+                                       imageSize,
+                                       param._trackingWindowRadius,
+                                       param._fDistRatio,
+                                       param._trackingMaxDescriptorDistance,
+                                       matches);
+
+    for(const matching::IndMatch& match : matches)
+      occurences[IndMatch3D2D(landmarkIds[match._i], descType, match._j)] = 1;
+  }
+  ALICEVISION_LOG_DEBUG("[tracking]	Found " << occurences.size() << " 2D-3D matches in " << timer.elapsedMs() << " [ms]");
+
+  if(occurences.size() < param._trackingMinInliers)
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]	Not enough matches, the track is lost");
+    return false;
+  }
+
+  // C. estimate the pose, without modifying the intrinsics if the track is lost
+  sfm::ImageLocalizerMatchData resectionData;
+  getAssociationsPoints(queryRegions, occurences, resectionData.pt2D, resectionData.pt3D, resectionData.vec_descType);
+
+  // no image of the database is retrieved
+  const std::vector<voctree::DocMatch> matchedImages;
+  camera::PinholeRadialK3 trackedIntrinsics = queryIntrinsics;
+  LocalizationResult trackingResult;
+
+  const bool isLocalized = estimatePose(occurences,
+                                        matchedImages,
+                                        imageSize,
+                                        param,
+                                        useInputIntrinsics,
+                                        trackedIntrinsics,
+                                        resectionData,
+                                        trackingResult,
+                                        imagePath);
+
+  if(!isLocalized || trackingResult.getInliers().size() < param._trackingMinInliers)
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]	Not enough inliers, the track is lost");
+    return false;
+  }
+
+  ALICEVISION_LOG_DEBUG("[tracking]	Frame tracked with " << trackingResult.getInliers().size() << " inliers");
+  queryIntrinsics = trackedIntrinsics;
+  localizationResult = trackingResult;
+  return true;
+}
+
+void VoctreeLocalizer::updateTracking(const Parameters &param,
+                                      const LocalizationResult &localizationResult,
+                                      const feature::MapRegionsPerDesc &queryRegions)
+{
+  if(!param._usePoseTracking || !localizationResult.isValid())
+  {
+    // the next frame cannot be tracked
+    _trackedFrame.reset();
+    _hasPreviousTrackedPose = false;
+    return;
+  }
+
+  _hasPreviousTrackedPose = (_trackedFrame != nullptr);
+  if(_hasPreviousTrackedPose)
+    _previousTrackedPose = _trackedFrame->_locResult.getPose();
+  _trackedFrame.reset(new FrameData(localizationResult, queryRegions));
+}
+
+std::vector<std::unique_ptr<feature::ImageDescriber>> VoctreeLocalizer::createImageDescribers() const
+{
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  imageDescribers.reserve(_imageDescribers.size());
+  for(const auto& imageDescriber : _imageDescribers)
+    imageDescribers.push_back(feature::createImageDescriber(imageDescriber->getDescriberType()));
+  return imageDescribers;
+}
+
+void VoctreeLocalizer::extractFeatures(const image::Image<float>& imageGrey,
+                                       const LocalizerParameters *param,
+                                       const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                       feature::MapRegionsPerDesc& queryRegionsPerDesc,
+                                       const std::string& imagePath) const
 {
   // A. extract descriptors and features from image
   ALICEVISION_LOG_DEBUG("[features]\tExtract Regions from query image");
-  feature::MapRegionsPerDesc queryRegionsPerDesc;
 
   image::Image<unsigned char> imageGrayUChar; // uchar image copy for uchar image describer
 
-  for(const auto& imageDescriber : _imageDescribers)
+  for(const auto& imageDescriber : imageDescribers)
   {
     const auto descType = imageDescriber->getDescriberType();
     auto & queryRegions = queryRegionsPerDesc[descType];
@@ -223,14 +425,12 @@ bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
     ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(descType) << " done: found " << queryRegions->RegionCount() << " features in " << timer.elapsedMs() << " [ms]");
   }
 
-  const std::pair<std::size_t, std::size_t> queryImageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
-
   // if debugging is enable save the svg image with the extracted features
   if(!param->_visualDebug.empty() && !imagePath.empty())
   {
     feature::MapFeaturesPerDesc extractedFeatures;
 
-    for(const auto& imageDescriber : _imageDescribers)
+    for(const auto& imageDescriber : imageDescribers)
     {
       const auto descType = imageDescriber->getDescriberType();
       extractedFeatures[descType] = queryRegionsPerDesc.at(descType)->GetRegionsPositions();
@@ -238,10 +438,23 @@ bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
 
     namespace bfs = boost::filesystem;
     feature::saveFeatures2SVG(imagePath,
-                     queryImageSize,
+                     std::make_pair(imageGrey.Width(), imageGrey.Height()),
                      extractedFeatures,
                      param->_visualDebug + "/" + bfs::path(imagePath).stem().string() + ".svg");
   }
+}
+
+bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
+                                const LocalizerParameters *param,
+                                bool useInputIntrinsics,
+                                camera::PinholeRadialK3 &queryIntrinsics,
+                                LocalizationResult &localizationResult,
+                                const std::string& imagePath /* = std::string() */)
+{
+  feature::MapRegionsPerDesc queryRegionsPerDesc;
+  extractFeatures(imageGrey, param, _imageDescribers, queryRegionsPerDesc, imagePath);
+
+  const std::pair<std::size_t, std::size_t> queryImageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
 
   return localize(queryRegionsPerDesc,
                   queryImageSize,
@@ -266,7 +479,8 @@ bool VoctreeLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sf
  */
 bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
                                     const std::string & weightsFilepath,
-                                    const std::string & featFolder)
+                                    const std::string & featFolder,
+                                    const std::string & reconstructionDatabaseFilepath)
 {
 
   bool withWeights = !weightsFilepath.empty();
@@ -292,6 +506,37 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
     ALICEVISION_LOG_DEBUG("No weights specified, skipping...");
   }
 
+  std::vector<feature::EImageDescriberType> matchingDescTypes;
+  for(const auto& imageDescriber : _imageDescribers)
+    matchingDescTypes.push_back(imageDescriber->getDescriberType());
+
+  std::vector<std::string> featuresFolders = _sfm_data.getFeaturesFolders();
+  if(!featFolder.empty())
+    featuresFolders.emplace_back(featFolder);
+
+  // the landmarks index is only valid for the same reconstruction and features,
+  // the reconstruction database also for the same vocabulary tree
+  _reconstructionFingerprint = computeReconstructionFingerprint(_sfm_data, featuresFolders, matchingDescTypes, {});
+  const std::uint64_t fingerprint = reconstructionDatabaseFilepath.empty() ? 0 :
+    computeReconstructionFingerprint(_sfm_data, featuresFolders, matchingDescTypes, {vocTreeFilepath, weightsFilepath});
+
+  // use the precompiled reconstruction database if it is up to date
+  if(!reconstructionDatabaseFilepath.empty() && boost::filesystem::exists(reconstructionDatabaseFilepath))
+  {
+    ALICEVISION_LOG_INFO("Loading the reconstruction database: " << reconstructionDatabaseFilepath);
+    system::Timer timer;
+    voctree::SparseHistogramPerImage histograms;
+    if(loadReconstructionDatabase(reconstructionDatabaseFilepath, _sfm_data, fingerprint, _voctree->words(), _voctreeDescType,
+                                  _imageDescribers, _regionsPerView, _reconstructedRegionsMappingPerView, histograms))
+    {
+      for(const auto& histogram : histograms)
+        _database.insert(histogram.first, histogram.second);
+      ALICEVISION_LOG_INFO("Reconstruction database loaded in " << timer.elapsedMs() << " [ms]");
+      return true;
+    }
+    ALICEVISION_LOG_WARNING("The reconstruction database will be rebuilt.");
+  }
+
   // Load the descriptors and the features related to the images
   // for every image, pass the descriptors through the vocabulary tree and
   // add its visual words to the database.
@@ -322,10 +567,6 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
     }
   }
 
-  std::vector<std::string> featuresFolders = _sfm_data.getFeaturesFolders();
-  if(!featFolder.empty())
-    featuresFolders.emplace_back(featFolder);
-
   // Read for each view the corresponding Regions and store them
 #pragma omp parallel for num_threads(3)
   for(int i = 0; i < _sfm_data.getViews().size(); ++i)
@@ -383,6 +624,14 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
       ++my_progress_bar;
     }
   }
+
+  if(!reconstructionDatabaseFilepath.empty())
+  {
+    ALICEVISION_LOG_INFO("Saving the reconstruction database: " << reconstructionDatabaseFilepath);
+    if(!saveReconstructionDatabase(reconstructionDatabaseFilepath, fingerprint, _voctree->words(), _voctreeDescType, matchingDescTypes,
+                                   _regionsPerView, _reconstructedRegionsMappingPerView, _database.getSparseHistogramPerImage()))
+      ALICEVISION_LOG_WARNING("Unable to save the reconstruction database.");
+  }
   return true;
 }
 
@@ -392,7 +641,7 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                                                bool useInputIntrinsics,
                                                camera::PinholeRadialK3 &queryIntrinsics,
                                                LocalizationResult &localizationResult,
-                                               const std::string &imagePath)
+                                               const std::string &imagePath) const
 {
   // A. Find the (visually) similar images in the database 
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
@@ -610,7 +859,7 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                           bool useInputIntrinsics,
                                           camera::PinholeRadialK3 &queryIntrinsics,
                                           LocalizationResult &localizationResult,
-                                          const std::string& imagePath)
+                                          const std::string& imagePath) const
 {
   
   sfm::ImageLocalizerMatchData resectionData;
@@ -632,6 +881,66 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                      matchedImages,
                      imagePath);
 
+  return estimatePose(occurences,
+                      matchedImages,
+                      queryImageSize,
+                      param,
+                      useInputIntrinsics,
+                      queryIntrinsics,
+                      resectionData,
+                      localizationResult,
+                      imagePath);
+}
+
+bool VoctreeLocalizer::localizeDirect(const feature::MapRegionsPerDesc &queryRegions,
+                                      const std::pair<std::size_t, std::size_t> & queryImageSize,
+                                      const Parameters &param,
+                                      bool useInputIntrinsics,
+                                      camera::PinholeRadialK3 &queryIntrinsics,
+                                      LocalizationResult &localizationResult,
+                                      const std::string& imagePath) const
+{
+  if(_landmarksIndex.empty())
+    throw std::logic_error("The landmarks index is not initialized, call initLandmarksIndex() to use the Direct algorithm.");
+
+  // A. match the query features with the descriptors of all the landmarks at once
+  ALICEVISION_LOG_DEBUG("[matching]\tMatching with the landmarks index");
+  system::Timer timer;
+  std::vector<IndMatch3D2D> matches;
+  _landmarksIndex.match(queryRegions, param._fDistRatio, param._nbIndexChecks, matches);
+  ALICEVISION_LOG_DEBUG("[matching]\tFound " << matches.size() << " 2D-3D matches in " << timer.elapsedMs() << " [ms]");
+
+  OccurenceMap occurences;
+  for(const IndMatch3D2D& match : matches)
+    occurences[match] = 1;
+
+  sfm::ImageLocalizerMatchData resectionData;
+  getAssociationsPoints(queryRegions, occurences, resectionData.pt2D, resectionData.pt3D, resectionData.vec_descType);
+
+  // no image of the database is retrieved
+  const std::vector<voctree::DocMatch> matchedImages;
+
+  return estimatePose(occurences,
+                      matchedImages,
+                      queryImageSize,
+                      param,
+                      useInputIntrinsics,
+                      queryIntrinsics,
+                      resectionData,
+                      localizationResult,
+                      imagePath);
+}
+
+bool VoctreeLocalizer::estimatePose(const OccurenceMap &occurences,
+                                    const std::vector<voctree::DocMatch>& matchedImages,
+                                    const std::pair<std::size_t, std::size_t> &queryImageSize,
+                                    const Parameters &param,
+                                    bool useInputIntrinsics,
+                                    camera::PinholeRadialK3 &queryIntrinsics,
+                                    sfm::ImageLocalizerMatchData &resectionData,
+                                    LocalizationResult &localizationResult,
+                                    const std::string& imagePath) const
+{
   const std::size_t numCollectedPts = occurences.size();
   std::vector<IndMatch3D2D> associationIDs;
   associationIDs.reserve(numCollectedPts);
@@ -731,12 +1040,6 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                 << " max = " << std::sqrt(sqrErrors.maxCoeff()));
   }
 
-  if(param._nbFrameBufferMatching > 0)
-  {
-    // add everything to the buffer
-    _frameBuffer.emplace_back(localizationResult, queryRegions);
-  }
-
   return localizationResult.isValid();
 }
 
@@ -953,14 +1256,25 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
     }
   }
   
+  getAssociationsPoints(queryRegions, out_occurences, out_pt2D, out_pt3D, out_descTypes);
+}
+
+void VoctreeLocalizer::getAssociationsPoints(const feature::MapRegionsPerDesc &queryRegions,
+                                             const OccurenceMap &occurences,
+                                             Mat &out_pt2D,
+                                             Mat &out_pt3D,
+                                             std::vector<feature::EImageDescriberType>& out_descTypes) const
+{
+  const std::size_t numCollectedPts = occurences.size();
+
   out_pt2D = Mat2X(2, numCollectedPts);
   out_pt3D = Mat3X(3, numCollectedPts);
   
 
-  out_descTypes.resize(out_occurences.size());
+  out_descTypes.resize(numCollectedPts);
 
   std::size_t index = 0;
-  for(const auto &idx : out_occurences)
+  for(const auto &idx : occurences)
   {
      // recopy all the points in the matching structure
     const IndexT pt2D_id = idx.first.featId;
@@ -1162,36 +1476,26 @@ bool VoctreeLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
 
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
+  // extract the features of the cameras concurrently, each camera uses its own
+  // image describers. A CUDA pipe cannot be shared, so it stays sequential with CUDA.
+  const bool useCuda = std::any_of(_imageDescribers.begin(), _imageDescribers.end(),
+                                   [](const std::unique_ptr<feature::ImageDescriber>& imageDescriber){ return imageDescriber->useCuda(); });
+  if(!useCuda)
   {
-    // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
-
-    image::Image<unsigned char> imageGrayUChar; // uchar image copy for uchar image describer
+    while(_rigImageDescribers.size() < numCams)
+      _rigImageDescribers.push_back(createImageDescribers());
+  }
 
-    // extract descriptors and features from each image
-    for(auto& imageDescriber: _imageDescribers)
-    {
-      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image...");
-      imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
+  #pragma omp parallel for if(!useCuda)
+  for(int i = 0; i < numCams; ++i)
+  {
+    // add the image size for this image
+    vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
 
-      if(imageDescriber->useFloatImage())
-      {
-        imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
-      }
-      else
-      {
-        // image descriptor can't use float image
-        if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
-          imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
-        imageDescriber->describe(imageGrayUChar, vec_queryRegions[i][imageDescriber->getDescriberType()]);
-      }
-      ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features");
-    }
-    ALICEVISION_LOG_DEBUG("[features]\tAll descriptors extracted. Found " <<  vec_queryRegions[i].getNbAllRegions() << " features");
+    extractFeatures(vec_imageGrey[i], parameters, useCuda ? _imageDescribers : _rigImageDescribers[i], vec_queryRegions[i]);
+    ALICEVISION_LOG_DEBUG("[features]\tAll descriptors extracted for camera " << i << ". Found " <<  vec_queryRegions[i].getNbAllRegions() << " features");
   }
   assert(vec_imageSize.size() == vec_queryRegions.size());
           
@@ -1271,10 +1575,10 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
   std::vector<Mat> vec_pts3D(numCams);
   std::vector<Mat> vec_pts2D(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // for each camera retrieve the associations,
+  // the cameras are matched concurrently against the database
+  #pragma omp parallel for
+  for(int camID = 0; camID < numCams; ++camID)
   {
 
     // this map is used to collect the 2d-3d associations as we go through the images
@@ -1298,8 +1602,11 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
                        pts3D,
                        descTypes,
                        matchedImages);
-    numAssociations += occurrences.size();
   }
+
+  std::size_t numAssociations = 0;
+  for(const auto& occurrences : vec_occurrences)
+    numAssociations += occurrences.size();
   
   // @todo Here it could be possible to filter the associations according to their
   // occurrences, eg giving priority to those associations that are more frequent
@@ -1518,14 +1825,28 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   assert(numCams==vec_imageSize.size());
 
   vec_localizationResults.resize(numCams);
+
+  const VoctreeLocalizer::Parameters *param = static_cast<const VoctreeLocalizer::Parameters *>(parameters);
+  if(!param)
+  {
+    // error!
+    throw std::invalid_argument("The parameters are not in the right format!!");
+  }
     
   // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // the cameras are localized concurrently, all of them against the frames buffered
+  // before this rig frame, then they are added to the frame buffer in camera order
+  std::vector<char> isLocalized(numCams, false);
+  #pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
-    isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], parameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
+    isLocalized[i] = localizeQuery(vec_queryRegions[i], vec_imageSize[i], *param, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     assert(isLocalized[i] == vec_localizationResults[i].isValid());
+  }
+
+  for(std::size_t i = 0; i < numCams; ++i)
+  {
+    addToFrameBuffer(*param, vec_localizationResults[i], vec_queryRegions[i]);
     if(!isLocalized[i])
     {
       ALICEVISION_CERR("Could not localize camera " << i);
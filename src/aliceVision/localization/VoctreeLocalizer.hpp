@@ -19,6 +19,7 @@
 #include <aliceVision/localization/LocalizationResult.hpp>
 #include <aliceVision/localization/ILocalizer.hpp>
 #include <aliceVision/localization/BoundedBuffer.hpp>
+#include <aliceVision/localization/LandmarksIndex.hpp>
 
 #include <flann/algorithms/dist.h>
 
@@ -37,7 +38,7 @@ struct FrameData
 class VoctreeLocalizer : public ILocalizer
 {
 public:
-  enum Algorithm : int {FirstBest=0, BestResult=1, AllResults=2, Cluster=3};
+  enum Algorithm : int {FirstBest=0, BestResult=1, AllResults=2, Cluster=3, Direct=4};
   static Algorithm initFromString(const std::string &value);
   
 public:
@@ -55,6 +56,11 @@ public:
       , _ccTagUseCuda(true)
       , _matchingError(std::numeric_limits<double>::infinity())
       , _nbFrameBufferMatching(10)
+      , _nbIndexChecks(128)
+      , _usePoseTracking(false)
+      , _trackingWindowRadius(20.0)
+      , _trackingMaxDescriptorDistance(250.0)
+      , _trackingMinInliers(30)
     {}
     
     /// Enable/disable guided matching when matching images
@@ -75,6 +81,17 @@ public:
     double _matchingError;
     /// maximum capacity of the frame buffer
     std::size_t _nbFrameBufferMatching;
+    /// for algorithm Direct, number of leaves visited by the prioritized search in the landmarks index
+    int _nbIndexChecks;
+    /// Enable/disable the tracking of sequential frames: the landmarks of the last frame are
+    /// projected with the predicted pose and matched in a window, the algorithm is only used on failure
+    bool _usePoseTracking;
+    /// radius (in pixels) of the search window around the predicted projection of the landmarks
+    double _trackingWindowRadius;
+    /// maximum descriptor distance of a tracked match, needed when the window contains a single feature
+    double _trackingMaxDescriptorDistance;
+    /// minimum number of inliers for a frame to be localized by tracking
+    std::size_t _trackingMinInliers;
   };
   
 public:
@@ -92,6 +109,9 @@ public:
    * when all the documents are added.
    * @param[in] matchingDescTypes List of descriptor types to use for feature matching.
    * @param[in] voctreeDescType Descriptor type used for image matching with voctree.
+   * @param[in] reconstructionDatabaseFilepath Optional path to a precompiled reconstruction
+   * database (see reconstructionDatabaseIO.hpp): it is loaded if it exists and matches the
+   * inputs, otherwise the database is built from the features and saved to this file.
    *
    * It enable the use of combined SIFT and CCTAG features.
    */
@@ -99,13 +119,32 @@ public:
                    const std::string &descriptorsFolder,
                    const std::string &vocTreeFilepath,
                    const std::string &weightsFilepath,
-                   const std::vector<feature::EImageDescriberType>& matchingDescTypes
+                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                   const std::string &reconstructionDatabaseFilepath = std::string()
                   );
   
+  /**
+   * @brief Initialize the landmarks index used by the Direct algorithm.
+   *
+   * @param[in] landmarksIndexFilepath Optional path to a precompiled landmarks index
+   * (see LandmarksIndex.hpp): it is loaded if it exists and matches the reconstruction,
+   * otherwise the index is built from the reconstructed regions and saved to this file.
+   * @return true if the index is ready
+   */
+  bool initLandmarksIndex(const std::string &landmarksIndexFilepath = std::string());
+
   void setCudaPipe( int i ) override
   {
       _cudaPipe = i;
   }
+
+  std::vector<std::unique_ptr<feature::ImageDescriber>> createImageDescribers() const override;
+
+  void extractFeatures(const image::Image<float> & imageGrey,
+                       const LocalizerParameters *param,
+                       const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                       feature::MapRegionsPerDesc &queryRegions,
+                       const std::string& imagePath = std::string()) const override;
   
   /**
    * @brief Just a wrapper around the different localization algorithm, the algorithm
@@ -209,7 +248,7 @@ public:
                                bool useInputIntrinsics,
                                camera::PinholeRadialK3 &queryIntrinsics,
                                LocalizationResult &localizationResult,
-                               const std::string &imagePath = std::string());
+                               const std::string &imagePath = std::string()) const;
 
   /**
    * @brief Try to localize an image in the database: it queries the database to 
@@ -234,9 +273,32 @@ public:
                           bool useInputIntrinsics,
                           camera::PinholeRadialK3 &queryIntrinsics,
                           LocalizationResult &localizationResult,
-                          const std::string& imagePath = std::string());
+                          const std::string& imagePath = std::string()) const;
   
   
+  /**
+   * @brief Try to localize an image by matching its features directly with the
+   * descriptors of the landmarks (see initLandmarksIndex()), without retrieving
+   * and matching the similar images of the database.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera, they are used if the
+   * flag useInputIntrinsics is set to true, otherwise they are estimated from the correspondences.
+   * @param[out] localizationResult The localization result containing the pose and the associations.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   * @return true if the localization is successful
+   */
+  bool localizeDirect(const feature::MapRegionsPerDesc & queryRegions,
+                      const std::pair<std::size_t, std::size_t> & imageSize,
+                      const Parameters &param,
+                      bool useInputIntrinsics,
+                      camera::PinholeRadialK3 &queryIntrinsics,
+                      LocalizationResult &localizationResult,
+                      const std::string& imagePath = std::string()) const;
+
   /**
    * @brief Retrieve matches to all images of the database.
    *
@@ -275,11 +337,87 @@ private:
    * when all the documents are added.
    * @param[in] feat_directory The path to the directory containing the features 
    * of the scene (.desc and .feat files).
+   * @param[in] reconstructionDatabaseFilepath Optional path to a precompiled reconstruction database.
    * @return true if everything went ok
    */
   bool initDatabase(const std::string & vocTreeFilepath,
                     const std::string & weightsFilepath,
-                    const std::string & featFolder);
+                    const std::string & featFolder,
+                    const std::string & reconstructionDatabaseFilepath = std::string());
+
+  /**
+   * @brief Localize a query image with the algorithm chosen by \p param._algorithm,
+   * without adding it to the frame buffer, so that several images can be localized
+   * concurrently against the same past frames.
+   */
+  bool localizeQuery(const feature::MapRegionsPerDesc & queryRegions,
+                     const std::pair<std::size_t, std::size_t> &imageSize,
+                     const Parameters &param,
+                     bool useInputIntrinsics,
+                     camera::PinholeRadialK3 &queryIntrinsics,
+                     LocalizationResult & localizationResult,
+                     const std::string& imagePath = std::string()) const;
+
+  /**
+   * @brief Recopy the 2D and 3D points of the associations.
+   */
+  void getAssociationsPoints(const feature::MapRegionsPerDesc &queryRegions,
+                             const OccurenceMap &occurences,
+                             Mat &out_pt2D,
+                             Mat &out_pt3D,
+                             std::vector<feature::EImageDescriberType>& out_descTypes) const;
+
+  /**
+   * @brief Estimate and refine the pose of a query image from its 2D-3D associations.
+   */
+  bool estimatePose(const OccurenceMap &occurences,
+                    const std::vector<voctree::DocMatch>& matchedImages,
+                    const std::pair<std::size_t, std::size_t> &queryImageSize,
+                    const Parameters &param,
+                    bool useInputIntrinsics,
+                    camera::PinholeRadialK3 &queryIntrinsics,
+                    sfm::ImageLocalizerMatchData &resectionData,
+                    LocalizationResult &localizationResult,
+                    const std::string& imagePath) const;
+
+  /**
+   * @brief Add a localized query image to the frame buffer, if the parameters use it.
+   */
+  void addToFrameBuffer(const Parameters &param,
+                        const LocalizationResult &localizationResult,
+                        const feature::MapRegionsPerDesc &queryRegions);
+
+  /**
+   * @brief Try to localize a frame of a sequence from the last localized frame.
+   * The pose is predicted with a constant velocity model from the two last
+   * localized frames, the inlier landmarks of the last frame are projected with
+   * the predicted pose and matched with the query features in a small window.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera, they are left
+   * untouched if the tracking fails.
+   * @param[out] localizationResult The localization result containing the pose and the associations.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   * @return true if the frame is localized with at least Parameters::_trackingMinInliers inliers
+   */
+  bool localizeTracking(const feature::MapRegionsPerDesc & queryRegions,
+                        const std::pair<std::size_t, std::size_t> & imageSize,
+                        const Parameters &param,
+                        bool useInputIntrinsics,
+                        camera::PinholeRadialK3 &queryIntrinsics,
+                        LocalizationResult &localizationResult,
+                        const std::string& imagePath = std::string()) const;
+
+  /**
+   * @brief Update the tracking state with the result of the last query image:
+   * a localized frame becomes the reference of the next one, otherwise the track is lost.
+   */
+  void updateTracking(const Parameters &param,
+                      const LocalizationResult &localizationResult,
+                      const feature::MapRegionsPerDesc &queryRegions);
 
   /**
    * @brief robustMatching
@@ -337,6 +475,9 @@ public:
   
   /// the feature extractor
   std::vector<std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
+
+  /// the feature extractors of each camera of a rig, created once to extract the cameras concurrently
+  std::vector<std::vector<std::unique_ptr<feature::ImageDescriber>>> _rigImageDescribers;
   
   // CUDA CCTag supports several parallel pipelines, where each one can
   // processing different image dimensions.
@@ -354,6 +495,17 @@ public:
   /// Last frames buffer
   BoundedBuffer<FrameData> _frameBuffer;
 
+  /// the index over the descriptors of the landmarks, for the Direct algorithm
+  LandmarksIndex _landmarksIndex;
+  /// the fingerprint of the reconstruction and features the landmarks index is built from
+  std::uint64_t _reconstructionFingerprint = 0;
+
+  /// the last localized frame of the sequence, the reference for tracking the next one
+  std::unique_ptr<FrameData> _trackedFrame;
+  /// the pose of the frame localized just before the tracked frame, for the constant velocity model
+  geometry::Pose3 _previousTrackedPose;
+  bool _hasPreviousTrackedPose = false;
+
   matching::EMatcherType _matcherType = matching::ANN_L2;
 };
 
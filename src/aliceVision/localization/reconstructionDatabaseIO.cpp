@@ -0,0 +1,476 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "reconstructionDatabaseIO.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+/// Magic number and version of the reconstruction database format
+const char dbMagic[4] = {'A', 'V', 'L', 'D'};
+const std::uint32_t dbVersion = 2;
+
+template<typename T>
+void write(std::ofstream& file, const T& value)
+{
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ofstream& file, const std::string& str)
+{
+  write<std::uint32_t>(file, str.size());
+  file.write(str.data(), str.size());
+}
+
+/**
+ * @brief Parse a part of the memory-mapped database.
+ */
+class MappedReader
+{
+public:
+  MappedReader(const char* data, std::size_t size, std::size_t pos = 0)
+    : _data(data)
+    , _size(size)
+    , _pos(pos)
+  {}
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    copy(&value, sizeof(T));
+    return value;
+  }
+
+  std::string readString()
+  {
+    const std::uint32_t size = read<std::uint32_t>();
+    std::string str(size, '\0');
+    copy(&str[0], size);
+    return str;
+  }
+
+  void copy(void* dst, std::size_t size)
+  {
+    if(size > _size || _pos > _size - size)
+      throw std::runtime_error("Corrupted reconstruction database.");
+    std::memcpy(dst, _data + _pos, size);
+    _pos += size;
+  }
+
+private:
+  const char* _data;
+  std::size_t _size;
+  std::size_t _pos;
+};
+
+void writeView(std::ofstream& file,
+               const std::vector<feature::EImageDescriberType>& descTypes,
+               const feature::MapRegionsPerDesc& regionsPerDesc,
+               const ReconstructedRegionsMappingPerDesc& mappingPerDesc,
+               const voctree::SparseHistogram* histogram)
+{
+  for(const feature::EImageDescriberType descType : descTypes)
+  {
+    const feature::Regions& regions = *regionsPerDesc.at(descType);
+    const ReconstructedRegionsMapping& mapping = mappingPerDesc.at(descType);
+    const std::size_t nbRegions = regions.RegionCount();
+
+    write<std::uint64_t>(file, nbRegions);
+    write<std::uint64_t>(file, regions.DescriptorByteLength());
+    for(const feature::PointFeature& feature : regions.Features())
+    {
+      write<float>(file, feature.x());
+      write<float>(file, feature.y());
+      write<float>(file, feature.scale());
+      write<float>(file, feature.orientation());
+    }
+    if(nbRegions > 0)
+      file.write(static_cast<const char*>(regions.DescriptorRawData()), nbRegions * regions.DescriptorByteLength());
+    for(std::size_t i = 0; i < nbRegions; ++i)
+      write<IndexT>(file, mapping._associated3dPoint.at(i));
+    write<std::uint64_t>(file, mapping._mapFullToLocal.size());
+    for(const auto& fullToLocal : mapping._mapFullToLocal)
+    {
+      write<IndexT>(file, fullToLocal.first);
+      write<IndexT>(file, fullToLocal.second);
+    }
+  }
+
+  write<std::uint8_t>(file, histogram ? 1 : 0);
+  if(histogram)
+  {
+    write<std::uint64_t>(file, histogram->size());
+    for(const auto& word : *histogram)
+    {
+      write<voctree::Word>(file, word.first);
+      write<std::uint64_t>(file, word.second.size());
+      file.write(reinterpret_cast<const char*>(word.second.data()), word.second.size() * sizeof(IndexT));
+    }
+  }
+}
+
+void readView(MappedReader& reader,
+              const sfmData::SfMData& sfmData,
+              const std::vector<feature::EImageDescriberType>& descTypes,
+              feature::MapRegionsPerDesc& regionsPerDesc,
+              ReconstructedRegionsMappingPerDesc& mappingPerDesc,
+              voctree::SparseHistogram& histogram,
+              bool& hasHistogram)
+{
+  for(const feature::EImageDescriberType descType : descTypes)
+  {
+    feature::Regions& regions = *regionsPerDesc.at(descType);
+    ReconstructedRegionsMapping& mapping = mappingPerDesc.at(descType);
+    const std::size_t nbRegions = reader.read<std::uint64_t>();
+
+    if(reader.read<std::uint64_t>() != regions.DescriptorByteLength())
+      throw std::runtime_error("The descriptors size of the reconstruction database does not match the describer type " +
+                               feature::EImageDescriberType_enumToString(descType) + ".");
+
+    std::vector<feature::PointFeature>& features = regions.Features();
+    features.reserve(nbRegions);
+    for(std::size_t i = 0; i < nbRegions; ++i)
+    {
+      const float x = reader.read<float>();
+      const float y = reader.read<float>();
+      const float scale = reader.read<float>();
+      const float orientation = reader.read<float>();
+      features.emplace_back(x, y, scale, orientation);
+    }
+    void* descriptors = regions.ResizeDescriptors(nbRegions);
+    reader.copy(descriptors, nbRegions * regions.DescriptorByteLength());
+
+    mapping._associated3dPoint.resize(nbRegions);
+    for(IndexT& landmarkId : mapping._associated3dPoint)
+    {
+      landmarkId = reader.read<IndexT>();
+      if(sfmData.getLandmarks().count(landmarkId) == 0)
+        throw std::runtime_error("The landmark " + std::to_string(landmarkId) + " of the reconstruction database is not in the reconstruction.");
+    }
+    const std::size_t nbFullToLocal = reader.read<std::uint64_t>();
+    for(std::size_t i = 0; i < nbFullToLocal; ++i)
+    {
+      const IndexT fullIndex = reader.read<IndexT>();
+      mapping._mapFullToLocal.emplace_hint(mapping._mapFullToLocal.end(), fullIndex, reader.read<IndexT>());
+    }
+  }
+
+  hasHistogram = (reader.read<std::uint8_t>() != 0);
+  if(!hasHistogram)
+    return;
+
+  const std::size_t nbWords = reader.read<std::uint64_t>();
+  for(std::size_t i = 0; i < nbWords; ++i)
+  {
+    const voctree::Word word = reader.read<voctree::Word>();
+    std::vector<IndexT>& featureIds = histogram.emplace_hint(histogram.end(), word, std::vector<IndexT>())->second;
+    featureIds.resize(reader.read<std::uint64_t>());
+    reader.copy(featureIds.data(), featureIds.size() * sizeof(IndexT));
+  }
+}
+
+/// Combine the identity of a file in a fingerprint: its path, size and modification time
+void hashFileIdentity(std::size_t& seed, const boost::filesystem::path& filepath)
+{
+  namespace bfs = boost::filesystem;
+
+  boost::system::error_code ec;
+  const bfs::path absolutePath = bfs::absolute(filepath);
+  stl::hash_combine(seed, absolutePath.generic_string());
+  if(!bfs::is_regular_file(absolutePath, ec))
+    return;
+  stl::hash_combine(seed, static_cast<std::uint64_t>(bfs::file_size(absolutePath, ec)));
+  stl::hash_combine(seed, static_cast<std::int64_t>(bfs::last_write_time(absolutePath, ec)));
+}
+
+/// Set of the views of the reconstruction observed by a landmark, as stored in a reconstruction database
+std::set<IndexT> getObservedViews(const sfmData::SfMData& sfmData)
+{
+  std::set<IndexT> observedViews;
+  for(const auto& landmark : sfmData.getLandmarks())
+  {
+    for(const auto& observation : landmark.second.observations)
+    {
+      if(sfmData.getViews().count(observation.first))
+        observedViews.insert(observation.first);
+    }
+  }
+  return observedViews;
+}
+
+} // namespace
+
+std::uint64_t computeReconstructionFingerprint(const sfmData::SfMData& sfmData,
+                                               const std::vector<std::string>& featuresFolders,
+                                               const std::vector<feature::EImageDescriberType>& descTypes,
+                                               const std::vector<std::string>& filepaths)
+{
+  namespace bfs = boost::filesystem;
+
+  std::size_t fingerprint = 0;
+
+  for(const auto& view : sfmData.getViews())
+  {
+    stl::hash_combine(fingerprint, view.first);
+    stl::hash_combine(fingerprint, view.second->getImagePath());
+  }
+
+  // the 2D-3D associations only depend on the observed features, not on the landmarks positions
+  for(const auto& landmark : sfmData.getLandmarks())
+  {
+    stl::hash_combine(fingerprint, landmark.first);
+    stl::hash_combine(fingerprint, static_cast<int>(landmark.second.descType));
+    for(const auto& observation : landmark.second.observations)
+    {
+      stl::hash_combine(fingerprint, observation.first);
+      stl::hash_combine(fingerprint, observation.second.id_feat);
+    }
+  }
+
+  for(const feature::EImageDescriberType descType : descTypes)
+    stl::hash_combine(fingerprint, feature::EImageDescriberType_enumToString(descType));
+
+  for(const std::string& filepath : filepaths)
+    hashFileIdentity(fingerprint, filepath);
+
+  for(const std::string& folder : featuresFolders)
+  {
+    hashFileIdentity(fingerprint, folder);
+    for(const IndexT viewId : getObservedViews(sfmData))
+    {
+      for(const feature::EImageDescriberType descType : descTypes)
+      {
+        const std::string basename = std::to_string(viewId) + "." + feature::EImageDescriberType_enumToString(descType);
+        hashFileIdentity(fingerprint, bfs::path(folder) / (basename + ".feat"));
+        hashFileIdentity(fingerprint, bfs::path(folder) / (basename + ".desc"));
+      }
+    }
+  }
+
+  return fingerprint;
+}
+
+bool saveReconstructionDatabase(const std::string& filepath,
+                                std::uint64_t fingerprint,
+                                std::size_t nbWords,
+                                feature::EImageDescriberType voctreeDescType,
+                                const std::vector<feature::EImageDescriberType>& descTypes,
+                                const feature::RegionsPerView& regionsPerView,
+                                const ReconstructedRegionsMappingPerView& mappingPerView,
+                                const voctree::SparseHistogramPerImage& histograms)
+{
+  namespace bfs = boost::filesystem;
+
+  // write in a temporary file, renamed once complete
+  const bfs::path tmpFilepath = bfs::path(filepath).parent_path() / bfs::unique_path(bfs::path(filepath).filename().string() + ".%%%%-%%%%.tmp");
+
+  {
+    std::ofstream file(tmpFilepath.string(), std::ios::out | std::ios::binary);
+    if(!file.is_open())
+    {
+      ALICEVISION_LOG_ERROR("Unable to write the reconstruction database: " << tmpFilepath.string());
+      return false;
+    }
+
+    const feature::MapRegionsPerView& regions = regionsPerView.getData();
+
+    file.write(dbMagic, sizeof(dbMagic));
+    write<std::uint32_t>(file, dbVersion);
+    write<std::uint64_t>(file, fingerprint);
+    write<std::uint64_t>(file, nbWords);
+    writeString(file, feature::EImageDescriberType_enumToString(voctreeDescType));
+    write<std::uint32_t>(file, descTypes.size());
+    for(const feature::EImageDescriberType descType : descTypes)
+      writeString(file, feature::EImageDescriberType_enumToString(descType));
+
+    // view table, the offsets are filled once the records are written
+    write<std::uint64_t>(file, regions.size());
+    const std::streamoff tableOffset = file.tellp();
+    for(std::size_t i = 0; i < regions.size(); ++i)
+    {
+      write<std::uint32_t>(file, 0);
+      write<std::uint64_t>(file, 0);
+    }
+
+    std::vector<std::pair<IndexT, std::uint64_t>> viewTable;
+    viewTable.reserve(regions.size());
+    for(const auto& regionsPerDesc : regions)
+    {
+      const IndexT viewId = regionsPerDesc.first;
+      viewTable.emplace_back(viewId, static_cast<std::uint64_t>(file.tellp()));
+      const auto histogramIt = histograms.find(viewId);
+      writeView(file, descTypes, regionsPerDesc.second, mappingPerView.at(viewId),
+                (histogramIt != histograms.end()) ? &histogramIt->second : nullptr);
+    }
+
+    file.seekp(tableOffset);
+    for(const auto& view : viewTable)
+    {
+      write<std::uint32_t>(file, view.first);
+      write<std::uint64_t>(file, view.second);
+    }
+
+    if(!file.good())
+    {
+      ALICEVISION_LOG_ERROR("Error while writing the reconstruction database: " << tmpFilepath.string());
+      file.close();
+      bfs::remove(tmpFilepath);
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  bfs::rename(tmpFilepath, filepath, ec);
+  if(ec)
+  {
+    ALICEVISION_LOG_ERROR("Unable to rename the reconstruction database to " << filepath << ": " << ec.message());
+    bfs::remove(tmpFilepath, ec);
+    return false;
+  }
+  return true;
+}
+
+bool loadReconstructionDatabase(const std::string& filepath,
+                                const sfmData::SfMData& sfmData,
+                                std::uint64_t fingerprint,
+                                std::size_t nbWords,
+                                feature::EImageDescriberType voctreeDescType,
+                                const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                feature::RegionsPerView& regionsPerView,
+                                ReconstructedRegionsMappingPerView& mappingPerView,
+                                voctree::SparseHistogramPerImage& histograms)
+{
+  namespace bip = boost::interprocess;
+
+  try
+  {
+    const bip::file_mapping mapping(filepath.c_str(), bip::read_only);
+    const bip::mapped_region region(mapping, bip::read_only);
+    const char* data = static_cast<const char*>(region.get_address());
+    const std::size_t size = region.get_size();
+
+    MappedReader header(data, size);
+    char magic[4];
+    header.copy(magic, sizeof(magic));
+    if(std::memcmp(magic, dbMagic, sizeof(dbMagic)) != 0)
+      throw std::runtime_error("Not a reconstruction database.");
+    const std::uint32_t version = header.read<std::uint32_t>();
+    if(version != dbVersion)
+      throw std::runtime_error("Unsupported reconstruction database version: " + std::to_string(version) + ".");
+    if(header.read<std::uint64_t>() != fingerprint)
+      throw std::runtime_error("The reconstruction database has been built from another reconstruction, features or vocabulary tree.");
+
+    if(header.read<std::uint64_t>() != nbWords ||
+       feature::EImageDescriberType_stringToEnum(header.readString()) != voctreeDescType)
+      throw std::runtime_error("The reconstruction database has been built with another vocabulary tree.");
+
+    std::vector<feature::EImageDescriberType> descTypes(header.read<std::uint32_t>());
+    for(feature::EImageDescriberType& descType : descTypes)
+      descType = feature::EImageDescriberType_stringToEnum(header.readString());
+
+    const bool sameDescTypes = (descTypes.size() == imageDescribers.size()) &&
+      std::all_of(imageDescribers.begin(), imageDescribers.end(), [&](const std::unique_ptr<feature::ImageDescriber>& imageDescriber)
+      {
+        return std::find(descTypes.begin(), descTypes.end(), imageDescriber->getDescriberType()) != descTypes.end();
+      });
+    if(!sameDescTypes)
+      throw std::runtime_error("The reconstruction database has been built with other describer types.");
+
+    // the database must contain exactly the observed views of the reconstruction
+    std::set<IndexT> observedViews = getObservedViews(sfmData);
+    std::vector<std::pair<IndexT, std::uint64_t>> viewTable(header.read<std::uint64_t>());
+    for(auto& view : viewTable)
+    {
+      view.first = header.read<std::uint32_t>();
+      view.second = header.read<std::uint64_t>();
+      if(observedViews.erase(view.first) == 0)
+        throw std::runtime_error("The view " + std::to_string(view.first) + " of the reconstruction database is not an observed view of the reconstruction.");
+    }
+    if(!observedViews.empty())
+      throw std::runtime_error("The view " + std::to_string(*observedViews.begin()) + " of the reconstruction is not in the reconstruction database.");
+
+    // allocate all the containers, so that the views can be filled in parallel
+    feature::MapRegionsPerView loadedRegions;
+    ReconstructedRegionsMappingPerView loadedMapping;
+    voctree::SparseHistogramPerImage loadedHistograms;
+    for(const auto& view : viewTable)
+    {
+      for(const auto& imageDescriber : imageDescribers)
+      {
+        imageDescriber->allocate(loadedRegions[view.first][imageDescriber->getDescriberType()]);
+        loadedMapping[view.first][imageDescriber->getDescriberType()];
+      }
+      loadedHistograms[view.first];
+    }
+
+    std::vector<char> hasHistogram(viewTable.size(), 0);
+    std::atomic<bool> valid(true);
+    std::string error;
+
+#pragma omp parallel for
+    for(int i = 0; i < viewTable.size(); ++i)
+    {
+      if(!valid)
+        continue;
+      const IndexT viewId = viewTable[i].first;
+      try
+      {
+        MappedReader reader(data, size, viewTable[i].second);
+        bool viewHasHistogram = false;
+        readView(reader, sfmData, descTypes, loadedRegions.at(viewId), loadedMapping.at(viewId), loadedHistograms.at(viewId), viewHasHistogram);
+        hasHistogram[i] = viewHasHistogram;
+      }
+      catch(const std::exception& e)
+      {
+#pragma omp critical
+        {
+          valid = false;
+          error = e.what();
+        }
+      }
+    }
+
+    if(!valid)
+      throw std::runtime_error(error);
+
+    // views without voctree histogram are not part of the voctree database
+    for(std::size_t i = 0; i < viewTable.size(); ++i)
+    {
+      if(!hasHistogram[i])
+        loadedHistograms.erase(viewTable[i].first);
+    }
+
+    regionsPerView.getData() = std::move(loadedRegions);
+    mappingPerView = std::move(loadedMapping);
+    histograms = std::move(loadedHistograms);
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Cannot load the reconstruction database '" << filepath << "': " << e.what());
+    return false;
+  }
+  return true;
+}
+
+} // namespace localization
+} // namespace aliceVision
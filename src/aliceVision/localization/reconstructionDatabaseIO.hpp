@@ -0,0 +1,108 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/localization/reconstructed_regions.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/voctree/VocabularyTree.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+// Reconstruction database file of the voctree localizer:
+// -- Header
+// magic "AVLD", version (uint32), fingerprint of the reconstruction (uint64)
+// number of words of the vocabulary tree (uint64), voctree describer type (string)
+// describer types (uint32 count, strings)
+// number of views (uint64), view table [view id (uint32), record offset (uint64)]
+// -- View records
+// for each describer type of the header:
+//   number of regions (uint64), descriptor size in bytes (uint64)
+//   features [x, y, scale, orientation], descriptors, associated 3D point ids,
+//   full to local feature mapping (uint64 count, [full index, local index])
+// voctree histogram flag (uint8), if set: uint64 number of words, [word (int32), uint64 count, feature ids]
+// --
+// This is a serialized cache of the loaded regions, not a shared memory: the
+// file is memory-mapped only to parse the view records in parallel, and the
+// regions, associations and histograms are copied into the localizer. Loading
+// it skips the reading, filtering and quantization of the features of every view.
+
+/**
+ * @brief Compute the fingerprint of the inputs of a reconstruction database, to detect a stale database.
+ * It depends on the views, the landmarks and their observations, on the describer types,
+ * on the identity (path, size and modification time) of the given files and of the
+ * features files of the observed views in the features folders.
+ * @param[in] sfmData The reconstruction
+ * @param[in] featuresFolders The features folders
+ * @param[in] descTypes The describer types used for matching
+ * @param[in] filepaths The other input files (e.g. the vocabulary tree and its weights), may be empty
+ * @return the fingerprint
+ */
+std::uint64_t computeReconstructionFingerprint(const sfmData::SfMData& sfmData,
+                                               const std::vector<std::string>& featuresFolders,
+                                               const std::vector<feature::EImageDescriberType>& descTypes,
+                                               const std::vector<std::string>& filepaths);
+
+/**
+ * @brief Save the reconstruction database of a voctree localizer: the regions
+ * of each view that have an associated 3D point, their associations and the
+ * voctree histogram of each view.
+ * The file is written next to \p filepath then renamed, so that concurrent
+ * processes never read a partial file.
+ * @param[in] filepath The database file
+ * @param[in] fingerprint The fingerprint of the reconstruction, see computeReconstructionFingerprint
+ * @param[in] nbWords The number of words of the vocabulary tree
+ * @param[in] voctreeDescType The describer type used by the vocabulary tree
+ * @param[in] descTypes The describer types used for matching
+ * @param[in] regionsPerView The reconstructed regions of each view
+ * @param[in] mappingPerView The associations of the reconstructed regions of each view
+ * @param[in] histograms The voctree histogram of each view
+ * @return true if completed
+ */
+bool saveReconstructionDatabase(const std::string& filepath,
+                                std::uint64_t fingerprint,
+                                std::size_t nbWords,
+                                feature::EImageDescriberType voctreeDescType,
+                                const std::vector<feature::EImageDescriberType>& descTypes,
+                                const feature::RegionsPerView& regionsPerView,
+                                const ReconstructedRegionsMappingPerView& mappingPerView,
+                                const voctree::SparseHistogramPerImage& histograms);
+
+/**
+ * @brief Load the reconstruction database of a voctree localizer.
+ * The database is rejected if it does not match the fingerprint, the vocabulary tree,
+ * the describer types or the observed views and the landmarks of the reconstruction.
+ * @param[in] filepath The database file
+ * @param[in] sfmData The reconstruction
+ * @param[in] fingerprint The fingerprint of the reconstruction, see computeReconstructionFingerprint
+ * @param[in] nbWords The number of words of the vocabulary tree
+ * @param[in] voctreeDescType The describer type used by the vocabulary tree
+ * @param[in] imageDescribers The image describers used for matching, to allocate the regions
+ * @param[out] regionsPerView The reconstructed regions of each view
+ * @param[out] mappingPerView The associations of the reconstructed regions of each view
+ * @param[out] histograms The voctree histogram of each view
+ * @return true if completed
+ */
+bool loadReconstructionDatabase(const std::string& filepath,
+                                const sfmData::SfMData& sfmData,
+                                std::uint64_t fingerprint,
+                                std::size_t nbWords,
+                                feature::EImageDescriberType voctreeDescType,
+                                const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                feature::RegionsPerView& regionsPerView,
+                                ReconstructedRegionsMappingPerView& mappingPerView,
+                                voctree::SparseHistogramPerImage& histograms);
+
+} // namespace localization
+} // namespace aliceVision
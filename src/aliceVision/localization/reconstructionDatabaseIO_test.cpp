@@ -0,0 +1,182 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/reconstructionDatabaseIO.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE reconstructionDatabaseIO
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const std::size_t nbWords = 1000;
+const std::size_t nbViews = 5;
+const std::size_t nbLandmarks = 50;
+
+void generateDatabase(sfmData::SfMData& sfmData,
+                      feature::RegionsPerView& regionsPerView,
+                      localization::ReconstructedRegionsMappingPerView& mappingPerView,
+                      voctree::SparseHistogramPerImage& histograms)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> position(0.f, 1000.f);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<IndexT> landmark(0, nbLandmarks - 1);
+  std::uniform_int_distribution<voctree::Word> word(0, nbWords - 1);
+
+  for(IndexT landmarkId = 0; landmarkId < nbLandmarks; ++landmarkId)
+    sfmData.structure[landmarkId] = sfmData::Landmark(Vec3::Random(), feature::EImageDescriberType::SIFT);
+
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    sfmData.views[viewId] = std::make_shared<sfmData::View>("", viewId, 0, viewId, 1000, 1000);
+
+    std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions());
+    localization::ReconstructedRegionsMapping& mapping = mappingPerView[viewId][feature::EImageDescriberType::SIFT];
+    const std::size_t nbRegions = 10 + viewId * 7;
+    for(std::size_t i = 0; i < nbRegions; ++i)
+    {
+      regions->Features().emplace_back(position(generator), position(generator), 2.f, 0.5f);
+      feature::SIFT_Regions::DescriptorT descriptor;
+      for(std::size_t j = 0; j < descriptor.size(); ++j)
+        descriptor[j] = static_cast<unsigned char>(byte(generator));
+      regions->Descriptors().push_back(descriptor);
+      const IndexT landmarkId = landmark(generator);
+      mapping._associated3dPoint.push_back(landmarkId);
+      mapping._mapFullToLocal[i * 3] = i;
+      sfmData.structure[landmarkId].observations[viewId] = sfmData::Observation(Vec2(regions->Features().back().x(), regions->Features().back().y()), i * 3, 2.0);
+    }
+    regionsPerView.addRegions(viewId, feature::EImageDescriberType::SIFT, regions.release());
+
+    // the last view is not part of the voctree database
+    if(viewId + 1 == nbViews)
+      continue;
+    voctree::SparseHistogram& histogram = histograms[viewId];
+    for(IndexT i = 0; i < nbRegions; ++i)
+      histogram[word(generator)].push_back(i);
+  }
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Save a random reconstruction database
+// - Load it and assert that the regions, the associations and the histograms are identical
+//-----------------
+BOOST_AUTO_TEST_CASE(reconstructionDatabaseIO_roundtrip)
+{
+  sfmData::SfMData sfmData;
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+  voctree::SparseHistogramPerImage histograms;
+  generateDatabase(sfmData, regionsPerView, mappingPerView, histograms);
+
+  const std::string filepath = (bfs::temp_directory_path() / bfs::unique_path("reconstructionDatabase_%%%%-%%%%.avld")).string();
+  const std::vector<feature::EImageDescriberType> descTypes = {feature::EImageDescriberType::SIFT};
+  const std::uint64_t fingerprint = localization::computeReconstructionFingerprint(sfmData, {}, descTypes, {});
+
+  BOOST_REQUIRE(localization::saveReconstructionDatabase(filepath, fingerprint, nbWords, feature::EImageDescriberType::SIFT, descTypes,
+                                                         regionsPerView, mappingPerView, histograms));
+
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  imageDescribers.push_back(feature::createImageDescriber(feature::EImageDescriberType::SIFT));
+
+  feature::RegionsPerView loadedRegionsPerView;
+  localization::ReconstructedRegionsMappingPerView loadedMappingPerView;
+  voctree::SparseHistogramPerImage loadedHistograms;
+  BOOST_REQUIRE(localization::loadReconstructionDatabase(filepath, sfmData, fingerprint, nbWords, feature::EImageDescriberType::SIFT, imageDescribers,
+                                                         loadedRegionsPerView, loadedMappingPerView, loadedHistograms));
+
+  BOOST_CHECK_EQUAL(loadedRegionsPerView.getData().size(), nbViews);
+  for(IndexT viewId = 0; viewId < nbViews; ++viewId)
+  {
+    const auto& regions = dynamic_cast<const feature::SIFT_Regions&>(regionsPerView.getRegions(viewId, feature::EImageDescriberType::SIFT));
+    const auto& loadedRegions = dynamic_cast<const feature::SIFT_Regions&>(loadedRegionsPerView.getRegions(viewId, feature::EImageDescriberType::SIFT));
+
+    BOOST_REQUIRE_EQUAL(loadedRegions.RegionCount(), regions.RegionCount());
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+    {
+      BOOST_CHECK(loadedRegions.Features()[i] == regions.Features()[i]);
+      BOOST_CHECK(loadedRegions.Descriptors()[i] == regions.Descriptors()[i]);
+    }
+
+    const auto& mapping = mappingPerView.at(viewId).at(feature::EImageDescriberType::SIFT);
+    const auto& loadedMapping = loadedMappingPerView.at(viewId).at(feature::EImageDescriberType::SIFT);
+    BOOST_CHECK(loadedMapping._associated3dPoint == mapping._associated3dPoint);
+    BOOST_CHECK(loadedMapping._mapFullToLocal == mapping._mapFullToLocal);
+  }
+  BOOST_CHECK(loadedHistograms == histograms);
+
+  bfs::remove(filepath);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Save a random reconstruction database
+// - Assert that it is rejected with another vocabulary tree, another fingerprint,
+//   a reconstruction with another observed view or a reconstruction without its landmarks
+//-----------------
+BOOST_AUTO_TEST_CASE(reconstructionDatabaseIO_mismatch)
+{
+  sfmData::SfMData sfmData;
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+  voctree::SparseHistogramPerImage histograms;
+  generateDatabase(sfmData, regionsPerView, mappingPerView, histograms);
+
+  const std::string filepath = (bfs::temp_directory_path() / bfs::unique_path("reconstructionDatabase_%%%%-%%%%.avld")).string();
+  const std::vector<feature::EImageDescriberType> descTypes = {feature::EImageDescriberType::SIFT};
+  const std::uint64_t fingerprint = localization::computeReconstructionFingerprint(sfmData, {}, descTypes, {});
+
+  BOOST_REQUIRE(localization::saveReconstructionDatabase(filepath, fingerprint, nbWords, feature::EImageDescriberType::SIFT, descTypes,
+                                                         regionsPerView, mappingPerView, histograms));
+
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  imageDescribers.push_back(feature::createImageDescriber(feature::EImageDescriberType::SIFT));
+
+  feature::RegionsPerView loadedRegionsPerView;
+  localization::ReconstructedRegionsMappingPerView loadedMappingPerView;
+  voctree::SparseHistogramPerImage loadedHistograms;
+
+  BOOST_CHECK(!localization::loadReconstructionDatabase(filepath, sfmData, fingerprint, nbWords + 1, feature::EImageDescriberType::SIFT, imageDescribers,
+                                                        loadedRegionsPerView, loadedMappingPerView, loadedHistograms));
+
+  // another reconstruction with the same ids
+  BOOST_CHECK(!localization::loadReconstructionDatabase(filepath, sfmData, fingerprint + 1, nbWords, feature::EImageDescriberType::SIFT, imageDescribers,
+                                                        loadedRegionsPerView, loadedMappingPerView, loadedHistograms));
+
+  // the fingerprint changes with the observations and with the views
+  sfmData::SfMData changedSfmData = sfmData;
+  changedSfmData.structure.begin()->second.observations.begin()->second.id_feat += 1;
+  BOOST_CHECK(localization::computeReconstructionFingerprint(changedSfmData, {}, descTypes, {}) != fingerprint);
+
+  // an observed view is added to the reconstruction
+  changedSfmData = sfmData;
+  changedSfmData.views[nbViews] = std::make_shared<sfmData::View>("", nbViews, 0, nbViews, 1000, 1000);
+  changedSfmData.structure.begin()->second.observations[nbViews] = sfmData::Observation(Vec2(0.0, 0.0), 0, 2.0);
+  BOOST_CHECK(localization::computeReconstructionFingerprint(changedSfmData, {}, descTypes, {}) != fingerprint);
+  BOOST_CHECK(!localization::loadReconstructionDatabase(filepath, changedSfmData, fingerprint, nbWords, feature::EImageDescriberType::SIFT, imageDescribers,
+                                                        loadedRegionsPerView, loadedMappingPerView, loadedHistograms));
+
+  sfmData.structure.erase(0);
+  BOOST_CHECK(!localization::loadReconstructionDatabase(filepath, sfmData, fingerprint, nbWords, feature::EImageDescriberType::SIFT, imageDescribers,
+                                                        loadedRegionsPerView, loadedMappingPerView, loadedHistograms));
+  BOOST_CHECK(loadedRegionsPerView.getData().empty());
+
+  bfs::remove(filepath);
+}
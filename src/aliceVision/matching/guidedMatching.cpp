@@ -7,6 +7,10 @@
 
 #include "guidedMatching.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace aliceVision {
 namespace matching {
 
@@ -69,5 +73,95 @@ bool line_to_endPoints(const Vec3& line, int W, int H, Vec2& x0, Vec2& x1)
     return true;
 }
 
+void guidedMatchingProjection(const camera::IntrinsicBase& camera,
+                              const geometry::Pose3& pose,
+                              const Mat3X& points,
+                              const feature::Regions& lRegions,
+                              const feature::Regions& rRegions,
+                              const std::pair<std::size_t, std::size_t>& imageSize,
+                              double windowRadius,
+                              double distRatio,
+                              double maxDescriptorDistance,
+                              matching::IndMatches& out_matches)
+{
+    assert(points.cols() == lRegions.RegionCount());
+
+    const double width = static_cast<double>(imageSize.first);
+    const double height = static_cast<double>(imageSize.second);
+    if(rRegions.RegionCount() == 0 || windowRadius <= 0.0 || width <= 0.0 || height <= 0.0)
+        return;
+
+    // bucket the query features in a grid of cells of the size of the window
+    const int gridWidth = static_cast<int>(std::ceil(width / windowRadius));
+    const int gridHeight = static_cast<int>(std::ceil(height / windowRadius));
+    std::vector<std::vector<std::size_t>> grid(gridWidth * gridHeight);
+    const auto toCell = [&](double v, int size) {
+        return std::min(size - 1, std::max(0, static_cast<int>(std::floor(v / windowRadius))));
+    };
+    for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    {
+        const Vec2 x = rRegions.GetRegionPosition(j);
+        grid[toCell(x(1), gridHeight) * gridWidth + toCell(x(0), gridWidth)].push_back(j);
+    }
+
+    const double sqWindowRadius = windowRadius * windowRadius;
+    const double sqMaxDescriptorDistance = maxDescriptorDistance * maxDescriptorDistance;
+
+    Mat2X projections;
+    camera.projectPoints(pose, points, projections);
+
+    // best 3D point and descriptor distance for each query feature
+    std::vector<std::pair<std::size_t, double>> bestPerFeature(rRegions.RegionCount(),
+        std::make_pair(std::numeric_limits<std::size_t>::max(), std::numeric_limits<double>::max()));
+
+    for(Mat3X::Index i = 0; i < points.cols(); ++i)
+    {
+        const Vec3 X = points.col(i);
+        if(pose.depth(X) <= 0.0)
+            continue;
+
+        const Vec2 proj = projections.col(i);
+        if(proj(0) < -windowRadius || proj(0) > width + windowRadius ||
+           proj(1) < -windowRadius || proj(1) > height + windowRadius)
+            continue;
+
+        distanceRatio<double> dR;
+        const int minCellX = toCell(proj(0) - windowRadius, gridWidth);
+        const int maxCellX = toCell(proj(0) + windowRadius, gridWidth);
+        const int minCellY = toCell(proj(1) - windowRadius, gridHeight);
+        const int maxCellY = toCell(proj(1) + windowRadius, gridHeight);
+        for(int cellY = minCellY; cellY <= maxCellY; ++cellY)
+        {
+            for(int cellX = minCellX; cellX <= maxCellX; ++cellX)
+            {
+                for(const std::size_t j : grid[cellY * gridWidth + cellX])
+                {
+                    if((rRegions.GetRegionPosition(j) - proj).squaredNorm() > sqWindowRadius)
+                        continue;
+                    dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+                }
+            }
+        }
+
+        // no feature in the window or no descriptor close enough, even for a single candidate
+        if(dR.bd > sqMaxDescriptorDistance || dR.bd == std::numeric_limits<double>::max())
+            continue;
+        // the distance ratio is only meaningful with several candidates
+        if(dR.sbd != std::numeric_limits<double>::max() && !dR.isValid(distRatio))
+            continue;
+
+        // keep the closest 3D point of each query feature
+        std::pair<std::size_t, double>& best = bestPerFeature[dR.idx];
+        if(dR.bd < best.second)
+            best = std::make_pair(static_cast<std::size_t>(i), dR.bd);
+    }
+
+    for(std::size_t j = 0; j < bestPerFeature.size(); ++j)
+    {
+        if(bestPerFeature[j].first != std::numeric_limits<std::size_t>::max())
+            out_matches.emplace_back(bestPerFeature[j].first, j);
+    }
+}
+
+}
 }
-}
\ No newline at end of file
@@ -315,6 +315,37 @@ void guidedMatching(const ModelT& mod,
   }
 }
 
+/**
+ * @brief Guided Matching (3D points + descriptors with distance ratio):
+ *        Project the 3D points with a predicted camera pose and keep, for each
+ *        of them, the query feature with the closest descriptor among the
+ *        features lying in a window around its projection.
+ *        The query features are bucketed in a grid so that each point only
+ *        visits the features of its window.
+ *
+ * @param[in] camera The camera intrinsics of the query image
+ * @param[in] pose The predicted pose of the query image
+ * @param[in] points The 3D points, one column per region of \p lRegions
+ * @param[in] lRegions regions describing the 3D points (only the descriptors are used)
+ * @param[in] rRegions regions of the query image
+ * @param[in] imageSize The size of the query image
+ * @param[in] windowRadius The radius (in pixels) of the search window around the projections
+ * @param[in] distRatio Maximal authorized distance ratio, used when the window contains several features
+ * @param[in] maxDescriptorDistance Maximal descriptor distance of a match, also used when the window contains a single feature
+ * @param[out] out_matches Ouput corresponding index (3D point index, query feature index),
+ *             each query feature is matched at most once
+ */
+void guidedMatchingProjection(const camera::IntrinsicBase& camera,
+                              const geometry::Pose3& pose,
+                              const Mat3X& points,
+                              const feature::Regions& lRegions,
+                              const feature::Regions& rRegions,
+                              const std::pair<std::size_t, std::size_t>& imageSize,
+                              double windowRadius,
+                              double distRatio,
+                              double maxDescriptorDistance,
+                              matching::IndMatches& out_matches);
+
 /**
  * @brief Compute a bucket index from an epipolar point
  *        (the one that is closer to image border intersection)
@@ -0,0 +1,115 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matching/guidedMatching.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+#include "aliceVision/camera/Pinhole.hpp"
+
+#include <limits>
+#include <random>
+
+#define BOOST_TEST_MODULE guidedMatching
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+//-----------------
+// Test summary:
+//-----------------
+// - Generate 3D points in front of a camera and the features observing them, with a small motion
+// - Predict their position with the previous pose and match them in a window
+// - Assert that each point is matched with its own feature, and that a too small window finds nothing
+//-----------------
+BOOST_AUTO_TEST_CASE(guidedMatchingProjection_window)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+  std::uniform_real_distribution<double> depth(4.0, 8.0);
+  std::uniform_int_distribution<int> byte(0, 255);
+
+  const std::pair<std::size_t, std::size_t> imageSize(1000, 800);
+  const camera::Pinhole camera(imageSize.first, imageSize.second, 800.0, 500.0, 400.0);
+
+  const geometry::Pose3 previousPose;
+  // the camera moves by a few centimeters between the two frames
+  const geometry::Pose3 currentPose(Mat3::Identity(), Vec3(0.02, -0.01, 0.0));
+
+  const std::size_t nbPoints = 300;
+  Mat3X points(3, nbPoints);
+  feature::SIFT_Regions pointsRegions;
+  feature::SIFT_Regions queryRegions;
+
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    const double z = depth(generator);
+    points.col(i) = Vec3(coordinate(generator) * z * 0.6, coordinate(generator) * z * 0.5, z);
+
+    feature::SIFT_Regions::DescriptorT descriptor;
+    for(std::size_t j = 0; j < descriptor.size(); ++j)
+      descriptor[j] = static_cast<unsigned char>(byte(generator));
+    pointsRegions.Features().emplace_back(0.f, 0.f, 1.f, 0.f);
+    pointsRegions.Descriptors().push_back(descriptor);
+
+    // the query feature i observes the point i in the current frame
+    const Vec2 x = camera.project(currentPose, points.col(i));
+    queryRegions.Features().emplace_back(static_cast<float>(x(0)), static_cast<float>(x(1)), 1.f, 0.f);
+    queryRegions.Descriptors().push_back(descriptor);
+  }
+
+  IndMatches matches;
+  guidedMatchingProjection(camera, previousPose, points, pointsRegions, queryRegions, imageSize, 20.0, 0.8, 250.0, matches);
+
+  BOOST_CHECK_EQUAL(matches.size(), nbPoints);
+  for(const IndMatch& match : matches)
+    BOOST_CHECK_EQUAL(match._i, match._j);
+
+  // the motion moves the projections by at least a pixel, they are not found in a smaller window
+  IndMatches noMatches;
+  guidedMatchingProjection(camera, previousPose, points, pointsRegions, queryRegions, imageSize, 0.5, 0.8, 250.0, noMatches);
+  BOOST_CHECK(noMatches.empty());
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Project a single 3D point next to a single query feature with another descriptor
+// - Assert that the feature alone in the window is rejected by the descriptor distance
+//-----------------
+BOOST_AUTO_TEST_CASE(guidedMatchingProjection_singleCandidate)
+{
+  const std::pair<std::size_t, std::size_t> imageSize(1000, 800);
+  const camera::Pinhole camera(imageSize.first, imageSize.second, 800.0, 500.0, 400.0);
+  const geometry::Pose3 pose;
+
+  Mat3X points(3, 1);
+  points.col(0) = Vec3(0.1, -0.2, 5.0);
+
+  feature::SIFT_Regions pointsRegions;
+  feature::SIFT_Regions queryRegions;
+  feature::SIFT_Regions::DescriptorT descriptor;
+  feature::SIFT_Regions::DescriptorT otherDescriptor;
+  for(std::size_t j = 0; j < descriptor.size(); ++j)
+  {
+    descriptor[j] = static_cast<unsigned char>(j % 2 ? 200 : 0);
+    otherDescriptor[j] = static_cast<unsigned char>(j % 2 ? 0 : 200);
+  }
+  pointsRegions.Features().emplace_back(0.f, 0.f, 1.f, 0.f);
+  pointsRegions.Descriptors().push_back(descriptor);
+
+  const Vec2 x = camera.project(pose, points.col(0));
+  queryRegions.Features().emplace_back(static_cast<float>(x(0)) + 2.f, static_cast<float>(x(1)), 1.f, 0.f);
+  queryRegions.Descriptors().push_back(otherDescriptor);
+
+  IndMatches matches;
+  guidedMatchingProjection(camera, pose, points, pointsRegions, queryRegions, imageSize, 20.0, 0.8, 250.0, matches);
+  BOOST_CHECK(matches.empty());
+
+  guidedMatchingProjection(camera, pose, points, pointsRegions, queryRegions, imageSize, 20.0, 0.8,
+                           std::numeric_limits<double>::infinity(), matches);
+  BOOST_CHECK_EQUAL(matches.size(), 1);
+}
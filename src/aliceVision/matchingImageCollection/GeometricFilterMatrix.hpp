@@ -58,6 +58,7 @@ struct GeometricFilterMatrix
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
   std::size_t m_stIteration; //maximal number of iteration for robust estimation
+  bool m_useSPRT = false; //reject bad hypotheses early with a SPRT during robust estimation
 };
 
 
@@ -228,7 +228,7 @@ struct GeometricFilterMatrix_F_AC : public GeometricFilterMatrix
       const double upper_bound_precision = Square(m_dPrecision);
 
       robustEstimation::Mat3Model model;
-      const std::pair<double, double> ACRansacOut = ACRANSAC(kernel, out_inliers, m_stIteration, &model, upper_bound_precision);
+      const std::pair<double, double> ACRansacOut = ACRANSAC(kernel, out_inliers, m_stIteration, &model, upper_bound_precision, m_useSPRT);
 
       m_F = model.getMatrix();
 
@@ -275,7 +275,7 @@ struct GeometricFilterMatrix_F_AC : public GeometricFilterMatrix
     const double upperBoundPrecision = Square(m_dPrecision);
 
     ModelT_ model;
-    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSAC(kernel, out_inliers, m_stIteration, &model, upperBoundPrecision);
+    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSAC(kernel, out_inliers, m_stIteration, &model, upperBoundPrecision, m_useSPRT);
     m_F = model.getMatrix();
 
     if(out_inliers.empty())
@@ -321,9 +321,17 @@ struct GeometricFilterMatrix_F_AC : public GeometricFilterMatrix
 
     //@fixme scorer should be using the pixel error, not the squared version, refactoring needed
     const double normalizedThreshold = Square(m_dPrecision * kernel.normalizer2()(0, 0));
-    robustEstimation::ScoreEvaluator<KernelT> scorer(normalizedThreshold);
-
-    robustEstimation::Mat3Model model = robustEstimation::LO_RANSAC(kernel, scorer, &out_inliers);
+    robustEstimation::Mat3Model model;
+    if(m_useSPRT)
+    {
+      const robustEstimation::ScoreEvaluatorSPRT<KernelT> scorer(normalizedThreshold);
+      model = robustEstimation::LO_RANSAC(kernel, scorer, &out_inliers);
+    }
+    else
+    {
+      const robustEstimation::ScoreEvaluator<KernelT> scorer(normalizedThreshold);
+      model = robustEstimation::LO_RANSAC(kernel, scorer, &out_inliers);
+    }
     m_F = model.getMatrix();
 
     if(out_inliers.empty())
@@ -5,6 +5,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "MeshTopology.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
@@ -12,8 +14,10 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cmath>
 #include <fstream>
 #include <map>
+#include <numeric>
 
 namespace aliceVision {
 namespace mesh {
@@ -28,93 +32,6 @@ Mesh::~Mesh()
 {
 }
 
-void Mesh::saveToObj(const std::string& filename)
-{
-  ALICEVISION_LOG_INFO("Save mesh to obj: " << filename);
-  ALICEVISION_LOG_INFO("Nb points: " << pts.size());
-  ALICEVISION_LOG_INFO("Nb triangles: " << tris.size());
-
-  FILE* f = fopen(filename.c_str(), "w");
-
-  fprintf(f, "# \n");
-  fprintf(f, "# Wavefront OBJ file\n");
-  fprintf(f, "# Created with AliceVision\n");
-  fprintf(f, "# \n");
-  fprintf(f, "g Mesh\n");
-
-  if(_colors.size() == pts.size())
-  {
-    std::size_t i = 0;
-    for(const auto& point : pts)
-    {
-      const rgb& col = _colors[i];
-      fprintf(f, "v %f %f %f %f %f %f\n", point.x, point.y, point.z, col.r/255.0f, col.g/255.0f, col.b/255.0f);
-      ++i;
-    }
-  }
-  else
-  {
-    for(const auto& point : pts)
-      fprintf(f, "v %f %f %f\n", point.x, point.y, point.z);    
-  }
-
-  for(int i = 0; i < tris.size(); i++)
-  {
-      Mesh::triangle& t = tris[i];
-      fprintf(f, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
-  }
-  fclose(f);
-  ALICEVISION_LOG_INFO("Save mesh to obj done.");
-}
-
-bool Mesh::loadFromBin(const std::string& binFileName)
-{
-    FILE* f = fopen(binFileName.c_str(), "rb");
-
-    if(f == nullptr)
-        return false;
-
-    int npts;
-    fread(&npts, sizeof(int), 1, f);
-    pts = StaticVector<Point3d>();
-    pts.resize(npts);
-    fread(&pts[0], sizeof(Point3d), npts, f);
-
-    int ntris;
-    fread(&ntris, sizeof(int), 1, f);
-    tris = StaticVector<Mesh::triangle>();
-    tris.resize(ntris);
-    fread(&tris[0], sizeof(Mesh::triangle), ntris, f);
-
-    fclose(f);
-    return true;
-}
-
-void Mesh::saveToBin(const std::string& binFileName)
-{
-    long t = std::clock();
-    ALICEVISION_LOG_DEBUG("Save mesh to bin.");
-    // printf("open\n");
-    FILE* f = fopen(binFileName.c_str(), "wb");
-
-    int npts = pts.size();
-    // printf("write npts %i\n",npts);
-    fwrite(&npts, sizeof(int), 1, f);
-    // printf("write pts\n");
-    fwrite(&pts[0], sizeof(Point3d), npts, f);
-
-    int ntris = tris.size();
-    // printf("write ntris %i\n",ntris);
-    fwrite(&ntris, sizeof(int), 1, f);
-    // printf("write tris\n");
-    fwrite(&tris[0], sizeof(Mesh::triangle), ntris, f);
-
-    // printf("close\n");
-    fclose(f);
-    // printf("done\n");
-    mvsUtils::printfElapsedTime(t, "Save mesh to bin ");
-}
-
 void Mesh::addMesh(const Mesh& mesh)
 {
     const std::size_t npts = pts.size();
@@ -144,6 +61,7 @@ void Mesh::addMesh(const Mesh& mesh)
             ALICEVISION_LOG_WARNING("addMesh: bad triangle index: " << t.v[0] << " " << t.v[1] << " " << t.v[2] << ", npts: " << mesh.pts.size());
         }
     }
+    invalidateTopology();
 
     if(!mesh.uvCoords.empty())
     {
@@ -462,226 +380,219 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj& tp, Mesh::rectan
     */
 }
 
-void Mesh::getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const
+std::shared_ptr<const MeshTopology> Mesh::getTopology() const
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris.size() * 3);
-    for(int i = 0; i < tris.size(); ++i)
-    {
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel(tris[i].v[2], i, 0));
-    }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    std::lock_guard<std::mutex> lock(_topologyCache.mutex);
+    const std::shared_ptr<const MeshTopology>& topology = _topologyCache.topology;
+    if(!topology || topology->getNbPoints() != pts.size() || topology->getNbTriangles() != tris.size())
+        _topologyCache.topology = std::make_shared<const MeshTopology>(*this);
+    return _topologyCache.topology;
+}
 
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
-    {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
-        {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
-        }
-        ++i;
-    }
-    int npts = j;
+void Mesh::invalidateTopology()
+{
+    std::lock_guard<std::mutex> lock(_topologyCache.mutex);
+    _topologyCache.topology.reset();
+}
+
+void Mesh::getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const
+{
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
 
-    out_ptsNeighTris.reserve(pts.size());
     out_ptsNeighTris.resize(pts.size());
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < pts.size(); ++ptId)
     {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
-
-        StaticVector<int>& triTmp = out_ptsNeighTris[middlePtId];
-        triTmp.reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
-        {
-            triTmp.push_back(vertexNeighborhoodPairs[l].y); // index of triangle
-        }
+        const MeshTopology::IndexRange ptTriangles = topology->getPtTriangles(ptId);
+        out_ptsNeighTris[ptId].getDataWritable().assign(ptTriangles.begin(), ptTriangles.end());
     }
 }
 
 void Mesh::getPtsNeighbors(std::vector<std::vector<int>>& out_ptsNeigh) const
 {
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
+
     out_ptsNeigh.resize(pts.size());
-    for(int triangleId = 0; triangleId < tris.size(); ++triangleId)
+
+    #pragma omp parallel for
+    for(int ptId = 0; ptId < pts.size(); ++ptId)
     {
-        const Mesh::triangle& triangle = tris[triangleId];
-        for(int k = 0; k < 3; ++k)
-        {
-            int ptId = triangle.v[k];
-            std::vector<int>& ptNeigh = out_ptsNeigh[ptId];
-            if(std::find(ptNeigh.begin(), ptNeigh.end(), triangle.v[(k+1)%3]) == ptNeigh.end())
-                ptNeigh.push_back(triangle.v[(k+1)%3]);
-            if(std::find(ptNeigh.begin(), ptNeigh.end(), triangle.v[(k+2)%3]) == ptNeigh.end())
-                ptNeigh.push_back(triangle.v[(k+2)%3]);
-        }
+        const MeshTopology::IndexRange ptNeighbors = topology->getPtNeighbors(ptId);
+        out_ptsNeigh[ptId].assign(ptNeighbors.begin(), ptNeighbors.end());
     }
 }
 
-
 void Mesh::getPtsNeighPtsOrdered(StaticVector<StaticVector<int>>& out_ptsNeighPts) const
 {
-    StaticVector<StaticVector<int>> ptsNeighborTriangles;
-    getPtsNeighborTriangles(ptsNeighborTriangles);
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
 
     out_ptsNeighPts.resize(pts.size());
 
-    for(int middlePtId = 0; middlePtId < pts.size(); ++middlePtId)
+    #pragma omp parallel
     {
-        StaticVector<int>& neighborTriangles = ptsNeighborTriangles[middlePtId];
-        if(neighborTriangles.empty())
-            continue;
-
+        // scratch buffers reused for all the points of the thread
+        StaticVector<int> neighborTriangles;
         StaticVector<int> vhid;
-        vhid.reserve(neighborTriangles.size() * 2);
-        int currentTriPtId = tris[neighborTriangles[0]].v[0];
-        int firstTriPtId = currentTriPtId;
-        vhid.push_back(currentTriPtId);
 
-        bool isThereTWithCurrentTriPtId = true;
-        while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
+        #pragma omp for schedule(dynamic, 1024)
+        for(int middlePtId = 0; middlePtId < pts.size(); ++middlePtId)
         {
-            isThereTWithCurrentTriPtId = false;
+            const MeshTopology::IndexRange ptTriangles = topology->getPtTriangles(middlePtId);
+            if(ptTriangles.empty())
+                continue;
 
-            // find triangle with middlePtId and currentTriPtId and get remaining point id
-            for(int n = 0; n < neighborTriangles.size(); ++n)
+            neighborTriangles.resize(0);
+            neighborTriangles.getDataWritable().assign(ptTriangles.begin(), ptTriangles.end());
+
+            vhid.resize(0);
+            vhid.reserve(neighborTriangles.size() * 2);
+            int currentTriPtId = tris[neighborTriangles[0]].v[0];
+            int firstTriPtId = currentTriPtId;
+            vhid.push_back(currentTriPtId);
+
+            bool isThereTWithCurrentTriPtId = true;
+            while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
             {
-                bool ok_middlePtId = false;
-                bool ok_actTriPtId = false;
-                int remainingPtId = -1; // remaining pt id
-                for(int k = 0; k < 3; ++k)
+                isThereTWithCurrentTriPtId = false;
+
+                // find triangle with middlePtId and currentTriPtId and get remaining point id
+                for(int n = 0; n < neighborTriangles.size(); ++n)
                 {
-                    int triPtId = tris[neighborTriangles[n]].v[k];
-                    double length = (pts[middlePtId] - pts[triPtId]).size();
-                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
-                    {
-                        remainingPtId = triPtId;
-                    }
-                    if(triPtId == middlePtId)
+                    bool ok_middlePtId = false;
+                    bool ok_actTriPtId = false;
+                    int remainingPtId = -1; // remaining pt id
+                    for(int k = 0; k < 3; ++k)
                     {
-                        ok_middlePtId = true;
+                        int triPtId = tris[neighborTriangles[n]].v[k];
+                        double length = (pts[middlePtId] - pts[triPtId]).size();
+                        if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
+                        {
+                            remainingPtId = triPtId;
+                        }
+                        if(triPtId == middlePtId)
+                        {
+                            ok_middlePtId = true;
+                        }
+                        if(triPtId == currentTriPtId)
+                        {
+                            ok_actTriPtId = true;
+                        }
                     }
-                    if(triPtId == currentTriPtId)
+
+                    if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
                     {
-                        ok_actTriPtId = true;
+                        currentTriPtId = remainingPtId;
+                        neighborTriangles.remove(n);
+                        vhid.push_back(currentTriPtId);
+                        isThereTWithCurrentTriPtId = true; // we removed one, so we try again
+                        break;
                     }
                 }
-
-                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
-                {
-                    currentTriPtId = remainingPtId;
-                    neighborTriangles.remove(n);
-                    vhid.push_back(currentTriPtId);
-                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
-                    break;
-                }
             }
-        }
 
-        if(!vhid.empty())
-        {
-            if(currentTriPtId == firstTriPtId)
+            if(!vhid.empty())
             {
-                vhid.pop(); // remove last ... which is first
-            }
+                if(currentTriPtId == firstTriPtId)
+                {
+                    vhid.pop(); // remove last ... which is first
+                }
 
-            // remove duplicates
-            StaticVector<int>& vhid1 = out_ptsNeighPts[middlePtId];
-            vhid1.reserve(vhid.size());
-            for(int k1 = 0; k1 < vhid.size(); k1++)
-            {
-                if(vhid1.indexOf(vhid[k1]) == -1)
+                // remove duplicates
+                StaticVector<int>& vhid1 = out_ptsNeighPts[middlePtId];
+                vhid1.reserve(vhid.size());
+                for(int k1 = 0; k1 < vhid.size(); k1++)
                 {
-                    vhid1.push_back(vhid[k1]);
+                    if(vhid1.indexOf(vhid[k1]) == -1)
+                    {
+                        vhid1.push_back(vhid[k1]);
+                    }
                 }
             }
         }
     }
 }
 
-void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, const mvsUtils::MultiViewParams& mp, int rc, int  /*scale*/, int w, int h)
-{
-    long tstart = clock();
-
-    ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int> nmap;
-    nmap.reserve(w * h);
-    nmap.resize_with(w * h, 0);
+namespace {
 
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < tris.size(); i++)
+/**
+ * @brief Edge functions of a projected triangle, used to classify the pixels of its bounding box
+ * without the exact (and expensive) triangle / rectangle overlap test.
+ * The classification is conservative: pixels close to an edge and pixels of degenerated
+ * triangles are ambiguous and have to be tested exactly.
+ */
+class TriangleEdgeFunctions
+{
+public:
+    enum class EPixelOverlap
     {
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(mp, tp, rc, 0)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(tp, re))
-                    {
-                        nmap[pix.x * h + pix.y] += 1;
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris.size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
+        OUTSIDE,
+        INSIDE,
+        AMBIGUOUS
+    };
 
-    // allocate
-    out.reserve(w * h);
-    out.resize(w * h);
-    for(int i = 0; i < w * h; i++)
+    explicit TriangleEdgeFunctions(const Point2d* p)
     {
-        if(nmap[i] > 0)
+        const double area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+        _degenerated = (std::abs(area) < 1e-6);
+
+        for(int k = 0; k < 3 && !_degenerated; ++k)
         {
-            out[i].reserve(nmap[i]);
+            const Point2d& a = p[k];
+            const Point2d& b = p[(k + 1) % 3];
+            const double length = std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+            _degenerated = (length < 1e-6);
+            // unit normal of the edge, oriented toward the inside of the triangle
+            const double orientation = (area > 0.0) ? 1.0 : -1.0;
+            _a[k] = -(b.y - a.y) / length * orientation;
+            _b[k] = (b.x - a.x) / length * orientation;
+            _c[k] = -(_a[k] * a.x + _b[k] * a.y);
+            // half extent of the pixel square along the normal
+            _halfExtent[k] = 0.5 * (std::abs(_a[k]) + std::abs(_b[k]));
         }
     }
 
-    // fill
-    t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < tris.size(); i++)
+    /// classify the pixel square [x, x+1] x [y, y+1]
+    EPixelOverlap classifyPixel(int x, int y) const
     {
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(mp, tp, rc, 0)))
+        if(_degenerated)
+            return EPixelOverlap::AMBIGUOUS;
+
+        const double cx = x + 0.5;
+        const double cy = y + 0.5;
+        bool inside = true;
+        for(int k = 0; k < 3; ++k)
         {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(tp, re))
-                    {
-                        out[pix.x * h + pix.y].push_back(i);
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris.size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
+            const double distance = _a[k] * cx + _b[k] * cy + _c[k];
+            if(distance < -_halfExtent[k] - margin)
+                return EPixelOverlap::OUTSIDE;
+            if(distance < _halfExtent[k] + margin)
+                inside = false;
+        }
+        return inside ? EPixelOverlap::INSIDE : EPixelOverlap::AMBIGUOUS;
+    }
 
-    mvsUtils::printfElapsedTime(tstart);
+private:
+    /// safety distance (in pixels) to the edges to avoid rounding issues
+    static constexpr double margin = 1e-3;
+
+    bool _degenerated;
+    double _a[3];
+    double _b[3];
+    double _c[3];
+    double _halfExtent[3];
+};
+
+constexpr double TriangleEdgeFunctions::margin;
+
+} // namespace
+
+void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h)
+{
+    StaticVector<int> allTris;
+    allTris.resize(tris.size());
+    std::iota(allTris.begin(), allTris.end(), 0);
+    getTrisMap(out, allTris, mp, rc, scale, w, h);
 }
 
 void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, StaticVector<int>& visTris, const mvsUtils::MultiViewParams& mp, int rc,
@@ -690,70 +601,87 @@ void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, StaticVector<int>& v
     long tstart = clock();
 
     ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int> nmap;
-    nmap.reserve(w * h);
-    nmap.resize_with(w * h, 0);
 
-    long t1 = mvsUtils::initEstimate();
-    for(int m = 0; m < visTris.size(); m++)
-    {
-        int i = visTris[m];
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(mp, tp, rc, 0)))
-        {
-            Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
-            {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
-                {
-                    Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(tp, re))
-                    {
-                        nmap[pix.x * h + pix.y] += 1;
-                    }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris.size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
+    // project the triangles
+    const int nbTris = visTris.size();
+    std::vector<triangle_proj> trisProj(nbTris);
+    std::vector<char> trisInImage(nbTris);
 
-    // allocate
-    out.resize(w * h);
-    for(int i = 0; i < w * h; i++)
+    #pragma omp parallel for
+    for(int m = 0; m < nbTris; ++m)
     {
-        if(nmap[i] > 0)
-        {
-            out[i].reserve(nmap[i]);
-        }
+        trisProj[m] = getTriangleProjection(visTris[m], mp, rc, w, h);
+        trisInImage[m] = isTriangleProjectionInImage(mp, trisProj[m], rc, 0);
     }
 
-    // fill
-    t1 = mvsUtils::initEstimate();
-    for(int m = 0; m < visTris.size(); m++)
+    getTrisMap(out, visTris, trisProj, trisInImage, w, h);
+
+    mvsUtils::printfElapsedTime(tstart);
+}
+
+void Mesh::getTrisMap(StaticVector<StaticVector<int>>& out, const StaticVector<int>& visTris, const std::vector<triangle_proj>& trisProj,
+                      const std::vector<char>& trisInImage, int w, int h)
+{
+    const int nbTris = visTris.size();
+
+    // assign the triangles to the image tiles overlapped by their bounding box, in order
+    const int tileSize = 64;
+    const int nbTilesX = (w + tileSize - 1) / tileSize;
+    const int nbTilesY = (h + tileSize - 1) / tileSize;
+    std::vector<std::vector<int>> tilesTris(nbTilesX * nbTilesY);
+
+    for(int m = 0; m < nbTris; ++m)
+    {
+        if(!trisInImage[m])
+            continue;
+        const triangle_proj& tp = trisProj[m];
+        const int tileXBegin = std::max(0, tp.lu.x) / tileSize;
+        const int tileXEnd = std::min(w - 1, tp.rd.x) / tileSize;
+        const int tileYBegin = std::max(0, tp.lu.y) / tileSize;
+        const int tileYEnd = std::min(h - 1, tp.rd.y) / tileSize;
+        for(int tileX = tileXBegin; tileX <= tileXEnd; ++tileX)
+            for(int tileY = tileYBegin; tileY <= tileYEnd; ++tileY)
+                tilesTris[tileX * nbTilesY + tileY].push_back(m);
+    }
+
+    // rasterize the tiles in parallel, each pixel is owned by a single tile
+    // and receives its triangles in the input order
+    out.resize(w * h);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int tileId = 0; tileId < tilesTris.size(); ++tileId)
     {
-        int i = visTris[m];
-        triangle_proj tp = getTriangleProjection(i, mp, rc, w, h);
-        if((isTriangleProjectionInImage(mp, tp, rc, 0)))
+        const int tileX = tileId / nbTilesY;
+        const int tileY = tileId % nbTilesY;
+
+        for(const int m : tilesTris[tileId])
         {
+            triangle_proj tp = trisProj[m];
+            const TriangleEdgeFunctions edgeFunctions(tp.tp2ds);
+
+            const int xBegin = std::max(tileX * tileSize, tp.lu.x);
+            const int xEnd = std::min(std::min((tileX + 1) * tileSize, w) - 1, tp.rd.x);
+            const int yBegin = std::max(tileY * tileSize, tp.lu.y);
+            const int yEnd = std::min(std::min((tileY + 1) * tileSize, h) - 1, tp.rd.y);
+
             Pixel pix;
-            for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
+            for(pix.x = xBegin; pix.x <= xEnd; ++pix.x)
             {
-                for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
+                for(pix.y = yBegin; pix.y <= yEnd; ++pix.y)
                 {
+                    const TriangleEdgeFunctions::EPixelOverlap overlap = edgeFunctions.classifyPixel(pix.x, pix.y);
+                    if(overlap == TriangleEdgeFunctions::EPixelOverlap::OUTSIDE)
+                        continue;
+
                     Mesh::rectangle re = Mesh::rectangle(pix, 1);
-                    if(doesTriangleIntersectsRectangle(tp, re))
+                    if(overlap == TriangleEdgeFunctions::EPixelOverlap::INSIDE || doesTriangleIntersectsRectangle(tp, re))
                     {
-                        out[pix.x * h + pix.y].push_back(i);
+                        out[pix.x * h + pix.y].push_back(visTris[m]);
                     }
-                } // for y
-            }     // for x
-        }         // isthere
-        mvsUtils::printfEstimate(i, tris.size(), t1);
-    } // for i ntris
-    mvsUtils::finishEstimate();
-
-    mvsUtils::printfElapsedTime(tstart);
+                }
+            }
+        }
+    }
 }
 
 void Mesh::getDepthMap(StaticVector<float>& depthMap, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h)
@@ -768,9 +696,10 @@ void Mesh::getDepthMap(StaticVector<float>& depthMap, StaticVector<StaticVector<
 {
     depthMap.resize_with(w * h, -1.0f);
 
-    Pixel pix;
-    for(pix.x = 0; pix.x < w; pix.x++)
+    #pragma omp parallel for
+    for(int x = 0; x < w; x++)
     {
+        Pixel pix(x, 0);
         for(pix.y = 0; pix.y < h; pix.y++)
         {
 
@@ -925,9 +854,10 @@ void Mesh::getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, StaticVecto
     btris.reserve(tris.size());
     btris.resize_with(tris.size(), false);
 
-    Pixel pix;
-    for(pix.x = 0; pix.x < w; pix.x++)
+    #pragma omp parallel for
+    for(int x = 0; x < w; x++)
     {
+        Pixel pix(x, 0);
         for(pix.y = 0; pix.y < h; pix.y++)
         {
             StaticVector<int>& ti = trisMap[pix.x * h + pix.y];
@@ -977,6 +907,7 @@ void Mesh::getVisibleTrianglesIndexes(StaticVector<int>& out_visTri, StaticVecto
                     float pixSize = mp.getCamPixelSize(lpi, rc) * 2.0f;
                     if(fabs(depth - lpidepth) < pixSize)
                     {
+                        #pragma omp atomic write
                         btris[idTri] = true;
                     }
                 }
@@ -1057,56 +988,19 @@ void Mesh::generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, Mes
 
 void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>>& edgesNeighTris, StaticVector<Pixel>& edgesPointsPairs)
 {
-    StaticVector<Voxel> edges;
-    edges.reserve(tris.size() * 3);
-
-    for(int i = 0; i < tris.size(); i++)
-    {
-        int a = tris[i].v[0];
-        int b = tris[i].v[1];
-        int c = tris[i].v[2];
-        edges.push_back(Voxel(std::min(a, b), std::max(a, b), i));
-        edges.push_back(Voxel(std::min(b, c), std::max(b, c), i));
-        edges.push_back(Voxel(std::min(c, a), std::max(c, a), i));
-    }
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
+    const int nbEdges = topology->getNbEdges();
 
-    qsort(&edges[0], edges.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
+    edgesNeighTris.resize(nbEdges);
+    edgesPointsPairs.resize(nbEdges);
 
-    edgesNeighTris.reserve(tris.size() * 3);
-    edgesPointsPairs.reserve(tris.size() * 3);
-    // remove duplicities
-    int i0 = 0;
-    long t1 = mvsUtils::initEstimate();
-    for(int i = 0; i < edges.size(); i++)
+    #pragma omp parallel for
+    for(int edgeId = 0; edgeId < nbEdges; ++edgeId)
     {
-        if((i == edges.size() - 1) || (edges[i].x != edges[i + 1].x))
-        {
-            StaticVector<Voxel> edges1;
-            edges1.reserve(i - i0 + 1);
-            edges1.getDataWritable().insert(edges1.begin(), edges.begin()+i0, edges.begin()+i+1);
-            qsort(&edges1[0], edges1.size(), sizeof(Voxel), qSortCompareVoxelByYAsc);
-
-            int j0 = 0;
-            for(int j = 0; j < edges1.size(); j++)
-            {
-                if((j == edges1.size() - 1) || (edges1[j].y != edges1[j + 1].y))
-                {
-                    edgesPointsPairs.push_back(Pixel(edges1[j].x, edges1[j].y));
-                    edgesNeighTris.resize(edgesNeighTris.size() + 1);
-                    StaticVector<int>& neighTris = edgesNeighTris.back();
-                    neighTris.reserve(j - j0 + 1);
-                    for(int k = j0; k <= j; k++)
-                    {
-                        neighTris.push_back(edges1[k].z);
-                    }
-                    j0 = j + 1;
-                }
-            }
-            i0 = i + 1;
-        }
-        mvsUtils::printfEstimate(i, edges.size(), t1);
+        const MeshTopology::IndexRange edgeTriangles = topology->getEdgeTriangles(edgeId);
+        edgesNeighTris[edgeId].getDataWritable().assign(edgeTriangles.begin(), edgeTriangles.end());
+        edgesPointsPairs[edgeId] = topology->getEdgePoints(edgeId);
     }
-    mvsUtils::finishEstimate();
 }
 
 void Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>>& ptsNeighPts, StaticVector<Point3d>& out_nms,
@@ -1296,6 +1190,7 @@ void Mesh::removeFreePointsFromMesh(StaticVector<int>& out_ptIdToNewPtId)
 
     std::swap(cleanedMesh.pts, pts);
     std::swap(cleanedMesh.tris, tris);
+    invalidateTopology();
     std::swap(cleanedMesh._colors, _colors);
 }
 
@@ -1331,51 +1226,16 @@ double Mesh::computeTriangleArea(int idTri) const
     return sqrt(p * (p - a) * (p - b) * (p - c));
 }
 
-void Mesh::getTrianglesEdgesIds(const StaticVector<StaticVector<int>>& edgesNeighTris, StaticVector<Voxel>& out) const
+void Mesh::getTrianglesEdgesIds(StaticVector<Voxel>& out) const
 {
-    out.reserve(tris.size());
-    out.resize_with(tris.size(), Voxel(-1, -1, -1));
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
+    const int nbTriangles = topology->getNbTriangles();
 
-    for(int i = 0; i < edgesNeighTris.size(); i++)
-    {
-        for(int j = 0; j < edgesNeighTris[i].size(); j++)
-        {
-            int idTri = edgesNeighTris[i][j];
+    out.resize(nbTriangles);
 
-            if(out[idTri].x == -1)
-            {
-                out[idTri].x = i;
-            }
-            else
-            {
-                if(out[idTri].y == -1)
-                {
-                    out[idTri].y = i;
-                }
-                else
-                {
-                    if(out[idTri].z == -1)
-                    {
-                        out[idTri].z = i;
-                    }
-                    else
-                    {
-                        ALICEVISION_LOG_ERROR("getTrianglesEdgesIds: bad condition.");
-                    }
-                }
-            }
-
-        } // for j
-    }     // for i
-
-    // check ... each triangle has to have three edge ids
-    for(int i = 0; i < tris.size(); i++)
-    {
-        if((out[i].x == -1) || (out[i].y == -1) || (out[i].z == -1))
-        {
-            ALICEVISION_LOG_ERROR("triangle " << i << " has to have three edge ids.");
-        }
-    }
+    #pragma omp parallel for
+    for(int triId = 0; triId < nbTriangles; ++triId)
+        out[triId] = topology->getTriangleEdges(triId);
 }
 
 
@@ -1746,6 +1606,7 @@ int Mesh::subdivideMeshOnce(const Mesh& refMesh, const GEO::AdaptiveKdTree& refM
 
     pts.swap(new_pts);
     tris.swap(new_tris);
+    invalidateTopology();
     uvCoords.swap(new_uvCoords);
     trisUvIds.swap(new_trisUvIds);
     _trisMtlIds.swap(new_trisMtlIds);
@@ -1801,6 +1662,7 @@ void Mesh::letJustTringlesIdsInMesh(StaticVector<int>& trisIdsToStay)
         trisTmp.push_back(tris[trisIdsToStay[i]]);
     }
     tris.swap(trisTmp);
+    invalidateTopology();
 }
 
 void Mesh::computeTrisCams(StaticVector<StaticVector<int>>& trisCams, const mvsUtils::MultiViewParams& mp, const std::string tmpDir)
@@ -1926,6 +1788,7 @@ void Mesh::initFromDepthMap(int stepDetail, const mvsUtils::MultiViewParams& mp,
 
     tris = StaticVector<Mesh::triangle>();
     tris.reserve(w * h * 2);
+    invalidateTopology();
     for(int x = 0; x < w - 1 - stepDetail; x += stepDetail)
     {
         for(int y = 0; y < h - 1 - stepDetail; y += stepDetail)
@@ -2064,6 +1927,7 @@ void Mesh::invertTriangleOrientations()
         Mesh::triangle& t = tris[i];
         std::swap(t.v[1], t.v[2]);
     }
+    invalidateTopology();
 }
 
 void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
@@ -2075,6 +1939,7 @@ void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
             tris[triId].v[k] = newPtId;
         }
     }
+    invalidateTopology();
 }
 
 int Mesh::getTriPtIndex(int triId, int ptId, bool failIfDoesNotExists) const
@@ -2142,8 +2007,7 @@ bool Mesh::isTriangleObtuse(int triId) const
 
 void Mesh::getLargestConnectedComponentTrisIds(StaticVector<int>& out) const
 {
-    StaticVector<StaticVector<int>> ptsNeighPtsOrdered;
-    getPtsNeighPtsOrdered(ptsNeighPtsOrdered);
+    const std::shared_ptr<const MeshTopology> topology = getTopology();
 
     StaticVector<int> colors;
     colors.reserve(pts.size());
@@ -2178,9 +2042,8 @@ void Mesh::getLargestConnectedComponentTrisIds(StaticVector<int>& out) const
                     throw std::runtime_error("getLargestConnectedComponentTrisIds: bad condition.");
                 }
             }
-            for(int j = 0; j < sizeOfStaticVector<int>(ptsNeighPtsOrdered[ptid]); ++j)
+            for(const int nptid : topology->getPtNeighbors(ptid))
             {
-                int nptid = ptsNeighPtsOrdered[ptid][j];
                 if((nptid > -1) && (colors[nptid] == -1))
                 {
                     if(buff.size() >= buff.capacity()) // should not happen but no problem
@@ -2214,276 +2077,6 @@ void Mesh::getLargestConnectedComponentTrisIds(StaticVector<int>& out) const
     }
 }
 
-bool Mesh::loadFromObjAscii(const std::string& objAsciiFileName)
-{  
-    ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
-    // read number of points, triangles, uvcoords
-    int npts = 0;
-    int ntris = 0;
-    int nuvs = 0;
-    int nnorms = 0;
-    int nlines = 0;
-    bool useColors = false;
-
-    {
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-        while(getline(in, line))
-        {
-            if((line[0] == 'v') && (line[1] == ' '))
-            {
-                if(npts == 0)
-                {
-                  useColors = mvsUtils::findNSubstrsInString(line, ".") == 6;
-                }
-                npts += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                nnorms += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                nuvs += 1;
-            }
-            if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                if((n1 == 3 && n2 == 0) || 
-                   (n1 == 6 && n2 == 0) ||
-                   (n1 == 0 && n2 == 3) ||
-                   (n1 == 0 && n2 == 0))
-                    ntris += 1;
-                else if((n1 == 4 && n2 == 0) ||
-                        (n1 == 8 && n2 == 0) ||
-                        (n1 == 0 && n2 == 4))
-                    ntris += 2;
-            }
-            nlines++;
-        }
-        in.close();
-    }
-
-    ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
-      << "\t- # normals: " << nnorms << std::endl
-      << "\t- # uv coordinates: " << nuvs << std::endl
-      << "\t- # triangles: " << ntris);
-
-    pts = StaticVector<Point3d>();
-    pts.reserve(npts);
-    tris = StaticVector<Mesh::triangle>();
-    tris.reserve(ntris);
-    uvCoords.reserve(nuvs);
-    trisUvIds.reserve(ntris);
-    normals.reserve(nnorms);
-    trisNormalsIds.reserve(ntris);
-    _trisMtlIds.reserve(ntris);
-    if(useColors)
-    {
-        _colors.reserve(npts);
-    }
-
-    std::map<std::string, int> materialCache;
-
-    {
-        int mtlId = -1;
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-
-        long t1 = mvsUtils::initEstimate();
-        int idline = 0;
-        while(getline(in, line))
-        {
-            if(line.size() < 3 || line[0] == '#')
-            {
-                // nothing to do
-            }
-            else if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
-            {
-                char buff[5000];
-                sscanf(line.c_str(), "usemtl %s", buff);
-                auto it = materialCache.find(buff);
-                if(it == materialCache.end())
-                    materialCache.emplace(buff, ++mtlId); // new material
-                else
-                    mtlId = it->second;                   // already known material
-            }
-            else if((line[0] == 'v') && (line[1] == ' '))
-            {
-                Point3d pt;
-                if(useColors)
-                {
-                    float r, g, b;
-                    sscanf(line.c_str(), "v %lf %lf %lf %f %f %f", &pt.x, &pt.y, &pt.z, &r, &g, &b);
-                    // convert float color data to uchar
-                    _colors.emplace_back(
-                      static_cast<unsigned char>(r*255.0f),
-                      static_cast<unsigned char>(g*255.0f),
-                      static_cast<unsigned char>(b*255.0f)
-                    );
-                }
-                else
-                {
-                    sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                }
-                pts.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                // printf("%f %f %f\n", pt.x, pt.y, pt.z);
-                normals.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                Point2d pt;
-                sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
-                uvCoords.push_back(pt);
-            }
-            else if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                Voxel vertex, uvCoord, vertexNormal;
-                Voxel vertex2, uvCoord2, vertexNormal2;
-                bool ok = false;
-                bool withNormal = false;
-                bool withUV = false;
-                bool withQuad = false;
-                if(n2 == 0)
-                {
-                    if(n1 == 0)
-                    {
-                        sscanf(line.c_str(), "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
-                        ok = true;
-                    }
-                    else if(n1 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
-                        ok = true;
-                        withUV = true;
-                    }
-                    else if(n1 == 6)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z);
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                    }
-                    else if(n1 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        ok = true;
-                        withUV = true;
-                        withQuad = true;
-                    }
-                    else if(n1 == 8)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
-                               &vertex.x, &uvCoord.x, &vertexNormal.x,
-                               &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z,
-                               &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                else
-                {
-                    if(n2 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
-                        ok = true;
-                        withNormal = true;
-                    }
-                    else if(n2 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i %i//%i",
-                               &vertex.x, &vertexNormal.x,
-                               &vertex.y, &vertexNormal.y,
-                               &vertex.z, &vertexNormal.z,
-                               &vertex2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                if(!ok)
-                {
-                    throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
-                }
-
-                // 1st triangle
-                {
-                    triangle t;
-                    t.v[0] = vertex.x - 1;
-                    t.v[1] = vertex.y - 1;
-                    t.v[2] = vertex.z - 1;
-                    t.alive = true;
-                    tris.push_back(t);
-                    _trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal - Voxel(1, 1, 1));
-                    }
-                }
-
-                // potential 2nd triangle
-                if(withQuad)
-                {
-                    triangle t;
-                    t.v[0] = vertex2.x - 1;
-                    t.v[1] = vertex2.y - 1;
-                    t.v[2] = vertex2.z - 1;
-                    t.alive = true;
-                    tris.push_back(t);
-                    _trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord2 - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal2 - Voxel(1, 1, 1));
-                    }
-                }
-            }
-
-            mvsUtils::printfEstimate(idline, nlines, t1);
-            idline++;
-        }
-        mvsUtils::finishEstimate();
-
-        in.close();
-        nmtls = materialCache.size();
-    }
-    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
-    return npts != 0 && ntris != 0;
-}
-
 bool Mesh::getEdgeNeighTrisInterval(Pixel& itr, Pixel& edge, StaticVector<Voxel>& edgesXStat,
                                        StaticVector<Voxel>& edgesXYStat)
 {
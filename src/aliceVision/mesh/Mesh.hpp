@@ -16,9 +16,14 @@
 
 #include <geogram/points/kd_tree.h>
 
+#include <memory>
+#include <mutex>
+
 namespace aliceVision {
 namespace mesh {
 
+class MeshTopology;
+
 using PointVisibility = StaticVector<int>;
 using PointsVisibility = StaticVector<PointVisibility>;
 
@@ -114,6 +119,35 @@ protected:
     /// Per triangle material id
     std::vector<int> _trisMtlIds;
 
+    /**
+     * @brief Cached adjacency of the triangles (see getTopology), released by invalidateTopology.
+     * The (immutable) topology is shared by the copies.
+     */
+    struct TopologyCache
+    {
+        TopologyCache() = default;
+        TopologyCache(const TopologyCache& other)
+        {
+            std::lock_guard<std::mutex> lock(other.mutex);
+            topology = other.topology;
+        }
+        TopologyCache& operator=(const TopologyCache& other)
+        {
+            if(this != &other)
+            {
+                std::lock(mutex, other.mutex);
+                std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+                std::lock_guard<std::mutex> otherLock(other.mutex, std::adopt_lock);
+                topology = other.topology;
+            }
+            return *this;
+        }
+
+        mutable std::mutex mutex;
+        std::shared_ptr<const MeshTopology> topology;
+    };
+    mutable TopologyCache _topologyCache;
+
 public:
     StaticVector<Point3d> pts;
     StaticVector<Mesh::triangle> tris;
@@ -128,17 +162,67 @@ public:
     Mesh();
     ~Mesh();
 
+    /**
+     * @brief Load a mesh, the file format is deduced from the extension (obj, ply or bin).
+     * @param[in] filepath the mesh file
+     * @return false if the file cannot be read or the mesh is empty
+     */
+    bool load(const std::string& filepath);
+
+    /**
+     * @brief Save the mesh, the file format is deduced from the extension (obj, ply or bin),
+     * OBJ for an unknown extension.
+     * @param[in] filepath the mesh file
+     */
+    void save(const std::string& filepath);
+
     void saveToObj(const std::string& filename);
+    bool loadFromObjAscii(const std::string& objAsciiFileName);
 
+    /**
+     * @brief Save the points, colors and triangles in a binary ply file.
+     */
+    void saveToPly(const std::string& plyFileName);
+    /**
+     * @brief Load the points, colors and triangles (polygons are triangulated)
+     * of an ascii or binary ply file.
+     */
+    bool loadFromPly(const std::string& plyFileName);
+
+    /**
+     * @brief Binary mesh format (host endianness):
+     * - header: "AVMB" magic and uint32 version
+     * - sections: char[4] tag, uint64 size of the rest of the section,
+     *   uint64 number of elements and the elements:
+     *   - "PTS ": points (3 x float64)
+     *   - "TRIS": triangles (3 x int32)
+     *   - "COLS": points colors (3 x uint8)
+     *   - "UVS ": uv coordinates (2 x float64)
+     *   - "TUVS": triangles uv coordinates ids (3 x int32)
+     *   - "MTLS": int32 number of materials and triangles material ids (int32)
+     *   - "VIS ": number of cameras of each point (int32) followed by all the camera ids (int32)
+     *   - "END ": no element, last section since version 2
+     * Unknown sections are skipped. Files without the magic are read as the legacy format
+     * (points and triangles only).
+     * @return false if the file is truncated or corrupted
+     */
     bool loadFromBin(const std::string& binFileName);
     void saveToBin(const std::string& binFileName);
-    bool loadFromObjAscii(const std::string& objAsciiFileName);
 
     void addMesh(const Mesh& mesh);
 
     void getTrisMap(StaticVector<StaticVector<int>>& out, const mvsUtils::MultiViewParams& mp, int rc, int scale, int w, int h);
     void getTrisMap(StaticVector<StaticVector<int>>& out, StaticVector<int>& visTris, const mvsUtils::MultiViewParams& mp, int rc, int scale,
                     int w, int h);
+    /**
+     * @brief Rasterize projected triangles into a (w x h) map of the triangles overlapping each pixel.
+     * @param[out] out per pixel (x * h + y) list of the overlapping triangles ids, in the visTris order
+     * @param[in] visTris triangles ids
+     * @param[in] trisProj projection of each triangle of visTris
+     * @param[in] trisInImage whether each projected triangle is fully inside the image, others are skipped
+     */
+    void getTrisMap(StaticVector<StaticVector<int>>& out, const StaticVector<int>& visTris, const std::vector<triangle_proj>& trisProj,
+                    const std::vector<char>& trisInImage, int w, int h);
     /// Per-vertex color data const accessor
     const std::vector<rgb>& colors() const { return _colors; }
     /// Per-vertex color data accessor
@@ -152,6 +236,20 @@ public:
     void getDepthMap(StaticVector<float>& depthMap, StaticVector<StaticVector<int>>& tmp, const mvsUtils::MultiViewParams& mp, int rc,
                      int scale, int w, int h);
 
+    /**
+     * @brief Get the adjacency of the triangles, built on first use and cached until invalidateTopology.
+     * The cache is also rebuilt if the number of points or triangles has changed.
+     * Concurrent calls are safe. The returned topology stays valid after the mesh is edited or destroyed,
+     * but describes the triangles at the time of the call.
+     */
+    std::shared_ptr<const MeshTopology> getTopology() const;
+
+    /**
+     * @brief Release the cached adjacency of the triangles.
+     * Called by the methods editing pts or tris, must be called after editing the triangles directly.
+     */
+    void invalidateTopology();
+
     void getPtsNeighbors(std::vector<std::vector<int>>& out_ptsNeighTris) const;
     void getPtsNeighborTriangles(StaticVector<StaticVector<int>>& out_ptsNeighTris) const;
     void getPtsNeighPtsOrdered(StaticVector<StaticVector<int>>& out_ptsNeighTris) const;
@@ -168,7 +266,8 @@ public:
     void generateMeshFromTrianglesSubset(const StaticVector<int>& visTris, Mesh& outMesh, StaticVector<int>& out_ptIdToNewPtId) const;
 
     void getNotOrientedEdges(StaticVector<StaticVector<int>>& edgesNeighTris, StaticVector<Pixel>& edgesPointsPairs);
-    void getTrianglesEdgesIds(const StaticVector<StaticVector<int>>& edgesNeighTris, StaticVector<Voxel>& out) const;
+    /// Get the ids of the 3 edges of each triangle, the edges are indexed as in getNotOrientedEdges
+    void getTrianglesEdgesIds(StaticVector<Voxel>& out) const;
 
     void getLaplacianSmoothingVectors(StaticVector<StaticVector<int>>& ptsNeighPts, StaticVector<Point3d>& out_nms,
                                       double maximalNeighDist = -1.0f);
@@ -5,10 +5,13 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "MeshEnergyOpt.hpp"
+#include <aliceVision/mesh/MeshSmoothing.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <ctime>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -23,90 +26,43 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-void MeshEnergyOpt::computeLaplacianPtsParallel(StaticVector<Point3d>& out_lapPts)
+bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool& ptsCanMove)
 {
-    out_lapPts.reserve(pts.size());
-    out_lapPts.resize_with(pts.size(), Point3d(0.0f, 0.0f, 0.f));
-    int nlabpts = 0;
-
-#pragma omp parallel for
-    for(int i = 0; i < pts.size(); i++)
+    if(pts.size() <= 4)
     {
-        Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
-        {
-            out_lapPts[i] = lapPt;
-            nlabpts++;
-        }
+        return false;
     }
-}
 
-void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
-                                                const Point3d& RD, StaticVectorBool& ptsCanMove)
-{
-    // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d> lapPts;
-    computeLaplacianPtsParallel(lapPts);
-
-    StaticVector<Point3d> newPts;
-    newPts.reserve(pts.size());
-    newPts.push_back_arr(&pts);
+    ALICEVISION_LOG_INFO("Optimizing mesh smooth: " << std::endl
+                         << "\t- lamda: " << lambda << std::endl
+                         << "\t- niters: " << niter << std::endl);
 
-#pragma omp parallel for
-    for(int i = 0; i < pts.size(); ++i)
-    {
-        if( ptsCanMove.empty() || ptsCanMove[i] )
-        {
-            Point3d n;
-
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
-            {
-                Point3d p = newPts[i] + n * lambda;
-                if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
-                {
-                    newPts[i] = p;
-                }
-            }
-        }
-    }
+    long t = std::clock();
+    MeshSmoothing smoothing(pts, ptsNeighPtsOrdered, ptsCanMove);
+    smoothing.biLaplacianSmoothing(lambda, niter);
+    smoothing.getPoints(pts);
+    mvsUtils::printfElapsedTime(t, "Mesh smoothing ");
 
-    pts.clear();
-    pts.swap(newPts);
+    return true;
 }
 
-bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool& ptsCanMove)
+bool MeshEnergyOpt::optimizeSmoothTaubin(float lambda, float mu, int niter, StaticVectorBool& ptsCanMove)
 {
     if(pts.size() <= 4)
     {
         return false;
     }
 
-   // bool saveDebug = mp ? mp->userParams.get<bool>("meshEnergyOpt.saveAllIterations", false) : false;
-
-    Point3d LU, RD;
-    LU = pts[0];
-    RD = pts[0];
-    for(int i = 0; i < pts.size(); i++)
-    {
-        LU.x = std::min(LU.x, pts[i].x);
-        LU.y = std::min(LU.y, pts[i].y);
-        LU.z = std::min(LU.z, pts[i].z);
-        RD.x = std::max(RD.x, pts[i].x);
-        RD.y = std::max(RD.y, pts[i].y);
-        RD.z = std::max(RD.z, pts[i].z);
-    }
-
-    ALICEVISION_LOG_INFO("Optimizing mesh smooth: " << std::endl
+    ALICEVISION_LOG_INFO("Optimizing mesh smooth (Taubin): " << std::endl
                          << "\t- lamda: " << lambda << std::endl
+                         << "\t- mu: " << mu << std::endl
                          << "\t- niters: " << niter << std::endl);
 
-    for(int i = 0; i < niter; i++)
-    {
-        ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
-        //if(saveDebug)
-        //    saveToObj(folder + "mesh_smoothed_" + std::to_string(i) + ".obj");
-    }
+    long t = std::clock();
+    MeshSmoothing smoothing(pts, ptsNeighPtsOrdered, ptsCanMove);
+    smoothing.taubinSmoothing(lambda, mu, niter);
+    smoothing.getPoints(pts);
+    mvsUtils::printfElapsedTime(t, "Mesh smoothing ");
 
     return true;
 }
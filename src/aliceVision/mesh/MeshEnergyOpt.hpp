@@ -19,11 +19,22 @@ public:
     explicit MeshEnergyOpt(mvsUtils::MultiViewParams* _mp);
     ~MeshEnergyOpt();
 
+    /**
+     * @brief Bi-Laplacian smoothing of the points.
+     * @param[in] lambda the step size
+     * @param[in] niter the number of iterations
+     * @param[in] ptsCanMove the points allowed to move (all the points if empty)
+     */
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool& ptsCanMove);
 
-private:
-    void computeLaplacianPtsParallel(StaticVector<Point3d>& out_lapPts);
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool& ptsCanMove);
+    /**
+     * @brief Taubin lambda/mu smoothing of the points, without shrinkage of the mesh.
+     * @param[in] lambda the shrinking step size (lambda > 0)
+     * @param[in] mu the inflating step size (mu < -lambda)
+     * @param[in] niter the number of iterations
+     * @param[in] ptsCanMove the points allowed to move (all the points if empty)
+     */
+    bool optimizeSmoothTaubin(float lambda, float mu, int niter, StaticVectorBool& ptsCanMove);
 };
 
 } // namespace mesh
@@ -0,0 +1,180 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshSmoothing.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace aliceVision {
+namespace mesh {
+
+MeshSmoothing::MeshSmoothing(const StaticVector<Point3d>& pts, const StaticVector<StaticVector<int>>& ptsNeighbors,
+                             const StaticVectorBool& ptsCanMove)
+    : _nbPoints(pts.size())
+{
+    // neighborhoods in compressed sparse row arrays
+    _neighborsOffsets.resize(_nbPoints + 1);
+    _neighborsOffsets[0] = 0;
+    for(int i = 0; i < _nbPoints; ++i)
+        _neighborsOffsets[i + 1] = _neighborsOffsets[i] + (i < ptsNeighbors.size() ? ptsNeighbors[i].size() : 0);
+    _neighbors.resize(_neighborsOffsets.back());
+    _invNbNeighbors.resize(_nbPoints);
+    _canMove.resize(_nbPoints);
+
+    #pragma omp parallel for
+    for(int i = 0; i < _nbPoints; ++i)
+    {
+        const int nbNeighbors = _neighborsOffsets[i + 1] - _neighborsOffsets[i];
+        if(nbNeighbors > 0)
+            std::copy(ptsNeighbors[i].begin(), ptsNeighbors[i].end(), _neighbors.begin() + _neighborsOffsets[i]);
+        _invNbNeighbors[i] = (nbNeighbors > 0) ? 1.0f / nbNeighbors : 0.0f;
+        _canMove[i] = (ptsCanMove.empty() || ptsCanMove[i]) && nbNeighbors > 0;
+    }
+
+    // positions relative to the center of the bounding box
+    Point3d bboxMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bboxMax(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+    for(const Point3d& p : pts)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            bboxMin.m[k] = std::min(bboxMin.m[k], p.m[k]);
+            bboxMax.m[k] = std::max(bboxMax.m[k], p.m[k]);
+        }
+    }
+    _center = (_nbPoints > 0) ? (bboxMin + bboxMax) / 2.0 : Point3d(0.0, 0.0, 0.0);
+
+    for(int k = 0; k < 3; ++k)
+    {
+        _bboxMin[k] = static_cast<float>(bboxMin.m[k] - _center.m[k]);
+        _bboxMax[k] = static_cast<float>(bboxMax.m[k] - _center.m[k]);
+        _pts[k].resize(_nbPoints);
+        _laplacian[k].resize(_nbPoints);
+        float* coords = _pts[k].data();
+
+        #pragma omp parallel for
+        for(int i = 0; i < _nbPoints; ++i)
+            coords[i] = static_cast<float>(pts[i].m[k] - _center.m[k]);
+    }
+}
+
+void MeshSmoothing::computeLaplacian(const std::vector<float>* in, std::vector<float>* out) const
+{
+    const int* offsets = _neighborsOffsets.data();
+    const int* neighbors = _neighbors.data();
+    const float* invNbNeighbors = _invNbNeighbors.data();
+    const float* inX = in[0].data();
+    const float* inY = in[1].data();
+    const float* inZ = in[2].data();
+    float* outX = out[0].data();
+    float* outY = out[1].data();
+    float* outZ = out[2].data();
+
+    #pragma omp parallel for schedule(static, 4096)
+    for(int i = 0; i < _nbPoints; ++i)
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float z = 0.0f;
+        for(int n = offsets[i]; n < offsets[i + 1]; ++n)
+        {
+            const int neighbor = neighbors[n];
+            x += inX[neighbor];
+            y += inY[neighbor];
+            z += inZ[neighbor];
+        }
+        const float w = invNbNeighbors[i];
+        // isolated points have a null Laplacian
+        outX[i] = (w > 0.0f) ? x * w - inX[i] : 0.0f;
+        outY[i] = (w > 0.0f) ? y * w - inY[i] : 0.0f;
+        outZ[i] = (w > 0.0f) ? z * w - inZ[i] : 0.0f;
+    }
+}
+
+void MeshSmoothing::movePoints(const std::vector<float>* vectors, float step, const std::vector<float>* factors)
+{
+    const char* canMove = _canMove.data();
+    const float* vX = vectors[0].data();
+    const float* vY = vectors[1].data();
+    const float* vZ = vectors[2].data();
+    const float* f = factors ? factors->data() : nullptr;
+    float* pX = _pts[0].data();
+    float* pY = _pts[1].data();
+    float* pZ = _pts[2].data();
+    const float minX = _bboxMin[0], minY = _bboxMin[1], minZ = _bboxMin[2];
+    const float maxX = _bboxMax[0], maxY = _bboxMax[1], maxZ = _bboxMax[2];
+
+    // branchless body to let the compiler vectorize the loop
+    #pragma omp parallel for schedule(static, 4096)
+    for(int i = 0; i < _nbPoints; ++i)
+    {
+        const float s = f ? f[i] : step;
+        const float x = pX[i] + s * vX[i];
+        const float y = pY[i] + s * vY[i];
+        const float z = pZ[i] + s * vZ[i];
+        // the comparisons also reject NaN
+        const bool inside = (x > minX) & (y > minY) & (z > minZ) & (x < maxX) & (y < maxY) & (z < maxZ);
+        const bool move = inside & (canMove[i] != 0);
+        pX[i] = move ? x : pX[i];
+        pY[i] = move ? y : pY[i];
+        pZ[i] = move ? z : pZ[i];
+    }
+}
+
+void MeshSmoothing::biLaplacianSmoothing(float lambda, int niter)
+{
+    // normalization factor of the bi-Laplacian [Kobbelt et al. 98, eq. (8)]
+    // v = 1 + 1/n * sum(1/n_j) over the n neighbors j
+    std::vector<float> factors(_nbPoints);
+
+    #pragma omp parallel for
+    for(int i = 0; i < _nbPoints; ++i)
+    {
+        float sum = 0.0f;
+        for(int n = _neighborsOffsets[i]; n < _neighborsOffsets[i + 1]; ++n)
+            sum += _invNbNeighbors[_neighbors[n]];
+        const float v = 1.0f + _invNbNeighbors[i] * sum;
+        factors[i] = -lambda / v;
+    }
+
+    for(int k = 0; k < 3; ++k)
+        _biLaplacian[k].resize(_nbPoints);
+
+    for(int iter = 0; iter < niter; ++iter)
+    {
+        computeLaplacian(_pts, _laplacian);
+        computeLaplacian(_laplacian, _biLaplacian);
+        movePoints(_biLaplacian, 0.0f, &factors);
+    }
+}
+
+void MeshSmoothing::taubinSmoothing(float lambda, float mu, int niter)
+{
+    for(int iter = 0; iter < niter; ++iter)
+    {
+        computeLaplacian(_pts, _laplacian);
+        movePoints(_laplacian, lambda, nullptr);
+        computeLaplacian(_pts, _laplacian);
+        movePoints(_laplacian, mu, nullptr);
+    }
+}
+
+void MeshSmoothing::getPoints(StaticVector<Point3d>& pts) const
+{
+    #pragma omp parallel for
+    for(int i = 0; i < _nbPoints; ++i)
+    {
+        if(!_canMove[i])
+            continue;
+        for(int k = 0; k < 3; ++k)
+            pts[i].m[k] = _center.m[k] + static_cast<double>(_pts[k][i]);
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
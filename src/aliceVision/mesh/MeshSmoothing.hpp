@@ -0,0 +1,90 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Iterative smoothing of the points of a mesh with umbrella (uniform) Laplacian operators.
+ *
+ * The neighborhoods are stored once in compressed sparse row arrays and the positions
+ * in float structure-of-arrays, relative to the center of the bounding box to keep
+ * the precision of large coordinates. Each iteration is made of parallel kernels
+ * on contiguous arrays. Only the points allowed to move are written back to the mesh.
+ */
+class MeshSmoothing
+{
+public:
+
+    /**
+     * @brief Initialize the smoothing of a set of points.
+     * @param[in] pts the points
+     * @param[in] ptsNeighbors the neighbor points of each point
+     * @param[in] ptsCanMove the points allowed to move (all the points if empty)
+     */
+    MeshSmoothing(const StaticVector<Point3d>& pts, const StaticVector<StaticVector<int>>& ptsNeighbors,
+                  const StaticVectorBool& ptsCanMove);
+
+    /**
+     * @brief Bi-Laplacian smoothing [Kobbelt et al. 98]: p += lambda * -U2(p) / v
+     * with U2 the Laplacian of the Laplacian and v its normalization factor.
+     * @param[in] lambda the step size
+     * @param[in] niter the number of iterations
+     */
+    void biLaplacianSmoothing(float lambda, int niter);
+
+    /**
+     * @brief Taubin lambda/mu smoothing [Taubin 95]: a Laplacian step of size lambda (shrinking)
+     * followed by a Laplacian step of size mu (inflating) at each iteration.
+     * @param[in] lambda the shrinking step size (lambda > 0)
+     * @param[in] mu the inflating step size (mu < -lambda)
+     * @param[in] niter the number of iterations
+     */
+    void taubinSmoothing(float lambda, float mu, int niter);
+
+    /**
+     * @brief Write the positions of the points allowed to move.
+     * @param[in,out] pts the points given at initialization
+     */
+    void getPoints(StaticVector<Point3d>& pts) const;
+
+private:
+
+    /// out = U(in), the umbrella Laplacian of the points with neighbors (0 for the others)
+    void computeLaplacian(const std::vector<float>* in, std::vector<float>* out) const;
+    /// move the points along the vectors: p += factor[i] * v (factor[i] = step if not given)
+    void movePoints(const std::vector<float>* vectors, float step, const std::vector<float>* factors);
+
+    int _nbPoints = 0;
+    /// neighbors of the point i are _neighbors[_neighborsOffsets[i], _neighborsOffsets[i+1])
+    std::vector<int> _neighborsOffsets;
+    std::vector<int> _neighbors;
+    /// 1 / number of neighbors (0 for isolated points)
+    std::vector<float> _invNbNeighbors;
+    /// 1 if the point is allowed to move
+    std::vector<char> _canMove;
+
+    Point3d _center;
+    /// positions (x, y, z arrays) relative to _center
+    std::vector<float> _pts[3];
+    /// moved points must stay strictly inside the initial bounding box
+    float _bboxMin[3];
+    float _bboxMax[3];
+
+    /// scratch buffers for the Laplacian vectors
+    std::vector<float> _laplacian[3];
+    std::vector<float> _biLaplacian[3];
+};
+
+} // namespace mesh
+} // namespace aliceVision
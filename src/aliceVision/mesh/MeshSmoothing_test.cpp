@@ -0,0 +1,226 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshEnergyOpt.hpp>
+#include <aliceVision/mesh/MeshSmoothing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+
+#define BOOST_TEST_MODULE MeshSmoothing
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+/**
+ * @brief Unit sphere made of a subdivided octahedron, with a fixed radial noise.
+ */
+void generateNoisySphere(Mesh& mesh, int nbSubdivisions, double noise)
+{
+    mesh.pts.push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(-1.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, -1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, 0.0, 1.0));
+    mesh.pts.push_back(Point3d(0.0, 0.0, -1.0));
+    mesh.tris.push_back(Mesh::triangle(0, 2, 4));
+    mesh.tris.push_back(Mesh::triangle(2, 1, 4));
+    mesh.tris.push_back(Mesh::triangle(1, 3, 4));
+    mesh.tris.push_back(Mesh::triangle(3, 0, 4));
+    mesh.tris.push_back(Mesh::triangle(2, 0, 5));
+    mesh.tris.push_back(Mesh::triangle(1, 2, 5));
+    mesh.tris.push_back(Mesh::triangle(3, 1, 5));
+    mesh.tris.push_back(Mesh::triangle(0, 3, 5));
+
+    for(int s = 0; s < nbSubdivisions; ++s)
+    {
+        std::map<std::pair<int, int>, int> midPoints;
+        const auto getMidPoint = [&](int a, int b) {
+            const std::pair<int, int> edge(std::min(a, b), std::max(a, b));
+            const auto it = midPoints.find(edge);
+            if(it != midPoints.end())
+                return it->second;
+            const int id = mesh.pts.size();
+            mesh.pts.push_back(((mesh.pts[a] + mesh.pts[b]) / 2.0).normalize());
+            midPoints[edge] = id;
+            return id;
+        };
+
+        StaticVector<Mesh::triangle> tris;
+        for(int i = 0; i < mesh.tris.size(); ++i)
+        {
+            const int a = mesh.tris[i].v[0];
+            const int b = mesh.tris[i].v[1];
+            const int c = mesh.tris[i].v[2];
+            const int ab = getMidPoint(a, b);
+            const int bc = getMidPoint(b, c);
+            const int ca = getMidPoint(c, a);
+            tris.push_back(Mesh::triangle(a, ab, ca));
+            tris.push_back(Mesh::triangle(ab, b, bc));
+            tris.push_back(Mesh::triangle(ca, bc, c));
+            tris.push_back(Mesh::triangle(ab, bc, ca));
+        }
+        mesh.tris.swap(tris);
+    }
+
+    std::mt19937 randomNumberGenerator(42);
+    std::uniform_real_distribution<double> distribution(-noise, noise);
+    for(int i = 0; i < mesh.pts.size(); ++i)
+        mesh.pts[i] = mesh.pts[i] * (1.0 + distribution(randomNumberGenerator));
+}
+
+double computeVolume(const Mesh& mesh)
+{
+    double volume = 0.0;
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const Mesh::triangle& t = mesh.tris[i];
+        volume += dot(mesh.pts[t.v[0]], cross(mesh.pts[t.v[1]], mesh.pts[t.v[2]])) / 6.0;
+    }
+    return volume;
+}
+
+/**
+ * @brief Previous double precision bi-Laplacian smoothing of MeshEnergyOpt::optimizeSmooth.
+ */
+void referenceBiLaplacianSmoothing(MeshEnergyOpt& mesh, float lambda, int niter)
+{
+    Point3d LU = mesh.pts[0];
+    Point3d RD = mesh.pts[0];
+    for(int i = 0; i < mesh.pts.size(); i++)
+    {
+        LU.x = std::min(LU.x, mesh.pts[i].x);
+        LU.y = std::min(LU.y, mesh.pts[i].y);
+        LU.z = std::min(LU.z, mesh.pts[i].z);
+        RD.x = std::max(RD.x, mesh.pts[i].x);
+        RD.y = std::max(RD.y, mesh.pts[i].y);
+        RD.z = std::max(RD.z, mesh.pts[i].z);
+    }
+
+    for(int iter = 0; iter < niter; iter++)
+    {
+        StaticVector<Point3d> lapPts;
+        lapPts.resize_with(mesh.pts.size(), Point3d(0.0, 0.0, 0.0));
+        for(int i = 0; i < mesh.pts.size(); i++)
+        {
+            Point3d lapPt;
+            if(mesh.getLaplacianSmoothingVector(i, lapPt))
+                lapPts[i] = lapPt;
+        }
+
+        StaticVector<Point3d> newPts = mesh.pts;
+        for(int i = 0; i < mesh.pts.size(); ++i)
+        {
+            Point3d n;
+            if(mesh.getBiLaplacianSmoothingVector(i, lapPts, n))
+            {
+                const Point3d p = newPts[i] + n * lambda;
+                if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
+                    newPts[i] = p;
+            }
+        }
+        mesh.pts.swap(newPts);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshSmoothing_biLaplacianDeviation)
+{
+    Mesh sphere;
+    generateNoisySphere(sphere, 3, 0.05);
+
+    // the same steps as meshFiltering
+    MeshEnergyOpt smoothed(nullptr);
+    smoothed.addMesh(sphere);
+    smoothed.init();
+    smoothed.cleanMesh(10);
+
+    MeshEnergyOpt reference(nullptr);
+    reference.addMesh(sphere);
+    reference.init();
+    reference.cleanMesh(10);
+
+    BOOST_REQUIRE_EQUAL(smoothed.pts.size(), reference.pts.size());
+
+    const float lambda = 1.0f;
+    const int niter = 10;
+    StaticVectorBool ptsCanMove;
+    BOOST_REQUIRE(smoothed.optimizeSmooth(lambda, niter, ptsCanMove));
+    referenceBiLaplacianSmoothing(reference, lambda, niter);
+
+    double maxDeviation = 0.0;
+    double maxDisplacement = 0.0;
+    for(int i = 0; i < reference.pts.size(); ++i)
+    {
+        maxDeviation = std::max(maxDeviation, (smoothed.pts[i] - reference.pts[i]).size());
+        maxDisplacement = std::max(maxDisplacement, (reference.pts[i] - sphere.pts[i]).size());
+    }
+
+    // the points moved and the float engine stays close to the previous double precision code
+    BOOST_CHECK(maxDisplacement > 1e-2);
+    BOOST_CHECK_SMALL(maxDeviation, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(MeshSmoothing_taubinVolume)
+{
+    Mesh sphere;
+    generateNoisySphere(sphere, 3, 0.05);
+
+    StaticVector<StaticVector<int>> ptsNeighbors;
+    sphere.getPtsNeighPtsOrdered(ptsNeighbors);
+    const StaticVectorBool ptsCanMove;
+
+    const float lambda = 0.5f;
+    const float mu = -0.53f;
+    const int niter = 20;
+
+    Mesh taubin = sphere;
+    {
+        MeshSmoothing smoothing(taubin.pts, ptsNeighbors, ptsCanMove);
+        smoothing.taubinSmoothing(lambda, mu, niter);
+        smoothing.getPoints(taubin.pts);
+    }
+
+    // Laplacian steps only (mu = 0)
+    Mesh laplacian = sphere;
+    {
+        MeshSmoothing smoothing(laplacian.pts, ptsNeighbors, ptsCanMove);
+        smoothing.taubinSmoothing(lambda, 0.0f, niter);
+        smoothing.getPoints(laplacian.pts);
+    }
+
+    const double initialVolume = computeVolume(sphere);
+    const double taubinVolume = computeVolume(taubin);
+    const double laplacianVolume = computeVolume(laplacian);
+
+    BOOST_CHECK_CLOSE(initialVolume, 4.0 / 3.0 * M_PI, 10.0);
+    BOOST_CHECK_CLOSE(taubinVolume, initialVolume, 5.0);
+    BOOST_CHECK(laplacianVolume < 0.9 * initialVolume);
+
+    // the noise is smoothed: the points get close to a sphere
+    double meanRadius = 0.0;
+    for(int i = 0; i < taubin.pts.size(); ++i)
+        meanRadius += taubin.pts[i].size() / taubin.pts.size();
+    BOOST_CHECK_CLOSE(meanRadius, 1.0, 3.0);
+
+    double radiusVariance = 0.0;
+    double initialRadiusVariance = 0.0;
+    for(int i = 0; i < taubin.pts.size(); ++i)
+    {
+        radiusVariance += std::pow(taubin.pts[i].size() - meanRadius, 2) / taubin.pts.size();
+        initialRadiusVariance += std::pow(sphere.pts[i].size() - 1.0, 2) / sphere.pts.size();
+    }
+    BOOST_CHECK(radiusVariance < 0.25 * initialRadiusVariance);
+}
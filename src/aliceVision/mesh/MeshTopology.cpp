@@ -0,0 +1,208 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshTopology.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/**
+ * @brief Convert counts into offsets (exclusive prefix sum), the total is appended at the end.
+ */
+void countsToOffsets(std::vector<int>& offsets)
+{
+    int sum = 0;
+    for(int& offset : offsets)
+    {
+        const int count = offset;
+        offset = sum;
+        sum += count;
+    }
+}
+
+} // namespace
+
+MeshTopology::MeshTopology(const Mesh& mesh)
+{
+    const int nbPoints = mesh.pts.size();
+    const int nbTris = mesh.tris.size();
+    const auto isValidPt = [nbPoints](int ptId) { return ptId >= 0 && ptId < nbPoints; };
+
+    // point -> triangles
+    _ptTrisOffsets.assign(nbPoints + 1, 0);
+
+    #pragma omp parallel for
+    for(int triId = 0; triId < nbTris; ++triId)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            const int ptId = mesh.tris[triId].v[k];
+            if(isValidPt(ptId))
+            {
+                #pragma omp atomic
+                ++_ptTrisOffsets[ptId];
+            }
+        }
+    }
+    countsToOffsets(_ptTrisOffsets);
+    _ptTris.resize(_ptTrisOffsets.back());
+
+    {
+        std::vector<int> cursors(_ptTrisOffsets.begin(), _ptTrisOffsets.end() - 1);
+
+        #pragma omp parallel for
+        for(int triId = 0; triId < nbTris; ++triId)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                const int ptId = mesh.tris[triId].v[k];
+                if(!isValidPt(ptId))
+                    continue;
+                int position;
+                #pragma omp atomic capture
+                position = cursors[ptId]++;
+                _ptTris[position] = triId;
+            }
+        }
+    }
+
+    // sort to be independent of the threads scheduling
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int ptId = 0; ptId < nbPoints; ++ptId)
+        std::sort(_ptTris.begin() + _ptTrisOffsets[ptId], _ptTris.begin() + _ptTrisOffsets[ptId + 1]);
+
+    // point -> points, in two passes (count, then fill) with a scratch buffer per thread
+    const auto getSortedNeighbors = [&](int ptId, std::vector<int>& neighbors)
+    {
+        neighbors.clear();
+        for(const int triId : getPtTriangles(ptId))
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                const int neighPtId = mesh.tris[triId].v[k];
+                if(neighPtId != ptId && isValidPt(neighPtId))
+                    neighbors.push_back(neighPtId);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    };
+
+    _ptNeighOffsets.assign(nbPoints + 1, 0);
+    _ptEdgesOffsets.assign(nbPoints + 1, 0);
+
+    #pragma omp parallel
+    {
+        std::vector<int> neighbors;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int ptId = 0; ptId < nbPoints; ++ptId)
+        {
+            getSortedNeighbors(ptId, neighbors);
+            _ptNeighOffsets[ptId] = neighbors.size();
+            // edges (a, b) are owned by their first point a < b
+            _ptEdgesOffsets[ptId] = neighbors.end() - std::upper_bound(neighbors.begin(), neighbors.end(), ptId);
+        }
+    }
+    countsToOffsets(_ptNeighOffsets);
+    countsToOffsets(_ptEdgesOffsets);
+    _ptNeighs.resize(_ptNeighOffsets.back());
+    _edges.resize(_ptEdgesOffsets.back());
+
+    #pragma omp parallel
+    {
+        std::vector<int> neighbors;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int ptId = 0; ptId < nbPoints; ++ptId)
+        {
+            getSortedNeighbors(ptId, neighbors);
+            std::copy(neighbors.begin(), neighbors.end(), _ptNeighs.begin() + _ptNeighOffsets[ptId]);
+
+            int edgeId = _ptEdgesOffsets[ptId];
+            for(auto it = std::upper_bound(neighbors.begin(), neighbors.end(), ptId); it != neighbors.end(); ++it)
+                _edges[edgeId++] = Pixel(ptId, *it);
+        }
+    }
+
+    // triangle -> edges
+    _trisEdges.resize(nbTris);
+
+    #pragma omp parallel for
+    for(int triId = 0; triId < nbTris; ++triId)
+    {
+        const Mesh::triangle& t = mesh.tris[triId];
+        _trisEdges[triId] = Voxel(getEdgeId(t.v[0], t.v[1]),
+                                  getEdgeId(t.v[1], t.v[2]),
+                                  getEdgeId(t.v[2], t.v[0]));
+    }
+
+    // edge -> triangles, the edges of a point a are only updated by the iteration on a
+    const auto forEachOwnedEdge = [&](int ptId, auto&& f)
+    {
+        int previousTriId = -1;
+        for(const int triId : getPtTriangles(ptId))
+        {
+            // a degenerated triangle can use the point and the edge twice
+            if(triId == previousTriId)
+                continue;
+            previousTriId = triId;
+            const Voxel& triEdges = _trisEdges[triId];
+            for(int k = 0; k < 3; ++k)
+            {
+                const int edgeId = triEdges.m[k];
+                if(edgeId >= 0 && _edges[edgeId].x == ptId && std::find(triEdges.m, triEdges.m + k, edgeId) == triEdges.m + k)
+                    f(edgeId, triId);
+            }
+        }
+    };
+
+    _edgeTrisOffsets.assign(_edges.size() + 1, 0);
+
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int ptId = 0; ptId < nbPoints; ++ptId)
+        forEachOwnedEdge(ptId, [&](int edgeId, int) { ++_edgeTrisOffsets[edgeId]; });
+
+    countsToOffsets(_edgeTrisOffsets);
+    _edgeTris.resize(_edgeTrisOffsets.back());
+
+    #pragma omp parallel
+    {
+        std::vector<int> cursors;
+
+        #pragma omp for schedule(dynamic, 1024)
+        for(int ptId = 0; ptId < nbPoints; ++ptId)
+        {
+            const int firstEdgeId = _ptEdgesOffsets[ptId];
+            cursors.assign(_edgeTrisOffsets.begin() + firstEdgeId, _edgeTrisOffsets.begin() + _ptEdgesOffsets[ptId + 1]);
+            // triangles of the point are sorted, so are the triangles of its edges
+            forEachOwnedEdge(ptId, [&](int edgeId, int triId) { _edgeTris[cursors[edgeId - firstEdgeId]++] = triId; });
+        }
+    }
+}
+
+int MeshTopology::getEdgeId(int ptIdA, int ptIdB) const
+{
+    const int a = std::min(ptIdA, ptIdB);
+    const int b = std::max(ptIdA, ptIdB);
+    if(a < 0 || b >= getNbPoints() || a == b)
+        return -1;
+
+    const auto first = _edges.begin() + _ptEdgesOffsets[a];
+    const auto last = _edges.begin() + _ptEdgesOffsets[a + 1];
+    const auto it = std::lower_bound(first, last, b, [](const Pixel& edge, int ptId) { return edge.y < ptId; });
+    if(it == last || it->y != b)
+        return -1;
+    return static_cast<int>(it - _edges.begin());
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,109 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mvsData/Pixel.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Immutable adjacency of the triangles of a mesh, stored in compressed
+ * sparse row arrays (one offset array and one flat index array per relation).
+ *
+ * - point -> triangles: ids of the triangles using the point, in ascending order
+ * - point -> points: ids of the points sharing an edge with the point, in ascending order
+ * - edges: unique not oriented edges (a, b) with a < b, sorted by a then b
+ * - edge -> triangles: ids of the triangles using the edge, in ascending order
+ * - triangle -> edges: ids of the edges (v0, v1), (v1, v2) and (v2, v0) of each triangle
+ *
+ * It is built in parallel with a fixed amount of allocations, and cached by the Mesh
+ * (see Mesh::getTopology).
+ */
+class MeshTopology
+{
+public:
+
+    /**
+     * @brief Contiguous range of indices in a flat array.
+     */
+    class IndexRange
+    {
+    public:
+        IndexRange(const int* begin, const int* end)
+            : _begin(begin)
+            , _end(end)
+        {}
+
+        const int* begin() const { return _begin; }
+        const int* end() const { return _end; }
+        int size() const { return static_cast<int>(_end - _begin); }
+        bool empty() const { return _begin == _end; }
+        int operator[](int i) const { return _begin[i]; }
+
+    private:
+        const int* _begin;
+        const int* _end;
+    };
+
+    /**
+     * @brief Build the topology of the triangles of a mesh.
+     * @param[in] mesh the input mesh
+     */
+    explicit MeshTopology(const Mesh& mesh);
+
+    /// number of points of the mesh at construction time
+    int getNbPoints() const { return static_cast<int>(_ptTrisOffsets.size()) - 1; }
+    /// number of triangles of the mesh at construction time
+    int getNbTriangles() const { return static_cast<int>(_trisEdges.size()); }
+    /// number of not oriented edges
+    int getNbEdges() const { return static_cast<int>(_edges.size()); }
+
+    /// triangles using the point ptId
+    IndexRange getPtTriangles(int ptId) const { return getRange(_ptTrisOffsets, _ptTris, ptId); }
+    /// points sharing an edge with the point ptId
+    IndexRange getPtNeighbors(int ptId) const { return getRange(_ptNeighOffsets, _ptNeighs, ptId); }
+    /// triangles using the edge edgeId
+    IndexRange getEdgeTriangles(int edgeId) const { return getRange(_edgeTrisOffsets, _edgeTris, edgeId); }
+
+    /// points (a, b) of the edge edgeId, with a < b
+    const Pixel& getEdgePoints(int edgeId) const { return _edges[edgeId]; }
+    /// edges (v0, v1), (v1, v2) and (v2, v0) of the triangle triId
+    const Voxel& getTriangleEdges(int triId) const { return _trisEdges[triId]; }
+
+    /**
+     * @brief Get the id of the edge between two points.
+     * @return the edge id or -1 if the points are not connected
+     */
+    int getEdgeId(int ptIdA, int ptIdB) const;
+
+private:
+
+    static IndexRange getRange(const std::vector<int>& offsets, const std::vector<int>& values, int i)
+    {
+        return IndexRange(values.data() + offsets[i], values.data() + offsets[i + 1]);
+    }
+
+    std::vector<int> _ptTrisOffsets;
+    std::vector<int> _ptTris;
+    std::vector<int> _ptNeighOffsets;
+    std::vector<int> _ptNeighs;
+    /// edges with the first point a are in [_ptEdgesOffsets[a], _ptEdgesOffsets[a+1])
+    std::vector<int> _ptEdgesOffsets;
+    std::vector<Pixel> _edges;
+    std::vector<int> _edgeTrisOffsets;
+    std::vector<int> _edgeTris;
+    std::vector<Voxel> _trisEdges;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,137 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
+
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE MeshTopology
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+/**
+ * @brief Square made of 2 triangles sharing the edge (0, 2), and a free point 4.
+ *
+ *  3 --- 2
+ *  |   / |
+ *  | /   |
+ *  0 --- 1
+ */
+void generateSquare(Mesh& mesh)
+{
+    mesh.pts.push_back(Point3d(0.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 0.0, 0.0));
+    mesh.pts.push_back(Point3d(1.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(0.0, 1.0, 0.0));
+    mesh.pts.push_back(Point3d(2.0, 2.0, 0.0));
+    mesh.tris.push_back(Mesh::triangle(0, 1, 2));
+    mesh.tris.push_back(Mesh::triangle(0, 2, 3));
+}
+
+std::vector<int> toVector(const MeshTopology::IndexRange& range)
+{
+    return std::vector<int>(range.begin(), range.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MeshTopology_square)
+{
+    Mesh mesh;
+    generateSquare(mesh);
+    const MeshTopology topology(mesh);
+
+    BOOST_CHECK_EQUAL(topology.getNbPoints(), 5);
+    BOOST_CHECK_EQUAL(topology.getNbTriangles(), 2);
+    BOOST_CHECK_EQUAL(topology.getNbEdges(), 5);
+
+    // point -> triangles
+    BOOST_CHECK(toVector(topology.getPtTriangles(0)) == std::vector<int>({0, 1}));
+    BOOST_CHECK(toVector(topology.getPtTriangles(1)) == std::vector<int>({0}));
+    BOOST_CHECK(toVector(topology.getPtTriangles(3)) == std::vector<int>({1}));
+    BOOST_CHECK(topology.getPtTriangles(4).empty());
+
+    // point -> points
+    BOOST_CHECK(toVector(topology.getPtNeighbors(0)) == std::vector<int>({1, 2, 3}));
+    BOOST_CHECK(toVector(topology.getPtNeighbors(1)) == std::vector<int>({0, 2}));
+    BOOST_CHECK(topology.getPtNeighbors(4).empty());
+
+    // edges
+    BOOST_CHECK_EQUAL(topology.getEdgeId(1, 3), -1);
+    BOOST_CHECK_EQUAL(topology.getEdgeId(0, 4), -1);
+    BOOST_CHECK_EQUAL(topology.getEdgeId(0, 0), -1);
+    for(int edgeId = 0; edgeId < topology.getNbEdges(); ++edgeId)
+    {
+        const Pixel& edge = topology.getEdgePoints(edgeId);
+        BOOST_CHECK_LT(edge.x, edge.y);
+        BOOST_CHECK_EQUAL(topology.getEdgeId(edge.x, edge.y), edgeId);
+        BOOST_CHECK_EQUAL(topology.getEdgeId(edge.y, edge.x), edgeId);
+    }
+
+    // edge -> triangles
+    BOOST_CHECK(toVector(topology.getEdgeTriangles(topology.getEdgeId(0, 2))) == std::vector<int>({0, 1}));
+    BOOST_CHECK(toVector(topology.getEdgeTriangles(topology.getEdgeId(1, 2))) == std::vector<int>({0}));
+    BOOST_CHECK(toVector(topology.getEdgeTriangles(topology.getEdgeId(3, 0))) == std::vector<int>({1}));
+
+    // triangle -> edges
+    for(int triId = 0; triId < topology.getNbTriangles(); ++triId)
+    {
+        const Mesh::triangle& t = mesh.tris[triId];
+        const Voxel& triEdges = topology.getTriangleEdges(triId);
+        BOOST_CHECK_EQUAL(triEdges.x, topology.getEdgeId(t.v[0], t.v[1]));
+        BOOST_CHECK_EQUAL(triEdges.y, topology.getEdgeId(t.v[1], t.v[2]));
+        BOOST_CHECK_EQUAL(triEdges.z, topology.getEdgeId(t.v[2], t.v[0]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(MeshTopology_cache)
+{
+    Mesh mesh;
+    generateSquare(mesh);
+
+    // concurrent first calls build a single topology
+    std::vector<std::shared_ptr<const MeshTopology>> topologies(16);
+    #pragma omp parallel for
+    for(int i = 0; i < static_cast<int>(topologies.size()); ++i)
+        topologies[i] = mesh.getTopology();
+    for(const std::shared_ptr<const MeshTopology>& topology : topologies)
+        BOOST_CHECK_EQUAL(topology, topologies.front());
+
+    BOOST_CHECK_EQUAL(mesh.getTopology(), topologies.front());
+    BOOST_CHECK_EQUAL(mesh.getTopology()->getEdgeId(1, 3), -1);
+
+    // a direct edit of the triangles is taken into account after invalidateTopology:
+    // flip the diagonal of the square
+    mesh.tris[0] = Mesh::triangle(0, 1, 3);
+    mesh.tris[1] = Mesh::triangle(1, 2, 3);
+    mesh.invalidateTopology();
+    const std::shared_ptr<const MeshTopology> flipped = mesh.getTopology();
+    BOOST_CHECK_NE(flipped->getEdgeId(1, 3), -1);
+    BOOST_CHECK_EQUAL(flipped->getEdgeId(0, 2), -1);
+    BOOST_CHECK(toVector(flipped->getPtTriangles(3)) == std::vector<int>({0, 1}));
+
+    // the previous topology is still valid and unchanged
+    BOOST_CHECK_EQUAL(topologies.front()->getEdgeId(1, 3), -1);
+    BOOST_CHECK_NE(topologies.front()->getEdgeId(0, 2), -1);
+
+    // adding triangles is detected without invalidateTopology
+    mesh.tris.push_back(Mesh::triangle(1, 4, 2));
+    BOOST_CHECK_EQUAL(mesh.getTopology()->getNbTriangles(), 3);
+
+    // the copies share the topology until they are edited
+    Mesh copy = mesh;
+    BOOST_CHECK_EQUAL(copy.getTopology(), mesh.getTopology());
+    copy.changeTriPtId(1, 2, 4);
+    BOOST_CHECK(toVector(copy.getTopology()->getPtTriangles(4)) == std::vector<int>({1, 2}));
+    BOOST_CHECK(toVector(mesh.getTopology()->getPtTriangles(4)) == std::vector<int>({2}));
+}
@@ -8,6 +8,7 @@
 #include "geoMesh.hpp"
 #include "UVAtlas.hpp"
 
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/numeric/numeric.hpp>
@@ -17,6 +18,7 @@
 #include <aliceVision/mvsData/Image.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
 
 #include <geogram/basic/common.h>
 #include <geogram/basic/geometry_nd.h>
@@ -26,7 +28,12 @@
 
 #include <boost/algorithm/string/case_conv.hpp> 
 
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 
 // Debug mode: save atlases decomposition in frequency bands and
@@ -114,6 +121,46 @@ bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& bar
     return dist < 0.5 + std::numeric_limits<double>::epsilon();
 }
 
+/**
+ * @brief Get the horizontal span of a 2D triangle within the rows [y0, y1].
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] y0 the first row
+ * @param[in] y1 the last row
+ * @param[out] xMin the minimum x of the triangle within the rows
+ * @param[out] xMax the maximum x of the triangle within the rows
+ * @return false if the triangle does not intersect the rows
+ */
+bool getTriangleSpanInRows(const Point2d* triangle, double y0, double y1, double& xMin, double& xMax)
+{
+    xMin = std::numeric_limits<double>::max();
+    xMax = std::numeric_limits<double>::lowest();
+
+    for(int k = 0; k < 3; ++k)
+    {
+        const Point2d& a = triangle[k];
+        const Point2d& b = triangle[(k + 1) % 3];
+
+        // vertices within the rows
+        if(a.y >= y0 && a.y <= y1)
+        {
+            xMin = std::min(xMin, a.x);
+            xMax = std::max(xMax, a.x);
+        }
+
+        // intersections of the edges with the row boundaries
+        for(const double y : {y0, y1})
+        {
+            if((a.y - y) * (b.y - y) < 0.0)
+            {
+                const double x = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+                xMin = std::min(xMin, x);
+                xMax = std::max(xMax, x);
+            }
+        }
+    }
+    return xMin <= xMax;
+}
+
 Point2d barycentricToCartesian(const Point2d* triangle, const Point2d& coords)
 {
     return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
@@ -237,6 +284,146 @@ void Texturing::updateAtlases()
     }
 }
 
+namespace {
+
+/**
+ * @brief Camera image and its laplacian pyramid, decoded in the background
+ *        while the previous cameras are rasterized.
+ */
+struct CameraImage
+{
+    Image img;
+    std::vector<Image> pyramidL;
+};
+
+} // namespace
+
+AccuPyramidsCache::AccuPyramidsCache(const std::vector<std::vector<int>>& camerasPerAtlas, std::size_t maxNbInMemory,
+                                     int nbBand, int textureSide, const bfs::path& spillFolder)
+    : _camerasPerAtlas(camerasPerAtlas)
+    , _nextCameraIndex(camerasPerAtlas.size(), 0)
+    , _maxNbInMemory(std::max(std::size_t(1), maxNbInMemory))
+    , _nbBand(nbBand)
+    , _textureSide(textureSide)
+    , _spillFolder(spillFolder)
+{}
+
+AccuPyramidsCache::~AccuPyramidsCache()
+{
+    for(std::size_t atlasID : _spilled)
+        bfs::remove(getSpillPath(atlasID));
+}
+
+Texturing::AccuPyramid& AccuPyramidsCache::get(std::size_t atlasID)
+{
+    auto it = _inMemory.find(atlasID);
+    if(it != _inMemory.end())
+        return it->second;
+
+    if(_inMemory.size() >= _maxNbInMemory)
+        spillFarthest();
+
+    Texturing::AccuPyramid& accuPyramid = _inMemory[atlasID];
+    accuPyramid.init(_nbBand, _textureSide, _textureSide);
+    if(_spilled.erase(atlasID))
+    {
+        const bfs::path spillPath = getSpillPath(atlasID);
+        accuPyramid.load(spillPath.string());
+        bfs::remove(spillPath);
+    }
+    return accuPyramid;
+}
+
+bool AccuPyramidsCache::setContributionsDone(std::size_t atlasID, std::size_t nbCameras)
+{
+    _nextCameraIndex.at(atlasID) += nbCameras;
+    return _nextCameraIndex.at(atlasID) == _camerasPerAtlas.at(atlasID).size();
+}
+
+void AccuPyramidsCache::release(std::size_t atlasID)
+{
+    _inMemory.erase(atlasID);
+}
+
+bfs::path AccuPyramidsCache::getSpillPath(std::size_t atlasID) const
+{
+    return _spillFolder / ("accuPyramid_" + std::to_string(1001 + atlasID) + ".bin");
+}
+
+int AccuPyramidsCache::getNextCamera(std::size_t atlasID) const
+{
+    const std::vector<int>& cameras = _camerasPerAtlas.at(atlasID);
+    const std::size_t next = _nextCameraIndex.at(atlasID);
+    return (next < cameras.size()) ? cameras[next] : std::numeric_limits<int>::max();
+}
+
+void AccuPyramidsCache::spillFarthest()
+{
+    auto farthestIt = std::max_element(_inMemory.begin(), _inMemory.end(),
+        [&](const std::pair<const std::size_t, Texturing::AccuPyramid>& a,
+            const std::pair<const std::size_t, Texturing::AccuPyramid>& b)
+        { return getNextCamera(a.first) < getNextCamera(b.first); });
+
+    ALICEVISION_LOG_INFO("  - Spill atlas " << farthestIt->first + 1 << " accumulation buffers to disk.");
+    farthestIt->second.save(getSpillPath(farthestIt->first).string());
+    _spilled.insert(farthestIt->first);
+    _inMemory.erase(farthestIt);
+    ++_nbSpills;
+}
+
+void Texturing::AccuPyramid::save(const std::string& filepath) const
+{
+    std::ofstream file(filepath, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to write accumulation buffers to " + filepath);
+
+    // header: number of levels, then the size of each level
+    const std::int32_t nbLevels = pyramid.size();
+    file.write(reinterpret_cast<const char*>(&nbLevels), sizeof(nbLevels));
+    for(const AccuImage& accuImage : pyramid)
+    {
+        const std::int32_t size[2] = {accuImage.img.width(), accuImage.img.height()};
+        file.write(reinterpret_cast<const char*>(size), sizeof(size));
+    }
+
+    for(const AccuImage& accuImage : pyramid)
+    {
+        file.write(reinterpret_cast<const char*>(accuImage.img.data().data()), accuImage.img.data().size() * sizeof(Color));
+        file.write(reinterpret_cast<const char*>(accuImage.imgCount.data()), accuImage.imgCount.size() * sizeof(float));
+    }
+    if(!file)
+        throw std::runtime_error("Unable to write accumulation buffers to " + filepath);
+}
+
+void Texturing::AccuPyramid::load(const std::string& filepath)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to read accumulation buffers from " + filepath);
+
+    // the saved sizes must match the initialized pyramid
+    std::int32_t nbLevels = 0;
+    file.read(reinterpret_cast<char*>(&nbLevels), sizeof(nbLevels));
+    if(!file || nbLevels != static_cast<std::int32_t>(pyramid.size()))
+        throw std::runtime_error("Invalid number of levels in accumulation buffers " + filepath);
+    for(const AccuImage& accuImage : pyramid)
+    {
+        std::int32_t size[2] = {0, 0};
+        file.read(reinterpret_cast<char*>(size), sizeof(size));
+        if(!file || size[0] != accuImage.img.width() || size[1] != accuImage.img.height() ||
+           accuImage.imgCount.size() != accuImage.img.data().size())
+            throw std::runtime_error("Invalid size of accumulation buffers " + filepath);
+    }
+
+    for(AccuImage& accuImage : pyramid)
+    {
+        file.read(reinterpret_cast<char*>(accuImage.img.data().data()), accuImage.img.data().size() * sizeof(Color));
+        file.read(reinterpret_cast<char*>(accuImage.imgCount.data()), accuImage.imgCount.size() * sizeof(float));
+    }
+    if(!file || file.peek() != std::ifstream::traits_type::eof())
+        throw std::runtime_error("Unable to read accumulation buffers from " + filepath);
+}
+
 void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
                                  const boost::filesystem::path& outPath, imageIO::EImageFileType textureFileType)
 {
@@ -258,9 +445,7 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
     std::partial_sum(m.begin(), m.end(), m.begin());
 
     ALICEVISION_LOG_INFO("Texturing in " + imageIO::EImageColorSpace_enumToString(texParams.processColorspace) + " colorspace.");
-    mvsUtils::ImagesCache imageCache(&mp, texParams.processColorspace, texParams.correctEV);
-    imageCache.setCacheSize(2);
-    ALICEVISION_LOG_INFO("Images loaded from cache with: " + imageCache.ECorrectEV_enumToString(texParams.correctEV));
+    ALICEVISION_LOG_INFO("Images loaded with: " + mvsUtils::ImagesCache::ECorrectEV_enumToString(texParams.correctEV));
 
     //calculate the maximum number of atlases in memory in MB
     system::MemoryInfo memInfo = system::getMemoryInfo();
@@ -270,7 +455,12 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
     const std::size_t atlasPyramidMaxMemSize = texParams.nbBand * atlasContribMemSize;
 
     const int freeRam = int(memInfo.freeRam / std::pow(2,20));
-    const int availableMem = freeRam - 2 * imageMaxMemSize - imagePyramidMaxMemSize; // keep some memory for the 2 input images in cache and one laplacian pyramid
+
+    // several cameras are decoded and rasterized concurrently,
+    // with up to a quarter of the free RAM for the current and the next batches of images with their laplacian pyramids
+    const std::size_t cameraMaxMemSize = std::max<std::size_t>(1, imageMaxMemSize + imagePyramidMaxMemSize);
+    const int nbCamerasPerBatch = std::max(1, std::min(omp_get_max_threads(), int(freeRam / (8 * cameraMaxMemSize))));
+    const int availableMem = freeRam - 2 * nbCamerasPerBatch * cameraMaxMemSize;
 
     const int nbAtlas = _atlases.size();
     int nbAtlasMax = std::floor(availableMem / atlasPyramidMaxMemSize); //maximum number of textures laplacian pyramid in RAM
@@ -283,396 +473,493 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp,
     ALICEVISION_LOG_INFO("Total amount of memory available : " << availableMem << " MB.");
     ALICEVISION_LOG_INFO("Total amount of an image in memory  : " << imageMaxMemSize << " MB.");
     ALICEVISION_LOG_INFO("Total amount of an atlas pyramid in memory: " << atlasPyramidMaxMemSize << " MB.");
-    ALICEVISION_LOG_INFO("Processing " << nbAtlas << " atlases by chunks of " << nbAtlasMax);
+    ALICEVISION_LOG_INFO("Processing " << nbAtlas << " atlases with up to " << nbAtlasMax << " in memory.");
+    ALICEVISION_LOG_INFO("Processing cameras by batches of " << nbCamerasPerBatch << ".");
+
+    // We select the best cameras for each triangle and store it per camera for each output texture files.
+    std::vector<AtlasContributions> contributionsPerCamera(mp.ncams);
+    for(std::size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
+        computeContributions(mp, atlasID, contributionsPerCamera);
 
-    //generateTexture for the maximum number of atlases, and iterate
-    const std::div_t divresult = div(nbAtlas, nbAtlasMax);
-    std::vector<size_t> atlasIDs;
-    atlasIDs.reserve(nbAtlasMax);
-    for(int n = 0; n <= divresult.quot; ++n)
+    // cameras contributing to each atlas, in processing order
+    std::vector<std::vector<int>> camerasPerAtlas(nbAtlas);
+    std::vector<int> cameras;
+    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
     {
-        atlasIDs.clear();
-        int imax = (n < divresult.quot ? nbAtlasMax : divresult.rem);
-        if(!imax)
-            continue;
-        for(int i = 0; i < imax; ++i)
+        if(contributionsPerCamera[camId].empty())
         {
-            size_t atlasID = size_t(n*nbAtlasMax + i);
-            atlasIDs.push_back(atlasID);
+            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
+            continue;
         }
-        ALICEVISION_LOG_INFO("Generating texture for atlases " << n*nbAtlasMax + 1 << " to " << n*nbAtlasMax+imax );
-        generateTexturesSubSet(mp, atlasIDs, imageCache, outPath, textureFileType);
+        cameras.push_back(camId);
+        for(const auto& c : contributionsPerCamera[camId])
+            camerasPerAtlas[c.first].push_back(camId);
     }
-}
 
-void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                                const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, imageIO::EImageFileType textureFileType)
-{
-    if(atlasIDs.size() > _atlases.size())
-        throw std::runtime_error("Invalid atlas IDs ");
+    AccuPyramidsCache accuPyramidsCache(camerasPerAtlas, nbAtlasMax, texParams.nbBand, texParams.textureSide, outPath);
 
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+    // atlases without any contribution are written right away
+    for(std::size_t atlasID = 0; atlasID < camerasPerAtlas.size(); ++atlasID)
+    {
+        if(!camerasPerAtlas[atlasID].empty())
+            continue;
+        finalizeTexture(accuPyramidsCache.get(atlasID), atlasID, outPath, textureFileType);
+        accuPyramidsCache.release(atlasID);
+    }
 
-    // We select the best cameras for each triangle and store it per camera for each output texture files.
-    // Triangles contributions are stored per frequency bands for multi-band blending.
-    using AtlasIndex = size_t;
-    using ScorePerTriangle = std::vector<std::pair<unsigned int, float>>; //list of <triangleId, score>
-    std::vector<std::map<AtlasIndex, std::vector<ScorePerTriangle>>> contributionsPerCamera(mp.ncams);
+    ALICEVISION_LOG_INFO("Reading pixel color.");
+
+    // each image is decoded once, while the previous batch of cameras is rasterized
+    using CameraImageFuture = std::future<std::unique_ptr<CameraImage>>;
+    const auto loadCameraImage = [&](int camId)
+    {
+        std::unique_ptr<CameraImage> cameraImage(new CameraImage());
+        mvsUtils::loadImage(mp.getImagePath(camId), &mp, camId, cameraImage->img, texParams.processColorspace, texParams.correctEV);
+        cameraImage->img.laplacianPyramid(cameraImage->pyramidL, texParams.nbBand, texParams.multiBandDownscale);
+        return cameraImage;
+    };
+    const auto loadCameraImages = [&](std::size_t batchBegin)
+    {
+        std::vector<CameraImageFuture> batch;
+        for(std::size_t i = batchBegin; i < std::min(cameras.size(), batchBegin + nbCamerasPerBatch); ++i)
+            batch.push_back(std::async(std::launch::async, loadCameraImage, cameras[i]));
+        return batch;
+    };
+
+    std::vector<CameraImageFuture> nextCameraImages = loadCameraImages(0);
 
-    //for each atlasID, calculate contributionPerCamera
-    for(const size_t atlasID : atlasIDs)
+    for(std::size_t batchBegin = 0; batchBegin < cameras.size(); batchBegin += nbCamerasPerBatch)
     {
-        ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
-                  << " (" << _atlases[atlasID].size() << " triangles).");
+        const std::size_t batchEnd = std::min(cameras.size(), batchBegin + nbCamerasPerBatch);
+
+        std::vector<std::unique_ptr<CameraImage>> cameraImages;
+        for(CameraImageFuture& cameraImage : nextCameraImages)
+            cameraImages.push_back(cameraImage.get());
+        nextCameraImages = loadCameraImages(batchEnd);
 
-        // iterate over atlas' triangles
-        for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+        // contributions of the batch cameras to each atlas, in camera order
+        std::map<AtlasIndex, std::vector<CameraContribution>> batchContributions;
+        std::map<AtlasIndex, std::size_t> nbBatchCameras;
+        for(std::size_t i = batchBegin; i < batchEnd; ++i)
         {
-            int triangleID = _atlases[atlasID][i];
+            const int camId = cameras[i];
+            const CameraImage& cameraImage = *cameraImages[i - batchBegin];
+            const AtlasContributions& cameraContributions = contributionsPerCamera[camId];
 
-            // Fuse visibilities of the 3 vertices
-            std::vector<int> allTriCams;
-            for (int k = 0; k < 3; k++)
+            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") with contributions to " << cameraContributions.size() << " texture files.");
+
+            for(const auto& c : cameraContributions)
             {
-                const int pointIndex = mesh->tris[triangleID].v[k];
-                const StaticVector<int> pointVisibilities = mesh->pointsVisibilities[pointIndex];
-                if (!pointVisibilities.empty())
+                ++nbBatchCameras[c.first];
+                for(int band = 0; band < c.second.size(); ++band)
                 {
-                    std::copy(pointVisibilities.begin(), pointVisibilities.end(), std::inserter(allTriCams, allTriCams.end()));
+                    if(!c.second[band].empty())
+                        batchContributions[c.first].push_back({camId, band, &c.second[band], &cameraImage.img, &cameraImage.pyramidL});
                 }
             }
-            if (allTriCams.empty())
+        }
+
+        // for each output texture file
+        for(const auto& c : batchContributions)
+        {
+            const AtlasIndex atlasID = c.first;
+            ALICEVISION_LOG_INFO("  - Texture file: " << atlasID + 1 << " (" << nbBatchCameras.at(atlasID) << " cameras).");
+
+            AccuPyramid& accuPyramid = accuPyramidsCache.get(atlasID);
+            fillAtlasPyramid(mp, c.second, accuPyramid);
+
+            // the atlas is complete after its last camera
+            if(accuPyramidsCache.setContributionsDone(atlasID, nbBatchCameras.at(atlasID)))
             {
-                // triangle without visibility
-                ALICEVISION_LOG_TRACE("No visibility for triangle " << triangleID << " in texture atlas " << atlasID << ".");
-                continue;
+                finalizeTexture(accuPyramid, atlasID, outPath, textureFileType);
+                accuPyramidsCache.release(atlasID);
             }
-            std::sort(allTriCams.begin(), allTriCams.end());
+        }
+    }
 
-            std::vector<std::pair<int, int>> selectedTriCams; // <camId, nbVertices>
-            selectedTriCams.emplace_back(allTriCams.front(), 1);
-            for (int j = 1; j < allTriCams.size(); ++j)
+    ALICEVISION_LOG_INFO("Texturing: " << cameras.size() << " images decoded, " << accuPyramidsCache.getNbSpills() << " atlas buffers spilled to disk.");
+}
+
+void Texturing::computeContributions(const mvsUtils::MultiViewParams& mp, std::size_t atlasID,
+                                     std::vector<AtlasContributions>& contributionsPerCamera)
+{
+    // Triangles contributions are stored per frequency bands for multi-band blending.
+    ALICEVISION_LOG_INFO("Selecting cameras for atlas " << atlasID + 1 << "/" << _atlases.size()
+              << " (" << _atlases[atlasID].size() << " triangles).");
+
+    // iterate over atlas' triangles
+    for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+    {
+        int triangleID = _atlases[atlasID][i];
+
+        // Fuse visibilities of the 3 vertices
+        std::vector<int> allTriCams;
+        for (int k = 0; k < 3; k++)
+        {
+            const int pointIndex = mesh->tris[triangleID].v[k];
+            const StaticVector<int> pointVisibilities = mesh->pointsVisibilities[pointIndex];
+            if (!pointVisibilities.empty())
             {
-                const unsigned int camId = allTriCams[j];
-                if(selectedTriCams.back().first == camId)
-                {
-                    ++selectedTriCams.back().second;
-                }
-                else
-                {
-                    selectedTriCams.emplace_back(camId, 1);
-                }
+                std::copy(pointVisibilities.begin(), pointVisibilities.end(), std::inserter(allTriCams, allTriCams.end()));
             }
+        }
+        if (allTriCams.empty())
+        {
+            // triangle without visibility
+            ALICEVISION_LOG_TRACE("No visibility for triangle " << triangleID << " in texture atlas " << atlasID << ".");
+            continue;
+        }
+        std::sort(allTriCams.begin(), allTriCams.end());
 
-            assert(!selectedTriCams.empty());
-
-            // Select the N best views for texturing
-            Point3d triangleNormal;
-            Point3d triangleCenter;
-            if (texParams.angleHardThreshold != 0.0)
+        std::vector<std::pair<int, int>> selectedTriCams; // <camId, nbVertices>
+        selectedTriCams.emplace_back(allTriCams.front(), 1);
+        for (int j = 1; j < allTriCams.size(); ++j)
+        {
+            const unsigned int camId = allTriCams[j];
+            if(selectedTriCams.back().first == camId)
             {
-                triangleNormal = mesh->computeTriangleNormal(triangleID);
-                triangleCenter = mesh->computeTriangleCenterOfGravity(triangleID);
+                ++selectedTriCams.back().second;
             }
-            using ScoreCamId = std::tuple<int, double, int>; // <nbVertex, score, camId>
-            std::vector<ScoreCamId> scorePerCamId;
-            for (const auto& itCamVis: selectedTriCams)
+            else
             {
-                const int camId = itCamVis.first;
-                const int verticesSupport = itCamVis.second;
-                if(texParams.forceVisibleByAllVertices && verticesSupport < 3)
-                    continue;
+                selectedTriCams.emplace_back(camId, 1);
+            }
+        }
 
-                if (texParams.angleHardThreshold != 0.0)
-                {
-                    const Point3d vecPointToCam = (mp.CArr[camId] - triangleCenter).normalize();
-                    const double angle = angleBetwV1andV2(triangleNormal, vecPointToCam);
-                    if(angle > texParams.angleHardThreshold)
-                        continue;
-                }
+        assert(!selectedTriCams.empty());
 
-                const int w = mp.getWidth(camId);
-                const int h = mp.getHeight(camId);
+        // Select the N best views for texturing
+        Point3d triangleNormal;
+        Point3d triangleCenter;
+        if (texParams.angleHardThreshold != 0.0)
+        {
+            triangleNormal = mesh->computeTriangleNormal(triangleID);
+            triangleCenter = mesh->computeTriangleCenterOfGravity(triangleID);
+        }
+        using ScoreCamId = std::tuple<int, double, int>; // <nbVertex, score, camId>
+        std::vector<ScoreCamId> scorePerCamId;
+        for (const auto& itCamVis: selectedTriCams)
+        {
+            const int camId = itCamVis.first;
+            const int verticesSupport = itCamVis.second;
+            if(texParams.forceVisibleByAllVertices && verticesSupport < 3)
+                continue;
 
-                const Mesh::triangle_proj tProj = mesh->getTriangleProjection(triangleID, mp, camId, w, h);
-                const int nbVertex = mesh->getTriangleNbVertexInImage(mp, tProj, camId, 20);
-                if(nbVertex == 0)
-                    // No triangle vertex in the image
+            if (texParams.angleHardThreshold != 0.0)
+            {
+                const Point3d vecPointToCam = (mp.CArr[camId] - triangleCenter).normalize();
+                const double angle = angleBetwV1andV2(triangleNormal, vecPointToCam);
+                if(angle > texParams.angleHardThreshold)
                     continue;
-
-                const double area = mesh->computeTriangleProjectionArea(tProj);
-                const double score = area * double(verticesSupport);
-                scorePerCamId.emplace_back(nbVertex, score, camId);
             }
-            if (scorePerCamId.empty())
-            {
-                // triangle without visibility
-                ALICEVISION_LOG_TRACE("No visibility for triangle " << triangleID << " in texture atlas " << atlasID << " after scoring!!");
+
+            const int w = mp.getWidth(camId);
+            const int h = mp.getHeight(camId);
+
+            const Mesh::triangle_proj tProj = mesh->getTriangleProjection(triangleID, mp, camId, w, h);
+            const int nbVertex = mesh->getTriangleNbVertexInImage(mp, tProj, camId, 20);
+            if(nbVertex == 0)
+                // No triangle vertex in the image
                 continue;
-            }
 
-            std::sort(scorePerCamId.begin(), scorePerCamId.end(), std::greater<ScoreCamId>());
-            const double minScore = texParams.bestScoreThreshold * std::get<1>(scorePerCamId.front()); // bestScoreThreshold * bestScore
-            const bool bestIsPartial = (std::get<0>(scorePerCamId.front()) < 3);
+            const double area = mesh->computeTriangleProjectionArea(tProj);
+            const double score = area * double(verticesSupport);
+            scorePerCamId.emplace_back(nbVertex, score, camId);
+        }
+        if (scorePerCamId.empty())
+        {
+            // triangle without visibility
+            ALICEVISION_LOG_TRACE("No visibility for triangle " << triangleID << " in texture atlas " << atlasID << " after scoring!!");
+            continue;
+        }
+
+        std::sort(scorePerCamId.begin(), scorePerCamId.end(), std::greater<ScoreCamId>());
+        const double minScore = texParams.bestScoreThreshold * std::get<1>(scorePerCamId.front()); // bestScoreThreshold * bestScore
+        const bool bestIsPartial = (std::get<0>(scorePerCamId.front()) < 3);
 
-            int nbContribMax = std::min(texParams.multiBandNbContrib.back(), static_cast<int>(scorePerCamId.size()));
-            int nbCumulatedVertices = 0;
-            int band = 0;
-            for(int contrib = 0; nbCumulatedVertices < 3 * nbContribMax && contrib < nbContribMax; ++contrib)
+        int nbContribMax = std::min(texParams.multiBandNbContrib.back(), static_cast<int>(scorePerCamId.size()));
+        int nbCumulatedVertices = 0;
+        int band = 0;
+        for(int contrib = 0; nbCumulatedVertices < 3 * nbContribMax && contrib < nbContribMax; ++contrib)
+        {
+            nbCumulatedVertices += std::get<0>(scorePerCamId[contrib]);
+            if (!bestIsPartial && contrib != 0)
             {
-                nbCumulatedVertices += std::get<0>(scorePerCamId[contrib]);
-                if (!bestIsPartial && contrib != 0)
+                if(std::get<1>(scorePerCamId[contrib]) < minScore)
                 {
-                    if(std::get<1>(scorePerCamId[contrib]) < minScore)
-                    {
-                        // The best image fully see the triangle and has a much better score, so only rely on the first ones
-                        break;
-                    }
+                    // The best image fully see the triangle and has a much better score, so only rely on the first ones
+                    break;
                 }
+            }
 
-                //for the camera camId : add triangle score to the corresponding texture, at the right frequency band
-                const int camId = std::get<2>(scorePerCamId[contrib]);
-                const int triangleScore = std::get<1>(scorePerCamId[contrib]);
-                auto& camContribution = contributionsPerCamera[camId];
-                if(camContribution.find(atlasID) == camContribution.end())
-                    camContribution[atlasID].resize(texParams.nbBand);
-                camContribution.at(atlasID)[band].emplace_back(triangleID, triangleScore);
+            //for the camera camId : add triangle score to the corresponding texture, at the right frequency band
+            const int camId = std::get<2>(scorePerCamId[contrib]);
+            const int triangleScore = std::get<1>(scorePerCamId[contrib]);
+            auto& camContribution = contributionsPerCamera[camId];
+            if(camContribution.find(atlasID) == camContribution.end())
+                camContribution[atlasID].resize(texParams.nbBand);
+            camContribution.at(atlasID)[band].emplace_back(triangleID, triangleScore);
 
-                if(contrib + 1 == texParams.multiBandNbContrib[band])
-                {
-                    ++band;
-                }
+            if(contrib + 1 == texParams.multiBandNbContrib[band])
+            {
+                ++band;
             }
         }
     }
+}
 
-    ALICEVISION_LOG_INFO("Reading pixel color.");
+void Texturing::getTrianglePixelCoords(unsigned int triangleId, Point2d* triPixs) const
+{
+    auto& triangleUvIds = mesh->trisUvIds[triangleId];
+    const StaticVector<Point2d>& uvCoords = mesh->uvCoords;
 
-    //pyramid of atlases frequency bands
-    std::map<AtlasIndex, AccuPyramid> accuPyramids;
-    for(std::size_t atlasID: atlasIDs)
-        accuPyramids[atlasID].init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
+    // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
+    Point2d udimBL;
+    udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
+    udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
 
-    //for each camera, for each texture, iterate over triangles and fill the accuPyramids map
-    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+    for(int k = 0; k < 3; k++)
     {
-        const std::map<AtlasIndex, std::vector<ScorePerTriangle>>& cameraContributions = contributionsPerCamera[camId];
+       const int uvPointIndex = triangleUvIds.m[k];
+       // UDIM: remap coordinates between [0,1]
+       const Point2d uv = uvCoords[uvPointIndex] - udimBL;
+       triPixs[k] = uv * texParams.textureSide;   // UV coordinates
+    }
+}
+
+void Texturing::fillAtlasPyramid(const mvsUtils::MultiViewParams& mp, const std::vector<CameraContribution>& contributions,
+                                 AccuPyramid& accuPyramid)
+{
+    // The atlas is split in tiles of rows, each one filled by a single thread.
+    // Within a tile, contributions are accumulated in (camera, band, triangle) order,
+    // so the result does not depend on the number of threads.
+    const int tileHeight = 64;
+    const int texSide = static_cast<int>(texParams.textureSide);
+    const int nbTiles = (texSide + tileHeight - 1) / tileHeight;
 
-        if(cameraContributions.empty())
+    using TriangleRef = std::pair<int, int>; // <contribution index, triangle index in contribution>
+    std::vector<std::vector<TriangleRef>> trianglesPerTile(nbTiles);
+
+    for(int ci = 0; ci < contributions.size(); ++ci)
+    {
+        const ScorePerTriangle& trianglesId = *contributions[ci].triangles;
+        for(int ti = 0; ti < trianglesId.size(); ++ti)
         {
-            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
-            continue;
-        }
-        ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") with contributions to " << cameraContributions.size() << " texture files:");
+            Point2d triPixs[3];
+            getTrianglePixelCoords(std::get<0>(trianglesId[ti]), triPixs);
 
-        // Load camera image from cache
-        mvsUtils::ImagesCache::ImgSharedPtr imgPtr = imageCache.getImg_sync(camId);
-        const Image& camImg = *imgPtr;
+            const int minY = clamp(static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y))), 0, texSide);
+            const int maxY = clamp(static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y))), 0, texSide);
+            if(minY >= maxY)
+                continue;
 
-        // Calculate laplacianPyramid
-        std::vector<Image> pyramidL; //laplacian pyramid
-        camImg.laplacianPyramid(pyramidL, texParams.nbBand, texParams.multiBandDownscale);
+            for(int tile = minY / tileHeight; tile <= (maxY - 1) / tileHeight; ++tile)
+                trianglesPerTile[tile].emplace_back(ci, ti);
+        }
+    }
 
-        // for each output texture file
-        for(const auto& c : cameraContributions)
-        {
-            AtlasIndex atlasID = c.first;
-            ALICEVISION_LOG_INFO("  - Texture file: " << atlasID + 1);
-            //for each frequency band
-            for(int band = 0; band < c.second.size(); ++band)
-            {
-                const ScorePerTriangle& trianglesId = c.second[band];
-                ALICEVISION_LOG_INFO("      - band " << band + 1 << ": " << trianglesId.size() << " triangles.");
+    #pragma omp parallel for schedule(dynamic)
+    for(int tile = 0; tile < nbTiles; ++tile)
+    {
+        const int rowBegin = tile * tileHeight;
+        const int rowEnd = std::min(texSide, rowBegin + tileHeight);
 
-                // for each triangle
-                #pragma omp parallel for
-                for(int ti = 0; ti < trianglesId.size(); ++ti)
-                {
-                    const unsigned int triangleId = std::get<0>(trianglesId[ti]);
-                    const float triangleScore = texParams.useScore ? std::get<1>(trianglesId[ti]) : 1.0f;
-                    // retrieve triangle 3D and UV coordinates
-                    Point2d triPixs[3];
-                    Point3d triPts[3];
-                    auto& triangleUvIds = mesh->trisUvIds[triangleId];
-                    // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
-                    Point2d udimBL;
-                    StaticVector<Point2d>& uvCoords = mesh->uvCoords;
-                    udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
-                    udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
-
-                    for(int k = 0; k < 3; k++)
-                    {
-                       const int pointIndex = mesh->tris[triangleId].v[k];
-                       triPts[k] = mesh->pts[pointIndex];                               // 3D coordinates
-                       const int uvPointIndex = triangleUvIds.m[k];
-                       Point2d uv = uvCoords[uvPointIndex];
-                       // UDIM: remap coordinates between [0,1]
-                       uv = uv - udimBL;
-
-                       triPixs[k] = uv * texParams.textureSide;   // UV coordinates
-                    }
+        for(const TriangleRef& triangleRef : trianglesPerTile[tile])
+        {
+            const CameraContribution& contribution = contributions[triangleRef.first];
+            const auto& triangle = (*contribution.triangles)[triangleRef.second];
+            const float triangleScore = texParams.useScore ? std::get<1>(triangle) : 1.0f;
 
-                    // compute triangle bounding box in pixel indexes
-                    // min values: floor(value)
-                    // max values: ceil(value)
-                    Pixel LU, RD;
-                    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-                    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-                    // sanity check: clamp values to [0; textureSide]
-                    int texSide = static_cast<int>(texParams.textureSide);
-                    LU.x = clamp(LU.x, 0, texSide);
-                    LU.y = clamp(LU.y, 0, texSide);
-                    RD.x = clamp(RD.x, 0, texSide);
-                    RD.y = clamp(RD.y, 0, texSide);
-
-                    // iterate over pixels of the triangle's bounding box
-                    for(int y = LU.y; y < RD.y; y++)
-                    {
-                       for(int x = LU.x; x < RD.x; x++)
-                       {
-                           Pixel pix(x, y); // top-left corner of the pixel
-                           Point2d barycCoords;
-
-                           // test if the pixel is inside triangle
-                           // and retrieve its barycentric coordinates
-                           if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                           {
-                               continue;
-                           }
-
-                           // remap 'y' to image coordinates system (inverted Y axis)
-                           const unsigned int y_ = (texParams.textureSide - 1) - y;
-                           // 1D pixel index
-                           unsigned int xyoffset = y_ * texParams.textureSide + x;
-                           // get 3D coordinates
-                           Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                           // get 2D coordinates in source image
-                           Point2d pixRC;
-                           mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                           // exclude out of bounds pixels
-                           if(!mp.isPixelInImage(pixRC, camId))
-                               continue;
-
-                           // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
-                           if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
-                               continue;
-
-                           // Fill the accumulated pyramid for this pixel
-                           // each frequency band also contributes to lower frequencies (higher band indexes)
-                           AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-                           for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
-                           {
-                               int downscaleCoef = std::pow(texParams.multiBandDownscale, bandContrib);
-                               AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
-
-                               // fill the accumulated color map for this pixel
-                               accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoef) * triangleScore;
-                               accuImage.imgCount[xyoffset] += triangleScore;
-                           }
-                       }
-                    }
-                }
-            }
+            rasterizeTriangle(mp, contribution, std::get<0>(triangle), triangleScore, rowBegin, rowEnd, accuPyramid);
         }
     }
+}
+
+void Texturing::rasterizeTriangle(const mvsUtils::MultiViewParams& mp, const CameraContribution& contribution,
+                                  unsigned int triangleId, float triangleScore, int rowBegin, int rowEnd,
+                                  AccuPyramid& accuPyramid) const
+{
+    const int camId = contribution.camId;
+    const Image& camImg = *contribution.img;
+    const std::vector<Image>& pyramidL = *contribution.pyramidL;
+
+    // retrieve triangle 3D and UV coordinates
+    Point2d triPixs[3];
+    Point3d triPts[3];
+    getTrianglePixelCoords(triangleId, triPixs);
+    for(int k = 0; k < 3; k++)
+    {
+       const int pointIndex = mesh->tris[triangleId].v[k];
+       triPts[k] = mesh->pts[pointIndex];                               // 3D coordinates
+    }
 
+    // compute triangle bounding box in pixel indexes
+    // min values: floor(value)
+    // max values: ceil(value)
+    Pixel LU, RD;
+    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+    // sanity check: clamp values to [0; textureSide], restrict rows to the current tile
+    int texSide = static_cast<int>(texParams.textureSide);
+    LU.x = clamp(LU.x, 0, texSide);
+    LU.y = clamp(LU.y, rowBegin, rowEnd);
+    RD.x = clamp(RD.x, 0, texSide);
+    RD.y = clamp(RD.y, rowBegin, rowEnd);
+
+    // distance tolerance of isPixelInTriangle
+    const double tolerance = std::sqrt(0.5);
+
+    // iterate over the pixels of each row span of the triangle
+    for(int y = LU.y; y < RD.y; y++)
+    {
+       // pixels whose center is close enough to the triangle lie in the span
+       // of the triangle within the rows [center - tolerance, center + tolerance]
+       double spanMin, spanMax;
+       if(!getTriangleSpanInRows(triPixs, y + 0.5 - tolerance, y + 0.5 + tolerance, spanMin, spanMax))
+           continue;
+       const int xBegin = std::max(LU.x, static_cast<int>(std::ceil(spanMin - tolerance - 0.5)));
+       const int xEnd = std::min(RD.x, static_cast<int>(std::floor(spanMax + tolerance - 0.5)) + 1);
+
+       for(int x = xBegin; x < xEnd; x++)
+       {
+           Pixel pix(x, y); // top-left corner of the pixel
+           Point2d barycCoords;
+
+           // test if the pixel is inside triangle
+           // and retrieve its barycentric coordinates
+           if(!isPixelInTriangle(triPixs, pix, barycCoords))
+           {
+               continue;
+           }
+
+           // remap 'y' to image coordinates system (inverted Y axis)
+           const unsigned int y_ = (texParams.textureSide - 1) - y;
+           // 1D pixel index
+           unsigned int xyoffset = y_ * texParams.textureSide + x;
+           // get 3D coordinates
+           Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+           // get 2D coordinates in source image
+           Point2d pixRC;
+           mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+           // exclude out of bounds pixels
+           if(!mp.isPixelInImage(pixRC, camId))
+               continue;
+
+           // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
+           if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
+               continue;
+
+           // Fill the accumulated pyramid for this pixel
+           // each frequency band also contributes to lower frequencies (higher band indexes)
+           for(std::size_t bandContrib = contribution.band; bandContrib < pyramidL.size(); ++bandContrib)
+           {
+               int downscaleCoef = std::pow(texParams.multiBandDownscale, bandContrib);
+               AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
+
+               // fill the accumulated color map for this pixel
+               accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoef) * triangleScore;
+               accuImage.imgCount[xyoffset] += triangleScore;
+           }
+       }
+    }
+}
+
+void Texturing::finalizeTexture(AccuPyramid& accuPyramid, std::size_t atlasID, const bfs::path& outPath,
+                                imageIO::EImageFileType textureFileType)
+{
     //calculate atlas texture in the first level of the pyramid (avoid creating a new buffer)
     //debug mode : write all the frequencies levels for each texture
-    for(std::size_t atlasID : atlasIDs)
-    {
-        AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-        AccuImage& atlasTexture = accuPyramid.pyramid[0];
-        ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
+    AccuImage& atlasTexture = accuPyramid.pyramid[0];
+    ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
 
 #if TEXTURING_MBB_DEBUG
+    {
+        // write the number of contribution per atlas frequency bands
+        if(!texParams.useScore)
         {
-            // write the number of contribution per atlas frequency bands
-            if(!texParams.useScore)
+            for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
             {
-                for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
 
-                    //write the number of contributions for each texture
-                    std::vector<float> imgContrib(textureSize);
+                //write the number of contributions for each texture
+                std::vector<float> imgContrib(texParams.textureSide * texParams.textureSide);
 
-                    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+                for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+                {
+                    unsigned int yoffset = yp * texParams.textureSide;
+                    for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
                     {
-                        unsigned int yoffset = yp * texParams.textureSide;
-                        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
-                        {
-                            unsigned int xyoffset = yoffset + xp;
-                            imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
-                        }
+                        unsigned int xyoffset = yoffset + xp;
+                        imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
                     }
+                }
 
-                    const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
-                    bfs::path texturePath = outPath / textureName;
+                const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
+                bfs::path texturePath = outPath / textureName;
 
-                    using namespace imageIO;
-                    OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
-                    if(texParams.convertLAB)
-                        colorspace.from = EImageColorSpace::LAB;
-                    writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
-                }
+                using namespace imageIO;
+                OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
+                if(texParams.convertLAB)
+                    colorspace.from = EImageColorSpace::LAB;
+                writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
             }
         }
+    }
 #endif
 
-        ALICEVISION_LOG_INFO("  - Computing final (average) color.");
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    ALICEVISION_LOG_INFO("  - Computing final (average) color.");
+    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    {
+        unsigned int yoffset = yp * texParams.textureSide;
+        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
         {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
-            {
-                unsigned int xyoffset = yoffset + xp;
+            unsigned int xyoffset = yoffset + xp;
 
-                // If the imgCount is valid on the first band, it will be valid on all the other bands
-                if(atlasTexture.imgCount[xyoffset] == 0)
-                    continue;
+            // If the imgCount is valid on the first band, it will be valid on all the other bands
+            if(atlasTexture.imgCount[xyoffset] == 0)
+                continue;
 
-                atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
-                atlasTexture.imgCount[xyoffset] = 1;
+            atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
+            atlasTexture.imgCount[xyoffset] = 1;
 
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
-                }
+            for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
+            {
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
             }
         }
+    }
 
 #if TEXTURING_MBB_DEBUG
+    {
+        //write each frequency band, for each texture
+        for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
         {
-            //write each frequency band, for each texture
-            for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
-            {
-                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
-            }
-
+            AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+            writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
         }
+
+    }
 #endif
 
-        // Fuse frequency bands into the first buffer, calculate final texture
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    // Fuse frequency bands into the first buffer, calculate final texture
+    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    {
+        unsigned int yoffset = yp * texParams.textureSide;
+        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
         {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+            unsigned int xyoffset = yoffset + xp;
+            for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
             {
-                unsigned int xyoffset = yoffset + xp;
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
-                }
+                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
             }
         }
-        writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
     }
+    writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
 }
 
 void Texturing::writeTexture(AccuImage& atlasTexture, const std::size_t atlasID, const boost::filesystem::path &outPath,
@@ -827,8 +1114,8 @@ void Texturing::loadOBJWithAtlas(const std::string& filename, bool flipNormals)
     // Clear internal data
     clear();
     mesh = new Mesh();
-    // Load .obj
-    if(!mesh->loadFromObjAscii(filename.c_str()))
+    // Load mesh (obj, ply or bin)
+    if(!mesh->load(filename))
     {
         throw std::runtime_error("Unable to load: " + filename);
     }
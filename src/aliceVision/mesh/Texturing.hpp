@@ -18,6 +18,11 @@
 
 #include <boost/filesystem.hpp>
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 namespace bfs = boost::filesystem;
 
 namespace aliceVision {
@@ -175,16 +180,63 @@ public:
             for(auto& accuImage : pyramid)
                 accuImage.resize(imgWidth, imgHeight);
         }
+
+        /// Write the accumulation buffers to a raw binary file
+        void save(const std::string& filepath) const;
+
+        /// Read the accumulation buffers from a raw binary file (the pyramid must be initialized with the same sizes)
+        void load(const std::string& filepath);
     };
 
-    /// Generate texture files for all texture atlases
+    using AtlasIndex = std::size_t;
+    /// list of <triangleId, score>
+    using ScorePerTriangle = std::vector<std::pair<unsigned int, float>>;
+    /// contributions of a camera to each atlas, per frequency band
+    using AtlasContributions = std::map<AtlasIndex, std::vector<ScorePerTriangle>>;
+
+    /**
+     * @brief Generate texture files for all texture atlases
+     *
+     * Each source image is decoded once (in the background while the previous one is rasterized)
+     * and contributes to all its atlases. Atlases are written as soon as their last contributing
+     * camera is processed. If the atlas buffers do not fit in memory, some are spilled to disk.
+     */
     void generateTextures(const mvsUtils::MultiViewParams& mp,
                           const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 
-    /// Generate texture files for the given sub-set of texture atlases
-    void generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                         const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
-                         const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
+    /// Select the best cameras for each triangle of the given atlas and store the contributions per camera
+    void computeContributions(const mvsUtils::MultiViewParams& mp, std::size_t atlasID,
+                              std::vector<AtlasContributions>& contributionsPerCamera);
+
+    /// triangles of a camera contributing to an atlas from a frequency band
+    struct CameraContribution
+    {
+        int camId;
+        int band;
+        const ScorePerTriangle* triangles;
+        const Image* img;
+        const std::vector<Image>* pyramidL;
+    };
+
+    /// Get the pixel coordinates of a triangle in its atlas
+    void getTrianglePixelCoords(unsigned int triangleId, Point2d* triPixs) const;
+
+    /**
+     * @brief Accumulate the colors of the given cameras triangles into the atlas pyramid
+     *
+     * Tiles of atlas rows are filled in parallel, with a deterministic accumulation order.
+     */
+    void fillAtlasPyramid(const mvsUtils::MultiViewParams& mp, const std::vector<CameraContribution>& contributions,
+                          AccuPyramid& accuPyramid);
+
+    /// Accumulate the colors of a camera triangle into the atlas pyramid, for the atlas rows in [rowBegin, rowEnd)
+    void rasterizeTriangle(const mvsUtils::MultiViewParams& mp, const CameraContribution& contribution,
+                           unsigned int triangleId, float triangleScore, int rowBegin, int rowEnd,
+                           AccuPyramid& accuPyramid) const;
+
+    /// Compute the final atlas texture from its accumulation pyramid and write it
+    void finalizeTexture(AccuPyramid& accuPyramid, std::size_t atlasID, const bfs::path& outPath,
+                         imageIO::EImageFileType textureFileType);
 
     ///Fill holes and write texture files for the given texture atlas
     void writeTexture(AccuImage& atlasTexture, const std::size_t atlasID, const bfs::path& outPath,
@@ -194,5 +246,56 @@ public:
     void saveAsOBJ(const bfs::path& dir, const std::string& basename, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 };
 
+/**
+ * @brief Keep the atlas accumulation pyramids in memory within a budget.
+ *
+ * When the budget is exceeded, the resident pyramid whose next contribution
+ * comes from the farthest camera is spilled to disk and reloaded when needed.
+ */
+class AccuPyramidsCache
+{
+public:
+    /**
+     * @param[in] camerasPerAtlas the ordered cameras contributing to each atlas
+     * @param[in] maxNbInMemory the maximum number of resident pyramids
+     * @param[in] nbBand the number of levels of each pyramid
+     * @param[in] textureSide the size of the atlas textures
+     * @param[in] spillFolder the folder of the spilled pyramids
+     */
+    AccuPyramidsCache(const std::vector<std::vector<int>>& camerasPerAtlas, std::size_t maxNbInMemory,
+                      int nbBand, int textureSide, const bfs::path& spillFolder);
+
+    ~AccuPyramidsCache();
+
+    /// Get the accumulation pyramid of an atlas, loaded or initialized if needed
+    Texturing::AccuPyramid& get(std::size_t atlasID);
+
+    /**
+     * @brief Mark the contributions of the next cameras to an atlas as done
+     * @return true if they were the last contributions to this atlas
+     */
+    bool setContributionsDone(std::size_t atlasID, std::size_t nbCameras);
+
+    /// Release the accumulation pyramid of an atlas
+    void release(std::size_t atlasID);
+
+    std::size_t getNbSpills() const { return _nbSpills; }
+
+private:
+    bfs::path getSpillPath(std::size_t atlasID) const;
+    int getNextCamera(std::size_t atlasID) const;
+    void spillFarthest();
+
+    const std::vector<std::vector<int>>& _camerasPerAtlas;
+    std::vector<std::size_t> _nextCameraIndex;
+    std::map<std::size_t, Texturing::AccuPyramid> _inMemory;
+    std::set<std::size_t> _spilled;
+    std::size_t _maxNbInMemory;
+    int _nbBand;
+    int _textureSide;
+    bfs::path _spillFolder;
+    std::size_t _nbSpills = 0;
+};
+
 } // namespace mesh
 } // namespace aliceVision
@@ -0,0 +1,629 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "meshDecimation.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace {
+
+/**
+ * @brief Symmetric 4x4 matrix of the sum of the squared distances to a set of planes.
+ */
+struct Quadric
+{
+    // a2, ab, ac, ad, b2, bc, bd, c2, cd, d2
+    double q[10] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    void addPlane(const Point3d& n, double d)
+    {
+        q[0] += n.x * n.x; q[1] += n.x * n.y; q[2] += n.x * n.z; q[3] += n.x * d;
+        q[4] += n.y * n.y; q[5] += n.y * n.z; q[6] += n.y * d;
+        q[7] += n.z * n.z; q[8] += n.z * d;
+        q[9] += d * d;
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for(int i = 0; i < 10; ++i)
+            q[i] += other.q[i];
+        return *this;
+    }
+
+    /// squared distance of the point p to the planes
+    double evaluate(const Point3d& p) const
+    {
+        return q[0] * p.x * p.x + 2.0 * q[1] * p.x * p.y + 2.0 * q[2] * p.x * p.z + 2.0 * q[3] * p.x
+             + q[4] * p.y * p.y + 2.0 * q[5] * p.y * p.z + 2.0 * q[6] * p.y
+             + q[7] * p.z * p.z + 2.0 * q[8] * p.z
+             + q[9];
+    }
+};
+
+/**
+ * @brief Collapse of the point "from" onto the point "to".
+ */
+struct Collapse
+{
+    double cost;
+    int from;
+    int to;
+    int fromVersion;
+    int toVersion;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+/**
+ * @brief Serial quadric error decimation of a cluster of triangles.
+ * Only the unlocked points are collapsed, and all the triangles of an unlocked point are in the cluster,
+ * so clusters can be decimated concurrently on the same mesh.
+ */
+class ClusterDecimater
+{
+public:
+    /// weight of the border constraint quadrics relative to the triangle quadrics
+    static constexpr double borderWeight = 1000.0;
+
+    ClusterDecimater(Mesh& mesh, const std::vector<char>& lockedPts, std::vector<int>& localIds)
+        : _mesh(mesh)
+        , _lockedPts(lockedPts)
+        , _localIds(localIds)
+        , _withVisibilities(mesh.pointsVisibilities.size() == mesh.pts.size())
+    {}
+
+    /**
+     * @brief Decimate the cluster.
+     * @param[in] clusterPts the global ids of the points of the cluster
+     * @param[in] clusterTris the global ids of the triangles of the cluster
+     * @param[in] nbPointsToRemove the number of points to remove
+     * @return the number of removed points
+     */
+    int decimate(const std::vector<int>& clusterPts, const std::vector<int>& clusterTris, int nbPointsToRemove)
+    {
+        const int nbLocalPts = clusterPts.size();
+        _clusterPts = &clusterPts;
+        for(int i = 0; i < nbLocalPts; ++i)
+            _localIds[clusterPts[i]] = i;
+
+        _ptTris.assign(nbLocalPts, std::vector<int>());
+        _quadrics.assign(nbLocalPts, Quadric());
+        _removed.assign(nbLocalPts, 0);
+        _versions.assign(nbLocalPts, 0);
+        _boundary.assign(nbLocalPts, 0);
+        _queue = std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>();
+
+        for(const int triId : clusterTris)
+        {
+            const Mesh::triangle& t = _mesh.tris[triId];
+            for(int k = 0; k < 3; ++k)
+                _ptTris[_localIds[t.v[k]]].push_back(triId);
+
+            // plane quadric of the triangle
+            const Point3d& a = _mesh.pts[t.v[0]];
+            const Point3d n = cross(_mesh.pts[t.v[1]] - a, _mesh.pts[t.v[2]] - a);
+            const double area2 = n.size();
+            if(area2 <= std::numeric_limits<double>::min())
+                continue;
+            const Point3d un = n / area2;
+            Quadric quadric;
+            quadric.addPlane(un, -dot(un, a));
+            for(int k = 0; k < 3; ++k)
+                _quadrics[_localIds[t.v[k]]] += quadric;
+        }
+
+        // border points: a neighbor seen in a single triangle defines a border edge
+        std::vector<int> neighbors;
+        for(int i = 0; i < nbLocalPts; ++i)
+        {
+            if(isLocked(i))
+                continue;
+            getNeighborsWithDuplicates(i, neighbors);
+            std::sort(neighbors.begin(), neighbors.end());
+            for(std::size_t n = 0; n < neighbors.size(); ++n)
+            {
+                const bool single = (n == 0 || neighbors[n - 1] != neighbors[n]) &&
+                                    (n + 1 == neighbors.size() || neighbors[n + 1] != neighbors[n]);
+                if(single)
+                {
+                    _boundary[i] = 1;
+                    addBorderQuadric(i, neighbors[n]);
+                }
+            }
+        }
+
+        for(int i = 0; i < nbLocalPts; ++i)
+            pushCollapses(i);
+
+        int nbRemoved = 0;
+        while(nbRemoved < nbPointsToRemove && !_queue.empty())
+        {
+            const Collapse collapse = _queue.top();
+            _queue.pop();
+
+            if(_removed[collapse.from] || _removed[collapse.to] ||
+               _versions[collapse.from] != collapse.fromVersion || _versions[collapse.to] != collapse.toVersion)
+                continue;
+
+            if(!isCollapseValid(collapse.from, collapse.to))
+                continue;
+
+            applyCollapse(collapse.from, collapse.to);
+            ++nbRemoved;
+            pushCollapses(collapse.to);
+        }
+        return nbRemoved;
+    }
+
+private:
+
+    bool isLocked(int localId) const { return _lockedPts[(*_clusterPts)[localId]] != 0; }
+
+    /// other points of the alive triangles of the point (with duplicates)
+    void getNeighborsWithDuplicates(int localId, std::vector<int>& neighbors) const
+    {
+        neighbors.clear();
+        const int ptId = (*_clusterPts)[localId];
+        for(const int triId : _ptTris[localId])
+        {
+            const Mesh::triangle& t = _mesh.tris[triId];
+            if(!t.alive)
+                continue;
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t.v[k] != ptId)
+                    neighbors.push_back(_localIds[t.v[k]]);
+            }
+        }
+    }
+
+    void getNeighbors(int localId, std::vector<int>& neighbors) const
+    {
+        getNeighborsWithDuplicates(localId, neighbors);
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    }
+
+    /**
+     * @brief Add to the point the quadric of the plane orthogonal to its triangle through the border edge,
+     * weighted by the squared length of the edge, to preserve the shape of the border.
+     */
+    void addBorderQuadric(int localId, int neighbor)
+    {
+        const int ptId = (*_clusterPts)[localId];
+        const int neighborPtId = (*_clusterPts)[neighbor];
+        for(const int triId : _ptTris[localId])
+        {
+            const Mesh::triangle& t = _mesh.tris[triId];
+            if(t.v[0] != neighborPtId && t.v[1] != neighborPtId && t.v[2] != neighborPtId)
+                continue;
+
+            const Point3d& a = _mesh.pts[t.v[0]];
+            const Point3d edge = _mesh.pts[neighborPtId] - _mesh.pts[ptId];
+            const Point3d n = cross(edge, cross(_mesh.pts[t.v[1]] - a, _mesh.pts[t.v[2]] - a));
+            const double norm = n.size();
+            if(norm <= std::numeric_limits<double>::min())
+                return;
+            const Point3d un = n / norm;
+            const double weight = dot(edge, edge) * borderWeight;
+            Quadric quadric;
+            quadric.addPlane(un * std::sqrt(weight), -dot(un, _mesh.pts[ptId]) * std::sqrt(weight));
+            _quadrics[localId] += quadric;
+            return;
+        }
+    }
+
+    /// push the best collapse of each edge of the point
+    void pushCollapses(int localId)
+    {
+        if(_removed[localId] || isLocked(localId))
+            return;
+
+        getNeighbors(localId, _neighborsA);
+        for(const int neighbor : _neighborsA)
+        {
+            if(_removed[neighbor] || isLocked(neighbor))
+                continue;
+
+            Quadric quadric = _quadrics[localId];
+            quadric += _quadrics[neighbor];
+            const double costToNeighbor = quadric.evaluate(_mesh.pts[(*_clusterPts)[neighbor]]);
+            const double costFromNeighbor = quadric.evaluate(_mesh.pts[(*_clusterPts)[localId]]);
+
+            if(costToNeighbor <= costFromNeighbor)
+                _queue.push({costToNeighbor, localId, neighbor, _versions[localId], _versions[neighbor]});
+            else
+                _queue.push({costFromNeighbor, neighbor, localId, _versions[neighbor], _versions[localId]});
+        }
+    }
+
+    bool isCollapseValid(int from, int to)
+    {
+        const int fromPtId = (*_clusterPts)[from];
+        const int toPtId = (*_clusterPts)[to];
+
+        // opposite points of the triangles of the edge
+        int nbEdgeTris = 0;
+        int opposites[2];
+        for(const int triId : _ptTris[from])
+        {
+            const Mesh::triangle& t = _mesh.tris[triId];
+            if(!t.alive || (t.v[0] != toPtId && t.v[1] != toPtId && t.v[2] != toPtId))
+                continue;
+            if(nbEdgeTris == 2)
+                return false; // non-manifold edge
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t.v[k] != fromPtId && t.v[k] != toPtId)
+                    opposites[nbEdgeTris] = _localIds[t.v[k]];
+            }
+            ++nbEdgeTris;
+        }
+        if(nbEdgeTris == 0)
+            return false;
+
+        // do not shrink the borders of the mesh
+        if(_boundary[from] && !(_boundary[to] && nbEdgeTris == 1))
+            return false;
+
+        // link condition: the common neighbors are the opposite points of the edge
+        getNeighbors(from, _neighborsA);
+        getNeighbors(to, _neighborsB);
+        _commonNeighbors.clear();
+        std::set_intersection(_neighborsA.begin(), _neighborsA.end(), _neighborsB.begin(), _neighborsB.end(),
+                              std::back_inserter(_commonNeighbors));
+        if(static_cast<int>(_commonNeighbors.size()) != nbEdgeTris)
+            return false;
+        for(int i = 0; i < nbEdgeTris; ++i)
+        {
+            if(std::find(_commonNeighbors.begin(), _commonNeighbors.end(), opposites[i]) == _commonNeighbors.end())
+                return false;
+        }
+
+        // no fold of the triangles moved with the point
+        const Point3d& toPt = _mesh.pts[toPtId];
+        for(const int triId : _ptTris[from])
+        {
+            const Mesh::triangle& t = _mesh.tris[triId];
+            if(!t.alive || t.v[0] == toPtId || t.v[1] == toPtId || t.v[2] == toPtId)
+                continue;
+
+            Point3d before[3];
+            Point3d after[3];
+            for(int k = 0; k < 3; ++k)
+            {
+                before[k] = _mesh.pts[t.v[k]];
+                after[k] = (t.v[k] == fromPtId) ? toPt : before[k];
+            }
+            const Point3d normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+            const Point3d normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+            if(dot(normalBefore, normalAfter) <= 0.0)
+                return false;
+        }
+        return true;
+    }
+
+    void applyCollapse(int from, int to)
+    {
+        const int fromPtId = (*_clusterPts)[from];
+        const int toPtId = (*_clusterPts)[to];
+
+        std::vector<int>& toTris = _ptTris[to];
+        toTris.erase(std::remove_if(toTris.begin(), toTris.end(), [&](int triId) { return !_mesh.tris[triId].alive; }), toTris.end());
+
+        for(const int triId : _ptTris[from])
+        {
+            Mesh::triangle& t = _mesh.tris[triId];
+            if(!t.alive)
+                continue;
+            if(t.v[0] == toPtId || t.v[1] == toPtId || t.v[2] == toPtId)
+            {
+                // triangles of the collapsed edge
+                t.alive = false;
+                continue;
+            }
+            for(int k = 0; k < 3; ++k)
+            {
+                if(t.v[k] == fromPtId)
+                    t.v[k] = toPtId;
+            }
+            toTris.push_back(triId);
+        }
+        toTris.erase(std::remove_if(toTris.begin(), toTris.end(), [&](int triId) { return !_mesh.tris[triId].alive; }), toTris.end());
+
+        _quadrics[to] += _quadrics[from];
+        _removed[from] = 1;
+        _ptTris[from].clear();
+        _ptTris[from].shrink_to_fit();
+        ++_versions[to];
+
+        if(_withVisibilities)
+        {
+            // union of the sorted visibilities
+            PointVisibility& toVisibility = _mesh.pointsVisibilities[toPtId];
+            PointVisibility& fromVisibility = _mesh.pointsVisibilities[fromPtId];
+            std::vector<int>& toCams = toVisibility.getDataWritable();
+            std::vector<int>& fromCams = fromVisibility.getDataWritable();
+            std::sort(toCams.begin(), toCams.end());
+            std::sort(fromCams.begin(), fromCams.end());
+            std::vector<int> cams;
+            cams.reserve(toCams.size() + fromCams.size());
+            std::set_union(toCams.begin(), toCams.end(), fromCams.begin(), fromCams.end(), std::back_inserter(cams));
+            toCams.swap(cams);
+            fromVisibility = PointVisibility();
+        }
+    }
+
+    Mesh& _mesh;
+    const std::vector<char>& _lockedPts;
+    /// local id in the current cluster of each point of the mesh
+    std::vector<int>& _localIds;
+    const bool _withVisibilities;
+
+    const std::vector<int>* _clusterPts = nullptr;
+    std::vector<std::vector<int>> _ptTris;
+    std::vector<Quadric> _quadrics;
+    std::vector<char> _removed;
+    std::vector<int> _versions;
+    std::vector<char> _boundary;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> _queue;
+    std::vector<int> _neighborsA;
+    std::vector<int> _neighborsB;
+    std::vector<int> _commonNeighbors;
+};
+
+/**
+ * @brief Remove the dead triangles and the points without triangle.
+ */
+void compactMesh(Mesh& mesh)
+{
+    const int nbPts = mesh.pts.size();
+    std::vector<int> newPtIds(nbPts, -1);
+    for(const Mesh::triangle& t : mesh.tris)
+    {
+        if(!t.alive)
+            continue;
+        for(int k = 0; k < 3; ++k)
+            newPtIds[t.v[k]] = 0;
+    }
+
+    int nbNewPts = 0;
+    for(int& newPtId : newPtIds)
+    {
+        if(newPtId == 0)
+            newPtId = nbNewPts++;
+    }
+
+    const bool withColors = (static_cast<int>(mesh.colors().size()) == nbPts);
+    const bool withVisibilities = (mesh.pointsVisibilities.size() == nbPts);
+
+    StaticVector<Point3d> pts;
+    pts.resize(nbNewPts);
+    std::vector<rgb> colors(withColors ? nbNewPts : 0);
+    PointsVisibility pointsVisibilities;
+    if(withVisibilities)
+        pointsVisibilities.resize(nbNewPts);
+
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const int newPtId = newPtIds[i];
+        if(newPtId < 0)
+            continue;
+        pts[newPtId] = mesh.pts[i];
+        if(withColors)
+            colors[newPtId] = mesh.colors()[i];
+        if(withVisibilities)
+            pointsVisibilities[newPtId].swap(mesh.pointsVisibilities[i]);
+    }
+
+    StaticVector<Mesh::triangle> tris;
+    tris.reserve(mesh.tris.size());
+    for(const Mesh::triangle& t : mesh.tris)
+    {
+        if(t.alive)
+            tris.push_back(Mesh::triangle(newPtIds[t.v[0]], newPtIds[t.v[1]], newPtIds[t.v[2]]));
+    }
+
+    mesh.pts.swap(pts);
+    mesh.tris.swap(tris);
+    mesh.colors().swap(colors);
+    mesh.pointsVisibilities.swap(pointsVisibilities);
+    mesh.uvCoords = StaticVector<Point2d>();
+    mesh.trisUvIds = StaticVector<Voxel>();
+    mesh.normals = StaticVector<Point3d>();
+    mesh.trisNormalsIds = StaticVector<Voxel>();
+    mesh.trisMtlIds().clear();
+    mesh.nmtls = 0;
+    mesh.invalidateTopology();
+}
+
+} // namespace
+
+int decimateMesh(Mesh& mesh, const DecimationParams& params)
+{
+    const int nbPts = mesh.pts.size();
+    const int nbTris = mesh.tris.size();
+    if(nbPts == 0 || nbTris == 0)
+        return 0;
+
+    // number of points used by the triangles
+    int nbUsedPts = 0;
+    {
+        std::vector<char> usedPts(nbPts, 0);
+        for(const Mesh::triangle& t : mesh.tris)
+        {
+            if(t.alive)
+                usedPts[t.v[0]] = usedPts[t.v[1]] = usedPts[t.v[2]] = 1;
+        }
+        nbUsedPts = std::count(usedPts.begin(), usedPts.end(), 1);
+    }
+
+    // bounding box and size of the partition cells
+    Point3d bboxMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bboxMax(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+    for(const Point3d& p : mesh.pts)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            bboxMin.m[k] = std::min(bboxMin.m[k], p.m[k]);
+            bboxMax.m[k] = std::max(bboxMax.m[k], p.m[k]);
+        }
+    }
+    const Point3d extent = bboxMax - bboxMin;
+    const double minExtent = std::max(std::max(extent.x, std::max(extent.y, extent.z)) * 1e-3, std::numeric_limits<double>::min());
+    const int nbClusters = std::max(2 * omp_get_max_threads(), nbTris / std::max(1, params.clusterSize));
+    const double cellSize = std::cbrt(std::max(extent.x, minExtent) * std::max(extent.y, minExtent) * std::max(extent.z, minExtent) / nbClusters);
+    int nbCells[3];
+    for(int k = 0; k < 3; ++k)
+        nbCells[k] = static_cast<int>(extent.m[k] / cellSize) + 2;
+
+    ALICEVISION_LOG_INFO("Decimate mesh from " << nbUsedPts << " to " << params.nbTargetPoints << " points, with " << nbClusters << " clusters.");
+
+    std::vector<int> ptsCluster(nbPts);
+    std::vector<char> lockedPts(nbPts);
+    std::vector<int> localIds(nbPts, -1);
+
+    int nbTotalRemoved = 0;
+    for(int pass = 0; pass < params.maxNbPasses && nbUsedPts - nbTotalRemoved > params.nbTargetPoints; ++pass)
+    {
+        // shift the partition by half a cell at each pass
+        const double offset = (pass % 2) * 0.5 * cellSize + (pass / 2) * 0.25 * cellSize;
+
+        #pragma omp parallel for
+        for(int i = 0; i < nbPts; ++i)
+        {
+            int cell[3];
+            for(int k = 0; k < 3; ++k)
+                cell[k] = std::min(nbCells[k] - 1, std::max(0, static_cast<int>((mesh.pts[i].m[k] - bboxMin.m[k] + offset) / cellSize)));
+            ptsCluster[i] = (cell[0] * nbCells[1] + cell[1]) * nbCells[2] + cell[2];
+        }
+
+        // triangles of a single cluster, the points of the other triangles are locked
+        std::fill(lockedPts.begin(), lockedPts.end(), 0);
+        std::vector<int> trisCluster(nbTris, -1);
+
+        #pragma omp parallel for
+        for(int triId = 0; triId < nbTris; ++triId)
+        {
+            const Mesh::triangle& t = mesh.tris[triId];
+            if(!t.alive)
+                continue;
+            const int cluster = ptsCluster[t.v[0]];
+            if(ptsCluster[t.v[1]] == cluster && ptsCluster[t.v[2]] == cluster)
+            {
+                trisCluster[triId] = cluster;
+                continue;
+            }
+            for(int k = 0; k < 3; ++k)
+            {
+                #pragma omp atomic write
+                lockedPts[t.v[k]] = 1;
+            }
+        }
+
+        // gather the points and the triangles of each non-empty cluster
+        std::vector<std::vector<int>> clustersTris;
+        std::vector<std::vector<int>> clustersPts;
+        {
+            std::vector<int> clusterIds(nbCells[0] * nbCells[1] * nbCells[2], -1);
+            for(int triId = 0; triId < nbTris; ++triId)
+            {
+                const int cell = trisCluster[triId];
+                if(cell < 0)
+                    continue;
+                if(clusterIds[cell] < 0)
+                {
+                    clusterIds[cell] = clustersTris.size();
+                    clustersTris.emplace_back();
+                    clustersPts.emplace_back();
+                }
+                clustersTris[clusterIds[cell]].push_back(triId);
+            }
+        }
+
+        const int nbClustersUsed = clustersTris.size();
+
+        // points of the triangles of each cluster
+        #pragma omp parallel for schedule(dynamic)
+        for(int c = 0; c < nbClustersUsed; ++c)
+        {
+            std::vector<int>& clusterPts = clustersPts[c];
+            clusterPts.reserve(clustersTris[c].size() * 3);
+            for(const int triId : clustersTris[c])
+                clusterPts.insert(clusterPts.end(), mesh.tris[triId].v, mesh.tris[triId].v + 3);
+            std::sort(clusterPts.begin(), clusterPts.end());
+            clusterPts.erase(std::unique(clusterPts.begin(), clusterPts.end()), clusterPts.end());
+        }
+
+        // distribute the points to remove according to the number of unlocked points of the clusters
+        std::vector<int> clustersNbUnlocked(nbClustersUsed, 0);
+        long long nbUnlocked = 0;
+        for(int c = 0; c < nbClustersUsed; ++c)
+        {
+            for(const int ptId : clustersPts[c])
+                clustersNbUnlocked[c] += (lockedPts[ptId] == 0);
+            nbUnlocked += clustersNbUnlocked[c];
+        }
+        if(nbUnlocked == 0)
+            break;
+
+        // floor of the proportional share of each cluster, then the remainder one by one,
+        // so that the clusters do not remove more points than needed to reach the target
+        const long long nbToRemove = std::min<long long>(nbUnlocked, nbUsedPts - nbTotalRemoved - params.nbTargetPoints);
+        std::vector<int> clustersNbToRemove(nbClustersUsed);
+        long long nbDistributed = 0;
+        for(int c = 0; c < nbClustersUsed; ++c)
+        {
+            clustersNbToRemove[c] = static_cast<int>(nbToRemove * clustersNbUnlocked[c] / nbUnlocked);
+            nbDistributed += clustersNbToRemove[c];
+        }
+        for(int c = 0; c < nbClustersUsed && nbDistributed < nbToRemove; ++c)
+        {
+            if(clustersNbToRemove[c] < clustersNbUnlocked[c])
+            {
+                ++clustersNbToRemove[c];
+                ++nbDistributed;
+            }
+        }
+
+        int nbRemovedInPass = 0;
+
+        #pragma omp parallel
+        {
+            ClusterDecimater decimater(mesh, lockedPts, localIds);
+
+            #pragma omp for schedule(dynamic) reduction(+:nbRemovedInPass)
+            for(int c = 0; c < nbClustersUsed; ++c)
+            {
+                if(clustersNbToRemove[c] > 0)
+                    nbRemovedInPass += decimater.decimate(clustersPts[c], clustersTris[c], clustersNbToRemove[c]);
+            }
+        }
+
+        nbTotalRemoved += nbRemovedInPass;
+        ALICEVISION_LOG_INFO("Decimation pass " << pass << ": " << nbRemovedInPass << " points removed.");
+        if(nbRemovedInPass == 0)
+            break;
+    }
+
+    compactMesh(mesh);
+
+    ALICEVISION_LOG_INFO("Decimated mesh: " << mesh.pts.size() << " points and " << mesh.tris.size() << " triangles.");
+    return nbTotalRemoved;
+}
+
+} // namespace mesh
+} // namespace aliceVision
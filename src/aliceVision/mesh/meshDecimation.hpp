@@ -0,0 +1,45 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Parameters of the quadric error decimation.
+ */
+struct DecimationParams
+{
+    /// target number of points (0 to decimate as much as possible)
+    int nbTargetPoints = 0;
+    /// approximate number of triangles of the spatial clusters decimated concurrently
+    int clusterSize = 500000;
+    /// maximum number of partitioning passes, the partition is shifted at each pass
+    /// to decimate the borders of the clusters of the previous pass
+    int maxNbPasses = 4;
+};
+
+/**
+ * @brief Decimate the mesh with quadric error edge collapses (Garland & Heckbert).
+ *
+ * The mesh is partitioned into spatial clusters decimated in parallel: the points
+ * of the triangles shared by several clusters are locked. Each point is collapsed onto
+ * one of its neighbors (no new position is created) and its visibilities are merged
+ * into the remaining point, so the result can be used for texturing.
+ * Collapses creating non-manifold configurations, folds or shrinking the mesh borders are rejected.
+ * The uv coordinates, normals and materials are discarded.
+ *
+ * @param[in,out] mesh the mesh to decimate
+ * @param[in] params the decimation parameters
+ * @return the number of removed points
+ */
+int decimateMesh(Mesh& mesh, const DecimationParams& params);
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/meshDecimation.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#define BOOST_TEST_MODULE meshDecimation
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+/// Generate a wavy grid of nbSide x nbSide vertices, each vertex is seen by the camera of its row
+void generateMesh(Mesh& mesh, int nbSide)
+{
+    for(int j = 0; j < nbSide; ++j)
+    {
+        for(int i = 0; i < nbSide; ++i)
+        {
+            mesh.pts.push_back(Point3d(i, j, 2.0 * std::sin(i * 0.2) * std::cos(j * 0.15)));
+            PointVisibility visibility;
+            visibility.push_back(j);
+            mesh.pointsVisibilities.push_back(visibility);
+        }
+    }
+    for(int j = 0; j + 1 < nbSide; ++j)
+    {
+        for(int i = 0; i + 1 < nbSide; ++i)
+        {
+            const int v = j * nbSide + i;
+            mesh.tris.push_back(Mesh::triangle(v, v + 1, v + nbSide));
+            mesh.tris.push_back(Mesh::triangle(v + 1, v + nbSide + 1, v + nbSide));
+        }
+    }
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Decimate a wavy grid to a quarter of its points
+// - Assert that the target is approached, the triangles are valid and manifold,
+//   the borders are kept and each point keeps visibilities
+//-----------------
+BOOST_AUTO_TEST_CASE(meshDecimation_grid)
+{
+    const int nbSide = 60;
+    Mesh mesh;
+    generateMesh(mesh, nbSide);
+    const int nbInputPts = mesh.pts.size();
+
+    DecimationParams params;
+    params.nbTargetPoints = nbInputPts / 4;
+    params.clusterSize = 1000;
+    const int nbRemoved = decimateMesh(mesh, params);
+
+    BOOST_CHECK_EQUAL(mesh.pts.size(), nbInputPts - nbRemoved);
+    BOOST_CHECK_LT(mesh.pts.size(), nbInputPts / 2);
+    BOOST_CHECK_GE(mesh.pts.size(), params.nbTargetPoints);
+    BOOST_REQUIRE_EQUAL(mesh.pointsVisibilities.size(), mesh.pts.size());
+
+    // valid, non degenerated triangles and manifold edges
+    std::map<std::pair<int, int>, int> edgesNbTris;
+    std::vector<char> usedPts(mesh.pts.size(), 0);
+    for(int t = 0; t < mesh.tris.size(); ++t)
+    {
+        const Mesh::triangle& tri = mesh.tris[t];
+        for(int k = 0; k < 3; ++k)
+        {
+            BOOST_REQUIRE(tri.v[k] >= 0 && tri.v[k] < mesh.pts.size());
+            usedPts[tri.v[k]] = 1;
+            const int a = tri.v[k];
+            const int b = tri.v[(k + 1) % 3];
+            BOOST_CHECK_NE(a, b);
+            ++edgesNbTris[std::make_pair(std::min(a, b), std::max(a, b))];
+        }
+    }
+    for(const auto& edge : edgesNbTris)
+        BOOST_CHECK_LE(edge.second, 2);
+    BOOST_CHECK(std::all_of(usedPts.begin(), usedPts.end(), [](char used) { return used != 0; }));
+
+    // the border constraints keep the extent of the grid
+    double minX = std::numeric_limits<double>::max(), maxX = std::numeric_limits<double>::lowest();
+    double minY = std::numeric_limits<double>::max(), maxY = std::numeric_limits<double>::lowest();
+    for(const Point3d& p : mesh.pts)
+    {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+    BOOST_CHECK_EQUAL(minX, 0.0);
+    BOOST_CHECK_EQUAL(maxX, nbSide - 1.0);
+    BOOST_CHECK_EQUAL(minY, 0.0);
+    BOOST_CHECK_EQUAL(maxY, nbSide - 1.0);
+
+    // the visibilities of the removed points are merged into the kept ones
+    int nbVisibilities = 0;
+    for(int i = 0; i < mesh.pointsVisibilities.size(); ++i)
+    {
+        BOOST_CHECK_GT(mesh.pointsVisibilities[i].size(), 0);
+        nbVisibilities += mesh.pointsVisibilities[i].size();
+    }
+    BOOST_CHECK_GT(nbVisibilities, mesh.pts.size());
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Decimate an empty mesh and a mesh already below the target
+// - Assert that nothing is removed
+//-----------------
+BOOST_AUTO_TEST_CASE(meshDecimation_nothingToRemove)
+{
+    Mesh emptyMesh;
+    DecimationParams params;
+    BOOST_CHECK_EQUAL(decimateMesh(emptyMesh, params), 0);
+
+    Mesh mesh;
+    generateMesh(mesh, 10);
+    const int nbInputPts = mesh.pts.size();
+    const int nbInputTris = mesh.tris.size();
+    params.nbTargetPoints = nbInputPts;
+    BOOST_CHECK_EQUAL(decimateMesh(mesh, params), 0);
+    BOOST_CHECK_EQUAL(mesh.pts.size(), nbInputPts);
+    BOOST_CHECK_EQUAL(mesh.tris.size(), nbInputTris);
+}
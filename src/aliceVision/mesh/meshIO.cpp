@@ -0,0 +1,1244 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2017 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Mesh.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace mesh {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+static_assert(sizeof(Point3d) == 3 * sizeof(double), "Point3d is expected to be tightly packed");
+static_assert(sizeof(Point2d) == 2 * sizeof(double), "Point2d is expected to be tightly packed");
+static_assert(sizeof(Voxel) == 3 * sizeof(int), "Voxel is expected to be tightly packed");
+static_assert(sizeof(rgb) == 3, "rgb is expected to be tightly packed");
+
+/**
+ * @brief Read a whole file in memory, followed by a null character.
+ * @param[in] filepath the file to read
+ * @param[out] buffer the file content
+ * @return false if the file cannot be read
+ */
+bool readFile(const std::string& filepath, std::vector<char>& buffer)
+{
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if(!file)
+        return false;
+
+    const std::streamsize size = file.tellg();
+    file.seekg(0);
+    buffer.resize(static_cast<std::size_t>(size) + 1);
+    if(size > 0 && !file.read(buffer.data(), size))
+        return false;
+    buffer[size] = '\0';
+    return true;
+}
+
+/**
+ * @brief Split a text buffer into chunks of whole lines.
+ * @param[in] begin the beginning of the buffer
+ * @param[in] end the end of the buffer
+ * @param[in] nbChunks the expected number of chunks
+ * @return the [begin, end) range of each chunk
+ */
+std::vector<std::pair<const char*, const char*>> splitLines(const char* begin, const char* end, std::size_t nbChunks)
+{
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const std::ptrdiff_t chunkSize = std::max<std::ptrdiff_t>(1, (end - begin) / std::max<std::size_t>(1, nbChunks));
+
+    const char* chunkBegin = begin;
+    while(chunkBegin < end)
+    {
+        const char* chunkEnd = (end - chunkBegin > chunkSize) ? chunkBegin + chunkSize : end;
+        chunkEnd = std::find(chunkEnd, end, '\n');
+        if(chunkEnd != end)
+            ++chunkEnd;
+        chunks.emplace_back(chunkBegin, chunkEnd);
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isEndOfLine(char c)
+{
+    return c == '\n' || c == '\r' || c == '\0';
+}
+
+inline const char* skipBlanks(const char* p)
+{
+    while(isBlank(*p))
+        ++p;
+    return p;
+}
+
+/// Parse a floating point value of the current line
+inline bool parseDouble(const char*& p, double& value)
+{
+    p = skipBlanks(p);
+    if(isEndOfLine(*p))
+        return false;
+    char* valueEnd;
+    value = std::strtod(p, &valueEnd);
+    if(valueEnd == p)
+        return false;
+    p = valueEnd;
+    return true;
+}
+
+/// Parse an integer value of the current line
+inline bool parseInt(const char*& p, int& value)
+{
+    const bool negative = (*p == '-');
+    if(negative)
+        ++p;
+    if(*p < '0' || *p > '9')
+        return false;
+    value = 0;
+    while(*p >= '0' && *p <= '9')
+        value = value * 10 + (*p++ - '0');
+    if(negative)
+        value = -value;
+    return true;
+}
+
+/// 1-based indices of a vertex of an OBJ face (0 if undefined), negative indices are relative to the end
+struct ObjFaceVertex
+{
+    int v = 0;
+    int vt = 0;
+    int vn = 0;
+};
+
+/// Parse a "v", "v/vt", "v/vt/vn" or "v//vn" face vertex
+inline bool parseObjFaceVertex(const char*& p, ObjFaceVertex& faceVertex)
+{
+    p = skipBlanks(p);
+    if(isEndOfLine(*p))
+        return false;
+
+    faceVertex = ObjFaceVertex();
+    if(!parseInt(p, faceVertex.v) || faceVertex.v == 0)
+        throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file.");
+    if(*p == '/')
+    {
+        ++p;
+        if(*p != '/' && (!parseInt(p, faceVertex.vt) || faceVertex.vt == 0))
+            throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file.");
+        if(*p == '/')
+        {
+            ++p;
+            if(!parseInt(p, faceVertex.vn) || faceVertex.vn == 0)
+                throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file.");
+        }
+    }
+
+    while(!isBlank(*p) && !isEndOfLine(*p))
+        ++p;
+    return true;
+}
+
+/**
+ * @brief Data of a chunk of lines of an OBJ file.
+ * Absolute indices are global. Relative (negative) indices are converted to indices from the start of the chunk,
+ * and their positions (3 * triangle id + vertex) are kept to add the offset of the chunk when the chunks are merged.
+ */
+struct ObjChunk
+{
+    std::vector<Point3d> pts;
+    std::vector<rgb> colors;
+    std::vector<Point3d> normals;
+    std::vector<Point2d> uvCoords;
+    std::vector<Mesh::triangle> tris;
+    std::vector<Voxel> trisUvIds;
+    std::vector<Voxel> trisNormalsIds;
+    /// material of each triangle, as an index in materials (-1 for the material of the previous chunks)
+    std::vector<int> trisMtlIds;
+    /// names of the materials used in the chunk, in order
+    std::vector<std::string> materials;
+    /// positions of the relative indices in tris, trisUvIds and trisNormalsIds
+    std::vector<std::size_t> relativePtIds;
+    std::vector<std::size_t> relativeUvIds;
+    std::vector<std::size_t> relativeNormalIds;
+};
+
+/**
+ * @brief Convert a 1-based OBJ index of the face vertex k of a new triangle to a 0-based index.
+ * @param[in] nbDefined number of elements defined before in the chunk, the reference of the relative indices
+ * @param[in] position position of the index (3 * triangle id + k), recorded in relativeIds if it is relative
+ */
+inline int toObjChunkIndex(int objIndex, std::size_t nbDefined, std::size_t position, std::vector<std::size_t>& relativeIds)
+{
+    if(objIndex > 0)
+        return objIndex - 1;
+    relativeIds.push_back(position);
+    return static_cast<int>(nbDefined) + objIndex;
+}
+
+inline int& faceIndex(Mesh::triangle& t, int k) { return t.v[k]; }
+inline int& faceIndex(Voxel& ids, int k) { return ids.m[k]; }
+
+/// Add the offset of a chunk to its relative indices
+template<typename T>
+void resolveObjChunkIndices(StaticVector<T>& out, std::size_t first, int offset, const std::vector<std::size_t>& relativeIds)
+{
+    for(const std::size_t position : relativeIds)
+        faceIndex(out[first + position / 3], position % 3) += offset;
+}
+
+void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    std::vector<ObjFaceVertex> faceVertices;
+    int mtlId = -1;
+
+    const char* line = begin;
+    while(line < end)
+    {
+        const char* lineEnd = std::find(line, end, '\n');
+        const char* p = skipBlanks(line);
+
+        if(p[0] == 'v' && isBlank(p[1]))
+        {
+            p += 1;
+            Point3d pt;
+            if(!parseDouble(p, pt.x) || !parseDouble(p, pt.y) || !parseDouble(p, pt.z))
+                throw std::runtime_error("Mesh: Invalid vertex while reading obj file.");
+            chunk.pts.push_back(pt);
+
+            // optional vertex color
+            double r, g, b;
+            if(parseDouble(p, r) && parseDouble(p, g) && parseDouble(p, b))
+            {
+                // convert float color data to uchar
+                chunk.colors.emplace_back(
+                  static_cast<unsigned char>(r*255.0f),
+                  static_cast<unsigned char>(g*255.0f),
+                  static_cast<unsigned char>(b*255.0f)
+                );
+            }
+        }
+        else if(p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+        {
+            p += 2;
+            Point3d pt;
+            if(!parseDouble(p, pt.x) || !parseDouble(p, pt.y) || !parseDouble(p, pt.z))
+                throw std::runtime_error("Mesh: Invalid normal while reading obj file.");
+            chunk.normals.push_back(pt);
+        }
+        else if(p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+        {
+            p += 2;
+            Point2d pt;
+            if(!parseDouble(p, pt.x) || !parseDouble(p, pt.y))
+                throw std::runtime_error("Mesh: Invalid uv coordinates while reading obj file.");
+            chunk.uvCoords.push_back(pt);
+        }
+        else if(p[0] == 'f' && isBlank(p[1]))
+        {
+            p += 1;
+            faceVertices.clear();
+            ObjFaceVertex faceVertex;
+            while(parseObjFaceVertex(p, faceVertex))
+                faceVertices.push_back(faceVertex);
+
+            if(faceVertices.size() < 3)
+                throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file.");
+
+            const bool withUV = (faceVertices.front().vt != 0);
+            const bool withNormal = (faceVertices.front().vn != 0);
+
+            // triangle fan: a quad (0, 1, 2, 3) gives the triangles (0, 1, 2) and (0, 2, 3)
+            for(std::size_t k = 1; k + 1 < faceVertices.size(); ++k)
+            {
+                const ObjFaceVertex& a = faceVertices[0];
+                const ObjFaceVertex& b = faceVertices[k];
+                const ObjFaceVertex& c = faceVertices[k + 1];
+
+                const std::size_t position = 3 * chunk.tris.size();
+                const std::size_t nbPts = chunk.pts.size();
+                chunk.tris.emplace_back(toObjChunkIndex(a.v, nbPts, position, chunk.relativePtIds),
+                                        toObjChunkIndex(b.v, nbPts, position + 1, chunk.relativePtIds),
+                                        toObjChunkIndex(c.v, nbPts, position + 2, chunk.relativePtIds));
+                chunk.trisMtlIds.push_back(mtlId);
+                if(withUV)
+                {
+                    const std::size_t uvPosition = 3 * chunk.trisUvIds.size();
+                    const std::size_t nbUVs = chunk.uvCoords.size();
+                    chunk.trisUvIds.emplace_back(toObjChunkIndex(a.vt, nbUVs, uvPosition, chunk.relativeUvIds),
+                                                 toObjChunkIndex(b.vt, nbUVs, uvPosition + 1, chunk.relativeUvIds),
+                                                 toObjChunkIndex(c.vt, nbUVs, uvPosition + 2, chunk.relativeUvIds));
+                }
+                if(withNormal)
+                {
+                    const std::size_t normalPosition = 3 * chunk.trisNormalsIds.size();
+                    const std::size_t nbNormals = chunk.normals.size();
+                    chunk.trisNormalsIds.emplace_back(toObjChunkIndex(a.vn, nbNormals, normalPosition, chunk.relativeNormalIds),
+                                                      toObjChunkIndex(b.vn, nbNormals, normalPosition + 1, chunk.relativeNormalIds),
+                                                      toObjChunkIndex(c.vn, nbNormals, normalPosition + 2, chunk.relativeNormalIds));
+                }
+            }
+        }
+        else if(std::strncmp(p, "usemtl", 6) == 0 && isBlank(p[6]))
+        {
+            p = skipBlanks(p + 6);
+            const char* nameEnd = p;
+            while(!isBlank(*nameEnd) && !isEndOfLine(*nameEnd))
+                ++nameEnd;
+            chunk.materials.emplace_back(p, nameEnd);
+            mtlId = static_cast<int>(chunk.materials.size()) - 1;
+        }
+
+        line = (lineEnd == end) ? end : lineEnd + 1;
+    }
+}
+
+template<typename T>
+void append(StaticVector<T>& out, const std::vector<T>& in)
+{
+    out.getDataWritable().insert(out.end(), in.begin(), in.end());
+}
+
+/// Types of the PLY properties
+enum class EPlyType
+{
+    INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64
+};
+
+EPlyType EPlyType_stringToEnum(const std::string& type)
+{
+    if(type == "char" || type == "int8")
+        return EPlyType::INT8;
+    if(type == "uchar" || type == "uint8")
+        return EPlyType::UINT8;
+    if(type == "short" || type == "int16")
+        return EPlyType::INT16;
+    if(type == "ushort" || type == "uint16")
+        return EPlyType::UINT16;
+    if(type == "int" || type == "int32")
+        return EPlyType::INT32;
+    if(type == "uint" || type == "uint32")
+        return EPlyType::UINT32;
+    if(type == "float" || type == "float32")
+        return EPlyType::FLOAT32;
+    if(type == "double" || type == "float64")
+        return EPlyType::FLOAT64;
+    throw std::out_of_range("Invalid ply property type " + type);
+}
+
+struct PlyProperty
+{
+    std::string name;
+    EPlyType type;
+    bool isList = false;
+    EPlyType countType = EPlyType::UINT8;
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    int getPropertyIndex(const std::string& propertyName) const
+    {
+        for(std::size_t i = 0; i < properties.size(); ++i)
+        {
+            if(properties[i].name == propertyName)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+};
+
+inline bool isHostLittleEndian()
+{
+    const std::uint16_t value = 1;
+    return *reinterpret_cast<const std::uint8_t*>(&value) == 1;
+}
+
+/**
+ * @brief Read the values of a PLY file body (ascii or binary).
+ */
+class PlyValueReader
+{
+public:
+    PlyValueReader(const char* begin, const char* end, bool ascii, bool swapBytes)
+        : _p(begin)
+        , _end(end)
+        , _ascii(ascii)
+        , _swapBytes(swapBytes)
+    {}
+
+    double read(EPlyType type)
+    {
+        if(_ascii)
+        {
+            char* valueEnd;
+            const double value = std::strtod(_p, &valueEnd);
+            if(valueEnd == _p)
+                throw std::runtime_error("Mesh: Invalid ascii value while reading ply file.");
+            _p = valueEnd;
+            return value;
+        }
+
+        switch(type)
+        {
+            case EPlyType::INT8:    return readBinary<std::int8_t>();
+            case EPlyType::UINT8:   return readBinary<std::uint8_t>();
+            case EPlyType::INT16:   return readBinary<std::int16_t>();
+            case EPlyType::UINT16:  return readBinary<std::uint16_t>();
+            case EPlyType::INT32:   return readBinary<std::int32_t>();
+            case EPlyType::UINT32:  return readBinary<std::uint32_t>();
+            case EPlyType::FLOAT32: return readBinary<float>();
+            case EPlyType::FLOAT64: return readBinary<double>();
+        }
+        throw std::out_of_range("Invalid ply property type");
+    }
+
+    /// Number of bytes left in the body, each value takes at least one byte
+    std::size_t remainingSize() const { return _end - _p; }
+
+private:
+    template<typename T>
+    double readBinary()
+    {
+        if(_end - _p < static_cast<std::ptrdiff_t>(sizeof(T)))
+            throw std::runtime_error("Mesh: Unexpected end of file while reading ply file.");
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, _p, sizeof(T));
+        if(_swapBytes)
+            std::reverse(bytes, bytes + sizeof(T));
+        _p += sizeof(T);
+        T value;
+        std::memcpy(&value, bytes, sizeof(T));
+        return static_cast<double>(value);
+    }
+
+    const char* _p;
+    const char* _end;
+    bool _ascii;
+    bool _swapBytes;
+};
+
+/**
+ * @brief Scale of a color property to [0, 255]: integer colors use the full range of their type,
+ * floating point colors are in [0, 1].
+ */
+float plyColorScale(EPlyType type)
+{
+    switch(type)
+    {
+        case EPlyType::INT8:   return 255.0f / std::numeric_limits<std::int8_t>::max();
+        case EPlyType::UINT8:  return 1.0f;
+        case EPlyType::INT16:  return 255.0f / std::numeric_limits<std::int16_t>::max();
+        case EPlyType::UINT16: return 255.0f / std::numeric_limits<std::uint16_t>::max();
+        case EPlyType::INT32:  return 255.0f / std::numeric_limits<std::int32_t>::max();
+        case EPlyType::UINT32: return 255.0f / std::numeric_limits<std::uint32_t>::max();
+        default:               return 255.0f;
+    }
+}
+
+/// Convert a color value to uint8 with its scale, clamped to [0, 255]
+inline unsigned char toColorComponent(double value, float scale)
+{
+    return static_cast<unsigned char>(std::min(255.0, std::max(0.0, std::round(value * scale))));
+}
+
+/// Tags of the sections of the binary mesh format
+const char binMagic[4] = {'A', 'V', 'M', 'B'};
+const std::uint32_t binVersion = 2;
+
+void writeSectionHeader(std::ofstream& file, const char* tag, std::uint64_t count, std::uint64_t payloadSize)
+{
+    const std::uint64_t sectionSize = sizeof(std::uint64_t) + payloadSize;
+    file.write(tag, 4);
+    file.write(reinterpret_cast<const char*>(&sectionSize), sizeof(sectionSize));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+}
+
+template<typename T>
+void writeArraySection(std::ofstream& file, const char* tag, const std::vector<T>& data)
+{
+    writeSectionHeader(file, tag, data.size(), data.size() * sizeof(T));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+}
+
+/**
+ * @brief Read an array of count elements from a section payload of payloadSize bytes.
+ * @return false if the array does not fit in the payload or if the file is truncated
+ */
+template<typename T>
+bool readArray(std::ifstream& file, std::uint64_t count, std::uint64_t payloadSize, std::vector<T>& data)
+{
+    if(count > payloadSize / sizeof(T))
+        return false;
+    const std::streamsize size = static_cast<std::streamsize>(count * sizeof(T));
+    data.resize(count);
+    file.read(reinterpret_cast<char*>(data.data()), size);
+    return file && file.gcount() == size;
+}
+
+} // namespace
+
+bool Mesh::load(const std::string& filepath)
+{
+    const std::string extension = boost::algorithm::to_lower_copy(bfs::path(filepath).extension().string());
+
+    if(extension == ".obj")
+        return loadFromObjAscii(filepath);
+    if(extension == ".ply")
+        return loadFromPly(filepath);
+    if(extension == ".bin")
+        return loadFromBin(filepath);
+
+    throw std::runtime_error("Mesh: Unsupported mesh file extension: " + filepath);
+}
+
+void Mesh::save(const std::string& filepath)
+{
+    const std::string extension = boost::algorithm::to_lower_copy(bfs::path(filepath).extension().string());
+
+    if(extension == ".obj")
+        saveToObj(filepath);
+    else if(extension == ".ply")
+        saveToPly(filepath);
+    else if(extension == ".bin")
+        saveToBin(filepath);
+    else
+    {
+        // OBJ is the historical format of the meshes
+        ALICEVISION_LOG_WARNING("Mesh: Unknown mesh file extension, saved in OBJ format: " << filepath);
+        saveToObj(filepath);
+    }
+}
+
+void Mesh::saveToObj(const std::string& filename)
+{
+  ALICEVISION_LOG_INFO("Save mesh to obj: " << filename);
+  ALICEVISION_LOG_INFO("Nb points: " << pts.size());
+  ALICEVISION_LOG_INFO("Nb triangles: " << tris.size());
+
+  FILE* f = fopen(filename.c_str(), "w");
+  if(f == nullptr)
+    throw std::runtime_error("Unable to write mesh file: " + filename);
+
+  fprintf(f, "# \n");
+  fprintf(f, "# Wavefront OBJ file\n");
+  fprintf(f, "# Created with AliceVision\n");
+  fprintf(f, "# \n");
+  fprintf(f, "g Mesh\n");
+
+  // lines are formatted in parallel by blocks, and written in order
+  const bool useColors = (_colors.size() == static_cast<std::size_t>(pts.size()));
+  const int blockSize = 100000;
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::string> blocks(nbThreads);
+
+  const auto writeLines = [&](int nbLines, const std::function<int(int, char*, std::size_t)>& formatLine)
+  {
+    for(int first = 0; first < nbLines; first += blockSize * nbThreads)
+    {
+      #pragma omp parallel for
+      for(int b = 0; b < nbThreads; ++b)
+      {
+        std::string& block = blocks[b];
+        block.clear();
+        char line[256];
+        const int begin = first + b * blockSize;
+        const int end = std::min(nbLines, begin + blockSize);
+        for(int i = begin; i < end; ++i)
+        {
+          const int length = std::max(0, formatLine(i, line, sizeof(line)));
+          if(length < static_cast<int>(sizeof(line)))
+          {
+            block.append(line, length);
+            continue;
+          }
+          // the line does not fit (e.g. huge coordinates), format it again in a large enough buffer
+          std::vector<char> longLine(length + 1);
+          block.append(longLine.data(), std::max(0, std::min(length, formatLine(i, longLine.data(), longLine.size()))));
+        }
+      }
+      for(const std::string& block : blocks)
+        fwrite(block.data(), 1, block.size(), f);
+    }
+  };
+
+  writeLines(pts.size(), [&](int i, char* line, std::size_t lineSize)
+  {
+    const Point3d& point = pts[i];
+    if(useColors)
+    {
+      const rgb& col = _colors[i];
+      return snprintf(line, lineSize, "v %f %f %f %f %f %f\n", point.x, point.y, point.z, col.r/255.0f, col.g/255.0f, col.b/255.0f);
+    }
+    return snprintf(line, lineSize, "v %f %f %f\n", point.x, point.y, point.z);
+  });
+
+  writeLines(tris.size(), [&](int i, char* line, std::size_t lineSize)
+  {
+    const Mesh::triangle& t = tris[i];
+    return snprintf(line, lineSize, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
+  });
+
+  fclose(f);
+  ALICEVISION_LOG_INFO("Save mesh to obj done.");
+}
+
+bool Mesh::loadFromObjAscii(const std::string& objAsciiFileName)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
+
+    std::vector<char> buffer;
+    if(!readFile(objAsciiFileName, buffer))
+        return false;
+
+    // parse chunks of lines in parallel
+    const char* begin = buffer.data();
+    const char* end = buffer.data() + buffer.size() - 1;
+    const std::vector<std::pair<const char*, const char*>> ranges = splitLines(begin, end, 4 * omp_get_max_threads());
+    std::vector<ObjChunk> chunks(ranges.size());
+    std::string error;
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < static_cast<int>(ranges.size()); ++i)
+    {
+        try
+        {
+            parseObjChunk(ranges[i].first, ranges[i].second, chunks[i]);
+        }
+        catch(const std::exception& e)
+        {
+            #pragma omp critical
+            error = e.what();
+        }
+    }
+
+    if(!error.empty())
+        throw std::runtime_error(error + " (" + objAsciiFileName + ")");
+
+    std::size_t npts = 0;
+    std::size_t ntris = 0;
+    std::size_t nuvs = 0;
+    std::size_t nnorms = 0;
+    std::size_t ncolors = 0;
+    std::size_t ntrisUvIds = 0;
+    std::size_t ntrisNormalsIds = 0;
+    for(const ObjChunk& chunk : chunks)
+    {
+        npts += chunk.pts.size();
+        ntris += chunk.tris.size();
+        nuvs += chunk.uvCoords.size();
+        nnorms += chunk.normals.size();
+        ncolors += chunk.colors.size();
+        ntrisUvIds += chunk.trisUvIds.size();
+        ntrisNormalsIds += chunk.trisNormalsIds.size();
+    }
+
+    ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
+      << "\t- # normals: " << nnorms << std::endl
+      << "\t- # uv coordinates: " << nuvs << std::endl
+      << "\t- # triangles: " << ntris);
+
+    // only use colors if all the vertices have one
+    const bool useColors = (ncolors == npts);
+
+    pts = StaticVector<Point3d>();
+    pts.reserve(npts);
+    tris = StaticVector<Mesh::triangle>();
+    invalidateTopology();
+    tris.reserve(ntris);
+    uvCoords = StaticVector<Point2d>();
+    uvCoords.reserve(nuvs);
+    trisUvIds = StaticVector<Voxel>();
+    trisUvIds.reserve(ntrisUvIds);
+    normals = StaticVector<Point3d>();
+    normals.reserve(nnorms);
+    trisNormalsIds = StaticVector<Voxel>();
+    trisNormalsIds.reserve(ntrisNormalsIds);
+    _trisMtlIds.clear();
+    _trisMtlIds.reserve(ntris);
+    _colors.clear();
+    if(useColors)
+        _colors.reserve(npts);
+
+    // merge the chunks in order, material ids are given in order of first use
+    std::map<std::string, int> materialCache;
+    int mtlId = -1;
+    for(const ObjChunk& chunk : chunks)
+    {
+        std::vector<int> chunkMtlIds;
+        chunkMtlIds.reserve(chunk.materials.size());
+        for(const std::string& material : chunk.materials)
+            chunkMtlIds.push_back(materialCache.emplace(material, static_cast<int>(materialCache.size())).first->second);
+
+        for(const int chunkMtlId : chunk.trisMtlIds)
+            _trisMtlIds.push_back(chunkMtlId < 0 ? mtlId : chunkMtlIds[chunkMtlId]);
+
+        if(!chunkMtlIds.empty())
+            mtlId = chunkMtlIds.back();
+
+        const int ptsOffset = pts.size();
+        const int uvsOffset = uvCoords.size();
+        const int normalsOffset = normals.size();
+        const std::size_t firstTri = tris.size();
+        const std::size_t firstTriUvIds = trisUvIds.size();
+        const std::size_t firstTriNormalsIds = trisNormalsIds.size();
+
+        append(pts, chunk.pts);
+        append(tris, chunk.tris);
+        append(uvCoords, chunk.uvCoords);
+        append(trisUvIds, chunk.trisUvIds);
+        append(normals, chunk.normals);
+        append(trisNormalsIds, chunk.trisNormalsIds);
+
+        resolveObjChunkIndices(tris, firstTri, ptsOffset, chunk.relativePtIds);
+        resolveObjChunkIndices(trisUvIds, firstTriUvIds, uvsOffset, chunk.relativeUvIds);
+        resolveObjChunkIndices(trisNormalsIds, firstTriNormalsIds, normalsOffset, chunk.relativeNormalIds);
+        if(useColors)
+            _colors.insert(_colors.end(), chunk.colors.begin(), chunk.colors.end());
+    }
+    nmtls = materialCache.size();
+
+    const auto isValidIndex = [](int index, int size) { return index >= 0 && index < size; };
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            if(!isValidIndex(tris[i].v[k], pts.size()))
+                throw std::runtime_error("Mesh: Invalid vertex index in obj file: " + objAsciiFileName);
+        }
+    }
+    for(int i = 0; i < trisUvIds.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            if(!isValidIndex(trisUvIds[i].m[k], uvCoords.size()))
+                throw std::runtime_error("Mesh: Invalid uv coordinates index in obj file: " + objAsciiFileName);
+        }
+    }
+    for(int i = 0; i < trisNormalsIds.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            if(!isValidIndex(trisNormalsIds[i].m[k], normals.size()))
+                throw std::runtime_error("Mesh: Invalid normal index in obj file: " + objAsciiFileName);
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
+    return npts != 0 && ntris != 0;
+}
+
+bool Mesh::loadFromPly(const std::string& plyFileName)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from ply file: " << plyFileName);
+
+    std::vector<char> buffer;
+    if(!readFile(plyFileName, buffer))
+        return false;
+
+    // parse the header
+    const char* headerEnd = std::strstr(buffer.data(), "end_header");
+    if(std::strncmp(buffer.data(), "ply", 3) != 0 || headerEnd == nullptr)
+        throw std::runtime_error("Mesh: Invalid ply header: " + plyFileName);
+
+    std::istringstream header(std::string(static_cast<const char*>(buffer.data()), headerEnd));
+    std::vector<PlyElement> elements;
+    std::string format;
+    std::string line;
+    while(std::getline(header, line))
+    {
+        std::istringstream lineStream(line);
+        std::string keyword;
+        lineStream >> keyword;
+        if(keyword == "format")
+        {
+            lineStream >> format;
+        }
+        else if(keyword == "element")
+        {
+            elements.emplace_back();
+            lineStream >> elements.back().name >> elements.back().count;
+        }
+        else if(keyword == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            std::string type;
+            lineStream >> type;
+            if(type == "list")
+            {
+                std::string countType;
+                lineStream >> countType >> type;
+                property.isList = true;
+                property.countType = EPlyType_stringToEnum(countType);
+            }
+            property.type = EPlyType_stringToEnum(type);
+            lineStream >> property.name;
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    const bool ascii = (format == "ascii");
+    if(!ascii && format != "binary_little_endian" && format != "binary_big_endian")
+        throw std::runtime_error("Mesh: Unsupported ply format " + format + ": " + plyFileName);
+
+    const bool swapBytes = !ascii && ((format == "binary_little_endian") != isHostLittleEndian());
+
+    // the body starts after the end of the header line
+    const char* bodyBegin = std::find(headerEnd, static_cast<const char*>(buffer.data() + buffer.size() - 1), '\n') + 1;
+    PlyValueReader reader(bodyBegin, buffer.data() + buffer.size() - 1, ascii, swapBytes);
+
+    pts = StaticVector<Point3d>();
+    tris = StaticVector<Mesh::triangle>();
+    invalidateTopology();
+    uvCoords = StaticVector<Point2d>();
+    trisUvIds = StaticVector<Voxel>();
+    normals = StaticVector<Point3d>();
+    trisNormalsIds = StaticVector<Voxel>();
+    _trisMtlIds.clear();
+    _colors.clear();
+    nmtls = 0;
+
+    std::vector<double> values;
+    std::vector<int> faceIndices;
+
+    for(const PlyElement& element : elements)
+    {
+        const bool isVertex = (element.name == "vertex");
+        const bool isFace = (element.name == "face");
+
+        const int xId = element.getPropertyIndex("x");
+        const int yId = element.getPropertyIndex("y");
+        const int zId = element.getPropertyIndex("z");
+        int rId = element.getPropertyIndex("red");
+        int gId = element.getPropertyIndex("green");
+        int bId = element.getPropertyIndex("blue");
+        const bool withColors = isVertex && rId >= 0 && gId >= 0 && bId >= 0;
+        const float colorScale = withColors ? plyColorScale(element.properties[rId].type) : 1.0f;
+        int indicesId = element.getPropertyIndex("vertex_indices");
+        if(indicesId < 0)
+            indicesId = element.getPropertyIndex("vertex_index");
+
+        // each element takes at least one byte, which bounds the memory reserved for a corrupted count
+        if(element.count > reader.remainingSize())
+            throw std::runtime_error("Mesh: Invalid number of " + element.name + " in ply file: " + plyFileName);
+
+        if(isVertex)
+        {
+            if(xId < 0 || yId < 0 || zId < 0)
+                throw std::runtime_error("Mesh: Missing vertex coordinates in ply file: " + plyFileName);
+            pts.reserve(element.count);
+            if(withColors)
+                _colors.reserve(element.count);
+        }
+        if(isFace)
+        {
+            if(indicesId < 0)
+                throw std::runtime_error("Mesh: Missing face indices in ply file: " + plyFileName);
+            tris.reserve(element.count);
+        }
+
+        values.resize(element.properties.size());
+        for(std::size_t i = 0; i < element.count; ++i)
+        {
+            for(std::size_t p = 0; p < element.properties.size(); ++p)
+            {
+                const PlyProperty& property = element.properties[p];
+                if(!property.isList)
+                {
+                    values[p] = reader.read(property.type);
+                    continue;
+                }
+
+                const double countValue = reader.read(property.countType);
+                if(countValue < 0 || countValue > reader.remainingSize())
+                    throw std::runtime_error("Mesh: Invalid list size in ply file: " + plyFileName);
+                const int count = static_cast<int>(countValue);
+                const bool keep = isFace && (static_cast<int>(p) == indicesId);
+                if(keep)
+                    faceIndices.resize(count);
+                for(int k = 0; k < count; ++k)
+                {
+                    const double value = reader.read(property.type);
+                    if(!keep)
+                        continue;
+                    if(value < 0 || value > std::numeric_limits<int>::max())
+                        throw std::runtime_error("Mesh: Invalid vertex index in ply file: " + plyFileName);
+                    faceIndices[k] = static_cast<int>(value);
+                }
+            }
+
+            if(isVertex)
+            {
+                pts.push_back(Point3d(values[xId], values[yId], values[zId]));
+                if(withColors)
+                {
+                    _colors.emplace_back(
+                      toColorComponent(values[rId], colorScale),
+                      toColorComponent(values[gId], colorScale),
+                      toColorComponent(values[bId], colorScale));
+                }
+            }
+            else if(isFace)
+            {
+                // triangle fan for polygons
+                for(std::size_t k = 1; k + 1 < faceIndices.size(); ++k)
+                {
+                    tris.push_back(Mesh::triangle(faceIndices[0], faceIndices[k], faceIndices[k + 1]));
+                    _trisMtlIds.push_back(-1);
+                }
+            }
+        }
+    }
+
+    // the vertices may be declared after the faces
+    for(int i = 0; i < tris.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            if(tris[i].v[k] >= pts.size())
+                throw std::runtime_error("Mesh: Invalid vertex index in ply file: " + plyFileName);
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << pts.size() << "\n\t- # triangles: " << tris.size());
+    return !pts.empty() && !tris.empty();
+}
+
+void Mesh::saveToPly(const std::string& plyFileName)
+{
+    ALICEVISION_LOG_INFO("Save mesh to ply: " << plyFileName);
+    ALICEVISION_LOG_INFO("Nb points: " << pts.size());
+    ALICEVISION_LOG_INFO("Nb triangles: " << tris.size());
+
+    std::ofstream file(plyFileName, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to write mesh file: " + plyFileName);
+
+    const bool useColors = (_colors.size() == static_cast<std::size_t>(pts.size()));
+
+    file << "ply\n"
+         << "format " << (isHostLittleEndian() ? "binary_little_endian" : "binary_big_endian") << " 1.0\n"
+         << "comment Created with AliceVision\n"
+         << "element vertex " << pts.size() << "\n"
+         << "property float x\n"
+         << "property float y\n"
+         << "property float z\n";
+    if(useColors)
+    {
+        file << "property uchar red\n"
+             << "property uchar green\n"
+             << "property uchar blue\n";
+    }
+    file << "element face " << tris.size() << "\n"
+         << "property list uchar int vertex_indices\n"
+         << "end_header\n";
+
+    // write by blocks to bound the memory of the binary buffer
+    const std::size_t blockSize = 1000000;
+    std::vector<char> block;
+
+    const std::size_t vertexSize = 3 * sizeof(float) + (useColors ? 3 : 0);
+    for(std::size_t first = 0; first < static_cast<std::size_t>(pts.size()); first += blockSize)
+    {
+        const std::size_t last = std::min<std::size_t>(pts.size(), first + blockSize);
+        block.resize((last - first) * vertexSize);
+        char* p = block.data();
+        for(std::size_t i = first; i < last; ++i)
+        {
+            const float xyz[3] = {static_cast<float>(pts[i].x), static_cast<float>(pts[i].y), static_cast<float>(pts[i].z)};
+            std::memcpy(p, xyz, sizeof(xyz));
+            p += sizeof(xyz);
+            if(useColors)
+            {
+                std::memcpy(p, &_colors[i], 3);
+                p += 3;
+            }
+        }
+        file.write(block.data(), block.size());
+    }
+
+    const std::size_t faceSize = 1 + 3 * sizeof(std::int32_t);
+    for(std::size_t first = 0; first < static_cast<std::size_t>(tris.size()); first += blockSize)
+    {
+        const std::size_t last = std::min<std::size_t>(tris.size(), first + blockSize);
+        block.resize((last - first) * faceSize);
+        char* p = block.data();
+        for(std::size_t i = first; i < last; ++i)
+        {
+            *p++ = 3;
+            const std::int32_t v[3] = {tris[i].v[0], tris[i].v[1], tris[i].v[2]};
+            std::memcpy(p, v, sizeof(v));
+            p += sizeof(v);
+        }
+        file.write(block.data(), block.size());
+    }
+
+    if(!file)
+        throw std::runtime_error("Unable to write mesh file: " + plyFileName);
+    ALICEVISION_LOG_INFO("Save mesh to ply done.");
+}
+
+bool Mesh::loadFromBin(const std::string& binFileName)
+{
+    std::ifstream file(binFileName, std::ios::binary | std::ios::ate);
+    if(!file)
+        return false;
+    const std::uint64_t fileSize = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+
+    const auto remainingSize = [&]() {
+        return fileSize - static_cast<std::uint64_t>(file.tellg());
+    };
+    const auto truncated = [&]() {
+        ALICEVISION_LOG_ERROR("Mesh: Truncated or corrupted binary mesh file: " << binFileName);
+        return false;
+    };
+
+    char magic[4];
+    file.read(magic, 4);
+    if(!file || std::memcmp(magic, binMagic, 4) != 0)
+    {
+        // legacy format: points and triangles only
+        file.clear();
+        file.seekg(0);
+
+        pts = StaticVector<Point3d>();
+        tris = StaticVector<Mesh::triangle>();
+        invalidateTopology();
+
+        int npts;
+        if(!file.read(reinterpret_cast<char*>(&npts), sizeof(int)) || npts < 0 ||
+           static_cast<std::uint64_t>(npts) > remainingSize() / sizeof(Point3d))
+            return truncated();
+        pts.resize(npts);
+        if(!file.read(reinterpret_cast<char*>(pts.getDataWritable().data()), npts * sizeof(Point3d)))
+            return truncated();
+
+        int ntris;
+        if(!file.read(reinterpret_cast<char*>(&ntris), sizeof(int)) || ntris < 0 ||
+           static_cast<std::uint64_t>(ntris) > remainingSize() / sizeof(Mesh::triangle))
+            return truncated();
+        tris.resize(ntris);
+        if(!file.read(reinterpret_cast<char*>(tris.getDataWritable().data()), ntris * sizeof(Mesh::triangle)))
+            return truncated();
+
+        return true;
+    }
+
+    std::uint32_t version;
+    if(!file.read(reinterpret_cast<char*>(&version), sizeof(version)))
+        return truncated();
+    if(version > binVersion)
+        throw std::runtime_error("Mesh: Unsupported binary mesh version " + std::to_string(version) + ": " + binFileName);
+
+    pts = StaticVector<Point3d>();
+    tris = StaticVector<Mesh::triangle>();
+    invalidateTopology();
+    uvCoords = StaticVector<Point2d>();
+    trisUvIds = StaticVector<Voxel>();
+    normals = StaticVector<Point3d>();
+    trisNormalsIds = StaticVector<Voxel>();
+    pointsVisibilities = PointsVisibility();
+    _trisMtlIds.clear();
+    _colors.clear();
+    nmtls = 0;
+
+    char tag[4];
+    std::uint64_t sectionSize;
+    bool hasPoints = false;
+    bool hasTriangles = false;
+    bool hasEnd = false;
+    while(!hasEnd)
+    {
+        // the file must end exactly on a section boundary
+        file.read(tag, 4);
+        if(file.gcount() == 0 && file.eof())
+            break;
+        if(!file || !file.read(reinterpret_cast<char*>(&sectionSize), sizeof(sectionSize)))
+            return truncated();
+
+        if(sectionSize < sizeof(std::uint64_t) || sectionSize > remainingSize())
+            return truncated();
+        const std::streampos sectionEnd = file.tellg() + static_cast<std::streamoff>(sectionSize);
+        const std::uint64_t payloadSize = sectionSize - sizeof(std::uint64_t);
+
+        std::uint64_t count;
+        if(!file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+            return truncated();
+
+        bool valid = true;
+        if(std::memcmp(tag, "END ", 4) == 0)
+        {
+            hasEnd = true;
+        }
+        else if(std::memcmp(tag, "PTS ", 4) == 0)
+        {
+            hasPoints = true;
+            valid = readArray(file, count, payloadSize, pts.getDataWritable());
+        }
+        else if(std::memcmp(tag, "TRIS", 4) == 0)
+        {
+            hasTriangles = true;
+            std::vector<Voxel> trisIds;
+            valid = readArray(file, count, payloadSize, trisIds);
+            tris.reserve(trisIds.size());
+            for(const Voxel& t : trisIds)
+                tris.push_back(Mesh::triangle(t.x, t.y, t.z));
+        }
+        else if(std::memcmp(tag, "COLS", 4) == 0)
+        {
+            valid = readArray(file, count, payloadSize, _colors);
+        }
+        else if(std::memcmp(tag, "UVS ", 4) == 0)
+        {
+            valid = readArray(file, count, payloadSize, uvCoords.getDataWritable());
+        }
+        else if(std::memcmp(tag, "TUVS", 4) == 0)
+        {
+            valid = readArray(file, count, payloadSize, trisUvIds.getDataWritable());
+        }
+        else if(std::memcmp(tag, "MTLS", 4) == 0)
+        {
+            std::int32_t nbMaterials;
+            valid = payloadSize >= sizeof(nbMaterials) &&
+                    file.read(reinterpret_cast<char*>(&nbMaterials), sizeof(nbMaterials)) &&
+                    readArray(file, count, payloadSize - sizeof(nbMaterials), _trisMtlIds);
+            if(valid)
+                nmtls = nbMaterials;
+        }
+        else if(std::memcmp(tag, "VIS ", 4) == 0)
+        {
+            std::vector<std::int32_t> nbCameras;
+            valid = readArray(file, count, payloadSize, nbCameras);
+
+            // the observations must fit in the rest of the section
+            std::uint64_t nbObservations = 0;
+            for(std::size_t i = 0; valid && i < nbCameras.size(); ++i)
+            {
+                valid = nbCameras[i] >= 0;
+                nbObservations += nbCameras[i];
+            }
+            valid = valid && nbObservations <= (payloadSize - count * sizeof(std::int32_t)) / sizeof(int);
+
+            if(valid)
+            {
+                pointsVisibilities.resize(count);
+                for(std::size_t i = 0; valid && i < count; ++i)
+                {
+                    PointVisibility& pointVisibility = pointsVisibilities[i];
+                    pointVisibility.resize(nbCameras[i]);
+                    valid = static_cast<bool>(file.read(reinterpret_cast<char*>(pointVisibility.getDataWritable().data()), nbCameras[i] * sizeof(int)));
+                }
+            }
+        }
+        if(!valid)
+            return truncated();
+
+        // unknown sections are skipped
+        file.seekg(sectionEnd);
+        if(!file)
+            return truncated();
+    }
+
+    if(file.bad())
+        throw std::runtime_error("Mesh: Unable to read binary mesh file: " + binFileName);
+
+    // the points and triangles are always saved, the end section since version 2
+    if(!hasPoints || !hasTriangles || (version >= 2 && !hasEnd))
+        return truncated();
+    return true;
+}
+
+void Mesh::saveToBin(const std::string& binFileName)
+{
+    long t = std::clock();
+    ALICEVISION_LOG_DEBUG("Save mesh to bin.");
+
+    std::ofstream file(binFileName, std::ios::binary);
+    if(!file)
+        throw std::runtime_error("Unable to write mesh file: " + binFileName);
+
+    file.write(binMagic, 4);
+    file.write(reinterpret_cast<const char*>(&binVersion), sizeof(binVersion));
+
+    writeArraySection(file, "PTS ", pts.getData());
+
+    {
+        std::vector<Voxel> trisIds;
+        trisIds.reserve(tris.size());
+        for(const Mesh::triangle& t : tris)
+            trisIds.emplace_back(t.v[0], t.v[1], t.v[2]);
+        writeArraySection(file, "TRIS", trisIds);
+    }
+
+    if(!_colors.empty())
+        writeArraySection(file, "COLS", _colors);
+
+    if(!uvCoords.empty())
+    {
+        writeArraySection(file, "UVS ", uvCoords.getData());
+        writeArraySection(file, "TUVS", trisUvIds.getData());
+    }
+
+    if(!_trisMtlIds.empty())
+    {
+        const std::int32_t nbMaterials = nmtls;
+        writeSectionHeader(file, "MTLS", _trisMtlIds.size(), sizeof(nbMaterials) + _trisMtlIds.size() * sizeof(int));
+        file.write(reinterpret_cast<const char*>(&nbMaterials), sizeof(nbMaterials));
+        file.write(reinterpret_cast<const char*>(_trisMtlIds.data()), _trisMtlIds.size() * sizeof(int));
+    }
+
+    if(!pointsVisibilities.empty())
+    {
+        std::vector<std::int32_t> nbCameras;
+        nbCameras.reserve(pointsVisibilities.size());
+        std::uint64_t nbObservations = 0;
+        for(const PointVisibility& pointVisibility : pointsVisibilities)
+        {
+            nbCameras.push_back(pointVisibility.size());
+            nbObservations += pointVisibility.size();
+        }
+        writeSectionHeader(file, "VIS ", nbCameras.size(), (nbCameras.size() + nbObservations) * sizeof(std::int32_t));
+        file.write(reinterpret_cast<const char*>(nbCameras.data()), nbCameras.size() * sizeof(std::int32_t));
+        for(const PointVisibility& pointVisibility : pointsVisibilities)
+            file.write(reinterpret_cast<const char*>(pointVisibility.getData().data()), pointVisibility.size() * sizeof(int));
+    }
+
+    writeSectionHeader(file, "END ", 0, 0);
+
+    if(!file)
+        throw std::runtime_error("Unable to write mesh file: " + binFileName);
+    mvsUtils::printfElapsedTime(t, "Save mesh to bin ");
+}
+
+} // namespace mesh
+} // namespace aliceVision
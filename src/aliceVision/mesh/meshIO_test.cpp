@@ -0,0 +1,282 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshIO
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// Generate a colored grid of nbSide x nbSide vertices
+void generateMesh(Mesh& mesh, int nbSide)
+{
+    for(int j = 0; j < nbSide; ++j)
+    {
+        for(int i = 0; i < nbSide; ++i)
+        {
+            mesh.pts.push_back(Point3d(i * 0.25, j * 0.5, (i * j) % 7 * 0.125));
+            mesh.colors().emplace_back(i * 10 % 256, j * 20 % 256, (i + j) % 256);
+        }
+    }
+    for(int j = 0; j + 1 < nbSide; ++j)
+    {
+        for(int i = 0; i + 1 < nbSide; ++i)
+        {
+            const int v = j * nbSide + i;
+            mesh.tris.push_back(Mesh::triangle(v, v + 1, v + nbSide));
+            mesh.tris.push_back(Mesh::triangle(v + 1, v + nbSide + 1, v + nbSide));
+        }
+    }
+}
+
+/// Check that two meshes have the same vertices, triangles and colors
+void checkSameMesh(const Mesh& mesh, const Mesh& loadedMesh, bool withColors)
+{
+    BOOST_REQUIRE_EQUAL(loadedMesh.pts.size(), mesh.pts.size());
+    BOOST_REQUIRE_EQUAL(loadedMesh.tris.size(), mesh.tris.size());
+    for(int i = 0; i < mesh.pts.size(); ++i)
+    {
+        BOOST_CHECK_SMALL((loadedMesh.pts[i] - mesh.pts[i]).size(), 1e-5);
+    }
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+            BOOST_CHECK_EQUAL(loadedMesh.tris[i].v[k], mesh.tris[i].v[k]);
+    }
+    if(!withColors)
+        return;
+    BOOST_REQUIRE_EQUAL(loadedMesh.colors().size(), mesh.colors().size());
+    for(std::size_t i = 0; i < mesh.colors().size(); ++i)
+    {
+        BOOST_CHECK_LE(std::abs(loadedMesh.colors()[i].r - mesh.colors()[i].r), 1);
+        BOOST_CHECK_LE(std::abs(loadedMesh.colors()[i].g - mesh.colors()[i].g), 1);
+        BOOST_CHECK_LE(std::abs(loadedMesh.colors()[i].b - mesh.colors()[i].b), 1);
+    }
+}
+
+/// Write a small ascii ply file with the given face list
+void writeAsciiPly(const bfs::path& filepath, const std::string& colorType, const std::string& vertices, const std::string& faces)
+{
+    std::ofstream file(filepath.string());
+    file << "ply\n"
+         << "format ascii 1.0\n"
+         << "element vertex 3\n"
+         << "property float x\n"
+         << "property float y\n"
+         << "property float z\n"
+         << "property " << colorType << " red\n"
+         << "property " << colorType << " green\n"
+         << "property " << colorType << " blue\n"
+         << "element face 1\n"
+         << "property list uchar int vertex_indices\n"
+         << "end_header\n"
+         << vertices << faces;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(meshIO_roundtrip)
+{
+    Mesh mesh;
+    generateMesh(mesh, 20);
+
+    const bfs::path folder = bfs::temp_directory_path() / bfs::unique_path("meshIO_%%%%-%%%%");
+    bfs::create_directory(folder);
+
+    // OBJ, PLY, binary and an unknown extension saved as OBJ
+    for(const std::string filename : {"mesh.obj", "mesh.ply", "mesh.bin", "mesh.OBJ"})
+    {
+        BOOST_TEST_CONTEXT(filename)
+        {
+            const std::string filepath = (folder / filename).string();
+            mesh.save(filepath);
+            Mesh loadedMesh;
+            BOOST_REQUIRE(loadedMesh.load(filepath));
+            checkSameMesh(mesh, loadedMesh, true);
+        }
+    }
+
+    const std::string unknownFilepath = (folder / "mesh.unknown").string();
+    mesh.save(unknownFilepath);
+    Mesh objMesh;
+    BOOST_REQUIRE(objMesh.loadFromObjAscii(unknownFilepath));
+    checkSameMesh(mesh, objMesh, true);
+
+    bfs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(meshIO_plyValidation)
+{
+    const bfs::path filepath = bfs::temp_directory_path() / bfs::unique_path("meshIO_%%%%-%%%%.ply");
+    const std::string vertices = "0 0 0 0 0 0\n1 0 0 0 0 0\n0 1 0 0 0 0\n";
+
+    // valid triangle
+    writeAsciiPly(filepath, "uchar", vertices, "3 0 1 2\n");
+    Mesh mesh;
+    BOOST_CHECK(mesh.loadFromPly(filepath.string()));
+    BOOST_CHECK_EQUAL(mesh.tris.size(), 1);
+
+    // vertex index out of range
+    writeAsciiPly(filepath, "uchar", vertices, "3 0 1 3\n");
+    BOOST_CHECK_THROW(mesh.loadFromPly(filepath.string()), std::runtime_error);
+
+    // negative vertex index
+    writeAsciiPly(filepath, "uchar", vertices, "3 0 -1 2\n");
+    BOOST_CHECK_THROW(mesh.loadFromPly(filepath.string()), std::runtime_error);
+
+    // negative list size
+    writeAsciiPly(filepath, "uchar", vertices, "-3 0 1 2\n");
+    BOOST_CHECK_THROW(mesh.loadFromPly(filepath.string()), std::runtime_error);
+
+    // huge element count
+    {
+        std::ofstream file(filepath.string());
+        file << "ply\nformat ascii 1.0\nelement vertex 18446744073709551615\nproperty float x\nproperty float y\nproperty float z\nend_header\n0 0 0\n";
+    }
+    BOOST_CHECK_THROW(mesh.loadFromPly(filepath.string()), std::runtime_error);
+
+    // 16 bits and float colors are scaled to [0, 255]
+    writeAsciiPly(filepath, "ushort", "0 0 0 65535 0 32768\n1 0 0 0 0 0\n0 1 0 0 0 0\n", "3 0 1 2\n");
+    BOOST_REQUIRE(mesh.loadFromPly(filepath.string()));
+    BOOST_CHECK_EQUAL(int(mesh.colors()[0].r), 255);
+    BOOST_CHECK_EQUAL(int(mesh.colors()[0].b), 128);
+
+    writeAsciiPly(filepath, "float", "0 0 0 1.0 2.0 0.5\n1 0 0 0 0 0\n0 1 0 0 0 0\n", "3 0 1 2\n");
+    BOOST_REQUIRE(mesh.loadFromPly(filepath.string()));
+    BOOST_CHECK_EQUAL(int(mesh.colors()[0].r), 255);
+    BOOST_CHECK_EQUAL(int(mesh.colors()[0].g), 255);
+    BOOST_CHECK_EQUAL(int(mesh.colors()[0].b), 128);
+
+    bfs::remove(filepath);
+}
+
+BOOST_AUTO_TEST_CASE(meshIO_objIndices)
+{
+    const bfs::path folder = bfs::temp_directory_path() / bfs::unique_path("meshIO_%%%%-%%%%");
+    bfs::create_directory(folder);
+    const std::string absoluteFilepath = (folder / "absolute.obj").string();
+    const std::string relativeFilepath = (folder / "relative.obj").string();
+
+    // the same strip of quads with absolute and relative indices, long enough to be parsed in several chunks
+    const int nbQuads = 5000;
+    {
+        std::ofstream absoluteFile(absoluteFilepath);
+        std::ofstream relativeFile(relativeFilepath);
+        for(int i = 0; i < nbQuads; ++i)
+        {
+            for(std::ofstream* file : {&absoluteFile, &relativeFile})
+            {
+                *file << "v " << i << " 0 0\n"
+                      << "v " << i << " 1 0\n"
+                      << "vt " << i << " 0\n"
+                      << "vt " << i << " 1\n";
+            }
+            if(i == 0)
+                continue;
+            const int v = 2 * i + 1;
+            absoluteFile << "f " << v - 2 << "/" << v - 2 << " " << v << "/" << v << " " << v + 1 << "/" << v + 1 << " " << v - 1 << "/" << v - 1 << "\n";
+            relativeFile << "f -4/-4 -2/-2 -1/-1 -3/-3\n";
+        }
+    }
+
+    Mesh absoluteMesh;
+    BOOST_REQUIRE(absoluteMesh.loadFromObjAscii(absoluteFilepath));
+    Mesh relativeMesh;
+    BOOST_REQUIRE(relativeMesh.loadFromObjAscii(relativeFilepath));
+    BOOST_CHECK_EQUAL(absoluteMesh.tris.size(), 2 * (nbQuads - 1));
+    checkSameMesh(absoluteMesh, relativeMesh, false);
+    BOOST_REQUIRE_EQUAL(relativeMesh.trisUvIds.size(), absoluteMesh.trisUvIds.size());
+    for(int i = 0; i < absoluteMesh.trisUvIds.size(); ++i)
+        BOOST_CHECK(relativeMesh.trisUvIds[i] == absoluteMesh.trisUvIds[i]);
+
+    // invalid indices: 0, out of range, before the first vertex
+    const std::string filepath = (folder / "invalid.obj").string();
+    for(const std::string face : {"f 0 1 2\n", "f 1 2 4\n", "f -4 -2 -1\n", "f 1/0 2/1 3/1\n", "f 1/1 2/1 3/2\n"})
+    {
+        BOOST_TEST_CONTEXT(face)
+        {
+            {
+                std::ofstream file(filepath);
+                file << "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\n" << face;
+            }
+            Mesh mesh;
+            BOOST_CHECK_THROW(mesh.loadFromObjAscii(filepath), std::runtime_error);
+        }
+    }
+
+    bfs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(meshIO_binVisibilities)
+{
+    Mesh mesh;
+    generateMesh(mesh, 10);
+    mesh.pointsVisibilities.resize(mesh.pts.size());
+    for(int i = 0; i < mesh.pts.size(); ++i)
+    {
+        // some points without visibility
+        for(int c = 0; c < i % 4; ++c)
+            mesh.pointsVisibilities[i].push_back(i * 3 + c);
+    }
+
+    const bfs::path filepath = bfs::temp_directory_path() / bfs::unique_path("meshIO_%%%%-%%%%.bin");
+    mesh.saveToBin(filepath.string());
+
+    Mesh loadedMesh;
+    BOOST_REQUIRE(loadedMesh.loadFromBin(filepath.string()));
+    checkSameMesh(mesh, loadedMesh, true);
+    BOOST_REQUIRE_EQUAL(loadedMesh.pointsVisibilities.size(), mesh.pointsVisibilities.size());
+    for(int i = 0; i < mesh.pointsVisibilities.size(); ++i)
+        BOOST_CHECK(loadedMesh.pointsVisibilities[i].getData() == mesh.pointsVisibilities[i].getData());
+
+    bfs::remove(filepath);
+}
+
+BOOST_AUTO_TEST_CASE(meshIO_binTruncation)
+{
+    Mesh mesh;
+    generateMesh(mesh, 4);
+    mesh.pointsVisibilities.resize(mesh.pts.size());
+    for(int i = 0; i < mesh.pts.size(); ++i)
+        mesh.pointsVisibilities[i].push_back(i);
+
+    const bfs::path filepath = bfs::temp_directory_path() / bfs::unique_path("meshIO_%%%%-%%%%.bin");
+    mesh.saveToBin(filepath.string());
+
+    std::vector<char> content(bfs::file_size(filepath));
+    {
+        std::ifstream file(filepath.string(), std::ios::binary);
+        file.read(content.data(), content.size());
+    }
+
+    // every truncation of the file is detected, whether it ends in or between the sections
+    for(std::size_t size = 0; size < content.size(); ++size)
+    {
+        {
+            std::ofstream file(filepath.string(), std::ios::binary | std::ios::trunc);
+            file.write(content.data(), size);
+        }
+        Mesh loadedMesh;
+        BOOST_CHECK_MESSAGE(!loadedMesh.loadFromBin(filepath.string()), "truncated to " << size << " bytes");
+    }
+
+    bfs::remove(filepath);
+}
@@ -0,0 +1,177 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#define BOOST_TEST_MODULE meshTrisMap
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace {
+
+const int width = 200;
+const int height = 150;
+const double focal = 250.0;
+
+/**
+ * @brief Fixed pinhole camera at the origin looking along +Z, the principal point is the image center.
+ */
+Point2d projectPoint(const Point3d& p)
+{
+    return Point2d(focal * p.x / p.z + width * 0.5, focal * p.y / p.z + height * 0.5);
+}
+
+Point3d unprojectPixel(double x, double y, double depth)
+{
+    return Point3d((x - width * 0.5) * depth / focal, (y - height * 0.5) * depth / focal, depth);
+}
+
+/**
+ * @brief Regular grid of triangles sharing edges, with vertices on the 64 pixels tile borders,
+ *        one large triangle over several tiles and one triangle partly outside of the image.
+ */
+void generateMesh(Mesh& mesh)
+{
+    const std::vector<double> xs = {0.5, 20.25, 63.5, 64.0, 100.7, 128.0, 150.3, 191.5, 199.0};
+    const std::vector<double> ys = {1.0, 40.5, 64.0, 90.25, 127.75, 128.0, 149.0};
+
+    for(int j = 0; j < ys.size(); ++j)
+        for(int i = 0; i < xs.size(); ++i)
+            mesh.pts.push_back(unprojectPixel(xs[i], ys[j], 2.0 + 0.1 * i + 0.05 * j));
+
+    for(int j = 0; j + 1 < ys.size(); ++j)
+    {
+        for(int i = 0; i + 1 < xs.size(); ++i)
+        {
+            const int a = j * xs.size() + i;
+            const int b = a + 1;
+            const int c = a + xs.size() + 1;
+            const int d = a + xs.size();
+            mesh.tris.push_back(Mesh::triangle(a, b, c));
+            mesh.tris.push_back(Mesh::triangle(a, c, d));
+        }
+    }
+
+    const int p0 = mesh.pts.size();
+    mesh.pts.push_back(unprojectPixel(10.0, 10.0, 3.0));
+    mesh.pts.push_back(unprojectPixel(190.0, 70.0, 3.0));
+    mesh.pts.push_back(unprojectPixel(60.0, 140.0, 3.0));
+    mesh.tris.push_back(Mesh::triangle(p0, p0 + 1, p0 + 2));
+
+    mesh.pts.push_back(unprojectPixel(-20.0, 30.0, 3.0));
+    mesh.pts.push_back(unprojectPixel(50.0, 30.0, 3.0));
+    mesh.pts.push_back(unprojectPixel(20.0, 80.0, 3.0));
+    mesh.tris.push_back(Mesh::triangle(p0 + 3, p0 + 4, p0 + 5));
+}
+
+/**
+ * @brief Same computation as Mesh::getTriangleProjection with the fixed camera.
+ */
+Mesh::triangle_proj getTriangleProjection(const Mesh& mesh, int triId)
+{
+    Mesh::triangle_proj tp;
+    for(int j = 0; j < 3; j++)
+    {
+        tp.tp2ds[j] = projectPoint(mesh.pts[mesh.tris[triId].v[j]]);
+        tp.tpixs[j].x = (int)floor(tp.tp2ds[j].x);
+        tp.tpixs[j].y = (int)floor(tp.tp2ds[j].y);
+    }
+
+    tp.lu = Pixel(width, height);
+    tp.rd = Pixel(0, 0);
+    for(int j = 0; j < 3; j++)
+    {
+        if((float)tp.lu.x > tp.tp2ds[j].x)
+            tp.lu.x = (int)tp.tp2ds[j].x;
+        if((float)tp.lu.y > tp.tp2ds[j].y)
+            tp.lu.y = (int)tp.tp2ds[j].y;
+        if((float)tp.rd.x < tp.tp2ds[j].x)
+            tp.rd.x = (int)tp.tp2ds[j].x;
+        if((float)tp.rd.y < tp.tp2ds[j].y)
+            tp.rd.y = (int)tp.tp2ds[j].y;
+    }
+    return tp;
+}
+
+bool isTriangleProjectionInImage(const Mesh::triangle_proj& tp)
+{
+    for(int j = 0; j < 3; j++)
+    {
+        if(tp.tpixs[j].x < 0 || tp.tpixs[j].x >= width || tp.tpixs[j].y < 0 || tp.tpixs[j].y >= height)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(meshTrisMap_tiledRasterization)
+{
+    Mesh mesh;
+    generateMesh(mesh);
+
+    // unsorted subset of the triangles to check that the output order follows visTris
+    StaticVector<int> visTris;
+    for(int i = mesh.tris.size() - 1; i >= 0; i -= 2)
+        visTris.push_back(i);
+    for(int i = 0; i < mesh.tris.size(); i += 2)
+        visTris.push_back(i);
+
+    std::vector<Mesh::triangle_proj> trisProj(visTris.size());
+    std::vector<char> trisInImage(visTris.size());
+    for(int m = 0; m < visTris.size(); ++m)
+    {
+        trisProj[m] = getTriangleProjection(mesh, visTris[m]);
+        trisInImage[m] = isTriangleProjectionInImage(trisProj[m]);
+    }
+    // the triangle partly outside of the image is skipped
+    BOOST_CHECK_EQUAL(std::count(trisInImage.begin(), trisInImage.end(), 0), 1);
+
+    StaticVector<StaticVector<int>> tiled;
+    mesh.getTrisMap(tiled, visTris, trisProj, trisInImage, width, height);
+
+    // previous implementation: scan of the bounding box of each triangle
+    StaticVector<StaticVector<int>> reference;
+    reference.resize(width * height);
+    for(int m = 0; m < visTris.size(); ++m)
+    {
+        if(!trisInImage[m])
+            continue;
+        Mesh::triangle_proj tp = trisProj[m];
+        Pixel pix;
+        for(pix.x = tp.lu.x; pix.x <= tp.rd.x; pix.x++)
+        {
+            for(pix.y = tp.lu.y; pix.y <= tp.rd.y; pix.y++)
+            {
+                Mesh::rectangle re = Mesh::rectangle(pix, 1);
+                if(mesh.doesTriangleIntersectsRectangle(tp, re))
+                    reference[pix.x * height + pix.y].push_back(visTris[m]);
+            }
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(tiled.size(), reference.size());
+
+    int nbSharedPixels = 0;
+    for(int i = 0; i < reference.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(tiled[i].size(), reference[i].size());
+        for(int j = 0; j < reference[i].size(); ++j)
+            BOOST_CHECK_EQUAL(tiled[i][j], reference[i][j]);
+        if(reference[i].size() > 1)
+            ++nbSharedPixels;
+    }
+
+    // triangles sharing edges overlap the same pixels
+    BOOST_CHECK(nbSharedPixels > 0);
+}
@@ -0,0 +1,119 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/mesh/Texturing.hpp>
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE texturing
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::mesh;
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const int nbBand = 3;
+const int textureSide = 16;
+
+/// Fill the accumulation pyramid with values depending on the atlas
+void fillPyramid(Texturing::AccuPyramid& accuPyramid, std::size_t atlasID)
+{
+    for(int level = 0; level < accuPyramid.pyramid.size(); ++level)
+    {
+        Texturing::AccuImage& accuImage = accuPyramid.pyramid[level];
+        for(int i = 0; i < accuImage.img.data().size(); ++i)
+        {
+            accuImage.img.data()[i] = Color(atlasID, level, i);
+            accuImage.imgCount[i] = atlasID + level + i;
+        }
+    }
+}
+
+/// Check the values of the accumulation pyramid of an atlas
+bool checkPyramid(const Texturing::AccuPyramid& accuPyramid, std::size_t atlasID)
+{
+    if(accuPyramid.pyramid.size() != nbBand)
+        return false;
+    for(int level = 0; level < accuPyramid.pyramid.size(); ++level)
+    {
+        const Texturing::AccuImage& accuImage = accuPyramid.pyramid[level];
+        if(accuImage.img.width() != textureSide || accuImage.img.height() != textureSide ||
+           accuImage.imgCount.size() != textureSide * textureSide)
+            return false;
+        for(int i = 0; i < accuImage.img.data().size(); ++i)
+        {
+            const Color& color = accuImage.img.data()[i];
+            if(color.r != atlasID || color.g != level || color.b != i || accuImage.imgCount[i] != atlasID + level + i)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(AccuPyramidsCache_spillAndReload)
+{
+    const bfs::path spillFolder = bfs::temp_directory_path() / bfs::unique_path("texturing_%%%%-%%%%");
+    bfs::create_directory(spillFolder);
+    {
+        // a single pyramid in memory: each new atlas spills the resident one
+        const std::vector<std::vector<int>> camerasPerAtlas = {{0, 2}, {1, 2}};
+        AccuPyramidsCache cache(camerasPerAtlas, 1, nbBand, textureSide, spillFolder);
+
+        fillPyramid(cache.get(0), 0);
+        BOOST_CHECK(!cache.setContributionsDone(0, 1));
+
+        fillPyramid(cache.get(1), 1);
+        BOOST_CHECK(!cache.setContributionsDone(1, 1));
+        BOOST_CHECK_EQUAL(cache.getNbSpills(), 1);
+
+        // atlas 0 is reloaded from disk, atlas 1 is spilled
+        BOOST_CHECK(checkPyramid(cache.get(0), 0));
+        BOOST_CHECK_EQUAL(cache.getNbSpills(), 2);
+        BOOST_CHECK(cache.setContributionsDone(0, 1));
+        cache.release(0);
+
+        // atlas 1 is reloaded from disk
+        BOOST_CHECK(checkPyramid(cache.get(1), 1));
+        BOOST_CHECK(cache.setContributionsDone(1, 1));
+        cache.release(1);
+        BOOST_CHECK_EQUAL(cache.getNbSpills(), 2);
+    }
+    // spilled files are removed
+    BOOST_CHECK(bfs::is_empty(spillFolder));
+    bfs::remove_all(spillFolder);
+}
+
+BOOST_AUTO_TEST_CASE(AccuPyramid_loadInvalidSize)
+{
+    const bfs::path filepath = bfs::temp_directory_path() / bfs::unique_path("accuPyramid_%%%%-%%%%.bin");
+
+    Texturing::AccuPyramid accuPyramid;
+    accuPyramid.init(nbBand, textureSide, textureSide);
+    fillPyramid(accuPyramid, 0);
+    accuPyramid.save(filepath.string());
+
+    // an empty pyramid or a pyramid of another size is not filled
+    Texturing::AccuPyramid emptyPyramid;
+    BOOST_CHECK_THROW(emptyPyramid.load(filepath.string()), std::runtime_error);
+
+    Texturing::AccuPyramid smallerPyramid;
+    smallerPyramid.init(nbBand, textureSide / 2, textureSide / 2);
+    BOOST_CHECK_THROW(smallerPyramid.load(filepath.string()), std::runtime_error);
+
+    // a truncated file is rejected
+    bfs::resize_file(filepath, bfs::file_size(filepath) - 1);
+    Texturing::AccuPyramid truncatedPyramid;
+    truncatedPyramid.init(nbBand, textureSide, textureSide);
+    BOOST_CHECK_THROW(truncatedPyramid.load(filepath.string()), std::runtime_error);
+
+    bfs::remove(filepath);
+}
@@ -30,7 +30,7 @@ public:
         APPLY_CORRECTION
     };
 
-    std::string ECorrectEV_enumToString(const ECorrectEV correctEV);
+    static std::string ECorrectEV_enumToString(const ECorrectEV correctEV);
 
     typedef std::shared_ptr<Image> ImgSharedPtr;
 
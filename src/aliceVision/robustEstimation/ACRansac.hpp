@@ -10,7 +10,9 @@
 #pragma once
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/SPRT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <algorithm>
 #include <cmath>
@@ -18,6 +20,7 @@
 #include <iterator>
 #include <limits>
 #include <numeric>
+#include <random>
 #include <vector>
 
 /**
@@ -130,6 +133,35 @@ inline ErrorIndex bestNFA(int startIndex, //number of point required for estimat
 }
 
 
+/**
+ * @brief Fill and order the residuals needed by bestNFA.
+ *
+ * bestNFA stops at the first residual above maxThreshold, so only the residuals
+ * below the threshold are sorted, the others are just moved at the end.
+ * Without upper bound of the precision (infinite maxThreshold), all the residuals are sorted.
+ *
+ * @param[in] errors the residual of each sample
+ * @param[in] maxThreshold the upper bound of the admissible error
+ * @param[out] vec_residuals [residual,index] with the admissible part sorted
+ * @return the number of admissible residuals
+ */
+inline std::size_t sortResidualsForNFA(const std::vector<double>& errors,
+                                       double maxThreshold,
+                                       std::vector<ErrorIndex>& vec_residuals)
+{
+  vec_residuals.resize(errors.size());
+  for(std::size_t i = 0; i < errors.size(); ++i)
+    vec_residuals[i] = ErrorIndex(errors[i], i);
+
+  auto admissibleEnd = vec_residuals.end();
+  if(maxThreshold != std::numeric_limits<double>::infinity())
+    admissibleEnd = std::partition(vec_residuals.begin(), vec_residuals.end(),
+                                   [maxThreshold](const ErrorIndex& e) { return e.first <= maxThreshold; });
+
+  std::sort(vec_residuals.begin(), admissibleEnd);
+  return std::distance(vec_residuals.begin(), admissibleEnd);
+}
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -138,6 +170,7 @@ inline ErrorIndex bestNFA(int startIndex, //number of point required for estimat
  * @param[in] nIter maximum number of consecutive iterations
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
+ * @param[in] useSPRT reject the hypotheses early with a SPRT against the inlier ratio of the best model so far
  *
  * @return (errorMax, minNFA)
  */
@@ -146,7 +179,8 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
                                    std::vector<size_t>& vec_inliers,
                                    std::size_t nIter = 1024,
                                    typename Kernel::ModelT* model = nullptr,
-                                   double precision = std::numeric_limits<double>::infinity())
+                                   double precision = std::numeric_limits<double>::infinity(),
+                                   bool useSPRT = false)
 {
   vec_inliers.clear();
 
@@ -181,6 +215,14 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  std::vector<std::size_t> vec_allSamples;
+  SPRT sprt(0.1, 0.01, 200.0, kernel.getMaximumNbModels());
+  if(useSPRT)
+  {
+    vec_allSamples.resize(nData);
+    std::iota(vec_allSamples.begin(), vec_allSamples.end(), 0);
+  }
+
   // Main estimation loop.
   for(std::size_t iter = 0; iter < nIter; ++iter)
   {
@@ -198,7 +240,20 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
     for (std::size_t k = 0; k < vec_models.size(); ++k)
     {
       // Residuals computation and ordering
-      kernel.errors(vec_models[k], vec_residuals_);
+      if(useSPRT && bACRansacMode && !vec_inliers.empty())
+      {
+        std::size_t nbTested, nbConsistent;
+        sprt.setEpsilon(vec_inliers.size() / static_cast<double>(nData));
+        if(!sprt.evaluate(kernel, vec_models[k], vec_allSamples, errorMax, vec_residuals_, nbTested, nbConsistent))
+        {
+          sprt.addRejected(nbTested, nbConsistent);
+          continue;
+        }
+      }
+      else
+      {
+        kernel.errors(vec_models[k], vec_residuals_);
+      }
 
       if (!bACRansacMode)
       {
@@ -213,12 +268,7 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
       }
       if (bACRansacMode)
       {
-        for (size_t i = 0; i < nData; ++i)
-        {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
-        }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
+        sortResidualsForNFA(vec_residuals_, maxThreshold, vec_residuals);
 
         // Most meaningful discrimination inliers/outliers
         const ErrorIndex best = bestNFA(
@@ -292,5 +342,262 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
   return std::make_pair(errorMax, minNFA);
 }
 
+/**
+ * @brief Parallel ACRANSAC routine (ErrorThreshold, NFA)
+ *
+ * The samples are drawn sequentially from the given random number generator
+ * by batches of \p batchSize iterations, then the hypotheses of a batch are
+ * fitted and scored concurrently. The batch results are merged in iteration
+ * order, so the output only depends on the generator seed and on the batch size,
+ * not on the number of threads. The focused sampling among the best inliers
+ * starts from the batch following the improvement. Only the residuals below
+ * a finite \p precision are sorted to compute the NFA, all of them otherwise.
+ *
+ * @param[in] kernel model and metric object
+ * @param[in,out] randomNumberGenerator random number generator used to draw the samples
+ * @param[out] vec_inliers points that fit the estimated model
+ * @param[in] nIter maximum number of consecutive iterations
+ * @param[out] model returned model if found
+ * @param[in] precision upper bound of the precision (squared error)
+ * @param[in] batchSize number of hypotheses evaluated concurrently
+ * @param[in] useSPRT reject the hypotheses early with a SPRT against the inlier ratio of the best model so far
+ *
+ * @return (errorMax, minNFA)
+ */
+template<typename Kernel>
+std::pair<double, double> ACRANSACParallel(const Kernel& kernel,
+                                           std::mt19937& randomNumberGenerator,
+                                           std::vector<size_t>& vec_inliers,
+                                           std::size_t nIter = 1024,
+                                           typename Kernel::ModelT* model = nullptr,
+                                           double precision = std::numeric_limits<double>::infinity(),
+                                           std::size_t batchSize = 64,
+                                           bool useSPRT = false)
+{
+  using ModelT = typename Kernel::ModelT;
+
+  /// score of one model of a hypothesis
+  struct ModelScore
+  {
+    ErrorIndex nfa{std::numeric_limits<double>::infinity(), 0};
+    double errorMax = std::numeric_limits<double>::infinity();
+    bool meaningful = false;
+    bool rejected = false;
+    std::size_t nbTested = 0;
+    std::size_t nbConsistent = 0;
+  };
+
+  vec_inliers.clear();
+
+  const std::size_t sizeSample = kernel.getMinimumNbRequiredSamples();
+  const std::size_t nData = kernel.nbSamples();
+  if (nData <= (std::size_t)sizeSample)
+    return std::make_pair(0.0,0.0);
+
+  batchSize = std::max<std::size_t>(batchSize, 1);
+
+  const double maxThreshold = (precision==std::numeric_limits<double>::infinity()) ?
+    std::numeric_limits<double>::infinity() :
+    precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
+
+  // Possible sampling indices [0,..,nData] (will change in the optimization phase)
+  std::vector<size_t> vec_index(nData);
+  std::iota(vec_index.begin(), vec_index.end(), 0);
+
+  // Precompute log combi
+  const double loge0 = log10((double)kernel.getMaximumNbModels() * (nData-sizeSample));
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+
+  // Output parameters
+  double minNFA = std::numeric_limits<double>::infinity();
+  double errorMax = std::numeric_limits<double>::infinity();
+
+  // Reserve 10% of iterations for focused sampling
+  size_t nIterReserve = nIter/10;
+  nIter -= nIterReserve;
+
+  bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
+
+  std::vector<std::vector<std::size_t>> batchSamples(batchSize);
+  std::vector<std::vector<ModelT>> batchModels(batchSize);
+  std::vector<std::vector<ModelScore>> batchScores(batchSize);
+
+  // buffers used to retrieve the inliers of a better model
+  std::vector<double> vec_residuals_(nData);
+  std::vector<ErrorIndex> vec_residuals(nData);
+
+  std::vector<std::size_t> vec_allSamples;
+  SPRT sprt(0.1, 0.01, 200.0, kernel.getMaximumNbModels());
+  if(useSPRT)
+  {
+    vec_allSamples.resize(nData);
+    std::iota(vec_allSamples.begin(), vec_allSamples.end(), 0);
+  }
+
+  std::size_t iter = 0;
+  bool earlyExit = false;
+
+  // Main estimation loop.
+  while(iter < nIter && !earlyExit)
+  {
+    const std::size_t nbHypotheses = std::min(batchSize, nIter - iter);
+    const bool batchACRansacMode = bACRansacMode;
+    const bool batchSPRT = useSPRT && bACRansacMode && !vec_inliers.empty();
+    const double batchErrorMax = errorMax;
+
+    if(batchSPRT)
+      sprt.setEpsilon(vec_inliers.size() / static_cast<double>(nData));
+
+    // draw the samples sequentially to keep the random sequence reproducible
+    for(std::size_t b = 0; b < nbHypotheses; ++b)
+    {
+      if(batchACRansacMode)
+        uniformSample(sizeSample, vec_index, batchSamples[b], randomNumberGenerator);
+      else
+        batchSamples[b] = randSample<std::size_t>(0, nData, sizeSample, randomNumberGenerator);
+    }
+
+    // fit and score the hypotheses of the batch concurrently
+    #pragma omp parallel if(!omp_in_parallel())
+    {
+      std::vector<double> threadErrors(nData);
+      std::vector<ErrorIndex> threadResiduals(nData);
+
+      #pragma omp for schedule(dynamic)
+      for(int b = 0; b < (int)nbHypotheses; ++b)
+      {
+        std::vector<ModelT>& models = batchModels[b];
+        std::vector<ModelScore>& scores = batchScores[b];
+
+        models.clear();
+        kernel.fit(batchSamples[b], models);
+        scores.assign(models.size(), ModelScore());
+
+        for(std::size_t k = 0; k < models.size(); ++k)
+        {
+          ModelScore& score = scores[k];
+
+          if(batchSPRT)
+          {
+            score.rejected = !sprt.evaluate(kernel, models[k], vec_allSamples, batchErrorMax, threadErrors,
+                                            score.nbTested, score.nbConsistent);
+            if(score.rejected)
+              continue;
+          }
+          else
+          {
+            kernel.errors(models[k], threadErrors);
+          }
+
+          if(!batchACRansacMode)
+          {
+            const std::size_t nInlier = std::count_if(threadErrors.begin(), threadErrors.end(),
+                                                      [maxThreshold](double e) { return e <= maxThreshold; });
+            score.meaningful = (nInlier > 2.5 * sizeSample);
+          }
+
+          sortResidualsForNFA(threadErrors, maxThreshold, threadResiduals);
+
+          // Most meaningful discrimination inliers/outliers
+          score.nfa = bestNFA(sizeSample,
+                              kernel.logalpha0(),
+                              threadResiduals,
+                              loge0,
+                              maxThreshold,
+                              vec_logc_n,
+                              vec_logc_k,
+                              kernel.multError());
+
+          if(score.nfa.first != std::numeric_limits<double>::infinity())
+            score.errorMax = threadResiduals[score.nfa.second - 1].first;
+        }
+      }
+    }
+
+    // merge the batch results in iteration order
+    for(std::size_t b = 0; b < nbHypotheses && iter < nIter; ++b, ++iter)
+    {
+      bool better = false;
+      for(std::size_t k = 0; k < batchModels[b].size(); ++k)
+      {
+        const ModelScore& score = batchScores[b][k];
+
+        if(score.rejected)
+        {
+          sprt.addRejected(score.nbTested, score.nbConsistent);
+          continue;
+        }
+
+        if(!bACRansacMode && score.meaningful)
+          bACRansacMode = true;
+
+        if(bACRansacMode && score.nfa.first < minNFA)
+        {
+          // A better model was found
+          better = true;
+          minNFA = score.nfa.first;
+          errorMax = score.errorMax; // Error threshold
+
+          kernel.errors(batchModels[b][k], vec_residuals_);
+          sortResidualsForNFA(vec_residuals_, maxThreshold, vec_residuals);
+          vec_inliers.resize(score.nfa.second);
+          for(size_t i = 0; i < score.nfa.second; ++i)
+            vec_inliers[i] = vec_residuals[i].second;
+          if(model) *model = batchModels[b][k];
+
+          ALICEVISION_LOG_TRACE("  nfa=" << minNFA
+            << " inliers=" << score.nfa.second << "/" << nData
+            << " precisionNormalized=" << errorMax
+            << " precision=" << kernel.unormalizeError(errorMax)
+            << " (iter=" << iter
+            << ",sample=" << batchSamples[b]
+            << ")");
+        }
+      }
+
+      // Early exit test -> no meaningful model found after nIterReserve*2 iterations
+      if (!bACRansacMode && iter > nIterReserve*2)
+      {
+        earlyExit = true;
+        break;
+      }
+
+      // ACRANSAC optimization: draw samples among best set of inliers so far
+      if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
+      {
+        if (vec_inliers.empty())
+        {
+          // No model found at all so far
+          ++nIter; // Continue to look for any model, even not meaningful
+          --nIterReserve;
+        }
+        else
+        {
+          // ACRANSAC optimization: draw samples among best set of inliers so far
+          vec_index = vec_inliers;
+          if(nIterReserve)
+          {
+            nIter = iter + 1 + nIterReserve;
+            nIterReserve = 0;
+          }
+        }
+      }
+    }
+  }
+
+  if(minNFA >= 0)
+    vec_inliers.clear();
+
+  if (!vec_inliers.empty())
+  {
+    if (model)
+      kernel.unnormalize(*model);
+    errorMax = kernel.unormalizeError(errorMax);
+  }
+
+  return std::make_pair(errorMax, minNFA);
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
@@ -11,6 +11,7 @@
 #include <aliceVision/robustEstimation/ransacTools.hpp>
 #include <aliceVision/robustEstimation/IRansacKernel.hpp>
 #include <limits>
+#include <random>
 #include <numeric>
 #include <iostream>
 #include <vector>
@@ -157,6 +158,7 @@ double iterativeReweightedLeastSquares(const Kernel &kernel,
  * 
  * @param[in] kernel The kernel used in the LORansac estimator.
  * @param[in] scorer The scorer used in the LORansac estimator.
+ * @param[in,out] randomNumberGenerator random number generator used to draw the samples
  * @param[in,out] best_model In input the model estimated by a minimum solver, as
  * output the best model found.
  * @param[out] bestInliers The inliers supporting the best model.
@@ -168,6 +170,7 @@ double iterativeReweightedLeastSquares(const Kernel &kernel,
 template<typename Kernel, typename Scorer>
 double localOptimization(const Kernel& kernel,
                          const Scorer& scorer,
+                         std::mt19937& randomNumberGenerator,
                          typename Kernel::ModelT& bestModel,
                          std::vector<std::size_t>& bestInliers,
                          double mtheta = std::sqrt(2),
@@ -235,7 +238,7 @@ double localOptimization(const Kernel& kernel,
   for(std::size_t i = 0; i < numRep; ++i)
   {
     std::vector<std::size_t> sample;
-    uniformSample(sampleSize, inliersBase, sample);
+    uniformSample(sampleSize, inliersBase, sample, randomNumberGenerator);
     assert(sampleSize > kernel.getMinimumNbRequiredSamplesLS());
     assert(sample.size() > kernel.getMinimumNbRequiredSamplesLS());
   
@@ -281,6 +284,7 @@ double localOptimization(const Kernel& kernel,
  * 
  * @param[in] kernel The kernel containing the problem to solve.
  * @param[in] scorer The scorer used to asses the model quality.
+ * @param[in,out] randomNumberGenerator random number generator used to draw the samples
  * @param[out] best_inliers The indices of the samples supporting the best model.
  * @param[out] best_score The score of the best model, ie the number of inliers
  * supporting the best model.
@@ -292,6 +296,7 @@ double localOptimization(const Kernel& kernel,
 template<typename Kernel, typename Scorer>
 typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
                                   const Scorer& scorer,
+                                  std::mt19937& randomNumberGenerator,
                                   std::vector<std::size_t>* best_inliers = NULL,
                                   double* best_score = NULL,
                                   bool bVerbose = false,
@@ -327,7 +332,7 @@ typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
   for(iteration = 0; iteration < max_iterations; ++iteration) 
   {
     std::vector<std::size_t> sample;
-    uniformSample(min_samples, total_samples, sample);
+    sample = randSample<std::size_t>(0, total_samples, min_samples, randomNumberGenerator);
 
     std::vector<typename Kernel::ModelT> models;
     kernel.fit(sample, models);
@@ -359,7 +364,7 @@ typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
         
         if(inliers.size() > kernel.getMinimumNbRequiredSamplesLS())
         {
-          score = localOptimization(kernel, scorer, bestModel, inliers);
+          score = localOptimization(kernel, scorer, randomNumberGenerator, bestModel, inliers);
         }
         
         if(bVerbose)
@@ -371,6 +376,7 @@ typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
         
         bestNumInliers = inliers.size();
         bestInlierRatio = inliers.size() / double(total_samples);
+        scorer.updateBestInlierRatio(bestInlierRatio);
 
         if (best_inliers) 
         {
@@ -407,5 +413,23 @@ typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
   return bestModel;  
 }
 
+/**
+ * @brief Implementation of the LORansac framework, drawing the samples with a randomly seeded generator.
+ * @see LO_RANSAC
+ */
+template<typename Kernel, typename Scorer>
+typename Kernel::ModelT LO_RANSAC(const Kernel& kernel,
+                                  const Scorer& scorer,
+                                  std::vector<std::size_t>* best_inliers = NULL,
+                                  double* best_score = NULL,
+                                  bool bVerbose = false,
+                                  std::size_t max_iterations = 100,
+                                  double outliers_probability = 1e-2)
+{
+  std::random_device rd;
+  std::mt19937 randomNumberGenerator(rd());
+  return LO_RANSAC(kernel, scorer, randomNumberGenerator, best_inliers, best_score, bVerbose, max_iterations, outliers_probability);
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
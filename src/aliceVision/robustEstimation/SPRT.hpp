@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation{
+
+/**
+ * @brief Sequential Probability Ratio Test used to reject bad hypotheses
+ * after the evaluation of a few residuals only.
+ *
+ * Each evaluated sample updates the likelihood ratio between the hypothesis
+ * "the model is bad" (a sample is consistent with probability delta) and
+ * "the model is good" (a sample is consistent with probability epsilon).
+ * The model is rejected as soon as the ratio exceeds the decision threshold.
+ * This implementation follows:
+ *
+ * Ondrej Chum, Jiri Matas:
+ * Optimal Randomized RANSAC. IEEE TPAMI 30(8): 1472-1482 (2008)
+ */
+class SPRT
+{
+public:
+
+  /**
+   * @brief SPRT constructor
+   * @param[in] epsilon The probability of a sample to be consistent with a good model
+   * @param[in] delta The probability of a sample to be consistent with a bad model
+   * @param[in] timeModelEstimation The time needed to estimate a model, in number of sample evaluations
+   * @param[in] nbModelsPerSample The average number of models returned by the minimal solver
+   */
+  explicit SPRT(double epsilon = 0.1,
+                double delta = 0.01,
+                double timeModelEstimation = 200.0,
+                double nbModelsPerSample = 1.0)
+    : _epsilon(epsilon)
+    , _delta(delta)
+    , _timeModelEstimation(timeModelEstimation)
+    , _nbModelsPerSample(nbModelsPerSample)
+  {
+    updateDecisionThreshold();
+  }
+
+  /**
+   * @brief Evaluate a model and stop as soon as it is considered as bad.
+   * @param[in] kernel The kernel used to compute the error of each sample
+   * @param[in] model The model to evaluate
+   * @param[in] samples The indices of the samples to evaluate
+   * @param[in] threshold The error threshold of a consistent sample
+   * @param[out] errors The error of each evaluated sample (complete if the model is accepted)
+   * @param[out] nbTested The number of evaluated samples
+   * @param[out] nbConsistent The number of consistent samples among the evaluated ones
+   * @return true if the model is accepted
+   */
+  template<typename Kernel, typename T>
+  bool evaluate(const Kernel& kernel,
+                const typename Kernel::ModelT& model,
+                const std::vector<T>& samples,
+                double threshold,
+                std::vector<double>& errors,
+                std::size_t& nbTested,
+                std::size_t& nbConsistent) const
+  {
+    const std::size_t nbSamples = samples.size();
+    errors.resize(nbSamples);
+    nbConsistent = 0;
+
+    // visit the samples with a stride coprime with their number, to avoid
+    // evaluating a sorted or spatially coherent subset of the data first
+    const std::size_t stride = getCoprimeStride(nbSamples);
+
+    double lambda = 1.0;
+    for(std::size_t i = 0, j = 0; i < nbSamples; ++i, j = (j + stride) % nbSamples)
+    {
+      errors[j] = kernel.error(samples[j], model);
+
+      if(errors[j] <= threshold)
+      {
+        lambda *= _lambdaConsistent;
+        ++nbConsistent;
+      }
+      else
+      {
+        lambda *= _lambdaInconsistent;
+      }
+
+      if(_enabled && lambda > _decisionThreshold)
+      {
+        nbTested = i + 1;
+        return false;
+      }
+    }
+    nbTested = nbSamples;
+    return true;
+  }
+
+  /**
+   * @brief Update the probability of consistency of a good model,
+   * typically with the inlier ratio of the best model so far.
+   * @param[in] epsilon The new probability
+   */
+  void setEpsilon(double epsilon)
+  {
+    if(epsilon == _epsilon)
+      return;
+    _epsilon = epsilon;
+    updateDecisionThreshold();
+  }
+
+  /**
+   * @brief Update the estimation of delta with the result of a rejected model.
+   * The decision threshold is only recomputed on significant changes.
+   * @param[in] nbTested The number of samples evaluated before the rejection
+   * @param[in] nbConsistent The number of consistent samples among them
+   */
+  void addRejected(std::size_t nbTested, std::size_t nbConsistent)
+  {
+    if(nbTested == 0)
+      return;
+
+    ++_nbRejected;
+    _deltaSum += nbConsistent / static_cast<double>(nbTested);
+
+    const double deltaEstimate = std::max(_deltaSum / _nbRejected, 1e-4);
+    if(std::abs(deltaEstimate - _delta) > 0.05 * _delta)
+    {
+      _delta = deltaEstimate;
+      updateDecisionThreshold();
+    }
+  }
+
+  double getEpsilon() const { return _epsilon; }
+  double getDelta() const { return _delta; }
+  double getDecisionThreshold() const { return _decisionThreshold; }
+
+private:
+
+  /**
+   * @brief Get a stride close to the golden ratio of n and coprime with n,
+   * so that (j + stride) % n visits every index once.
+   */
+  static std::size_t getCoprimeStride(std::size_t n)
+  {
+    if(n < 3)
+      return 1;
+    std::size_t stride = static_cast<std::size_t>(0.618 * n);
+    while(gcd(stride, n) != 1)
+      --stride;
+    return stride;
+  }
+
+  static std::size_t gcd(std::size_t a, std::size_t b)
+  {
+    while(b != 0)
+    {
+      const std::size_t t = a % b;
+      a = b;
+      b = t;
+    }
+    return a;
+  }
+
+  /**
+   * @brief Compute the likelihood ratio factors and the optimal decision threshold A
+   * as the fixed point of A = K1 / K2 + 1 + log(A).
+   */
+  void updateDecisionThreshold()
+  {
+    // the test is meaningless if a bad model is as consistent as a good one
+    _enabled = (_delta > 0.0 && _epsilon < 1.0 && _delta < _epsilon);
+    if(!_enabled)
+    {
+      _lambdaConsistent = 1.0;
+      _lambdaInconsistent = 1.0;
+      return;
+    }
+
+    _lambdaConsistent = _delta / _epsilon;
+    _lambdaInconsistent = (1.0 - _delta) / (1.0 - _epsilon);
+
+    const double C = (1.0 - _delta) * std::log((1.0 - _delta) / (1.0 - _epsilon)) +
+                     _delta * std::log(_delta / _epsilon);
+    const double K = _timeModelEstimation * C / _nbModelsPerSample + 1.0;
+
+    double A = K;
+    for(int i = 0; i < 10; ++i)
+      A = K + std::log(A);
+    _decisionThreshold = A;
+  }
+
+  double _epsilon;
+  double _delta;
+  double _timeModelEstimation;
+  double _nbModelsPerSample;
+
+  bool _enabled = false;
+  double _lambdaConsistent = 1.0;
+  double _lambdaInconsistent = 1.0;
+  double _decisionThreshold = 1.0;
+
+  std::size_t _nbRejected = 0;
+  double _deltaSum = 0.0;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
@@ -7,6 +7,11 @@
 
 #pragma once
 
+#include <aliceVision/robustEstimation/SPRT.hpp>
+
+#include <limits>
+#include <vector>
+
 namespace aliceVision {
 namespace robustEstimation{
 
@@ -58,10 +63,79 @@ public:
   }
   
   double getThreshold() const {return _threshold;}
+
+  /**
+   * @brief Called by the estimator with the inlier ratio of each new best model.
+   * Nothing to do for the exhaustive scoring.
+   */
+  void updateBestInlierRatio(double /*inlierRatio*/) const {}
   
 private:
   double _threshold;
 };
 
+/**
+ * @brief Templated Functor class to evaluate a given model over a set of samples,
+ * rejecting bad models early with a Sequential Probability Ratio Test.
+ *
+ * Only the scoring of the hypotheses (without explicit threshold) uses the SPRT,
+ * the scoring with an explicit threshold used by the local optimization is exhaustive.
+ * The expected inlier ratio of a good model is the one of the best model so far,
+ * given by the estimator with updateBestInlierRatio.
+ * A rejected model has no inliers and an infinite score.
+ */
+template<typename Kernel>
+class ScoreEvaluatorSPRT : public ScoreEvaluator<Kernel>
+{
+public:
+  explicit ScoreEvaluatorSPRT(double threshold, const SPRT& sprt = SPRT())
+    : ScoreEvaluator<Kernel>(threshold)
+    , _sprt(sprt)
+  {}
+
+  /// exhaustive scoring used by the local optimization
+  using ScoreEvaluator<Kernel>::score;
+
+  template <typename T>
+  double score(const Kernel &kernel,
+               const typename Kernel::ModelT& model,
+               const std::vector<T>& samples,
+               std::vector<T>& inliers) const
+  {
+    const double threshold = this->getThreshold();
+    std::size_t nbTested = 0;
+    std::size_t nbConsistent = 0;
+
+    if(!_sprt.evaluate(kernel, model, samples, threshold, _errors, nbTested, nbConsistent))
+    {
+      _sprt.addRejected(nbTested, nbConsistent);
+      return std::numeric_limits<double>::infinity();
+    }
+
+    // same inlier test as ScoreEvaluator::score, used by the local optimization
+    double cost = 0.0;
+    for(std::size_t j = 0; j < samples.size(); ++j)
+    {
+      cost += _errors[j];
+      if(_errors[j] < threshold)
+        inliers.push_back(samples[j]);
+    }
+    return cost;
+  }
+
+  /// a good model is at least as consistent as the best one so far
+  void updateBestInlierRatio(double inlierRatio) const
+  {
+    if(inlierRatio > _sprt.getEpsilon())
+      _sprt.setEpsilon(inlierRatio);
+  }
+
+  const SPRT& getSPRT() const {return _sprt;}
+
+private:
+  mutable SPRT _sprt;
+  mutable std::vector<double> _errors;
+};
+
 } // namespace robustEstimation
 } // namespace aliceVision
@@ -269,3 +269,75 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// test the parallel ACRANSAC on a contaminated line and check that
+// two runs with the same seed give the same result.
+BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACParallel)
+{
+  const int S = 100;
+  const int W = S, H = S;
+  const float outlierRatio = .3f;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, outlierRatio, 0.5, GTModel, gen, points, vec_inliersGT);
+
+  LineKernel lineKernel(points, W, H);
+
+  std::vector<std::size_t> vec_inliersA;
+  robustEstimation::MatrixModel<Vec2> modelA;
+  std::mt19937 genA(42);
+  const std::pair<double,double> retA = ACRANSACParallel(lineKernel, genA, vec_inliersA, 1000, &modelA);
+
+  std::vector<std::size_t> vec_inliersB;
+  robustEstimation::MatrixModel<Vec2> modelB;
+  std::mt19937 genB(42);
+  const std::pair<double,double> retB = ACRANSACParallel(lineKernel, genB, vec_inliersB, 1000, &modelB);
+
+  BOOST_CHECK(!vec_inliersA.empty());
+  BOOST_CHECK(vec_inliersA.size() <= vec_inliersGT.size());
+  BOOST_CHECK_EQUAL(retA.first, retB.first);
+  BOOST_CHECK_EQUAL(retA.second, retB.second);
+  BOOST_CHECK(vec_inliersA == vec_inliersB);
+  BOOST_CHECK_SMALL(modelA.getMatrix()[1] - modelB.getMatrix()[1], 1e-12);
+}
+
+// test the early rejection of the hypotheses with a SPRT in ACRANSAC
+BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSPRT)
+{
+  const int S = 100;
+  const int W = S, H = S;
+  const float outlierRatio = .3f;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, outlierRatio, 0.5, GTModel, gen, points, vec_inliersGT);
+
+  LineKernel lineKernel(points, W, H);
+
+  std::vector<std::size_t> vec_inliers;
+  robustEstimation::MatrixModel<Vec2> model;
+  ACRANSAC(lineKernel, vec_inliers, 1000, &model, std::numeric_limits<double>::infinity(), true);
+
+  BOOST_CHECK(!vec_inliers.empty());
+  BOOST_CHECK(vec_inliers.size() <= vec_inliersGT.size());
+  BOOST_CHECK_SMALL(GTModel(1) - model.getMatrix()[1], 0.05);
+
+  std::vector<std::size_t> vec_inliersParallel;
+  std::mt19937 genParallel(42);
+  ACRANSACParallel(lineKernel, genParallel, vec_inliersParallel, 1000, &model, std::numeric_limits<double>::infinity(), 64, true);
+
+  BOOST_CHECK(!vec_inliersParallel.empty());
+  BOOST_CHECK(vec_inliersParallel.size() <= vec_inliersGT.size());
+  BOOST_CHECK_SMALL(GTModel(1) - model.getMatrix()[1], 0.05);
+}
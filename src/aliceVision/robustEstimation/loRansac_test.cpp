@@ -114,3 +114,38 @@ BOOST_AUTO_TEST_CASE(LoRansacLineFitter_RealCaseLoRansac)
     BOOST_CHECK_EQUAL(expectedInliers, inliers.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(LoRansacLineFitter_RealCaseLoRansacSPRT)
+{
+  const std::size_t numPoints = 300;
+  const double outlierRatio = .3;
+  const double gaussianNoiseLevel = 0.01;
+  const std::size_t numTrials = 10;
+  // the noisy inliers close to the threshold may be missed
+  const int inliersTolerance = numPoints / 100;
+
+  Vec2 GTModel; // y = 2x + 1
+  GTModel << -2, .3;
+
+  // fixed seeds for the data and for the sampling, so the test is deterministic
+  std::mt19937 gen(5489);
+  std::mt19937 randomNumberGenerator(42);
+
+  for(std::size_t trial = 0; trial < numTrials; ++trial)
+  {
+    Mat2X xy(2, numPoints);
+    vector<std::size_t> vec_inliersGT;
+    generateLine(numPoints, outlierRatio, gaussianNoiseLevel, GTModel, gen, xy, vec_inliersGT);
+
+    LineKernel kernel(xy);
+    const ScoreEvaluatorSPRT<LineKernel> scorer(3 * gaussianNoiseLevel);
+    std::vector<std::size_t> inliers;
+    const LineKernel::ModelT model = LO_RANSAC(kernel, scorer, randomNumberGenerator, &inliers);
+
+    const std::size_t expectedInliers = numPoints - (std::size_t) numPoints * outlierRatio;
+    BOOST_CHECK_LE(std::abs(static_cast<int>(inliers.size()) - static_cast<int>(expectedInliers)), inliersTolerance);
+    BOOST_CHECK_SMALL(GTModel[1] - model.getMatrix()[1], 1e-2);
+    // the good model has been accepted and set the expected inlier ratio
+    BOOST_CHECK_CLOSE(scorer.getSPRT().getEpsilon(), inliers.size() / double(numPoints), 1e-6);
+  }
+}
@@ -37,7 +37,23 @@ namespace robustEstimation{
 template<typename IntT>
 inline std::vector<IntT> randSample(IntT lowerBound,
                                     IntT upperBound,
-                                    IntT numSamples)
+                                    IntT numSamples);
+
+/**
+ * @brief Same as randSample() but using the given random number generator,
+ * so that the produced sequence is reproducible for a fixed seed.
+ *
+ * @param[in] lowerBound The lower bound of the range.
+ * @param[in] upperBound The upper bound of the range (not included).
+ * @param[in] numSamples Number of unique samples to draw.
+ * @param[in,out] generator The random number generator.
+ * @return samples The vector containing the samples.
+ */
+template<typename IntT>
+inline std::vector<IntT> randSample(IntT lowerBound,
+                                    IntT upperBound,
+                                    IntT numSamples,
+                                    std::mt19937& generator)
 {
   const auto rangeSize = upperBound - lowerBound;
   
@@ -45,10 +61,6 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   assert(numSamples <= rangeSize);
   static_assert(std::is_integral<IntT>::value, "Only integer types are supported");
 
-  
-  std::random_device rd;
-  std::mt19937 generator(rd());
-
   if(numSamples * 1.5 > rangeSize)
   {
     // if the number of required samples is a large fraction of the range size
@@ -82,6 +94,16 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   }
 }
 
+template<typename IntT>
+inline std::vector<IntT> randSample(IntT lowerBound,
+                                    IntT upperBound,
+                                    IntT numSamples)
+{
+  std::random_device rd;
+  std::mt19937 generator(rd());
+  return randSample<IntT>(lowerBound, upperBound, numSamples, generator);
+}
+
 /**
 * @brief Pick a random subset of the integers in the range [0, upperBound).
 *
@@ -157,5 +179,27 @@ inline void uniformSample(std::size_t sampleSize,
   }
 }
 
+/**
+ * @brief Generate a random sequence containing a sampling without replacement of
+ * of the elements of the input vector, using the given random number generator.
+ *
+ * @param[in] sampleSize The size of the sample to generate.
+ * @param[in] elements The possible data indices.
+ * @param[out] sample The random sample of sizeSample indices.
+ * @param[in,out] generator The random number generator.
+ */
+inline void uniformSample(std::size_t sampleSize,
+                          const std::vector<std::size_t>& elements,
+                          std::vector<std::size_t>& sample,
+                          std::mt19937& generator)
+{
+  sample = randSample<std::size_t>(0, elements.size(), sampleSize, generator);
+  assert(sample.size() == sampleSize);
+  for(auto& s : sample)
+  {
+    s = elements[ s ];
+  }
+}
+
 } // namespace robustEstimation
 } // namespace aliceVision
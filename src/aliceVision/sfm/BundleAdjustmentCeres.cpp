@@ -7,17 +7,20 @@
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/sfm/ResidualErrorConstraintFunctor.hpp>
 #include <aliceVision/sfm/ResidualErrorRotationPriorFunctor.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/camera/Equidistant.hpp>
+#include <aliceVision/system/Timer.hpp>
 
 #include <boost/filesystem.hpp>
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
 #include <fstream>
 
 
@@ -34,10 +37,26 @@ using namespace aliceVision::geometry;
  * @brief Create the appropriate cost functor according the provided input camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] useAnalyticDerivatives Use the cost functions with analytic derivatives when available
  * @return cost functor
  */
-ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation)
+ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const sfmData::Observation& observation, bool useAnalyticDerivatives)
 {
+  if(useAnalyticDerivatives)
+  {
+    switch(intrinsicPtr->getType())
+    {
+      case EINTRINSIC::PINHOLE_CAMERA:
+        return new ResidualErrorCostFunction_Pinhole(observation);
+      case EINTRINSIC::PINHOLE_CAMERA_RADIAL3:
+        return new ResidualErrorCostFunction_PinholeRadialK3(observation);
+      case EINTRINSIC::EQUIDISTANT_CAMERA:
+        return new ResidualErrorCostFunction_Equidistant(observation, getEquidistantRadiusCoefficient(dynamic_cast<const EquiDistant&>(*intrinsicPtr)));
+      default:
+        break;
+    }
+  }
+
   switch(intrinsicPtr->getType())
   {
     case EINTRINSIC::PINHOLE_CAMERA:
@@ -52,6 +71,8 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intri
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 3>(new ResidualErrorFunctor_PinholeFisheye(observation));
     case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 3>(new ResidualErrorFunctor_PinholeFisheye1(observation));
+    case EINTRINSIC::EQUIDISTANT_CAMERA:
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Equidistant, 2, 3, 6, 3>(new ResidualErrorFunctor_Equidistant(observation, getEquidistantRadiusCoefficient(dynamic_cast<const EquiDistant&>(*intrinsicPtr))));
     default:
       throw std::logic_error("Cannot create cost function, unrecognized intrinsic type in BA.");
   }
@@ -79,6 +100,8 @@ ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* in
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 6, 3>(new ResidualErrorFunctor_PinholeFisheye(observation));
     case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 6, 3>(new ResidualErrorFunctor_PinholeFisheye1(observation));
+    case EINTRINSIC::EQUIDISTANT_CAMERA:
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Equidistant, 2, 3, 6, 6, 3>(new ResidualErrorFunctor_Equidistant(observation, getEquidistantRadiusCoefficient(dynamic_cast<const EquiDistant&>(*intrinsicPtr))));
     default:
       throw std::logic_error("Cannot create rig cost function, unrecognized intrinsic type in BA.");
   }
@@ -117,6 +140,63 @@ ceres::CostFunction* createConstraintsCostFunctionFromIntrinsics(const Intrinsic
   } 
 }
 
+/**
+ * @brief Count the number of reconstructed views per intrinsic
+ * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+ * @return the number of reconstructed views of each intrinsic referenced by a view
+ */
+std::map<IndexT, std::size_t> computeIntrinsicsUsage(const sfmData::SfMData& sfmData)
+{
+  std::map<IndexT, std::size_t> intrinsicsUsage;
+
+  for(const auto& viewPair: sfmData.getViews())
+  {
+    const sfmData::View& view = *(viewPair.second);
+
+    if(intrinsicsUsage.find(view.getIntrinsicId()) == intrinsicsUsage.end())
+      intrinsicsUsage[view.getIntrinsicId()] = 0;
+
+    if(sfmData.isPoseAndIntrinsicDefined(&view))
+      ++intrinsicsUsage.at(view.getIntrinsicId());
+  }
+  return intrinsicsUsage;
+}
+
+/**
+ * @brief Get the indices of the intrinsic parameters that are not refined
+ * @param[in] intrinsic The intrinsic
+ * @param[in] usageCount The number of reconstructed views using the intrinsic
+ * @param[in] refineOptions The chosen refine flag
+ * @return the indices of the constant parameters
+ */
+std::vector<int> getIntrinsicConstantParams(const IntrinsicBase& intrinsic, std::size_t usageCount, BundleAdjustment::ERefineOptions refineOptions)
+{
+  const bool refineIntrinsicsOpticalCenter = (refineOptions & BundleAdjustment::REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) || (refineOptions & BundleAdjustment::REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA);
+  const bool refineIntrinsicsFocalLength = refineOptions & BundleAdjustment::REFINE_INTRINSICS_FOCAL;
+  const bool refineIntrinsicsDistortion = refineOptions & BundleAdjustment::REFINE_INTRINSICS_DISTORTION;
+  const std::size_t minImagesForOpticalCenter = 3;
+  const std::size_t nbParams = intrinsic.getParams().size();
+
+  std::vector<int> constantParams;
+
+  // focal length
+  if(!refineIntrinsicsFocalLength)
+    constantParams.push_back(0);
+
+  // optical center
+  if(!refineIntrinsicsOpticalCenter || (usageCount <= minImagesForOpticalCenter))
+  {
+    constantParams.push_back(1);
+    constantParams.push_back(2);
+  }
+
+  // lens distortion
+  if(!refineIntrinsicsDistortion)
+    for(std::size_t i = 3; i < nbParams; ++i)
+      constantParams.push_back(i);
+
+  return constantParams;
+}
 void BundleAdjustmentCeres::CeresOptions::setDenseBA()
 {
   // default configuration use a DENSE representation
@@ -257,6 +337,7 @@ void BundleAdjustmentCeres::Statistics::show() const
 
   ALICEVISION_LOG_INFO("Bundle Adjustment Statistics:\n"
                         << ss.str()
+                        << "\t- problem creation duration: " << timeProblemCreation << " s\n"
                         << "\t- adjustment duration: " << time << " s\n"
                         << "\t- poses:\n"
                         << "\t    - # refined:  " << states[EParameter::POSE][EParameterState::REFINED]  << "\n"
@@ -270,6 +351,7 @@ void BundleAdjustmentCeres::Statistics::show() const
                         << "\t    - # refined:  " << states[EParameter::INTRINSIC][EParameterState::REFINED]  << "\n"
                         << "\t    - # constant: " << states[EParameter::INTRINSIC][EParameterState::CONSTANT] << "\n"
                         << "\t    - # ignored:  " << states[EParameter::INTRINSIC][EParameterState::IGNORED]  << "\n"
+                        << "\t- # landmarks built: " << nbLandmarksBuilt << "\n"
                         << "\t- # residual blocks: " << nbResidualBlocks << "\n"
                         << "\t- # successful iterations: " << nbSuccessfullIterations   << "\n"
                         << "\t- # unsuccessful iterations: " << nbUnsuccessfullIterations << "\n"
@@ -318,6 +400,7 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     poseBlock.at(4) = t(1);
     poseBlock.at(5) = t(2);
 
+    // note: adding an already existing parameter block is ignored by Ceres
     double* poseBlockPtr = poseBlock.data();
     problem.AddParameterBlock(poseBlockPtr, 6);
 
@@ -329,10 +412,12 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     {
       // set the whole parameter block as constant.
       _statistics.addState(EParameter::POSE, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(poseBlockPtr);
+      setParameterBlockConstant(poseBlockPtr, true, problem);
       return;
     }
 
+    setParameterBlockConstant(poseBlockPtr, false, problem);
+
     // constant parameters
     std::vector<int> constantExtrinsic;
 
@@ -352,8 +437,8 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
       constantExtrinsic.push_back(5);
     }
 
-    // subset parametrization
-    if(!constantExtrinsic.empty())
+    // subset parametrization (only depends on the refine options, set once per block)
+    if(!constantExtrinsic.empty() && _parameterizedBlocks.insert(poseBlockPtr).second)
     {
       ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(6, constantExtrinsic);
       problem.SetParameterization(poseBlockPtr, subsetParameterization);
@@ -408,19 +493,8 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
   const bool refineIntrinsicsDistortion = refineOptions & REFINE_INTRINSICS_DISTORTION;
   const bool refineIntrinsics = refineIntrinsicsDistortion || refineIntrinsicsFocalLength || refineIntrinsicsOpticalCenter;
 
-  std::map<IndexT, std::size_t> intrinsicsUsage;
-
   // count the number of reconstructed views per intrinsic
-  for(const auto& viewPair: sfmData.getViews())
-  {
-    const sfmData::View& view = *(viewPair.second);
-
-    if(intrinsicsUsage.find(view.getIntrinsicId()) == intrinsicsUsage.end())
-      intrinsicsUsage[view.getIntrinsicId()] = 0;
-
-    if(sfmData.isPoseAndIntrinsicDefined(&view))
-      ++intrinsicsUsage.at(view.getIntrinsicId());
-  }
+  const std::map<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfmData);
 
   for(const auto& intrinsicPair: sfmData.getIntrinsics())
   {
@@ -441,8 +515,18 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
 
     assert(isValid(intrinsicPtr->getType()));
 
+    // note: the block memory is kept if the block already exists in the problem
     std::vector<double>& intrinsicBlock = _intrinsicsBlocks[intrinsicId];
-    intrinsicBlock = intrinsicPtr->getParams();
+    const std::vector<double> params = intrinsicPtr->getParams();
+    if(intrinsicBlock.empty())
+    {
+      intrinsicBlock = params;
+    }
+    else
+    {
+      assert(intrinsicBlock.size() == params.size());
+      std::copy(params.begin(), params.end(), intrinsicBlock.begin());
+    }
 
     double* intrinsicBlockPtr = intrinsicBlock.data();
     problem.AddParameterBlock(intrinsicBlockPtr, intrinsicBlock.size());
@@ -455,15 +539,20 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     {
       // set the whole parameter block as constant.
       _statistics.addState(EParameter::INTRINSIC, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(intrinsicBlockPtr);
+      setParameterBlockConstant(intrinsicBlockPtr, true, problem);
       continue;
     }
 
+    setParameterBlockConstant(intrinsicBlockPtr, false, problem);
+
     // constant parameters
-    std::vector<int> constantIntrinisc;
+    const std::vector<int> constantIntrinisc = getIntrinsicConstantParams(*intrinsicPtr, usageCount, refineOptions);
+    const auto isRefinedParam = [&](int index) {
+      return std::find(constantIntrinisc.begin(), constantIntrinisc.end(), index) == constantIntrinisc.end();
+    };
 
     // refine the focal length
-    if(refineIntrinsicsFocalLength)
+    if(isRefinedParam(0))
     {
       std::shared_ptr<camera::IntrinsicsScaleOffset> intrinsicScaleOffset = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffset>(intrinsicPtr);
       if(intrinsicScaleOffset->initialScale() > 0)
@@ -481,16 +570,9 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
         problem.SetParameterLowerBound(intrinsicBlockPtr, 0, 0.0);
       }
     }
-    else
-    {
-      // set focal length as constant
-      constantIntrinisc.push_back(0);
-    }
-
-    const std::size_t minImagesForOpticalCenter = 3;
 
     // optical center
-    if(refineIntrinsicsOpticalCenter && (usageCount > minImagesForOpticalCenter))
+    if(isRefinedParam(1))
     {
       // refine optical center within 10% of the image size.
       assert(intrinsicBlock.size() >= 3);
@@ -504,22 +586,13 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       problem.SetParameterLowerBound(intrinsicBlockPtr, 2, opticalCenterMinPercent * intrinsicPtr->h());
       problem.SetParameterUpperBound(intrinsicBlockPtr, 2, opticalCenterMaxPercent * intrinsicPtr->h());
     }
-    else
-    {
-      // don't refine the optical center
-      constantIntrinisc.push_back(1);
-      constantIntrinisc.push_back(2);
-    }
-
-    // lens distortion
-    if(!refineIntrinsicsDistortion)
-      for(std::size_t i = 3; i < intrinsicBlock.size(); ++i)
-        constantIntrinisc.push_back(i);
 
-    if(!constantIntrinisc.empty())
+    // subset parametrization (cannot be changed once set, see updateProblem)
+    if(!constantIntrinisc.empty() && _parameterizedBlocks.insert(intrinsicBlockPtr).second)
     {
       ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(intrinsicBlock.size(), constantIntrinisc);
       problem.SetParameterization(intrinsicBlockPtr, subsetParameterization);
+      _intrinsicsConstantParams[intrinsicId] = constantIntrinisc;
     }
 
     _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
@@ -534,7 +607,9 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
   // note: set it to NULL if you don't want use a lossFunction.
   ceres::LossFunction* lossFunction = _ceresOptions.lossFunction.get();
 
-  // build the residual blocks corresponding to the track observations
+  // landmarks without residual blocks in the problem
+  std::vector<const sfmData::Landmarks::value_type*> newLandmarks;
+
   for(const auto& landmarkPair: sfmData.getLandmarks())
   {
     const IndexT landmarkId = landmarkPair.first;
@@ -548,6 +623,9 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       continue;
     }
 
+    if(landmark.observations.empty())
+      continue;
+
     std::array<double,3>& landmarkBlock = _landmarksBlocks[landmarkId];
     for(std::size_t i = 0; i < 3; ++i)
       landmarkBlock.at(i) = landmark.X(Eigen::Index(i));
@@ -557,6 +635,71 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
     // add landmark parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(landmarkBlockPtr);
 
+    if(_landmarksObservations.count(landmarkId))
+    {
+      // the residual blocks already exist (persistent problem), only update the landmark state
+      const bool isConstant = (!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT);
+      setParameterBlockConstant(landmarkBlockPtr, isConstant, problem);
+      for(std::size_t i = 0; i < landmark.observations.size(); ++i)
+        _statistics.addState(EParameter::LANDMARK, isConstant ? EParameterState::CONSTANT : EParameterState::REFINED);
+      continue;
+    }
+
+    newLandmarks.push_back(&landmarkPair);
+  }
+
+  // create the cost functions of the new landmarks in parallel,
+  // the residual blocks are then added to the problem sequentially
+  std::vector<std::vector<ceres::CostFunction*>> costFunctions(newLandmarks.size());
+  bool unrecognizedIntrinsic = false;
+
+  #pragma omp parallel for
+  for(int i = 0; i < newLandmarks.size(); ++i)
+  {
+    const sfmData::Landmark& landmark = newLandmarks.at(i)->second;
+    std::vector<ceres::CostFunction*>& landmarkCostFunctions = costFunctions.at(i);
+    landmarkCostFunctions.reserve(landmark.observations.size());
+
+    try
+    {
+      for(const auto& observationPair: landmark.observations)
+      {
+        const sfmData::View& view = sfmData.getView(observationPair.first);
+        const IntrinsicBase* intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+
+        if(view.isPartOfRig() && !view.isPoseIndependant())
+          landmarkCostFunctions.push_back(createRigCostFunctionFromIntrinsics(intrinsicPtr, observationPair.second));
+        else
+          landmarkCostFunctions.push_back(createCostFunctionFromIntrinsics(intrinsicPtr, observationPair.second, _ceresOptions.useAnalyticDerivatives));
+      }
+    }
+    catch(const std::logic_error& e)
+    {
+      #pragma omp critical
+      {
+        ALICEVISION_LOG_ERROR(e.what());
+        unrecognizedIntrinsic = true;
+      }
+    }
+  }
+
+  if(unrecognizedIntrinsic)
+  {
+    for(const auto& landmarkCostFunctions : costFunctions)
+      for(ceres::CostFunction* costFunction : landmarkCostFunctions)
+        delete costFunction;
+    throw std::logic_error("Cannot create cost function, unrecognized intrinsic type in BA.");
+  }
+
+  // build the residual blocks corresponding to the track observations
+  for(std::size_t i = 0; i < newLandmarks.size(); ++i)
+  {
+    const IndexT landmarkId = newLandmarks.at(i)->first;
+    const sfmData::Landmark& landmark = newLandmarks.at(i)->second;
+    double* landmarkBlockPtr = _landmarksBlocks.at(landmarkId).data();
+    std::vector<std::pair<IndexT, const sfmData::Observation*>>& landmarkObservations = _landmarksObservations[landmarkId];
+    std::size_t costFunctionIndex = 0;
+
     // iterate over 2D observation associated to the 3D landmark
     for(const auto& observationPair: landmark.observations)
     {
@@ -582,10 +725,10 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
         _ceresOptions.linearSolverOrdering.AddElementToGroup(intrinsicBlockPtr, 2);
       }
 
+      ceres::CostFunction* costFunction = costFunctions.at(i).at(costFunctionIndex++);
+
       if(view.isPartOfRig() && !view.isPoseIndependant())
       {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
-
         problem.AddResidualBlock(costFunction,
             lossFunction,
             intrinsicBlockPtr,
@@ -595,8 +738,6 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       }
       else
       {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
-
         problem.AddResidualBlock(costFunction,
             lossFunction,
             intrinsicBlockPtr,
@@ -604,11 +745,13 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
             landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
       }
 
+      landmarkObservations.emplace_back(observationPair.first, &observation);
+
       if(!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT)
       {
         // set the whole landmark parameter block as constant.
         _statistics.addState(EParameter::LANDMARK, EParameterState::CONSTANT);
-        problem.SetParameterBlockConstant(landmarkBlockPtr);
+        setParameterBlockConstant(landmarkBlockPtr, true, problem);
       }
       else
       {
@@ -616,6 +759,8 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       }
     }
   }
+
+  _statistics.nbLandmarksBuilt += newLandmarks.size();
 }
 
 void BundleAdjustmentCeres::addConstraints2DToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem)
@@ -644,7 +789,7 @@ void BundleAdjustmentCeres::addConstraints2DToProblem(const sfmData::SfMData& sf
 
 
     ceres::CostFunction* costFunction = createConstraintsCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view_1.getIntrinsicId()), constraint.ObservationFirst.x, constraint.ObservationSecond.x);
-    problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2);
+    _otherResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2));
   }
 }
 
@@ -666,7 +811,7 @@ void BundleAdjustmentCeres::addRotationPriorsToProblem(const sfmData::SfMData& s
 
 
     ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<ResidualErrorRotationPriorFunctor, 3, 6, 6>(new ResidualErrorRotationPriorFunctor(prior._second_R_first));
-    problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2);
+    _otherResidualBlocks.push_back(problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2));
   }
 }
 
@@ -697,6 +842,132 @@ void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
   addRotationPriorsToProblem(sfmData, refineOptions, problem);
 }
 
+bool BundleAdjustmentCeres::updateProblem(const sfmData::SfMData& sfmData,
+                                          ERefineOptions refineOptions,
+                                          ceres::Problem& problem)
+{
+  const std::map<IndexT, std::size_t> intrinsicsUsage = computeIntrinsicsUsage(sfmData);
+
+  const auto isPoseKept = [&](IndexT poseId) {
+    return sfmData.getPoses().count(poseId) && getPoseState(poseId) != EParameterState::IGNORED;
+  };
+
+  const auto isIntrinsicKept = [&](IndexT intrinsicId) {
+    const auto usageIt = intrinsicsUsage.find(intrinsicId);
+    return sfmData.getIntrinsics().count(intrinsicId) &&
+           usageIt != intrinsicsUsage.end() && usageIt->second > 0 &&
+           getIntrinsicState(intrinsicId) != EParameterState::IGNORED;
+  };
+
+  // the subset parametrization of a block cannot be changed
+  for(const auto& constantParamsPair : _intrinsicsConstantParams)
+  {
+    const IndexT intrinsicId = constantParamsPair.first;
+    if(!isIntrinsicKept(intrinsicId))
+      continue;
+
+    const IntrinsicBase& intrinsic = *sfmData.getIntrinsics().at(intrinsicId);
+    if(intrinsic.isLocked() || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
+      continue;
+
+    if(getIntrinsicConstantParams(intrinsic, intrinsicsUsage.at(intrinsicId), refineOptions) != constantParamsPair.second)
+      return false;
+  }
+
+  // rig sub-poses are never removed from the problem
+  for(const auto& rigBlockPair : _rigBlocks)
+  {
+    const auto rigIt = sfmData.getRigs().find(rigBlockPair.first);
+    if(rigIt == sfmData.getRigs().end())
+      return false;
+
+    for(const auto& subPoseBlockPair : rigBlockPair.second)
+    {
+      if(subPoseBlockPair.first >= rigIt->second.getNbSubPoses() ||
+         rigIt->second.getSubPose(subPoseBlockPair.first).status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+        return false;
+    }
+  }
+
+  // remove the 2D constraints and the rotation priors, they are always added again
+  for(ceres::ResidualBlockId residualBlockId : _otherResidualBlocks)
+    problem.RemoveResidualBlock(residualBlockId);
+  _otherResidualBlocks.clear();
+
+  // remove the landmarks with different observations or with removed views
+  for(auto it = _landmarksObservations.begin(); it != _landmarksObservations.end();)
+  {
+    const IndexT landmarkId = it->first;
+    const auto landmarkIt = sfmData.getLandmarks().find(landmarkId);
+
+    bool isKept = (landmarkIt != sfmData.getLandmarks().end()) &&
+                  (getLandmarkState(landmarkId) != EParameterState::IGNORED) &&
+                  (landmarkIt->second.observations.size() == it->second.size());
+
+    if(isKept)
+    {
+      std::size_t i = 0;
+      for(const auto& observationPair : landmarkIt->second.observations)
+      {
+        const sfmData::View& view = sfmData.getView(observationPair.first);
+        if(it->second.at(i++) != std::make_pair(observationPair.first, &observationPair.second) ||
+           !isPoseKept(view.getPoseId()) || !isIntrinsicKept(view.getIntrinsicId()))
+        {
+          isKept = false;
+          break;
+        }
+      }
+    }
+
+    if(isKept)
+    {
+      ++it;
+      continue;
+    }
+
+    removeParameterBlock(_landmarksBlocks.at(landmarkId).data(), problem);
+    _landmarksBlocks.erase(landmarkId);
+    it = _landmarksObservations.erase(it);
+  }
+
+  // remove the poses
+  for(auto it = _posesBlocks.begin(); it != _posesBlocks.end();)
+  {
+    if(isPoseKept(it->first))
+    {
+      ++it;
+      continue;
+    }
+    removeParameterBlock(it->second.data(), problem);
+    it = _posesBlocks.erase(it);
+  }
+
+  // remove the intrinsics
+  for(auto it = _intrinsicsBlocks.begin(); it != _intrinsicsBlocks.end();)
+  {
+    if(isIntrinsicKept(it->first))
+    {
+      ++it;
+      continue;
+    }
+    removeParameterBlock(it->second.data(), problem);
+    _intrinsicsConstantParams.erase(it->first);
+    it = _intrinsicsBlocks.erase(it);
+  }
+
+  // refresh the remaining blocks and add the new ones
+  _statistics = Statistics();
+  _allParametersBlocks.clear();
+
+  addExtrinsicsToProblem(sfmData, refineOptions, problem);
+  addIntrinsicsToProblem(sfmData, refineOptions, problem);
+  addLandmarksToProblem(sfmData, refineOptions, problem);
+  addConstraints2DToProblem(sfmData, refineOptions, problem);
+  addRotationPriorsToProblem(sfmData, refineOptions, problem);
+
+  return true;
+}
+
 void BundleAdjustmentCeres::updateFromSolution(sfmData::SfMData& sfmData, ERefineOptions refineOptions) const
 {
   const bool refinePoses = (refineOptions & REFINE_ROTATION) || (refineOptions & REFINE_TRANSLATION);
@@ -783,6 +1054,9 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
                                            ERefineOptions refineOptions,
                                            ceres::CRSMatrix& jacobian)
 {
+  // the parameter blocks are shared with the persistent problem
+  _problem.reset();
+
   // create problem
   ceres::Problem::Options problemOptions;
   problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
@@ -802,11 +1076,36 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
 
 bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
 {
+  system::Timer timer;
+
   // create problem
   ceres::Problem::Options problemOptions;
   problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problemOptions);
-  createProblem(sfmData, refineOptions, problem);
+
+  std::unique_ptr<ceres::Problem> localProblem;
+  ceres::Problem* problem = nullptr;
+
+  if(_ceresOptions.persistentProblem)
+  {
+    // try to update the problem of the previous call
+    if(!_problem || (refineOptions != _problemRefineOptions) || !updateProblem(sfmData, refineOptions, *_problem))
+    {
+      // fast removal is needed to remove the landmarks efficiently in updateProblem
+      problemOptions.enable_fast_removal = true;
+      _problem.reset(new ceres::Problem(problemOptions));
+      _problemRefineOptions = refineOptions;
+      createProblem(sfmData, refineOptions, *_problem);
+    }
+    problem = _problem.get();
+  }
+  else
+  {
+    localProblem.reset(new ceres::Problem(problemOptions));
+    createProblem(sfmData, refineOptions, *localProblem);
+    problem = localProblem.get();
+  }
+
+  _statistics.timeProblemCreation = timer.elapsed();
 
   // configure a Bundle Adjustment engine and run it
   // make Ceres automatically detect the bundle structure.
@@ -815,7 +1114,7 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
 
   // solve BA
   ceres::Solver::Summary summary;  
-  ceres::Solve(options, &problem, &summary);
+  ceres::Solve(options, problem, &summary);
 
   // print summary
   if(_ceresOptions.summary)
@@ -11,11 +11,13 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
+#include <aliceVision/sfmData/Landmark.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 
 #include <ceres/ceres.h>
 
 #include <memory>
+#include <set>
 
 
 namespace aliceVision {
@@ -55,6 +57,12 @@ public:
     bool useParametersOrdering = true;
     bool summary = false;
     bool verbose = true;
+    /// keep the Ceres problem between two adjust calls with the same refine options
+    /// and only update the parameter and residual blocks that changed
+    bool persistentProblem = false;
+    /// use the cost functions with analytic derivatives (Pinhole, PinholeRadialK3, Equidistant)
+    /// instead of the automatic differentiation ones
+    bool useAnalyticDerivatives = true;
   };
 
   /**
@@ -99,6 +107,10 @@ public:
     std::size_t nbUnsuccessfullIterations = 0;
     /// number of resiudal blocks in the Ceres problem
     std::size_t nbResidualBlocks = 0;
+    /// number of landmarks (re)built in the Ceres problem
+    std::size_t nbLandmarksBuilt = 0;
+    /// time spent to create or update the Ceres problem (s)
+    double timeProblemCreation = 0.0;
     /// RMSEinitial: sqrt(initial_cost / num_residuals)
     double RMSEinitial = 0.0;
     /// RMSEfinal: sqrt(final_cost / num_residuals)
@@ -180,6 +192,41 @@ private:
     _intrinsicsBlocks.clear();
     _landmarksBlocks.clear();
     _rigBlocks.clear();
+
+    _landmarksObservations.clear();
+    _intrinsicsConstantParams.clear();
+    _constantBlocks.clear();
+    _parameterizedBlocks.clear();
+    _otherResidualBlocks.clear();
+    _ceresOptions.linearSolverOrdering = ceres::ParameterBlockOrdering();
+  }
+
+  /**
+   * @brief Set a parameter block constant or variable, only calling Ceres if its state changes
+   * @param[in] block The parameter block pointer
+   * @param[in] isConstant The new state of the parameter block
+   * @param[out] problem The Ceres bundle adjustement problem
+   */
+  inline void setParameterBlockConstant(double* block, bool isConstant, ceres::Problem& problem)
+  {
+    if(isConstant && _constantBlocks.insert(block).second)
+      problem.SetParameterBlockConstant(block);
+    else if(!isConstant && _constantBlocks.erase(block))
+      problem.SetParameterBlockVariable(block);
+  }
+
+  /**
+   * @brief Remove a parameter block and all its residual blocks from the problem
+   * @param[in] block The parameter block pointer
+   * @param[out] problem The Ceres bundle adjustement problem
+   */
+  inline void removeParameterBlock(double* block, ceres::Problem& problem)
+  {
+    problem.RemoveParameterBlock(block);
+    _constantBlocks.erase(block);
+    _parameterizedBlocks.erase(block);
+    if(_ceresOptions.useParametersOrdering)
+      _ceresOptions.linearSolverOrdering.Remove(block);
   }
 
   /**
@@ -238,6 +285,18 @@ private:
    */
   void createProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
+  /**
+   * @brief Update the persistent Ceres bundle adjustement problem:
+   *  - remove the blocks of the landmarks whose observations changed and of the removed poses / intrinsics.
+   *  - refresh the values and states of the remaining blocks.
+   *  - add the blocks of the new poses, intrinsics and landmarks.
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag (should be the one used to create the problem)
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   * @return false if the problem cannot be updated and has to be created again
+   */
+  bool updateProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
+
   /**
    * @brief Update The given SfMData with the solver solution
    * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction, notably the poses and sub-poses
@@ -306,6 +365,24 @@ private:
   /// block: ceres angleAxis(3) + translation(3)
   HashMap<IndexT, HashMap<IndexT, std::array<double,6>>> _rigBlocks;
 
+  // persistent problem data
+
+  /// persistent Ceres problem (only used with CeresOptions::persistentProblem)
+  std::unique_ptr<ceres::Problem> _problem;
+  /// refine options used to create the persistent problem
+  ERefineOptions _problemRefineOptions = REFINE_NONE;
+  /// observations <viewId, observation> used to build the residual blocks of each landmark
+  /// note: the cost functions keep a reference on the SfMData observations
+  HashMap<IndexT, std::vector<std::pair<IndexT, const sfmData::Observation*>>> _landmarksObservations;
+  /// constant parameters of each intrinsic block with a subset parametrization
+  HashMap<IndexT, std::vector<int>> _intrinsicsConstantParams;
+  /// parameter blocks currently set as constant
+  std::set<double*> _constantBlocks;
+  /// parameter blocks with a subset parametrization
+  std::set<double*> _parameterizedBlocks;
+  /// residual blocks of the 2D constraints and rotation priors
+  std::vector<ceres::ResidualBlockId> _otherResidualBlocks;
+
 };
 
 } // namespace sfm
@@ -0,0 +1,419 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/BundleAdjustmentPartitionedCeres.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/graph/graph.hpp>
+#include <aliceVision/multiview/rotationAveraging/l2.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <tuple>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/**
+ * @brief A cluster sub-scene and the weights used to merge its results.
+ */
+struct ClusterScene
+{
+  sfmData::SfMData sfmData;
+  /// number of observations from the cluster poses per landmark
+  std::map<IndexT, std::size_t> landmarksWeight;
+  /// number of observations from the cluster poses per intrinsic
+  std::map<IndexT, std::size_t> intrinsicsWeight;
+};
+
+/**
+ * @brief Count the landmarks shared by each pair of poses.
+ * @param[in] sfmData The input SfMData
+ * @return The number of shared landmarks per pair of pose ids
+ */
+std::map<Pair, std::size_t> countSharedLandmarks(const sfmData::SfMData& sfmData)
+{
+  std::map<Pair, std::size_t> nbSharedLandmarks;
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    std::set<IndexT> landmarkPoses;
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      if(sfmData.isPoseAndIntrinsicDefined(&view))
+        landmarkPoses.insert(view.getPoseId());
+    }
+
+    for(auto it = landmarkPoses.begin(); it != landmarkPoses.end(); ++it)
+      for(auto itNext = std::next(it); itNext != landmarkPoses.end(); ++itNext)
+        ++nbSharedLandmarks[Pair(*it, *itNext)];
+  }
+  return nbSharedLandmarks;
+}
+
+/**
+ * @brief Create the sub-scene of a cluster.
+ * It contains the landmarks observed by the cluster poses, with all their observations
+ * from posed views. The boundary poses are refined with the cluster poses,
+ * the other poses (the separator) are locked.
+ * @param[in] sfmData The full scene
+ * @param[in] clusterPoses The pose ids of the cluster
+ * @param[in] boundaryPoses The boundary pose ids of the cluster
+ * @param[out] clusterScene The cluster sub-scene
+ */
+void createClusterScene(const sfmData::SfMData& sfmData,
+                        const std::set<IndexT>& clusterPoses,
+                        const std::set<IndexT>& boundaryPoses,
+                        ClusterScene& clusterScene)
+{
+  sfmData::SfMData& clusterSfmData = clusterScene.sfmData;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    std::size_t nbClusterObservations = 0;
+    std::size_t nbValidObservations = 0;
+    for(const auto& observationPair : landmark.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      if(!sfmData.isPoseAndIntrinsicDefined(&view))
+        continue;
+      ++nbValidObservations;
+      if(clusterPoses.count(view.getPoseId()))
+        ++nbClusterObservations;
+    }
+
+    if(nbClusterObservations == 0 || nbValidObservations < 2)
+      continue;
+
+    sfmData::Landmark& clusterLandmark = clusterSfmData.getLandmarks()[landmarkPair.first];
+    clusterLandmark.X = landmark.X;
+    clusterLandmark.descType = landmark.descType;
+    clusterLandmark.rgb = landmark.rgb;
+    clusterScene.landmarksWeight[landmarkPair.first] = nbClusterObservations;
+
+    for(const auto& observationPair : landmark.observations)
+    {
+      const std::shared_ptr<sfmData::View>& view = sfmData.getViews().at(observationPair.first);
+      if(!sfmData.isPoseAndIntrinsicDefined(view.get()))
+        continue;
+
+      clusterLandmark.observations[observationPair.first] = observationPair.second;
+
+      const IndexT poseId = view->getPoseId();
+      const IndexT intrinsicId = view->getIntrinsicId();
+      const bool isClusterPose = (clusterPoses.count(poseId) > 0);
+
+      if(isClusterPose)
+        ++clusterScene.intrinsicsWeight[intrinsicId];
+
+      if(clusterSfmData.getViews().count(view->getViewId()))
+        continue;
+
+      clusterSfmData.getViews().emplace(view->getViewId(), view);
+
+      if(!clusterSfmData.existsPose(*view))
+      {
+        sfmData::CameraPose pose = sfmData.getAbsolutePose(poseId);
+        if(!isClusterPose && !boundaryPoses.count(poseId))
+          pose.lock();
+        clusterSfmData.getPoses().emplace(poseId, pose);
+      }
+
+      if(!clusterSfmData.getIntrinsics().count(intrinsicId))
+        clusterSfmData.getIntrinsics().emplace(intrinsicId, std::shared_ptr<camera::IntrinsicBase>(sfmData.getIntrinsicPtr(intrinsicId)->clone()));
+    }
+  }
+}
+
+} // namespace
+
+BundleAdjustmentPartitionedCeres::BundleAdjustmentPartitionedCeres(const PartitionOptions& partitionOptions,
+                                                                   const BundleAdjustmentCeres::CeresOptions& ceresOptions)
+  : _partitionOptions(partitionOptions)
+  , _ceresOptions(ceresOptions)
+{}
+
+std::vector<std::set<IndexT>> BundleAdjustmentPartitionedCeres::computeClusters(const sfmData::SfMData& sfmData) const
+{
+  const std::map<Pair, std::size_t> nbSharedLandmarks = countSharedLandmarks(sfmData);
+
+  std::set<IndexT> poseIds;
+  for(const auto& posePair : sfmData.getPoses())
+    poseIds.insert(posePair.first);
+
+  std::vector<Pair> posePairs;
+  for(const auto& sharedPair : nbSharedLandmarks)
+  {
+    if(sharedPair.second >= _partitionOptions.minSharedLandmarks)
+      posePairs.push_back(sharedPair.first);
+  }
+
+  using Graph = graph::indexedGraph::GraphT;
+  const graph::indexedGraph poseGraph(poseIds, posePairs);
+  Graph::NodeMap<int> nodeCluster(poseGraph.g, -1);
+  std::vector<std::vector<Graph::Node>> clusters;
+
+  const std::size_t maxClusterSize = std::max<std::size_t>(1, _partitionOptions.maxClusterSize);
+
+  // breadth-first region growing from the first unassigned pose,
+  // the clusters never span several connected components
+  for(const auto& nodePair : poseGraph.map_size_t_to_node)
+  {
+    if(nodeCluster[nodePair.second] >= 0)
+      continue;
+
+    const int clusterIndex = static_cast<int>(clusters.size());
+    clusters.emplace_back();
+    std::vector<Graph::Node>& cluster = clusters.back();
+
+    std::deque<Graph::Node> queue = {nodePair.second};
+    nodeCluster[nodePair.second] = clusterIndex;
+
+    while(!queue.empty() && cluster.size() < maxClusterSize)
+    {
+      const Graph::Node node = queue.front();
+      queue.pop_front();
+      cluster.push_back(node);
+
+      for(Graph::IncEdgeIt edge(poseGraph.g, node); edge != lemon::INVALID; ++edge)
+      {
+        const Graph::Node neighbor = poseGraph.g.oppositeNode(node, edge);
+        if(nodeCluster[neighbor] < 0)
+        {
+          nodeCluster[neighbor] = clusterIndex;
+          queue.push_back(neighbor);
+        }
+      }
+    }
+
+    // release the queued poses that do not fit in the cluster
+    for(const Graph::Node& node : queue)
+      nodeCluster[node] = -1;
+  }
+
+  // merge the small clusters (region growing leftovers) into their most connected neighbor cluster,
+  // as long as the merged cluster does not exceed the maximum cluster size
+  const std::size_t minClusterSize = maxClusterSize / 4;
+  for(std::size_t i = 0; i < clusters.size(); ++i)
+  {
+    if(clusters[i].empty() || clusters[i].size() >= minClusterSize)
+      continue;
+
+    std::map<int, std::size_t> nbConnections;
+    for(const Graph::Node& node : clusters[i])
+    {
+      for(Graph::IncEdgeIt edge(poseGraph.g, node); edge != lemon::INVALID; ++edge)
+      {
+        const int neighborCluster = nodeCluster[poseGraph.g.oppositeNode(node, edge)];
+        if(neighborCluster != static_cast<int>(i) &&
+           clusters[neighborCluster].size() + clusters[i].size() <= maxClusterSize)
+          ++nbConnections[neighborCluster];
+      }
+    }
+
+    if(nbConnections.empty())
+      continue;
+
+    const int bestCluster = std::max_element(nbConnections.begin(), nbConnections.end(),
+                                             [](const std::pair<const int, std::size_t>& a,
+                                                const std::pair<const int, std::size_t>& b)
+                                             { return a.second < b.second; })->first;
+
+    for(const Graph::Node& node : clusters[i])
+    {
+      nodeCluster[node] = bestCluster;
+      clusters[bestCluster].push_back(node);
+    }
+    clusters[i].clear();
+  }
+
+  std::vector<std::set<IndexT>> clustersPoses;
+  for(const std::vector<Graph::Node>& cluster : clusters)
+  {
+    if(cluster.empty())
+      continue;
+
+    clustersPoses.emplace_back();
+    for(const Graph::Node& node : cluster)
+      clustersPoses.back().insert((*poseGraph.map_nodeMapIndex)[node]);
+  }
+  return clustersPoses;
+}
+
+std::vector<std::set<IndexT>> BundleAdjustmentPartitionedCeres::computeBoundaryPoses(const sfmData::SfMData& sfmData,
+                                                                                     const std::vector<std::set<IndexT>>& clusters) const
+{
+  std::map<IndexT, std::size_t> poseCluster;
+  for(std::size_t c = 0; c < clusters.size(); ++c)
+    for(const IndexT poseId : clusters.at(c))
+      poseCluster[poseId] = c;
+
+  std::vector<std::set<IndexT>> boundaryPoses(clusters.size());
+  for(const auto& sharedPair : countSharedLandmarks(sfmData))
+  {
+    if(sharedPair.second < _partitionOptions.minSharedLandmarks)
+      continue;
+
+    const auto itA = poseCluster.find(sharedPair.first.first);
+    const auto itB = poseCluster.find(sharedPair.first.second);
+    if(itA == poseCluster.end() || itB == poseCluster.end() || itA->second == itB->second)
+      continue;
+
+    boundaryPoses.at(itA->second).insert(itB->first);
+    boundaryPoses.at(itB->second).insert(itA->first);
+  }
+  return boundaryPoses;
+}
+
+bool BundleAdjustmentPartitionedCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
+  const std::vector<std::set<IndexT>> clusters = computeClusters(sfmData);
+
+  // rig sub-poses are shared by all the clusters and cannot be merged
+  if(clusters.size() <= 1 || !sfmData.getRigs().empty())
+  {
+    BundleAdjustmentCeres BA(_ceresOptions);
+    return BA.adjust(sfmData, refineOptions);
+  }
+
+  const std::vector<std::set<IndexT>> boundaryPoses = _partitionOptions.shareBoundaryPoses ?
+                                                      computeBoundaryPoses(sfmData, clusters) :
+                                                      std::vector<std::set<IndexT>>(clusters.size());
+
+  ALICEVISION_LOG_INFO("Partitioned bundle adjustment: " << sfmData.getPoses().size() << " poses split into " << clusters.size() << " clusters.");
+
+  const int nbClusters = static_cast<int>(clusters.size());
+  const bool refineIntrinsics = (refineOptions & REFINE_INTRINSICS_ALL) ||
+                                (refineOptions & REFINE_INTRINSICS_OPTICALCENTER_ALWAYS);
+
+  // share the threads between the clusters solved in parallel
+  BundleAdjustmentCeres::CeresOptions clusterOptions = _ceresOptions;
+  clusterOptions.verbose = false;
+  clusterOptions.summary = false;
+  clusterOptions.persistentProblem = false;
+  clusterOptions.nbThreads = std::max(1u, _ceresOptions.nbThreads / static_cast<unsigned int>(std::min(nbClusters, omp_get_max_threads())));
+
+  for(std::size_t iteration = 0; iteration < _partitionOptions.nbIterations; ++iteration)
+  {
+    system::Timer timer;
+    std::vector<ClusterScene> clusterScenes(nbClusters);
+    std::vector<char> clusterSuccess(nbClusters, 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < nbClusters; ++c)
+    {
+      ClusterScene& clusterScene = clusterScenes.at(c);
+      createClusterScene(sfmData, clusters.at(c), boundaryPoses.at(c), clusterScene);
+
+      BundleAdjustmentCeres::CeresOptions options = clusterOptions;
+      if(clusterScene.sfmData.getPoses().size() > 100)
+        options.setSparseBA();
+      else
+        options.setDenseBA();
+
+      BundleAdjustmentCeres BA(options);
+      clusterSuccess.at(c) = BA.adjust(clusterScene.sfmData, refineOptions);
+    }
+
+    // merge the cluster results
+    std::map<IndexT, std::tuple<Mat3, Vec3, std::size_t>> posesSum;
+    std::map<IndexT, std::pair<Vec3, std::size_t>> landmarksSum;
+    std::map<IndexT, std::pair<std::vector<double>, std::size_t>> intrinsicsSum;
+    std::size_t nbSucceededClusters = 0;
+
+    for(int c = 0; c < nbClusters; ++c)
+    {
+      if(!clusterSuccess.at(c))
+        continue;
+      ++nbSucceededClusters;
+
+      const ClusterScene& clusterScene = clusterScenes.at(c);
+
+      // the poses refined by several clusters (boundary poses) are averaged
+      for(const auto& posePair : clusterScene.sfmData.getPoses())
+      {
+        if(posePair.second.isLocked())
+          continue;
+
+        const geometry::Pose3& transform = posePair.second.getTransform();
+        std::tuple<Mat3, Vec3, std::size_t>& sum = posesSum.emplace(posePair.first, std::make_tuple(Mat3(Mat3::Zero()), Vec3(Vec3::Zero()), 0)).first->second;
+        std::get<0>(sum) += transform.rotation();
+        std::get<1>(sum) += transform.center();
+        ++std::get<2>(sum);
+      }
+
+      // shared landmarks are weighted by their number of observations in each cluster
+      for(const auto& weightPair : clusterScene.landmarksWeight)
+      {
+        std::pair<Vec3, std::size_t>& sum = landmarksSum.emplace(weightPair.first, std::make_pair(Vec3(Vec3::Zero()), 0)).first->second;
+        sum.first += static_cast<double>(weightPair.second) * clusterScene.sfmData.getLandmarks().at(weightPair.first).X;
+        sum.second += weightPair.second;
+      }
+
+      if(!refineIntrinsics)
+        continue;
+
+      // shared intrinsics are weighted by their number of observations in each cluster
+      for(const auto& weightPair : clusterScene.intrinsicsWeight)
+      {
+        const std::vector<double> params = clusterScene.sfmData.getIntrinsicPtr(weightPair.first)->getParams();
+        auto it = intrinsicsSum.find(weightPair.first);
+        if(it == intrinsicsSum.end())
+          it = intrinsicsSum.emplace(weightPair.first, std::make_pair(std::vector<double>(params.size(), 0.0), 0)).first;
+
+        for(std::size_t i = 0; i < params.size(); ++i)
+          it->second.first.at(i) += static_cast<double>(weightPair.second) * params.at(i);
+        it->second.second += weightPair.second;
+      }
+    }
+
+    if(nbSucceededClusters == 0)
+    {
+      ALICEVISION_LOG_WARNING("Partitioned bundle adjustment: all the clusters failed.");
+      return false;
+    }
+
+    for(const auto& sumPair : posesSum)
+    {
+      const double nbEstimates = static_cast<double>(std::get<2>(sumPair.second));
+      const Mat3 rotation = (nbEstimates > 1.0) ? rotationAveraging::l2::ClosestSVDRotationMatrix(std::get<0>(sumPair.second) / nbEstimates) :
+                                                  std::get<0>(sumPair.second);
+      sfmData.getPoses().at(sumPair.first).setTransform(geometry::Pose3(rotation, std::get<1>(sumPair.second) / nbEstimates));
+    }
+
+    for(const auto& sumPair : landmarksSum)
+      sfmData.getLandmarks().at(sumPair.first).X = sumPair.second.first / static_cast<double>(sumPair.second.second);
+
+    for(auto& sumPair : intrinsicsSum)
+    {
+      std::vector<double>& params = sumPair.second.first;
+      for(double& param : params)
+        param /= static_cast<double>(sumPair.second.second);
+      sfmData.getIntrinsicPtr(sumPair.first)->updateFromParams(params);
+    }
+
+    ALICEVISION_LOG_INFO("Partitioned bundle adjustment: iteration " << iteration + 1 << "/" << _partitionOptions.nbIterations
+                         << ", " << nbSucceededClusters << "/" << nbClusters << " clusters refined in " << timer.elapsed() << " s.");
+  }
+
+  if(_partitionOptions.finalGlobalAdjustment)
+  {
+    BundleAdjustmentCeres BA(_ceresOptions);
+    return BA.adjust(sfmData, refineOptions);
+  }
+
+  return true;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,101 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/BundleAdjustment.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+/**
+ * @brief Bundle adjustment of very large scenes by partitioning of the pose graph.
+ *
+ * The poses are split into clusters of connected poses (region growing on the graph
+ * of the poses sharing landmarks), of at most maxClusterSize poses. Each cluster is refined
+ * independently and in parallel with its boundary poses: the poses of the other clusters connected
+ * to it in the pose graph, so that neighbor clusters overlap. The other poses observing its landmarks
+ * (the separator) are kept constant. The poses refined by several clusters, the landmarks and
+ * the intrinsics shared by several clusters are then merged.
+ * Iterating this process propagates the corrections through the separators (block Jacobi scheme).
+ * An optional global bundle adjustment can be performed at the end.
+ */
+class BundleAdjustmentPartitionedCeres : public BundleAdjustment
+{
+public:
+
+  /**
+   * @brief Contains the partitioning parameters.
+   */
+  struct PartitionOptions
+  {
+    /// maximum number of poses in a cluster
+    std::size_t maxClusterSize = 500;
+    /// minimum number of shared landmarks to connect two poses in the pose graph
+    std::size_t minSharedLandmarks = 10;
+    /// also refine the boundary poses in each cluster (overlapping clusters)
+    bool shareBoundaryPoses = true;
+    /// number of cluster refinement and merging iterations
+    std::size_t nbIterations = 3;
+    /// perform a global bundle adjustment after the partitioned iterations
+    bool finalGlobalAdjustment = false;
+  };
+
+  /**
+   * @brief BundleAdjustmentPartitionedCeres constructor
+   * @param[in] partitionOptions The partitioning parameters
+   * @param[in] ceresOptions The Ceres parameters used for the clusters and the final global adjustment
+   */
+  explicit BundleAdjustmentPartitionedCeres(const PartitionOptions& partitionOptions,
+                                            const BundleAdjustmentCeres::CeresOptions& ceresOptions = BundleAdjustmentCeres::CeresOptions());
+
+  /**
+   * @brief Perform a partitioned bundle adjustment on the SfMData.
+   * Scenes with rigs or with a single cluster use a regular bundle adjustment.
+   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag
+   * @return false if the bundle adjustment failed else true
+   */
+  bool adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions = REFINE_ALL) override;
+
+  /**
+   * @brief Split the poses of the scene into clusters of connected poses.
+   * @param[in] sfmData The input SfMData
+   * @return The pose ids of each cluster
+   */
+  std::vector<std::set<IndexT>> computeClusters(const sfmData::SfMData& sfmData) const;
+
+  /**
+   * @brief Get the boundary poses of each cluster: the poses of the other clusters
+   *        sharing at least minSharedLandmarks landmarks with a pose of the cluster.
+   * @param[in] sfmData The input SfMData
+   * @param[in] clusters The pose ids of each cluster
+   * @return The boundary pose ids of each cluster
+   */
+  std::vector<std::set<IndexT>> computeBoundaryPoses(const sfmData::SfMData& sfmData,
+                                                     const std::vector<std::set<IndexT>>& clusters) const;
+
+private:
+
+  /// partitioning parameters
+  PartitionOptions _partitionOptions;
+  /// Ceres parameters
+  BundleAdjustmentCeres::CeresOptions _ceresOptions;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,333 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/Landmark.hpp>
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include <cmath>
+
+// Define ceres cost functions with analytic derivatives for the most common AliceVision camera models.
+// They have the same parameter blocks as the corresponding functors of ResidualErrorFunctor.hpp
+// but avoid the cost of the automatic differentiation (Jet evaluation with all the block derivatives).
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Apply an angle-axis pose [R;t] to a 3D point and compute the derivatives of the transformed point.
+ * @param[in] cam_Rt The pose block: rotation (angle axis), translation [rX,rY,rZ,tx,ty,tz]
+ * @param[in] pos_3dpoint The 3D point block
+ * @param[out] d_P_d_Rt The derivative of the transformed point wrt. the pose block (optional)
+ * @param[out] d_P_d_X The derivative of the transformed point wrt. the 3D point (optional)
+ * @return the transformed point P = R * X + t
+ */
+inline Vec3 applyAngleAxisPose(const double* const cam_Rt,
+                               const double* const pos_3dpoint,
+                               Eigen::Matrix<double, 3, 6>* d_P_d_Rt,
+                               Mat3* d_P_d_X)
+{
+  const Eigen::Map<const Vec3> angleAxis(cam_Rt);
+  const Eigen::Map<const Vec3> t(&cam_Rt[3]);
+  const Eigen::Map<const Vec3> X(pos_3dpoint);
+
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(cam_Rt, R.data());
+
+  if(d_P_d_Rt != nullptr)
+  {
+    // d(R(w) X) / dw = -R [X]x Jr(w), with Jr the right Jacobian of SO(3)
+    const Mat3 W = CrossProductMatrix(angleAxis);
+    const double theta2 = angleAxis.squaredNorm();
+    Mat3 Jr;
+
+    if(theta2 > 1e-12)
+    {
+      const double theta = std::sqrt(theta2);
+      Jr = Mat3::Identity() - (1.0 - std::cos(theta)) / theta2 * W + (theta - std::sin(theta)) / (theta2 * theta) * W * W;
+    }
+    else
+    {
+      // first order approximation near the identity
+      Jr = Mat3::Identity() - 0.5 * W;
+    }
+
+    d_P_d_Rt->leftCols<3>() = -R * CrossProductMatrix(X) * Jr;
+    d_P_d_Rt->rightCols<3>().setIdentity();
+  }
+
+  if(d_P_d_X != nullptr)
+    *d_P_d_X = R;
+
+  return R * X + t;
+}
+
+/**
+ * @brief Compute the derivative of the perspective division [x/z, y/z] wrt. the point.
+ * @param[in] P The point in the camera coordinate system
+ * @return the 2x3 derivative
+ */
+inline Eigen::Matrix<double, 2, 3> getPerspectiveDivisionDerivative(const Vec3& P)
+{
+  const double invZ = 1.0 / P(2);
+  Eigen::Matrix<double, 2, 3> d_xu_d_P;
+  d_xu_d_P << invZ, 0.0, -P(0) * invZ * invZ,
+              0.0, invZ, -P(1) * invZ * invZ;
+  return d_xu_d_P;
+}
+
+/**
+ * @brief Fill the pose and landmark Jacobians from the derivative of the residual wrt. the transformed point.
+ */
+inline void fillPoseAndLandmarkJacobians(const Eigen::Matrix<double, 2, 3>& d_res_d_P,
+                                         const Eigen::Matrix<double, 3, 6>& d_P_d_Rt,
+                                         const Mat3& d_P_d_X,
+                                         double** jacobians)
+{
+  if(jacobians[1] != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+    J = d_res_d_P * d_P_d_Rt;
+  }
+
+  if(jacobians[2] != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[2]);
+    J = d_res_d_P * d_P_d_X;
+  }
+}
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a Pinhole camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,3,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 => the intrinsic data block [focal, principal point x, principal point y],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ * @see ResidualErrorFunctor_Pinhole
+ */
+class ResidualErrorCostFunction_Pinhole : public ceres::SizedCostFunction<2, 3, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction_Pinhole(const sfmData::Observation& obs)
+    : _obs(obs)
+  {
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double focal = cam_K[0];
+    const double invScale = 1.0 / (_obs.scale > 0.0 ? _obs.scale : 1.0);
+
+    Eigen::Matrix<double, 3, 6> d_P_d_Rt;
+    Mat3 d_P_d_X;
+    const bool withJacobians = (jacobians != nullptr);
+    const Vec3 P = applyAngleAxisPose(parameters[1], parameters[2], withJacobians ? &d_P_d_Rt : nullptr, withJacobians ? &d_P_d_X : nullptr);
+
+    const Vec2 x_u = P.head<2>() / P(2);
+
+    residuals[0] = (cam_K[1] + focal * x_u(0) - _obs.x(0)) * invScale;
+    residuals[1] = (cam_K[2] + focal * x_u(1) - _obs.x(1)) * invScale;
+
+    if(!withJacobians)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[0]);
+      J << x_u(0), 1.0, 0.0,
+           x_u(1), 0.0, 1.0;
+      J *= invScale;
+    }
+
+    const Eigen::Matrix<double, 2, 3> d_res_d_P = (focal * invScale) * getPerspectiveDivisionDerivative(P);
+    fillPoseAndLandmarkJacobians(d_res_d_P, d_P_d_Rt, d_P_d_X, jacobians);
+
+    return true;
+  }
+
+private:
+  const sfmData::Observation& _obs; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic derivatives for a PinholeRadialK3 camera and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,6,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 6 => the intrinsic data block [focal, principal point x, principal point y, K1, K2, K3],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ * @see ResidualErrorFunctor_PinholeRadialK3
+ */
+class ResidualErrorCostFunction_PinholeRadialK3 : public ceres::SizedCostFunction<2, 6, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction_PinholeRadialK3(const sfmData::Observation& obs)
+    : _obs(obs)
+  {
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double focal = cam_K[0];
+    const double k1 = cam_K[3];
+    const double k2 = cam_K[4];
+    const double k3 = cam_K[5];
+    const double invScale = 1.0 / (_obs.scale > 0.0 ? _obs.scale : 1.0);
+
+    Eigen::Matrix<double, 3, 6> d_P_d_Rt;
+    Mat3 d_P_d_X;
+    const bool withJacobians = (jacobians != nullptr);
+    const Vec3 P = applyAngleAxisPose(parameters[1], parameters[2], withJacobians ? &d_P_d_Rt : nullptr, withJacobians ? &d_P_d_X : nullptr);
+
+    const Vec2 x_u = P.head<2>() / P(2);
+
+    // apply distortion (xd,yd) = disto(x_u,y_u)
+    const double r2 = x_u.squaredNorm();
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = 1.0 + k1 * r2 + k2 * r4 + k3 * r6;
+    const Vec2 x_d = x_u * r_coeff;
+
+    residuals[0] = (cam_K[1] + focal * x_d(0) - _obs.x(0)) * invScale;
+    residuals[1] = (cam_K[2] + focal * x_d(1) - _obs.x(1)) * invScale;
+
+    if(!withJacobians)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[0]);
+      J.col(0) = x_d;
+      J.col(1) << 1.0, 0.0;
+      J.col(2) << 0.0, 1.0;
+      J.col(3) = focal * r2 * x_u;
+      J.col(4) = focal * r4 * x_u;
+      J.col(5) = focal * r6 * x_u;
+      J *= invScale;
+    }
+
+    // d(x_d) / d(x_u) = r_coeff * I + x_u * d(r_coeff)/d(x_u)
+    const double d_rcoeff_d_r2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+    const Eigen::Matrix2d d_xd_d_xu = r_coeff * Eigen::Matrix2d::Identity() + (2.0 * d_rcoeff_d_r2) * x_u * x_u.transpose();
+
+    const Eigen::Matrix<double, 2, 3> d_res_d_P = (focal * invScale) * d_xd_d_xu * getPerspectiveDivisionDerivative(P);
+    fillPoseAndLandmarkJacobians(d_res_d_P, d_P_d_Rt, d_P_d_X, jacobians);
+
+    return true;
+  }
+
+private:
+  const sfmData::Observation& _obs; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic derivatives for an Equidistant camera (without distortion) and a 3D point.
+ *
+ *  Data parameter blocks are the following <2,3,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 => the intrinsic data block [focal, principal point x, principal point y],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ * @see ResidualErrorFunctor_Equidistant
+ */
+class ResidualErrorCostFunction_Equidistant : public ceres::SizedCostFunction<2, 3, 6, 3>
+{
+public:
+  explicit ResidualErrorCostFunction_Equidistant(const sfmData::Observation& obs, double radiusCoefficient)
+    : _obs(obs)
+    , _radiusCoefficient(radiusCoefficient)
+  {
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double focal = cam_K[0];
+    const double invScale = 1.0 / (_obs.scale > 0.0 ? _obs.scale : 1.0);
+
+    Eigen::Matrix<double, 3, 6> d_P_d_Rt;
+    Mat3 d_P_d_X;
+    const bool withJacobians = (jacobians != nullptr);
+    const Vec3 P = applyAngleAxisPose(parameters[1], parameters[2], withJacobians ? &d_P_d_Rt : nullptr, withJacobians ? &d_P_d_X : nullptr);
+
+    // image point = pp + c * focal * angle_Z * [cos(angle_radial), sin(angle_radial)]
+    //             = pp + c * focal * (angle_Z / rho) * [x, y]
+    const double rho2 = P(0) * P(0) + P(1) * P(1);
+    const double rho = std::sqrt(rho2);
+    const double n2 = rho2 + P(2) * P(2);
+    const bool nearAxis = (rho2 <= 1e-12 * P(2) * P(2)) && (P(2) > 0.0);
+
+    // a = angle_Z / rho and its derivative wrt. rho divided by rho
+    double a;
+    double d_a_d_rho_over_rho;
+
+    if(nearAxis)
+    {
+      // series expansion of atan(rho / z) / rho near the optical axis
+      const double invZ = 1.0 / P(2);
+      a = invZ;
+      d_a_d_rho_over_rho = -2.0 / 3.0 * invZ * invZ * invZ;
+    }
+    else
+    {
+      a = std::atan2(rho, P(2)) / rho;
+      d_a_d_rho_over_rho = (P(2) / n2 - a) / rho2;
+    }
+
+    const double cf = _radiusCoefficient * focal;
+    const Vec2 g = a * P.head<2>();
+
+    residuals[0] = (cam_K[1] + cf * g(0) - _obs.x(0)) * invScale;
+    residuals[1] = (cam_K[2] + cf * g(1) - _obs.x(1)) * invScale;
+
+    if(!withJacobians)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobians[0]);
+      J.col(0) = _radiusCoefficient * g;
+      J.col(1) << 1.0, 0.0;
+      J.col(2) << 0.0, 1.0;
+      J *= invScale;
+    }
+
+    // d(g) / d(P) = a * [I2 | 0] + [x, y]^T * d(a) / d(P)
+    const Eigen::RowVector3d d_a_d_P(P(0) * d_a_d_rho_over_rho,
+                                     P(1) * d_a_d_rho_over_rho,
+                                     -1.0 / n2);
+    Eigen::Matrix<double, 2, 3> d_g_d_P = P.head<2>() * d_a_d_P;
+    d_g_d_P(0, 0) += a;
+    d_g_d_P(1, 1) += a;
+
+    const Eigen::Matrix<double, 2, 3> d_res_d_P = (cf * invScale) * d_g_d_P;
+    fillPoseAndLandmarkJacobians(d_res_d_P, d_P_d_Rt, d_P_d_X, jacobians);
+
+    return true;
+  }
+
+private:
+  const sfmData::Observation& _obs; // The 2D observation
+  double _radiusCoefficient;
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -961,6 +961,150 @@ struct ResidualErrorFunctor_PinholeFisheye1
   const sfmData::Observation& _obs; // The 2D observation
 };
 
+/**
+ * @brief Get the coefficient between the image radius (in pixels) and focal * angle_Z of an equidistant camera
+ * @param[in] intrinsic The equidistant intrinsic
+ * @return the radius coefficient (see camera::EquiDistant::project)
+ */
+inline double getEquidistantRadiusCoefficient(const camera::EquiDistant& intrinsic)
+{
+  const double rsensor = std::min(intrinsic.sensorWidth(), intrinsic.sensorHeight());
+  const double rscale = intrinsic.sensorWidth() / std::max(intrinsic.w(), intrinsic.h());
+  return 2.0 * rscale * intrinsic.getCircleRadius() / rsensor;
+}
+
+/**
+ * @brief Ceres functor to use an Equidistant camera model (without distortion)
+ *
+ *  Data parameter blocks are the following <2,3,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 3 => the intrinsic data block [focal, principal point x, principal point y],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ *  The image radius is radiusCoefficient * focal * angle_Z, see camera::EquiDistant::project.
+ */
+struct ResidualErrorFunctor_Equidistant
+{
+  explicit ResidualErrorFunctor_Equidistant(const sfmData::Observation& obs, double radiusCoefficient)
+      : _obs(obs)
+      , _radiusCoefficient(radiusCoefficient)
+  {
+  }
+
+  // Enum to map intrinsics parameters between aliceVision & ceres camera data parameter block.
+  enum {
+    OFFSET_FOCAL_LENGTH = 0,
+    OFFSET_PRINCIPAL_POINT_X = 1,
+    OFFSET_PRINCIPAL_POINT_Y = 2
+  };
+
+  template <typename T>
+  void applyIntrinsicParameters(const T* const cam_K,
+                                const T* const pos_proj,
+                                T* out_residuals) const
+  {
+    const T& focal = cam_K[OFFSET_FOCAL_LENGTH];
+    const T& principal_point_x = cam_K[OFFSET_PRINCIPAL_POINT_X];
+    const T& principal_point_y = cam_K[OFFSET_PRINCIPAL_POINT_Y];
+
+    // Compute angle with optical center and radial angle
+    const T angle_Z = atan2(sqrt(pos_proj[0] * pos_proj[0] + pos_proj[1] * pos_proj[1]), pos_proj[2]);
+    const T angle_radial = atan2(pos_proj[1], pos_proj[0]);
+
+    // radius = focal * angle_Z
+    const T radius = T(_radiusCoefficient) * focal * angle_Z;
+
+    // Apply principal point to get the final image coordinates
+    const T projected_x = principal_point_x + cos(angle_radial) * radius;
+    const T projected_y = principal_point_y + sin(angle_radial) * radius;
+
+    // Compute and return the error is the difference between the predicted
+    //  and observed position
+    const T scale(_obs.scale > 0.0 ? _obs.scale : 1.0);
+    out_residuals[0] = (projected_x - T(_obs.x[0])) / scale;
+    out_residuals[1] = (projected_y - T(_obs.x[1])) / scale;
+  }
+
+  template <typename T>
+  bool operator()(
+    const T* const cam_K,
+    const T* const cam_Rt,
+    const T* const subpose_Rt,
+    const T* const pos_3dpoint,
+    T* out_residuals) const
+  {
+    T pos_proj[3];
+
+    // Apply RIG pose
+    {
+      const T * cam_R = cam_Rt;
+      const T * cam_t = &cam_Rt[3];
+
+      // Rotate the point according the camera rotation
+      ceres::AngleAxisRotatePoint(cam_R, pos_3dpoint, pos_proj);
+
+      // Apply the camera translation
+      pos_proj[0] += cam_t[0];
+      pos_proj[1] += cam_t[1];
+      pos_proj[2] += cam_t[2];
+    }
+
+    // Apply RIG sub-pose
+    {
+      const T * cam_R = subpose_Rt;
+      const T * cam_t = &subpose_Rt[3];
+
+      // Rotate the point according to the camera rotation
+      T pos_proj_tmp[3] = { pos_proj[0], pos_proj[1], pos_proj[2] };
+      ceres::AngleAxisRotatePoint(cam_R, pos_proj_tmp, pos_proj);
+
+      // Apply the camera translation
+      pos_proj[0] += cam_t[0];
+      pos_proj[1] += cam_t[1];
+      pos_proj[2] += cam_t[2];
+    }
+
+    applyIntrinsicParameters(cam_K, pos_proj, out_residuals);
+
+    return true;
+  }
+
+  /**
+   * @param[in] cam_K: Camera intrinsics( focal, principal point [x,y] )
+   * @param[in] cam_Rt: Camera parameterized using one block of 6 parameters [R;t]:
+   *   - 3 for rotation(angle axis), 3 for translation
+   * @param[in] pos_3dpoint
+   * @param[out] out_residuals
+   */
+  template <typename T>
+  bool operator()(
+    const T* const cam_K,
+    const T* const cam_Rt,
+    const T* const pos_3dpoint,
+    T* out_residuals) const
+  {
+    const T * cam_R = cam_Rt;
+    const T * cam_t = &cam_Rt[3];
+
+    T pos_proj[3];
+    // Rotate the point according the camera rotation
+    ceres::AngleAxisRotatePoint(cam_R, pos_3dpoint, pos_proj);
+
+    // Apply the camera translation
+    pos_proj[0] += cam_t[0];
+    pos_proj[1] += cam_t[1];
+    pos_proj[2] += cam_t[2];
+
+    applyIntrinsicParameters(cam_K, pos_proj, out_residuals);
+
+    return true;
+  }
+
+  const sfmData::Observation& _obs; // The 2D observation
+  double _radiusCoefficient;
+};
 
 } // namespace sfm
 } // namespace aliceVision
@@ -137,6 +137,99 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye)
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem_Pinhole)
+{
+  const int nviews = 4;
+  const int npoints = 8;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.setDenseBA();
+  options.persistentProblem = true;
+
+  BundleAdjustmentCeres BA(options);
+  BOOST_CHECK( BA.adjust(sfmData) );
+  BOOST_CHECK_EQUAL(BA.getStatistics().nbLandmarksBuilt, npoints);
+
+  const double dResidual_first = RMSE(sfmData);
+  BOOST_CHECK(dResidual_before > dResidual_first);
+
+  // remove an observation (as an outlier removal step would do) and a landmark
+  sfmData.getLandmarks().at(0).observations.erase(0);
+  sfmData.getLandmarks().erase(1);
+
+  // only the modified landmark is rebuilt
+  BOOST_CHECK( BA.adjust(sfmData) );
+  BOOST_CHECK_EQUAL(BA.getStatistics().nbLandmarksBuilt, 1);
+  BOOST_CHECK_EQUAL(BA.getStatistics().nbResidualBlocks, 2 * (nviews * (npoints - 1) - 1));
+  BOOST_CHECK(RMSE(sfmData) <= dResidual_first + 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned_Pinhole)
+{
+  const int nviews = 12;
+  const int npoints = 16;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  BundleAdjustmentPartitionedCeres::PartitionOptions partitionOptions;
+  partitionOptions.maxClusterSize = 4;
+  partitionOptions.minSharedLandmarks = 1;
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.setDenseBA();
+
+  BundleAdjustmentPartitionedCeres BA(partitionOptions, options);
+
+  // each pose belongs to exactly one cluster
+  const std::vector<std::set<IndexT>> clusters = BA.computeClusters(sfmData);
+  BOOST_CHECK_EQUAL(clusters.size(), 3);
+  std::set<IndexT> clusteredPoses;
+  for(const std::set<IndexT>& cluster : clusters)
+  {
+    BOOST_CHECK(cluster.size() <= partitionOptions.maxClusterSize);
+    clusteredPoses.insert(cluster.begin(), cluster.end());
+  }
+  BOOST_CHECK_EQUAL(clusteredPoses.size(), nviews);
+
+  // neighbor clusters overlap through their boundary poses
+  const std::vector<std::set<IndexT>> boundaryPoses = BA.computeBoundaryPoses(sfmData, clusters);
+  BOOST_CHECK_EQUAL(boundaryPoses.size(), clusters.size());
+  for(std::size_t c = 0; c < clusters.size(); ++c)
+  {
+    BOOST_CHECK(!boundaryPoses.at(c).empty());
+    for(const IndexT poseId : boundaryPoses.at(c))
+      BOOST_CHECK(clusters.at(c).count(poseId) == 0 && clusteredPoses.count(poseId) == 1);
+  }
+
+  // the leftover cluster is not merged into a full cluster
+  {
+    BundleAdjustmentPartitionedCeres::PartitionOptions largeOptions = partitionOptions;
+    largeOptions.maxClusterSize = 10;
+    const BundleAdjustmentPartitionedCeres largeBA(largeOptions, options);
+    const std::vector<std::set<IndexT>> largeClusters = largeBA.computeClusters(sfmData);
+    BOOST_CHECK_EQUAL(largeClusters.size(), 2);
+    for(const std::set<IndexT>& cluster : largeClusters)
+      BOOST_CHECK(cluster.size() <= largeOptions.maxClusterSize);
+  }
+
+  BOOST_CHECK( BA.adjust(sfmData, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK_LT(dResidual_after, dResidual_before);
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing)
 {
   const int nviews = 4;
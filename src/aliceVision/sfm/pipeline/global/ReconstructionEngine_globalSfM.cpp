@@ -8,6 +8,7 @@
 #include "ReconstructionEngine_globalSfM.hpp"
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/BundleAdjustmentPartitionedCeres.hpp>
 #include <aliceVision/multiview/triangulation/triangulationDLT.hpp>
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
 #include <aliceVision/graph/connectedComponent.hpp>
@@ -368,16 +369,27 @@ bool ReconstructionEngine_globalSfM::Adjust()
   BundleAdjustmentCeres::CeresOptions options; 
   options.useParametersOrdering = false; // disable parameters ordering
 
-  BundleAdjustmentCeres BA(options);
+  std::unique_ptr<BundleAdjustment> BA;
+  if(_partitionedBAMaxClusterSize > 0 && _sfmData.getPoses().size() > _partitionedBAMaxClusterSize)
+  {
+    BundleAdjustmentPartitionedCeres::PartitionOptions partitionOptions;
+    partitionOptions.maxClusterSize = _partitionedBAMaxClusterSize;
+    partitionOptions.finalGlobalAdjustment = false;
+    BA.reset(new BundleAdjustmentPartitionedCeres(partitionOptions, options));
+  }
+  else
+  {
+    BA.reset(new BundleAdjustmentCeres(options));
+  }
   // - refine only Structure and translations
-  bool success = BA.adjust(_sfmData, BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
+  bool success = BA->adjust(_sfmData, BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
   if(success)
   {
     if(!_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_00_refine_T_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
 
     // refine only structure and rotations & translations
-    success = BA.adjust(_sfmData, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
+    success = BA->adjust(_sfmData, BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE);
 
     if(success && !_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_01_refine_RT_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
@@ -386,7 +398,7 @@ bool ReconstructionEngine_globalSfM::Adjust()
   if(success && !_lockAllIntrinsics)
   {
     // refine all: Structure, motion:{rotations, translations} and optics:{intrinsics}
-    success = BA.adjust(_sfmData, BundleAdjustment::REFINE_ALL);
+    success = BA->adjust(_sfmData, BundleAdjustment::REFINE_ALL);
     if(success && !_loggingFile.empty())
       sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_02_refine_KRT_Xi.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
   }
@@ -420,7 +432,7 @@ bool ReconstructionEngine_globalSfM::Adjust()
   BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
   if(!_lockAllIntrinsics)
     refineOptions |= BundleAdjustment::REFINE_INTRINSICS_ALL;
-  success = BA.adjust(_sfmData, refineOptions);
+  success = BA->adjust(_sfmData, refineOptions);
 
   if(success && !_loggingFile.empty())
     sfmDataIO::Save(_sfmData, (fs::path(_loggingFile).parent_path() / "structure_04_outlier_removed.ply").string(), sfmDataIO::ESfMData(sfmDataIO::EXTRINSICS | sfmDataIO::STRUCTURE));
@@ -36,6 +36,12 @@ public:
 
   void setLockAllIntrinsics(bool v) { _lockAllIntrinsics = v; }
 
+  /**
+   * @brief Use a partitioned bundle adjustment for the scenes with more poses than the given cluster size
+   * @param[in] maxClusterSize The maximum number of poses per cluster, 0 to disable the partitioned bundle adjustment
+   */
+  void setPartitionedBAMaxClusterSize(std::size_t maxClusterSize) { _partitionedBAMaxClusterSize = maxClusterSize; }
+
   virtual bool process();
 
 protected:
@@ -65,6 +71,7 @@ private:
   ERotationAveragingMethod _eRotationAveragingMethod;
   ETranslationAveragingMethod _eTranslationAveragingMethod;
   bool _lockAllIntrinsics = false;
+  std::size_t _partitionedBAMaxClusterSize = 0;
   EFeatureConstraint _featureConstraint = EFeatureConstraint::BASIC;
 
   // Data provider
@@ -55,7 +55,8 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
 
     // robust estimation of the Projection matrix and its precision
     robustEstimation::Mat34Model model;
-    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &model, precision);
+    std::mt19937 generator(resectionData.randomSeed);
+    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSACParallel(kernel, generator, resectionData.vec_inliers, resectionData.max_iteration, &model, precision, 64, resectionData.useSPRT);
     P = model.getMatrix();
     // update the upper bound precision of the model found by AC-RANSAC
     resectionData.error_max = ACRansacOut.first;
@@ -90,7 +91,8 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
 
         // robust estimation of the Projection matrix and its precision
         robustEstimation::Mat34Model model;
-        const std::pair<double, double> ACRansacOut = robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &model, precision);
+        std::mt19937 generator(resectionData.randomSeed);
+        const std::pair<double, double> ACRansacOut = robustEstimation::ACRANSACParallel(kernel, generator, resectionData.vec_inliers, resectionData.max_iteration, &model, precision, 64, resectionData.useSPRT);
 
         P = model.getMatrix();
 
@@ -128,9 +130,17 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
         // and normalization inside the kernel
         // @todo refactor, maybe move scorer directly inside the kernel
         const double threshold = resectionData.error_max * resectionData.error_max * (kernel.normalizer2()(0, 0) * kernel.normalizer2()(0, 0));
-        robustEstimation::ScoreEvaluator<KernelT> scorer(threshold);
-
-        const robustEstimation::Mat34Model model = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers);
+        robustEstimation::Mat34Model model;
+        if(resectionData.useSPRT)
+        {
+          const robustEstimation::ScoreEvaluatorSPRT<KernelT> scorer(threshold);
+          model = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers);
+        }
+        else
+        {
+          const robustEstimation::ScoreEvaluator<KernelT> scorer(threshold);
+          model = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers);
+        }
         P = model.getMatrix();
 
         break;
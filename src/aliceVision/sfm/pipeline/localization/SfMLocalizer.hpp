@@ -14,6 +14,7 @@
 
 #include <cstddef>
 #include <limits>
+#include <random>
 
 namespace aliceVision {
 namespace sfm {
@@ -42,6 +43,13 @@ struct ImageLocalizerMatchData
   /// Upper bound pixel(s) tolerance for residual errors
   double error_max = std::numeric_limits<double>::infinity();
   size_t max_iteration = 4096;
+
+  /// Seed of the random number generator used by the robust estimation,
+  /// random by default as the sequential ACRANSAC sampling: set it to get reproducible resections
+  std::mt19937::result_type randomSeed = std::random_device()();
+
+  /// Reject bad hypotheses early with a SPRT during the robust estimation
+  bool useSPRT = false;
 };
 
 class SfMLocalizer
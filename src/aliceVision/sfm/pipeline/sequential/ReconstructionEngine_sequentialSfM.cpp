@@ -555,6 +555,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
     ResectionData newResectionData;
     newResectionData.error_max = _params.localizerEstimatorError;
     newResectionData.max_iteration = _params.localizerEstimatorMaxIterations;
+    newResectionData.useSPRT = _params.localizerEstimatorSPRT;
     const bool hasResected = computeResection(viewId, newResectionData);
 
 #pragma omp critical
@@ -664,6 +665,10 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
     }
   }
 
+  // the outlier removal iterations only change a few landmarks,
+  // keep the Ceres problem between them
+  options.persistentProblem = true;
+
   BundleAdjustmentCeres BA(options);
 
   // give the local strategy graph is local strategy is enable
@@ -62,6 +62,7 @@ public:
     robustEstimation::ERobustEstimator localizerEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
     double localizerEstimatorError = std::numeric_limits<double>::infinity();
     size_t localizerEstimatorMaxIterations = 4096;
+    bool localizerEstimatorSPRT = false;
 
     // Pyramid scoring
 
@@ -0,0 +1,186 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <ceres/ceres.h>
+
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE residualErrorCostFunction
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+
+namespace {
+
+/**
+ * @brief Random parameter blocks of a visible observation
+ */
+struct Sample
+{
+  std::vector<double> intrinsic;
+  std::array<double, 6> pose;
+  std::array<double, 3> point;
+};
+
+std::vector<Sample> generateSamples(const std::vector<double>& intrinsic, std::size_t nbSamples)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> rotation(-0.5, 0.5);
+  std::uniform_real_distribution<double> translation(-1.0, 1.0);
+  std::uniform_real_distribution<double> lateral(-1.0, 1.0);
+  std::uniform_real_distribution<double> depth(2.0, 10.0);
+
+  std::vector<Sample> samples(nbSamples);
+  for(Sample& sample : samples)
+  {
+    sample.intrinsic = intrinsic;
+    sample.pose = {rotation(generator), rotation(generator), rotation(generator),
+                   translation(generator), translation(generator), translation(generator)};
+
+    // choose a point in front of the camera and express it in the world coordinate system
+    const Vec3 P(lateral(generator), lateral(generator), depth(generator));
+    Mat3 R;
+    ceres::AngleAxisToRotationMatrix(sample.pose.data(), R.data());
+    const Vec3 X = R.transpose() * (P - Vec3(sample.pose[3], sample.pose[4], sample.pose[5]));
+    sample.point = {X(0), X(1), X(2)};
+  }
+  return samples;
+}
+
+/**
+ * @brief Compare the residuals and the Jacobians of two cost functions
+ */
+void checkCostFunctions(const ceres::CostFunction& analytic, const ceres::CostFunction& autodiff, const std::vector<Sample>& samples)
+{
+  const std::size_t intrinsicSize = samples.front().intrinsic.size();
+
+  for(const Sample& sample : samples)
+  {
+    const double* parameters[3] = {sample.intrinsic.data(), sample.pose.data(), sample.point.data()};
+
+    std::array<double, 2> residualsAnalytic, residualsAutodiff;
+    std::vector<double> jK_analytic(2 * intrinsicSize), jK_autodiff(2 * intrinsicSize);
+    std::array<double, 12> jRt_analytic, jRt_autodiff;
+    std::array<double, 6> jX_analytic, jX_autodiff;
+    double* jacobiansAnalytic[3] = {jK_analytic.data(), jRt_analytic.data(), jX_analytic.data()};
+    double* jacobiansAutodiff[3] = {jK_autodiff.data(), jRt_autodiff.data(), jX_autodiff.data()};
+
+    BOOST_CHECK(analytic.Evaluate(parameters, residualsAnalytic.data(), jacobiansAnalytic));
+    BOOST_CHECK(autodiff.Evaluate(parameters, residualsAutodiff.data(), jacobiansAutodiff));
+
+    for(std::size_t i = 0; i < 2; ++i)
+      BOOST_CHECK_SMALL(residualsAnalytic[i] - residualsAutodiff[i], 1e-8);
+    for(std::size_t i = 0; i < jK_analytic.size(); ++i)
+      BOOST_CHECK_SMALL(jK_analytic[i] - jK_autodiff[i], 1e-6 * std::max(1.0, std::abs(jK_autodiff[i])));
+    for(std::size_t i = 0; i < jRt_analytic.size(); ++i)
+      BOOST_CHECK_SMALL(jRt_analytic[i] - jRt_autodiff[i], 1e-6 * std::max(1.0, std::abs(jRt_autodiff[i])));
+    for(std::size_t i = 0; i < jX_analytic.size(); ++i)
+      BOOST_CHECK_SMALL(jX_analytic[i] - jX_autodiff[i], 1e-6 * std::max(1.0, std::abs(jX_autodiff[i])));
+  }
+}
+
+/**
+ * @brief Measure the number of residual and Jacobian evaluations per second of a cost function
+ */
+double evaluationsPerSecond(const ceres::CostFunction& costFunction, const std::vector<Sample>& samples, std::size_t nbRepetitions)
+{
+  const std::size_t intrinsicSize = samples.front().intrinsic.size();
+  std::array<double, 2> residuals;
+  std::vector<double> jK(2 * intrinsicSize);
+  std::array<double, 12> jRt;
+  std::array<double, 6> jX;
+  double* jacobians[3] = {jK.data(), jRt.data(), jX.data()};
+  double checksum = 0.0;
+
+  system::Timer timer;
+  for(std::size_t r = 0; r < nbRepetitions; ++r)
+  {
+    for(const Sample& sample : samples)
+    {
+      const double* parameters[3] = {sample.intrinsic.data(), sample.pose.data(), sample.point.data()};
+      costFunction.Evaluate(parameters, residuals.data(), jacobians);
+      checksum += residuals[0] + jRt[0];
+    }
+  }
+  const double elapsed = timer.elapsed();
+  BOOST_CHECK(std::isfinite(checksum));
+  return (nbRepetitions * samples.size()) / std::max(elapsed, 1e-9);
+}
+
+void compareCostFunctions(const std::string& name, const ceres::CostFunction& analytic, const ceres::CostFunction& autodiff, const std::vector<double>& intrinsic)
+{
+  const std::vector<Sample> samples = generateSamples(intrinsic, 1000);
+
+  checkCostFunctions(analytic, autodiff, samples);
+
+  const std::size_t nbRepetitions = 20;
+  const double analyticThroughput = evaluationsPerSecond(analytic, samples, nbRepetitions);
+  const double autodiffThroughput = evaluationsPerSecond(autodiff, samples, nbRepetitions);
+
+  ALICEVISION_LOG_INFO(name << " Jacobian evaluations per second:" << std::endl
+                       << "\t- analytic: " << analyticThroughput << std::endl
+                       << "\t- autodiff: " << autodiffThroughput << std::endl
+                       << "\t- speedup:  " << analyticThroughput / autodiffThroughput);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(COST_FUNCTION_AnalyticDerivatives_Pinhole)
+{
+  const sfmData::Observation observation(Vec2(520.0, 410.0), 0, 2.0);
+
+  const ResidualErrorCostFunction_Pinhole analytic(observation);
+  const ceres::AutoDiffCostFunction<ResidualErrorFunctor_Pinhole, 2, 3, 6, 3> autodiff(new ResidualErrorFunctor_Pinhole(observation));
+
+  compareCostFunctions("Pinhole", analytic, autodiff, {1000.0, 480.0, 360.0});
+}
+
+BOOST_AUTO_TEST_CASE(COST_FUNCTION_AnalyticDerivatives_PinholeRadialK3)
+{
+  const sfmData::Observation observation(Vec2(520.0, 410.0), 0, 2.0);
+
+  const ResidualErrorCostFunction_PinholeRadialK3 analytic(observation);
+  const ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeRadialK3, 2, 6, 6, 3> autodiff(new ResidualErrorFunctor_PinholeRadialK3(observation));
+
+  compareCostFunctions("PinholeRadialK3", analytic, autodiff, {1000.0, 480.0, 360.0, 0.1, -0.05, 0.01});
+}
+
+BOOST_AUTO_TEST_CASE(COST_FUNCTION_AnalyticDerivatives_Equidistant)
+{
+  const sfmData::Observation observation(Vec2(520.0, 410.0), 0, 2.0);
+  const camera::EquiDistant intrinsic(1000, 1000, 500.0, 500.0, 500.0);
+  const double radiusCoefficient = getEquidistantRadiusCoefficient(intrinsic);
+
+  const ResidualErrorCostFunction_Equidistant analytic(observation, radiusCoefficient);
+  const ceres::AutoDiffCostFunction<ResidualErrorFunctor_Equidistant, 2, 3, 6, 3> autodiff(new ResidualErrorFunctor_Equidistant(observation, radiusCoefficient));
+
+  compareCostFunctions("Equidistant", analytic, autodiff, {500.0, 500.0, 500.0});
+
+  // the residual is consistent with the camera model
+  const geometry::Pose3 pose(Mat3::Identity(), Vec3::Zero());
+  const Vec3 X(0.3, -0.2, 1.5);
+  const double cam_Rt[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  const double cam_K[3] = {500.0, 500.0, 500.0};
+  const double* parameters[3] = {cam_K, cam_Rt, X.data()};
+  double residuals[2];
+  analytic.Evaluate(parameters, residuals, nullptr);
+
+  const Vec2 projected = intrinsic.project(pose, X);
+  BOOST_CHECK_SMALL(2.0 * residuals[0] + observation.x(0) - projected(0), 1e-8);
+  BOOST_CHECK_SMALL(2.0 * residuals[1] + observation.x(1) - projected(1), 1e-8);
+}
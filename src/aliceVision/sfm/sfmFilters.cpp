@@ -10,6 +10,7 @@
 #include <aliceVision/stl/stl.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
+#include <aliceVision/sfm/utils/statistics.hpp>
 
 #include <iterator>
 
@@ -22,21 +23,23 @@ IndexT RemoveOutliers_PixelResidualError(sfmData::SfMData& sfmData,
                                          const unsigned int minTrackLength)
 {
   IndexT outlier_count = 0;
-  sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
 
+  // residuals of the observations, computed in batch per view
+  std::map<IndexT, ViewResiduals> viewsResiduals;
+  computeViewsResiduals(sfmData, viewsResiduals);
 
-  while(iterTracks != sfmData.structure.end())
+  for(const auto& viewResidualsPair : viewsResiduals)
   {
-    sfmData::Observations & observations = iterTracks->second.observations;
-    sfmData::Observations::iterator itObs = observations.begin();
+    const IndexT viewId = viewResidualsPair.first;
+    const ViewResiduals& viewResiduals = viewResidualsPair.second;
+    const geometry::Pose3 pose = sfmData.getPose(sfmData.getView(viewId)).getTransform();
 
-    while(itObs != observations.end())
+    for(std::size_t o = 0; o < viewResiduals.landmarkIds.size(); ++o)
     {
-      const sfmData::View * view = sfmData.views.at(itObs->first).get();
-      const geometry::Pose3 pose = sfmData.getPose(*view).getTransform();
-      const camera::IntrinsicBase * intrinsic = sfmData.intrinsics.at(view->getIntrinsicId()).get();
+      sfmData::Observations& observations = sfmData.structure.at(viewResiduals.landmarkIds[o]).observations;
+      const sfmData::Observations::iterator itObs = observations.find(viewId);
 
-      Vec2 residual = intrinsic->residual(pose, iterTracks->second.X, itObs->second.x);
+      Vec2 residual = viewResiduals.residuals.col(o);
       if(featureConstraint == EFeatureConstraint::SCALE && itObs->second.scale > 0.0)
       {
           // Apply the scale of the feature to get a residual value
@@ -44,15 +47,18 @@ IndexT RemoveOutliers_PixelResidualError(sfmData::SfMData& sfmData,
           residual /= itObs->second.scale;
       }
 
-      if((pose.depth(iterTracks->second.X) < 0) || (residual.norm() > dThresholdPixel))
+      if((pose.depth(viewResiduals.pts3D.col(o)) < 0) || (residual.norm() > dThresholdPixel))
       {
         ++outlier_count;
-        itObs = observations.erase(itObs);
+        observations.erase(itObs);
       }
-      else
-        ++itObs;
     }
+  }
 
+  sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
+  while(iterTracks != sfmData.structure.end())
+  {
+    const sfmData::Observations& observations = iterTracks->second.observations;
     if (observations.empty() || observations.size() < minTrackLength)
       iterTracks = sfmData.structure.erase(iterTracks);
     else
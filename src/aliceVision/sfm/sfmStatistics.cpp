@@ -7,6 +7,7 @@
 #include "sfmStatistics.hpp"
 
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
+#include <aliceVision/sfm/utils/statistics.hpp>
 
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 #include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
@@ -30,26 +31,17 @@ void computeResidualsHistogram(const sfmData::SfMData& sfmData, BoxStats<double>
     return;
 
   // Collect residuals for each observation
+  std::map<IndexT, ViewResiduals> viewsResiduals;
+  computeViewsResiduals(sfmData, viewsResiduals, specificViews);
+
   std::vector<double> vec_residuals;
   vec_residuals.reserve(sfmData.structure.size());
 
-  for(const auto &track : sfmData.getLandmarks())
+  for(const auto& viewResidualsPair : viewsResiduals)
   {
-    const aliceVision::sfmData::Observations & observations = track.second.observations;
-    for(const auto& obs: observations)
-    {
-      if(!specificViews.empty())
-      {
-          if(specificViews.count(obs.first) == 0)
-              continue;
-      }
-      const sfmData::View& view = sfmData.getView(obs.first);
-      const aliceVision::geometry::Pose3 pose = sfmData.getPose(view).getTransform();
-      const std::shared_ptr<aliceVision::camera::IntrinsicBase> intrinsic = sfmData.getIntrinsics().find(view.getIntrinsicId())->second;
-      const Vec2 residual = intrinsic->residual(pose, track.second.X, obs.second.x);
-      vec_residuals.push_back(residual.norm());
-      //ALICEVISION_LOG_INFO("[AliceVision] sfmtstatistics::computeResidualsHistogram track: " << track.first << ", residual: " << residual.norm());
-    }
+    const Mat2X& residuals = viewResidualsPair.second.residuals;
+    for(Mat2X::Index o = 0; o < residuals.cols(); ++o)
+      vec_residuals.push_back(residuals.col(o).norm());
   }
 
  // ALICEVISION_LOG_INFO("[AliceVision] sfmtstatistics::computeResidualsHistogram vec_residuals.size(): " << vec_residuals.size());
@@ -319,19 +311,17 @@ void computeResidualsPerView(const sfmData::SfMData& sfmData, int& nbViews, std:
     nbResidualsPerViewThirdQuartile.resize(nbViews);
 
     // Collect residuals (number of residuals per 3D points) of all landmarks visible in each view
-    std::map<IndexT, std::vector<double>> residualsPerView;
+    std::map<IndexT, ViewResiduals> viewsResiduals;
+    computeViewsResiduals(sfmData, viewsResiduals);
 
-    for(const auto &landmark : sfmData.getLandmarks())
+    std::map<IndexT, std::vector<double>> residualsPerView;
+    for(const auto& viewResidualsPair : viewsResiduals)
     {
-      const aliceVision::sfmData::Observations & observations = landmark.second.observations;
-      for(const auto& obs: observations)
-      {
-        const sfmData::View& view = sfmData.getView(obs.first);
-        const aliceVision::geometry::Pose3 pose = sfmData.getPose(view).getTransform();
-        const std::shared_ptr<aliceVision::camera::IntrinsicBase> intrinsic = sfmData.getIntrinsics().find(view.getIntrinsicId())->second;
-        const Vec2 residual = intrinsic->residual(pose, landmark.second.X, obs.second.x);
-        residualsPerView[obs.first].push_back(residual.norm());
-      }
+      const Mat2X& residuals = viewResidualsPair.second.residuals;
+      std::vector<double>& viewResiduals = residualsPerView[viewResidualsPair.first];
+      viewResiduals.reserve(residuals.cols());
+      for(Mat2X::Index o = 0; o < residuals.cols(); ++o)
+        viewResiduals.push_back(residuals.col(o).norm());
     }
 
     std::vector<IndexT> viewKeys;
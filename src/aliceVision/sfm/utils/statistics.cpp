@@ -11,28 +11,65 @@
 namespace aliceVision {
 namespace sfm {
 
-double RMSE(const sfmData::SfMData& sfmData)
+void computeViewsResiduals(const sfmData::SfMData& sfmData,
+                           std::map<IndexT, ViewResiduals>& out_residuals,
+                           const std::set<IndexT>& specificViews)
 {
-  // Compute residuals for each observation
-  std::vector<double> vec;
-  for(sfmData::Landmarks::const_iterator iterTracks = sfmData.getLandmarks().begin();
-      iterTracks != sfmData.getLandmarks().end();
-      ++iterTracks)
+  out_residuals.clear();
+
+  // landmarks observed by each view
+  for(const auto& landmarkPair : sfmData.getLandmarks())
   {
-    const sfmData::Observations& obs = iterTracks->second.observations;
-    for(sfmData::Observations::const_iterator itObs = obs.begin();
-      itObs != obs.end(); ++itObs)
+    for(const auto& observationPair : landmarkPair.second.observations)
     {
-      const sfmData::View* view = sfmData.getViews().find(itObs->first)->second.get();
-      const geometry::Pose3 pose = sfmData.getPose(*view).getTransform();
-      const std::shared_ptr<camera::IntrinsicBase> intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId());
-      const Vec2 residual = intrinsic->residual(pose, iterTracks->second.X, itObs->second.x);
-      vec.push_back(residual(0));
-      vec.push_back(residual(1));
+      if(specificViews.empty() || specificViews.count(observationPair.first))
+        out_residuals[observationPair.first].landmarkIds.push_back(landmarkPair.first);
     }
   }
-  const Eigen::Map<Eigen::RowVectorXd> residuals(&vec[0], vec.size());
-  const double RMSE = std::sqrt(residuals.squaredNorm() / vec.size());
+
+  std::vector<std::map<IndexT, ViewResiduals>::iterator> viewsResiduals;
+  viewsResiduals.reserve(out_residuals.size());
+  for(auto it = out_residuals.begin(); it != out_residuals.end(); ++it)
+    viewsResiduals.push_back(it);
+
+  // project the landmarks of each view in batch
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(viewsResiduals.size()); ++i)
+  {
+    const IndexT viewId = viewsResiduals[i]->first;
+    ViewResiduals& viewResiduals = viewsResiduals[i]->second;
+
+    const sfmData::View& view = sfmData.getView(viewId);
+    const geometry::Pose3 pose = sfmData.getPose(view).getTransform();
+    const camera::IntrinsicBase& intrinsic = *sfmData.getIntrinsics().at(view.getIntrinsicId());
+
+    const std::size_t nbObservations = viewResiduals.landmarkIds.size();
+    Mat2X pts2D(2, nbObservations);
+    viewResiduals.pts3D.resize(3, nbObservations);
+    for(std::size_t o = 0; o < nbObservations; ++o)
+    {
+      const sfmData::Landmark& landmark = sfmData.getLandmarks().at(viewResiduals.landmarkIds[o]);
+      viewResiduals.pts3D.col(o) = landmark.X;
+      pts2D.col(o) = landmark.observations.at(viewId).x;
+    }
+    viewResiduals.residuals = intrinsic.residuals(pose, viewResiduals.pts3D, pts2D);
+  }
+}
+
+double RMSE(const sfmData::SfMData& sfmData)
+{
+  // Compute residuals for each observation
+  std::map<IndexT, ViewResiduals> viewsResiduals;
+  computeViewsResiduals(sfmData, viewsResiduals);
+
+  double squaredNorm = 0.0;
+  std::size_t nbValues = 0;
+  for(const auto& viewResidualsPair : viewsResiduals)
+  {
+    squaredNorm += viewResidualsPair.second.residuals.squaredNorm();
+    nbValues += viewResidualsPair.second.residuals.size();
+  }
+  const double RMSE = std::sqrt(squaredNorm / nbValues);
   return RMSE;
 }
 
@@ -7,6 +7,13 @@
 
 #pragma once
 
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/types.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
+
 namespace aliceVision {
 
 namespace sfmData {
@@ -15,6 +22,30 @@ class SfMData;
 
 namespace sfm {
 
+/**
+ * @brief Reprojection residuals of the observations of a view
+ */
+struct ViewResiduals
+{
+  /// landmark of each observation
+  std::vector<IndexT> landmarkIds;
+  /// 3D point of each observation, one per column
+  Mat3X pts3D;
+  /// residual of each observation, one per column
+  Mat2X residuals;
+};
+
+/**
+ * @brief Compute the reprojection residuals of the observations, grouped by view,
+ *        with one batch projection per view (see IntrinsicBase::residuals)
+ * @param[in] sfmData The given input SfMData
+ * @param[out] out_residuals The residuals of the observations of each view
+ * @param[in] specificViews Limit the computation to these views, if not empty
+ */
+void computeViewsResiduals(const sfmData::SfMData& sfmData,
+                           std::map<IndexT, ViewResiduals>& out_residuals,
+                           const std::set<IndexT>& specificViews = std::set<IndexT>());
+
 /**
  * @brief Compute the Root Mean Square Error of the residuals
  * @param[in] sfmData The given input SfMData
@@ -0,0 +1,839 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryIO.hpp"
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace {
+
+/// Magic number and version of the binary SfMData format
+const char binMagic[4] = {'A', 'V', 'S', 'F'};
+const std::uint32_t binVersion = 2;
+
+/**
+ * @brief Serialize the payload of a section in memory, then write it with its header.
+ */
+class SectionWriter
+{
+public:
+  template<typename T>
+  void write(const T& value)
+  {
+    append(&value, sizeof(T));
+  }
+
+  template<typename T>
+  void writeArray(const std::vector<T>& values)
+  {
+    append(values.data(), values.size() * sizeof(T));
+  }
+
+  void writeString(const std::string& str)
+  {
+    write<std::uint32_t>(str.size());
+    append(str.data(), str.size());
+  }
+
+  template<typename Derived>
+  void writeMatrix(const Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      write<double>(matrix(i));
+  }
+
+  void writeSection(std::ofstream& file, const char* tag, std::uint64_t count) const
+  {
+    const std::uint64_t sectionSize = sizeof(std::uint64_t) + _data.size();
+    file.write(tag, 4);
+    file.write(reinterpret_cast<const char*>(&sectionSize), sizeof(sectionSize));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(_data.data(), _data.size());
+  }
+
+private:
+  void append(const void* data, std::size_t size)
+  {
+    const char* bytes = static_cast<const char*>(data);
+    _data.insert(_data.end(), bytes, bytes + size);
+  }
+
+  std::vector<char> _data;
+};
+
+/**
+ * @brief Read the payload of a section in memory and parse it.
+ */
+class SectionReader
+{
+public:
+  SectionReader(std::ifstream& file, std::uint64_t payloadSize)
+    : _data(payloadSize)
+  {
+    file.read(_data.data(), payloadSize);
+    if(!file)
+      throw std::runtime_error("Truncated binary SfMData section.");
+  }
+
+  template<typename T>
+  T read()
+  {
+    T value;
+    copy(&value, sizeof(T));
+    return value;
+  }
+
+  template<typename T>
+  void readArray(std::vector<T>& values, std::size_t count)
+  {
+    checkCount(count, sizeof(T));
+    values.resize(count);
+    copy(values.data(), count * sizeof(T));
+  }
+
+  std::string readString()
+  {
+    const std::uint32_t size = read<std::uint32_t>();
+    checkCount(size, 1);
+    std::string str(size, '\0');
+    copy(&str[0], size);
+    return str;
+  }
+
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    for(int i = 0; i < matrix.size(); ++i)
+      matrix(i) = read<double>();
+  }
+
+  /**
+   * @brief Check that the rest of the section can hold count elements of at least elementSize bytes,
+   * before allocating them.
+   */
+  void checkCount(std::uint64_t count, std::size_t elementSize) const
+  {
+    if(count > (_data.size() - _pos) / elementSize)
+      throw std::runtime_error("Corrupted binary SfMData section.");
+  }
+
+private:
+  void copy(void* dst, std::size_t size)
+  {
+    if(_pos + size > _data.size())
+      throw std::runtime_error("Corrupted binary SfMData section.");
+    std::memcpy(dst, _data.data() + _pos, size);
+    _pos += size;
+  }
+
+  std::vector<char> _data;
+  std::size_t _pos = 0;
+};
+
+void writeFolders(std::ofstream& file, const sfmData::SfMData& sfmData)
+{
+  SectionWriter section;
+  const std::vector<std::string>& featuresFolders = sfmData.getRelativeFeaturesFolders();
+  const std::vector<std::string>& matchesFolders = sfmData.getRelativeMatchesFolders();
+
+  section.write<std::uint32_t>(featuresFolders.size());
+  for(const std::string& folder : featuresFolders)
+    section.writeString(folder);
+
+  section.write<std::uint32_t>(matchesFolders.size());
+  for(const std::string& folder : matchesFolders)
+    section.writeString(folder);
+
+  section.writeSection(file, "FOLD", featuresFolders.size() + matchesFolders.size());
+}
+
+void readFolders(SectionReader& section, sfmData::SfMData& sfmData)
+{
+  const std::uint32_t nbFeaturesFolders = section.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbFeaturesFolders; ++i)
+    sfmData.addFeaturesFolder(section.readString());
+
+  const std::uint32_t nbMatchesFolders = section.read<std::uint32_t>();
+  for(std::uint32_t i = 0; i < nbMatchesFolders; ++i)
+    sfmData.addMatchesFolder(section.readString());
+}
+
+void writeViews(std::ofstream& file, const sfmData::Views& views)
+{
+  SectionWriter section;
+
+  for(const auto& viewPair : views)
+  {
+    const sfmData::View& view = *viewPair.second;
+
+    section.write<IndexT>(view.getViewId());
+    section.write<IndexT>(view.getPoseId());
+    section.write<IndexT>(view.isPartOfRig() ? view.getRigId() : UndefinedIndexT);
+    section.write<IndexT>(view.isPartOfRig() ? view.getSubPoseId() : UndefinedIndexT);
+    section.write<IndexT>(view.getFrameId());
+    section.write<IndexT>(view.getIntrinsicId());
+    section.write<IndexT>(view.getResectionId());
+    section.write<std::uint8_t>(view.isPoseIndependant());
+    section.writeString(view.getImagePath());
+    section.write<std::uint64_t>(view.getWidth());
+    section.write<std::uint64_t>(view.getHeight());
+
+    const std::map<std::string, std::string>& metadata = view.getMetadata();
+    section.write<std::uint32_t>(metadata.size());
+    for(const auto& metadataPair : metadata)
+    {
+      section.writeString(metadataPair.first);
+      section.writeString(metadataPair.second);
+    }
+  }
+
+  section.writeSection(file, "VIEW", views.size());
+}
+
+void readViews(SectionReader& section, std::uint64_t count, sfmData::Views& views)
+{
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    auto view = std::make_shared<sfmData::View>();
+
+    view->setViewId(section.read<IndexT>());
+    view->setPoseId(section.read<IndexT>());
+
+    const IndexT rigId = section.read<IndexT>();
+    const IndexT subPoseId = section.read<IndexT>();
+    if(rigId != UndefinedIndexT)
+      view->setRigAndSubPoseId(rigId, subPoseId);
+
+    view->setFrameId(section.read<IndexT>());
+    view->setIntrinsicId(section.read<IndexT>());
+    view->setResectionId(section.read<IndexT>());
+    view->setIndependantPose(section.read<std::uint8_t>() != 0);
+    view->setImagePath(section.readString());
+    view->setWidth(section.read<std::uint64_t>());
+    view->setHeight(section.read<std::uint64_t>());
+
+    const std::uint32_t nbMetadata = section.read<std::uint32_t>();
+    for(std::uint32_t m = 0; m < nbMetadata; ++m)
+    {
+      const std::string key = section.readString();
+      view->addMetadata(key, section.readString());
+    }
+
+    views.emplace(view->getViewId(), view);
+  }
+}
+
+void writeIntrinsics(std::ofstream& file, const sfmData::Intrinsics& intrinsics)
+{
+  SectionWriter section;
+
+  for(const auto& intrinsicPair : intrinsics)
+  {
+    const camera::IntrinsicBase& intrinsic = *intrinsicPair.second;
+
+    section.write<IndexT>(intrinsicPair.first);
+    section.writeString(camera::EINTRINSIC_enumToString(intrinsic.getType()));
+    section.writeString(camera::EIntrinsicInitMode_enumToString(intrinsic.getInitializationMode()));
+    section.write<std::uint32_t>(intrinsic.w());
+    section.write<std::uint32_t>(intrinsic.h());
+    section.write<double>(intrinsic.sensorWidth());
+    section.write<double>(intrinsic.sensorHeight());
+    section.writeString(intrinsic.serialNumber());
+    section.write<std::uint8_t>(intrinsic.isLocked());
+
+    // scale and offset, the intrinsic is created from them
+    const auto* intrinsicScaleOffset = dynamic_cast<const camera::IntrinsicsScaleOffset*>(&intrinsic);
+    section.write<double>(intrinsicScaleOffset ? intrinsicScaleOffset->initialScale() : -1.0);
+    section.write<double>(intrinsicScaleOffset ? intrinsicScaleOffset->getScale()(0) : 1.0);
+    section.writeMatrix(intrinsicScaleOffset ? intrinsicScaleOffset->getOffset() : Vec2(Vec2::Zero()));
+
+    // distortion
+    const auto* intrinsicScaleOffsetDisto = dynamic_cast<const camera::IntrinsicsScaleOffsetDisto*>(&intrinsic);
+    const std::vector<double> distortionParams = intrinsicScaleOffsetDisto ? intrinsicScaleOffsetDisto->getDistortionParams() : std::vector<double>();
+    section.write<std::uint32_t>(distortionParams.size());
+    section.writeArray(distortionParams);
+
+    // fisheye circle
+    const auto* intrinsicEquidistant = dynamic_cast<const camera::EquiDistant*>(&intrinsic);
+    section.write<std::uint8_t>(intrinsicEquidistant != nullptr);
+    if(intrinsicEquidistant)
+    {
+      section.write<double>(intrinsicEquidistant->getCircleCenterX());
+      section.write<double>(intrinsicEquidistant->getCircleCenterY());
+      section.write<double>(intrinsicEquidistant->getCircleRadius());
+    }
+  }
+
+  section.writeSection(file, "INTR", intrinsics.size());
+}
+
+void readIntrinsics(SectionReader& section, std::uint64_t count, sfmData::Intrinsics& intrinsics)
+{
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    const IndexT intrinsicId = section.read<IndexT>();
+    const camera::EINTRINSIC intrinsicType = camera::EINTRINSIC_stringToEnum(section.readString());
+    const camera::EIntrinsicInitMode initializationMode = camera::EIntrinsicInitMode_stringToEnum(section.readString());
+    const unsigned int width = section.read<std::uint32_t>();
+    const unsigned int height = section.read<std::uint32_t>();
+    const double sensorWidth = section.read<double>();
+    const double sensorHeight = section.read<double>();
+    const std::string serialNumber = section.readString();
+    const bool locked = section.read<std::uint8_t>() != 0;
+    const double pxInitialFocalLength = section.read<double>();
+    const double pxFocalLength = section.read<double>();
+    Vec2 principalPoint;
+    section.readMatrix(principalPoint);
+
+    std::shared_ptr<camera::IntrinsicBase> intrinsic = camera::createIntrinsic(intrinsicType, width, height, pxFocalLength, principalPoint(0), principalPoint(1));
+
+    intrinsic->setSerialNumber(serialNumber);
+    intrinsic->setInitializationMode(initializationMode);
+    intrinsic->setSensorWidth(sensorWidth);
+    intrinsic->setSensorHeight(sensorHeight);
+
+    if(locked)
+      intrinsic->lock();
+    else
+      intrinsic->unlock();
+
+    std::shared_ptr<camera::IntrinsicsScaleOffset> intrinsicWithScale = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffset>(intrinsic);
+    if(intrinsicWithScale != nullptr)
+      intrinsicWithScale->setInitialScale(pxInitialFocalLength);
+
+    std::vector<double> distortionParams;
+    section.readArray(distortionParams, section.read<std::uint32_t>());
+
+    std::shared_ptr<camera::IntrinsicsScaleOffsetDisto> intrinsicWithDistoEnabled = std::dynamic_pointer_cast<camera::IntrinsicsScaleOffsetDisto>(intrinsic);
+    if(intrinsicWithDistoEnabled != nullptr)
+    {
+      // ensure that we have the right number of params
+      distortionParams.resize(intrinsicWithDistoEnabled->getDistortionParams().size(), 0.0);
+      intrinsicWithDistoEnabled->setDistortionParams(distortionParams);
+    }
+
+    if(section.read<std::uint8_t>() != 0)
+    {
+      const double circleCenterX = section.read<double>();
+      const double circleCenterY = section.read<double>();
+      const double circleRadius = section.read<double>();
+
+      std::shared_ptr<camera::EquiDistant> intrinsicEquiDistant = std::dynamic_pointer_cast<camera::EquiDistant>(intrinsic);
+      if(intrinsicEquiDistant != nullptr)
+      {
+        intrinsicEquiDistant->setCircleCenterX(circleCenterX);
+        intrinsicEquiDistant->setCircleCenterY(circleCenterY);
+        intrinsicEquiDistant->setCircleRadius(circleRadius);
+      }
+    }
+
+    intrinsics.emplace(intrinsicId, intrinsic);
+  }
+}
+
+void writePoses(std::ofstream& file, const sfmData::Poses& poses)
+{
+  SectionWriter section;
+
+  for(const auto& posePair : poses)
+  {
+    const geometry::Pose3& transform = posePair.second.getTransform();
+
+    section.write<IndexT>(posePair.first);
+    section.writeMatrix(transform.rotation());
+    section.writeMatrix(transform.center());
+    section.write<std::uint8_t>(posePair.second.isLocked());
+  }
+
+  section.writeSection(file, "POSE", poses.size());
+}
+
+void readPoses(SectionReader& section, std::uint64_t count, sfmData::Poses& poses)
+{
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    const IndexT poseId = section.read<IndexT>();
+    Mat3 rotation;
+    Vec3 center;
+    section.readMatrix(rotation);
+    section.readMatrix(center);
+    const bool locked = section.read<std::uint8_t>() != 0;
+
+    poses.emplace(poseId, sfmData::CameraPose(geometry::Pose3(rotation, center), locked));
+  }
+}
+
+void writeRigs(std::ofstream& file, const sfmData::Rigs& rigs)
+{
+  SectionWriter section;
+
+  for(const auto& rigPair : rigs)
+  {
+    const std::vector<sfmData::RigSubPose>& subPoses = rigPair.second.getSubPoses();
+
+    section.write<IndexT>(rigPair.first);
+    section.write<std::uint32_t>(subPoses.size());
+
+    for(const sfmData::RigSubPose& subPose : subPoses)
+    {
+      section.writeString(sfmData::ERigSubPoseStatus_enumToString(subPose.status));
+      section.writeMatrix(subPose.pose.rotation());
+      section.writeMatrix(subPose.pose.center());
+    }
+  }
+
+  section.writeSection(file, "RIGS", rigs.size());
+}
+
+void readRigs(SectionReader& section, std::uint64_t count, sfmData::Rigs& rigs)
+{
+  for(std::uint64_t i = 0; i < count; ++i)
+  {
+    const IndexT rigId = section.read<IndexT>();
+    const std::uint32_t nbSubPoses = section.read<std::uint32_t>();
+    section.checkCount(nbSubPoses, 12 * sizeof(double));
+    sfmData::Rig rig(nbSubPoses);
+
+    for(std::uint32_t subPoseId = 0; subPoseId < nbSubPoses; ++subPoseId)
+    {
+      sfmData::RigSubPose subPose;
+      subPose.status = sfmData::ERigSubPoseStatus_stringToEnum(section.readString());
+
+      Mat3 rotation;
+      Vec3 center;
+      section.readMatrix(rotation);
+      section.readMatrix(center);
+      subPose.pose = geometry::Pose3(rotation, center);
+
+      rig.setSubPose(subPoseId, subPose);
+    }
+
+    rigs.emplace(rigId, rig);
+  }
+}
+
+/// Tags of the three sections of a set of landmarks
+struct LandmarksTags
+{
+  const char* landmarks;
+  const char* observations;
+  const char* features;
+};
+
+const LandmarksTags structureTags = {"LMKS", "OBSV", "FEAT"};
+const LandmarksTags controlPointsTags = {"CPTS", "CPOB", "CPFT"};
+
+void writeLandmarks(std::ofstream& file, const sfmData::Landmarks& landmarks, const LandmarksTags& tags, bool saveObservations, bool saveFeatures)
+{
+  const std::size_t nbLandmarks = landmarks.size();
+
+  // landmarks, one array per field
+  {
+    std::vector<IndexT> ids;
+    std::vector<std::uint8_t> descTypes;
+    std::vector<double> positions;
+    std::vector<std::uint8_t> colors;
+    ids.reserve(nbLandmarks);
+    descTypes.reserve(nbLandmarks);
+    positions.reserve(3 * nbLandmarks);
+    colors.reserve(3 * nbLandmarks);
+
+    // describer types are stored by name, landmarks refer to them by index
+    std::map<feature::EImageDescriberType, std::uint8_t> descTypesIndices;
+    std::vector<std::string> descTypesNames;
+
+    for(const auto& landmarkPair : landmarks)
+    {
+      const sfmData::Landmark& landmark = landmarkPair.second;
+
+      auto descTypeIt = descTypesIndices.find(landmark.descType);
+      if(descTypeIt == descTypesIndices.end())
+      {
+        descTypeIt = descTypesIndices.emplace(landmark.descType, descTypesNames.size()).first;
+        descTypesNames.push_back(feature::EImageDescriberType_enumToString(landmark.descType));
+      }
+
+      ids.push_back(landmarkPair.first);
+      descTypes.push_back(descTypeIt->second);
+      positions.insert(positions.end(), landmark.X.data(), landmark.X.data() + 3);
+      colors.insert(colors.end(), {landmark.rgb.r(), landmark.rgb.g(), landmark.rgb.b()});
+    }
+
+    SectionWriter section;
+    section.write<std::uint32_t>(descTypesNames.size());
+    for(const std::string& descTypeName : descTypesNames)
+      section.writeString(descTypeName);
+    section.writeArray(ids);
+    section.writeArray(descTypes);
+    section.writeArray(positions);
+    section.writeArray(colors);
+    section.writeSection(file, tags.landmarks, nbLandmarks);
+  }
+
+  if(!saveObservations)
+    return;
+
+  std::size_t nbObservations = 0;
+  for(const auto& landmarkPair : landmarks)
+    nbObservations += landmarkPair.second.observations.size();
+
+  // observations of each landmark, in the order of the landmarks section
+  {
+    std::vector<std::uint32_t> nbLandmarkObservations;
+    std::vector<IndexT> viewIds;
+    nbLandmarkObservations.reserve(nbLandmarks);
+    viewIds.reserve(nbObservations);
+
+    for(const auto& landmarkPair : landmarks)
+    {
+      const sfmData::Observations& observations = landmarkPair.second.observations;
+      nbLandmarkObservations.push_back(observations.size());
+      for(const auto& observationPair : observations)
+        viewIds.push_back(observationPair.first);
+    }
+
+    SectionWriter section;
+    section.writeArray(nbLandmarkObservations);
+    section.writeArray(viewIds);
+    section.writeSection(file, tags.observations, nbLandmarks);
+  }
+
+  if(!saveFeatures)
+    return;
+
+  // features of each observation, in the order of the observations section
+  {
+    std::vector<IndexT> featureIds;
+    std::vector<double> coordinates;
+    std::vector<double> scales;
+    featureIds.reserve(nbObservations);
+    coordinates.reserve(2 * nbObservations);
+    scales.reserve(nbObservations);
+
+    for(const auto& landmarkPair : landmarks)
+    {
+      for(const auto& observationPair : landmarkPair.second.observations)
+      {
+        const sfmData::Observation& observation = observationPair.second;
+        featureIds.push_back(observation.id_feat);
+        coordinates.insert(coordinates.end(), observation.x.data(), observation.x.data() + 2);
+        scales.push_back(observation.scale);
+      }
+    }
+
+    SectionWriter section;
+    section.writeArray(featureIds);
+    section.writeArray(coordinates);
+    section.writeArray(scales);
+    section.writeSection(file, tags.features, nbObservations);
+  }
+}
+
+/**
+ * @brief Landmarks being loaded, in the order of the file sections
+ */
+struct LandmarksLoader
+{
+  std::vector<sfmData::Landmark*> landmarks;
+  std::vector<std::size_t> observationsOffsets;
+
+  void readLandmarks(SectionReader& section, std::uint64_t count, sfmData::Landmarks& output)
+  {
+    const std::uint32_t nbDescTypes = section.read<std::uint32_t>();
+    section.checkCount(nbDescTypes, sizeof(std::uint32_t));
+    std::vector<feature::EImageDescriberType> descTypesByIndex(nbDescTypes);
+    for(feature::EImageDescriberType& descType : descTypesByIndex)
+      descType = feature::EImageDescriberType_stringToEnum(section.readString());
+
+    std::vector<IndexT> ids;
+    std::vector<std::uint8_t> descTypes;
+    std::vector<double> positions;
+    std::vector<std::uint8_t> colors;
+    section.readArray(ids, count);
+    section.readArray(descTypes, count);
+    section.readArray(positions, 3 * count);
+    section.readArray(colors, 3 * count);
+
+    // the observations are filled in parallel through the landmarks pointers: each id must be unique
+    landmarks.resize(count);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      if(descTypes[i] >= descTypesByIndex.size())
+        throw std::runtime_error("Corrupted binary SfMData landmarks section.");
+
+      const auto insertion = output.emplace(ids[i], sfmData::Landmark());
+      if(!insertion.second)
+        throw std::runtime_error("Duplicate landmark id " + std::to_string(ids[i]) + " in binary SfMData.");
+
+      sfmData::Landmark& landmark = insertion.first->second;
+      landmark.descType = descTypesByIndex[descTypes[i]];
+      landmark.X = Vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+      landmark.rgb = image::RGBColor(colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]);
+      landmarks[i] = &landmark;
+    }
+  }
+
+  void readObservations(SectionReader& section, std::uint64_t count)
+  {
+    if(count != landmarks.size())
+      throw std::runtime_error("Binary SfMData observations do not match the landmarks.");
+
+    std::vector<std::uint32_t> nbLandmarkObservations;
+    section.readArray(nbLandmarkObservations, count);
+
+    observationsOffsets.resize(count + 1);
+    observationsOffsets[0] = 0;
+    for(std::size_t i = 0; i < count; ++i)
+      observationsOffsets[i + 1] = observationsOffsets[i] + nbLandmarkObservations[i];
+
+    std::vector<IndexT> viewIds;
+    section.readArray(viewIds, observationsOffsets.back());
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      for(std::size_t o = observationsOffsets[i] + 1; o < observationsOffsets[i + 1]; ++o)
+      {
+        if(viewIds[o - 1] >= viewIds[o])
+          throw std::runtime_error("Binary SfMData observations are not sorted by view id.");
+      }
+    }
+
+    // observations are written sorted by view id: append them at the end of each flat_map
+    #pragma omp parallel for
+    for(int i = 0; i < static_cast<int>(count); ++i)
+    {
+      sfmData::Observations& observations = landmarks[i]->observations;
+      observations.reserve(nbLandmarkObservations[i]);
+      for(std::size_t o = observationsOffsets[i]; o < observationsOffsets[i + 1]; ++o)
+        observations.emplace_hint(observations.end(), viewIds[o], sfmData::Observation());
+    }
+  }
+
+  void readFeatures(SectionReader& section, std::uint64_t count)
+  {
+    if(observationsOffsets.empty() || count != observationsOffsets.back())
+      throw std::runtime_error("Binary SfMData features do not match the observations.");
+
+    std::vector<IndexT> featureIds;
+    std::vector<double> coordinates;
+    std::vector<double> scales;
+    section.readArray(featureIds, count);
+    section.readArray(coordinates, 2 * count);
+    section.readArray(scales, count);
+
+    #pragma omp parallel for
+    for(int i = 0; i < static_cast<int>(landmarks.size()); ++i)
+    {
+      std::size_t o = observationsOffsets[i];
+      for(auto& observationPair : landmarks[i]->observations)
+      {
+        sfmData::Observation& observation = observationPair.second;
+        observation.id_feat = featureIds[o];
+        observation.x = Vec2(coordinates[2 * o], coordinates[2 * o + 1]);
+        observation.scale = scales[o];
+        ++o;
+      }
+    }
+  }
+};
+
+} // namespace
+
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Unable to write the binary SfMData file: " << filename);
+    return false;
+  }
+
+  file.write(binMagic, 4);
+  file.write(reinterpret_cast<const char*>(&binVersion), sizeof(binVersion));
+
+  writeFolders(file, sfmData);
+
+  if(saveViews)
+    writeViews(file, sfmData.getViews());
+
+  if(saveIntrinsics)
+    writeIntrinsics(file, sfmData.getIntrinsics());
+
+  if(saveExtrinsics)
+  {
+    writePoses(file, sfmData.getPoses());
+    writeRigs(file, sfmData.getRigs());
+  }
+
+  if(saveStructure)
+    writeLandmarks(file, sfmData.getLandmarks(), structureTags, saveObservations, saveFeatures);
+
+  if(saveControlPoints)
+    writeLandmarks(file, sfmData.getControlPoints(), controlPointsTags, true, true);
+
+  // mark the end of the file, so that a file truncated on a section boundary is detected
+  SectionWriter().writeSection(file, "END ", 0);
+
+  file.close();
+  if(!file)
+  {
+    ALICEVISION_LOG_ERROR("Unable to write the binary SfMData file: " << filename);
+    return false;
+  }
+  return true;
+}
+
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if(!file.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Unable to open the binary SfMData file: " << filename);
+    return false;
+  }
+  const std::uint64_t fileSize = static_cast<std::uint64_t>(file.tellg());
+  file.seekg(0);
+
+  char magic[4];
+  std::uint32_t version = 0;
+  file.read(magic, 4);
+  file.read(reinterpret_cast<char*>(&version), sizeof(version));
+  if(!file || std::memcmp(magic, binMagic, 4) != 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid binary SfMData file: " << filename);
+    return false;
+  }
+  if(version != binVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported binary SfMData version " << version << ": " << filename);
+    return false;
+  }
+
+  LandmarksLoader structureLoader;
+  LandmarksLoader controlPointsLoader;
+
+  char tag[4];
+  std::uint64_t sectionSize;
+  bool hasEnd = false;
+  try
+  {
+    while(!hasEnd)
+    {
+      // the file must end exactly on a section boundary
+      file.read(tag, 4);
+      if(file.gcount() == 0 && file.eof())
+        break;
+      if(!file || !file.read(reinterpret_cast<char*>(&sectionSize), sizeof(sectionSize)))
+        throw std::runtime_error("Truncated binary SfMData section header.");
+
+      const std::uint64_t sectionBegin = static_cast<std::uint64_t>(file.tellg());
+      if(sectionSize < sizeof(std::uint64_t) || sectionSize > fileSize - sectionBegin)
+        throw std::runtime_error("Truncated binary SfMData section.");
+      const std::streampos sectionEnd = file.tellg() + static_cast<std::streamoff>(sectionSize);
+      const auto isSection = [&tag](const char* sectionTag) { return std::memcmp(tag, sectionTag, 4) == 0; };
+
+      if(isSection("END "))
+      {
+        hasEnd = true;
+        file.seekg(sectionEnd);
+        continue;
+      }
+
+      const bool loadSection =
+        isSection("FOLD") ||
+        (loadViews && isSection("VIEW")) ||
+        (loadIntrinsics && isSection("INTR")) ||
+        (loadExtrinsics && (isSection("POSE") || isSection("RIGS"))) ||
+        (loadStructure && isSection(structureTags.landmarks)) ||
+        (loadStructure && loadObservations && isSection(structureTags.observations)) ||
+        (loadStructure && loadFeatures && isSection(structureTags.features)) ||
+        (loadControlPoints && (isSection(controlPointsTags.landmarks) || isSection(controlPointsTags.observations) || isSection(controlPointsTags.features)));
+
+      // sections which are not requested (or unknown) are skipped without being read
+      if(!loadSection)
+      {
+        file.seekg(sectionEnd);
+        continue;
+      }
+
+      std::uint64_t count;
+      file.read(reinterpret_cast<char*>(&count), sizeof(count));
+      SectionReader section(file, sectionSize - sizeof(count));
+
+      if(isSection("FOLD"))
+        readFolders(section, sfmData);
+      else if(isSection("VIEW"))
+        readViews(section, count, sfmData.getViews());
+      else if(isSection("INTR"))
+        readIntrinsics(section, count, sfmData.getIntrinsics());
+      else if(isSection("POSE"))
+        readPoses(section, count, sfmData.getPoses());
+      else if(isSection("RIGS"))
+        readRigs(section, count, sfmData.getRigs());
+      else if(isSection(structureTags.landmarks))
+        structureLoader.readLandmarks(section, count, sfmData.getLandmarks());
+      else if(isSection(structureTags.observations))
+        structureLoader.readObservations(section, count);
+      else if(isSection(structureTags.features))
+        structureLoader.readFeatures(section, count);
+      else if(isSection(controlPointsTags.landmarks))
+        controlPointsLoader.readLandmarks(section, count, sfmData.getControlPoints());
+      else if(isSection(controlPointsTags.observations))
+        controlPointsLoader.readObservations(section, count);
+      else if(isSection(controlPointsTags.features))
+        controlPointsLoader.readFeatures(section, count);
+    }
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what() << " Unable to read the binary SfMData file: " << filename);
+    return false;
+  }
+
+  if(file.bad())
+  {
+    ALICEVISION_LOG_ERROR("Unable to read the binary SfMData file: " << filename);
+    return false;
+  }
+
+  if(!hasEnd)
+  {
+    ALICEVISION_LOG_ERROR("Truncated binary SfMData file: " << filename);
+    return false;
+  }
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
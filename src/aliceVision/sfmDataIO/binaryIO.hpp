@@ -0,0 +1,56 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+// AliceVision binary SfMData file (.sfmb):
+// -- Header
+// magic "AVSF", version (uint32)
+// -- Sections
+// tag (4 chars), section size (uint64), element count (uint64), payload
+// --
+// FOLD: features and matches folders
+// VIEW: views
+// INTR: intrinsics
+// POSE: poses
+// RIGS: rigs
+// LMKS: landmarks [ids, descTypes, X, colors] (one array per field)
+// OBSV: landmarks observations [#observations per landmark, view ids]
+// FEAT: landmarks observations features [feature ids, x, scale]
+// CPTS, CPOB, CPFT: control points, with the same layout as LMKS, OBSV and FEAT
+// END : end of the file (no element)
+// --
+// Each section is only read if it is requested by the ESfMData load flag,
+// the other sections are skipped without being read. Unknown sections are skipped.
+// A file that does not end on a section boundary, or without the end section, is rejected.
+
+/**
+ * @brief Save an SfMData in a binary file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
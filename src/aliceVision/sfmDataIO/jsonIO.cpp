@@ -10,8 +10,22 @@
 
 #include <boost/property_tree/json_parser.hpp>
 
-#include <memory>
+#include <algorithm>
 #include <cassert>
+#include <clocale>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <locale>
+#include <memory>
+#include <sstream>
+
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
 
 namespace aliceVision {
 namespace sfmDataIO {
@@ -312,6 +326,584 @@ void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& l
 }
 
 
+namespace {
+
+/// Number of landmarks formatted or parsed in parallel before being written or inserted
+const std::size_t landmarksBatchSize = 100000;
+
+/// Output string stream with the classic locale and the precision of boost::property_tree for doubles
+struct ClassicNumberStream
+{
+  ClassicNumberStream()
+  {
+    stream.imbue(std::locale::classic());
+    stream.precision(std::numeric_limits<double>::max_digits10);
+  }
+
+  std::ostringstream stream;
+};
+
+/// Append a double as boost::property_tree does (max_digits10 precision), whatever the global locale
+inline void appendNumber(std::string& out, double value)
+{
+  // the landmarks are formatted in parallel, one stream per thread
+  thread_local ClassicNumberStream classicNumberStream;
+  std::ostringstream& stream = classicNumberStream.stream;
+  stream.str(std::string());
+  stream << value;
+  out += stream.str();
+}
+
+/**
+ * @brief Locale-independent strtod: JSON numbers always use '.' as decimal separator,
+ *        whatever the C locale of the application.
+ */
+inline double strtodClassic(const char* str, char** end)
+{
+#ifdef _WIN32
+  static const _locale_t classicLocale = _create_locale(LC_NUMERIC, "C");
+  return _strtod_l(str, end, classicLocale);
+#else
+  static const locale_t classicLocale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+  return strtod_l(str, end, classicLocale);
+#endif
+}
+
+inline void appendNumber(std::string& out, unsigned int value)
+{
+  out += std::to_string(value);
+}
+
+inline void appendKey(std::string& out, const char* key, int indent)
+{
+  out.append(4 * indent, ' ');
+  out += '"';
+  out += key;
+  out += "\": ";
+}
+
+template<typename T>
+inline void appendQuoted(std::string& out, T value)
+{
+  out += '"';
+  appendNumber(out, value);
+  out += '"';
+}
+
+/**
+ * @brief Append a matrix as an array of values, formatted as bpt::write_json does
+ * @param[in] indent The indentation level of the array
+ */
+template<typename T, typename Derived>
+void appendMatrix(std::string& out, const Eigen::MatrixBase<Derived>& matrix, int indent)
+{
+  out += "[\n";
+  for(int i = 0; i < matrix.size(); ++i)
+  {
+    out.append(4 * (indent + 1), ' ');
+    appendQuoted<T>(out, matrix(i));
+    if(i + 1 < matrix.size())
+      out += ',';
+    out += '\n';
+  }
+  out.append(4 * indent, ' ');
+  out += ']';
+}
+
+/**
+ * @brief Append a landmark without an intermediate property tree,
+ *        with the exact formatting of saveLandmark followed by bpt::write_json
+ * @param[in] indent The indentation level of the landmark object
+ */
+void appendLandmark(std::string& out, IndexT landmarkId, const sfmData::Landmark& landmark, int indent, bool saveObservations, bool saveFeatures)
+{
+  out += "{\n";
+  appendKey(out, "landmarkId", indent + 1);
+  appendQuoted(out, landmarkId);
+  out += ",\n";
+  appendKey(out, "descType", indent + 1);
+  out += '"';
+  out += bpt::json_parser::create_escapes(feature::EImageDescriberType_enumToString(landmark.descType));
+  out += "\",\n";
+  appendKey(out, "color", indent + 1);
+  appendMatrix<unsigned int>(out, landmark.rgb, indent + 1);
+  out += ",\n";
+  appendKey(out, "X", indent + 1);
+  appendMatrix<double>(out, landmark.X, indent + 1);
+
+  if(saveObservations)
+  {
+    out += ",\n";
+    appendKey(out, "observations", indent + 1);
+
+    if(landmark.observations.empty())
+    {
+      // an empty property tree is written as an empty value
+      out += "\"\"";
+    }
+    else
+    {
+      out += "[\n";
+      std::size_t i = 0;
+      for(const auto& obsPair : landmark.observations)
+      {
+        const sfmData::Observation& observation = obsPair.second;
+
+        out.append(4 * (indent + 2), ' ');
+        out += "{\n";
+        appendKey(out, "observationId", indent + 3);
+        appendQuoted(out, obsPair.first);
+
+        if(saveFeatures)
+        {
+          out += ",\n";
+          appendKey(out, "featureId", indent + 3);
+          appendQuoted(out, observation.id_feat);
+          out += ",\n";
+          appendKey(out, "x", indent + 3);
+          appendMatrix<double>(out, observation.x, indent + 3);
+          out += ",\n";
+          appendKey(out, "scale", indent + 3);
+          appendQuoted(out, observation.scale);
+        }
+
+        out += '\n';
+        out.append(4 * (indent + 2), ' ');
+        out += '}';
+        if(++i < landmark.observations.size())
+          out += ',';
+        out += '\n';
+      }
+      out.append(4 * (indent + 1), ' ');
+      out += ']';
+    }
+  }
+
+  out += '\n';
+  out.append(4 * indent, ' ');
+  out += '}';
+}
+
+/**
+ * @brief Write the landmarks array of an SfMData top-level key,
+ *        landmarks are formatted in parallel by batches to bound the memory
+ */
+void writeLandmarks(std::ostream& stream, const sfmData::Landmarks& landmarks, bool saveObservations, bool saveFeatures)
+{
+  std::vector<const sfmData::Landmarks::value_type*> landmarkPairs;
+  landmarkPairs.reserve(landmarks.size());
+  for(const auto& landmarkPair : landmarks)
+    landmarkPairs.push_back(&landmarkPair);
+
+  std::vector<std::string> formatted(std::min(landmarksBatchSize, landmarkPairs.size()));
+
+  stream << "[\n";
+  for(std::size_t batchBegin = 0; batchBegin < landmarkPairs.size(); batchBegin += landmarksBatchSize)
+  {
+    const int batchSize = static_cast<int>(std::min(landmarksBatchSize, landmarkPairs.size() - batchBegin));
+
+    std::exception_ptr exception;
+
+    #pragma omp parallel for
+    for(int i = 0; i < batchSize; ++i)
+    {
+      try
+      {
+        const sfmData::Landmarks::value_type& landmarkPair = *landmarkPairs[batchBegin + i];
+        std::string& out = formatted[i];
+        out.assign(8, ' ');
+        appendLandmark(out, landmarkPair.first, landmarkPair.second, 2, saveObservations, saveFeatures);
+        if(batchBegin + i + 1 < landmarkPairs.size())
+          out += ',';
+        out += '\n';
+      }
+      catch(...)
+      {
+        #pragma omp critical
+        exception = std::current_exception();
+      }
+    }
+
+    if(exception)
+      std::rethrow_exception(exception);
+
+    for(int i = 0; i < batchSize; ++i)
+      stream << formatted[i];
+  }
+  stream << "    ]";
+}
+
+/**
+ * @brief Pull parser over an in-memory JSON document.
+ *        Values are read on demand, so large arrays can be split and parsed in parallel.
+ */
+class JsonParser
+{
+public:
+  JsonParser(const char* begin, const char* end, const char* documentBegin, const std::string& filename)
+    : _cur(begin)
+    , _end(end)
+    , _documentBegin(documentBegin)
+    , _filename(filename)
+  {}
+
+  /// Parser over a sub-range of the same document
+  JsonParser subParser(const char* begin, const char* end) const
+  {
+    return JsonParser(begin, end, _documentBegin, _filename);
+  }
+
+  const char* position() const { return _cur; }
+
+  char peek()
+  {
+    skipWhitespace();
+    if(_cur == _end)
+      error("unexpected end of data");
+    return *_cur;
+  }
+
+  bool consume(char c)
+  {
+    skipWhitespace();
+    if(_cur != _end && *_cur == c)
+    {
+      ++_cur;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c)
+  {
+    if(!consume(c))
+      error(std::string("expected '") + c + "'");
+  }
+
+  std::string readString()
+  {
+    expect('"');
+    const char* begin = _cur;
+    while(_cur != _end && *_cur != '"' && *_cur != '\\')
+      ++_cur;
+    if(_cur == _end)
+      error("unterminated string");
+    if(*_cur == '"')
+      return std::string(begin, _cur++);
+
+    // slow path with escape sequences
+    std::string str(begin, _cur);
+    while(_cur != _end && *_cur != '"')
+    {
+      if(*_cur != '\\')
+      {
+        str += *_cur++;
+        continue;
+      }
+      if(++_cur == _end)
+        break;
+      switch(*_cur++)
+      {
+        case '"':  str += '"'; break;
+        case '\\': str += '\\'; break;
+        case '/':  str += '/'; break;
+        case 'b':  str += '\b'; break;
+        case 'f':  str += '\f'; break;
+        case 'n':  str += '\n'; break;
+        case 'r':  str += '\r'; break;
+        case 't':  str += '\t'; break;
+        case 'u':  appendCodepoint(str, readHex4()); break;
+        default:   error("invalid escape sequence");
+      }
+    }
+    if(_cur == _end)
+      error("unterminated string");
+    ++_cur;
+    return str;
+  }
+
+  /// Read a string or a literal (number, boolean, null) as text
+  std::string readScalar()
+  {
+    if(peek() == '"')
+      return readString();
+    const char* begin = _cur;
+    while(_cur != _end && !isDelimiter(*_cur))
+      ++_cur;
+    if(begin == _cur)
+      error("expected value");
+    return std::string(begin, _cur);
+  }
+
+  /// Read a number, written as a string or as a literal, directly from the document
+  template<typename T>
+  T readNumber()
+  {
+    const bool quoted = (peek() == '"');
+    if(quoted)
+      ++_cur;
+    char* numberEnd = nullptr;
+    const double number = strtodClassic(_cur, &numberEnd);
+    if(numberEnd == _cur || numberEnd > _end || (quoted && (numberEnd == _end || *numberEnd != '"')))
+      error("invalid number");
+    _cur = numberEnd + (quoted ? 1 : 0);
+    return static_cast<T>(number);
+  }
+
+  template<typename Derived>
+  void readMatrix(Eigen::MatrixBase<Derived>& matrix)
+  {
+    int i = 0;
+    readArray([&]()
+    {
+      if(i >= matrix.size())
+        error("invalid matrix / vector size");
+      matrix(i++) = readNumber<typename Derived::Scalar>();
+    });
+  }
+
+  void skipValue()
+  {
+    const char c = peek();
+    if(c == '"')
+    {
+      skipString();
+    }
+    else if(c == '{' || c == '[')
+    {
+      int depth = 0;
+      while(_cur != _end)
+      {
+        const char d = *_cur;
+        if(d == '"')
+        {
+          skipString();
+          continue;
+        }
+        ++_cur;
+        if(d == '{' || d == '[')
+          ++depth;
+        else if((d == '}' || d == ']') && --depth == 0)
+          return;
+      }
+      error("unterminated object or array");
+    }
+    else
+    {
+      readScalar();
+    }
+  }
+
+  /// Read an object, onMember is called with each key and must read its value
+  template<typename F>
+  void readObject(F&& onMember)
+  {
+    expect('{');
+    if(consume('}'))
+      return;
+    do
+    {
+      const std::string key = readString();
+      expect(':');
+      onMember(key);
+    }
+    while(consume(','));
+    expect('}');
+  }
+
+  /// Read an array, onElement is called for each element and must read it
+  template<typename F>
+  void readArray(F&& onElement)
+  {
+    // an empty property tree is written as an empty value
+    if(peek() == '"')
+    {
+      readString();
+      return;
+    }
+    expect('[');
+    if(consume(']'))
+      return;
+    do
+    {
+      onElement();
+    }
+    while(consume(','));
+    expect(']');
+  }
+
+  [[noreturn]] void error(const std::string& message) const
+  {
+    const unsigned long line = 1 + std::count(_documentBegin, _cur, '\n');
+    throw bpt::json_parser_error(message, _filename, line);
+  }
+
+private:
+  static bool isDelimiter(char c)
+  {
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  void skipWhitespace()
+  {
+    while(_cur != _end && (*_cur == ' ' || *_cur == '\n' || *_cur == '\r' || *_cur == '\t'))
+      ++_cur;
+  }
+
+  void skipString()
+  {
+    ++_cur;
+    while(_cur != _end && *_cur != '"')
+    {
+      if(*_cur == '\\' && _cur + 1 != _end)
+        ++_cur;
+      ++_cur;
+    }
+    if(_cur == _end)
+      error("unterminated string");
+    ++_cur;
+  }
+
+  unsigned int readHex4()
+  {
+    if(_end - _cur < 4)
+      error("invalid escape sequence");
+    unsigned int codepoint = 0;
+    for(int i = 0; i < 4; ++i)
+    {
+      const char c = *_cur++;
+      codepoint <<= 4;
+      if(c >= '0' && c <= '9')      codepoint += c - '0';
+      else if(c >= 'a' && c <= 'f') codepoint += c - 'a' + 10;
+      else if(c >= 'A' && c <= 'F') codepoint += c - 'A' + 10;
+      else error("invalid escape sequence");
+    }
+    return codepoint;
+  }
+
+  /// Encode a codepoint in UTF-8, as bpt::read_json does
+  static void appendCodepoint(std::string& str, unsigned int codepoint)
+  {
+    if(codepoint < 0x80)
+    {
+      str += static_cast<char>(codepoint);
+    }
+    else if(codepoint < 0x800)
+    {
+      str += static_cast<char>(0xC0 | (codepoint >> 6));
+      str += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+      str += static_cast<char>(0xE0 | (codepoint >> 12));
+      str += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      str += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+  }
+
+  const char* _cur;
+  const char* _end;
+  const char* _documentBegin;
+  const std::string& _filename;
+};
+
+/**
+ * @brief Parse a landmark object without an intermediate property tree (same content as loadLandmark)
+ */
+void parseLandmark(JsonParser& parser, IndexT& landmarkId, sfmData::Landmark& landmark, bool loadObservations, bool loadFeatures)
+{
+  landmarkId = UndefinedIndexT;
+
+  parser.readObject([&](const std::string& key)
+  {
+    if(key == "landmarkId")
+      landmarkId = parser.readNumber<IndexT>();
+    else if(key == "descType")
+      landmark.descType = feature::EImageDescriberType_stringToEnum(parser.readString());
+    else if(key == "color")
+      parser.readMatrix(landmark.rgb);
+    else if(key == "X")
+      parser.readMatrix(landmark.X);
+    else if(key == "observations" && loadObservations)
+    {
+      parser.readArray([&]()
+      {
+        IndexT observationId = UndefinedIndexT;
+        sfmData::Observation observation;
+
+        parser.readObject([&](const std::string& obsKey)
+        {
+          if(obsKey == "observationId")
+            observationId = parser.readNumber<IndexT>();
+          else if(obsKey == "featureId" && loadFeatures)
+            observation.id_feat = parser.readNumber<IndexT>();
+          else if(obsKey == "x" && loadFeatures)
+            parser.readMatrix(observation.x);
+          else if(obsKey == "scale" && loadFeatures)
+            observation.scale = parser.readNumber<double>();
+          else
+            parser.skipValue();
+        });
+
+        landmark.observations.emplace(observationId, observation);
+      });
+    }
+    else
+      parser.skipValue();
+  });
+
+  if(landmarkId == UndefinedIndexT)
+    parser.error("landmark without landmarkId");
+}
+
+/**
+ * @brief Parse the landmarks array of an SfMData top-level key.
+ *        The array is first split in landmarks, which are then parsed in parallel by batches.
+ */
+void parseLandmarks(JsonParser& parser, sfmData::Landmarks& landmarks, bool loadObservations, bool loadFeatures)
+{
+  std::vector<std::pair<const char*, const char*>> landmarkRanges;
+  parser.readArray([&]()
+  {
+    const char* begin = parser.position();
+    parser.skipValue();
+    landmarkRanges.emplace_back(begin, parser.position());
+  });
+
+  std::vector<std::pair<IndexT, sfmData::Landmark>> batch;
+  for(std::size_t batchBegin = 0; batchBegin < landmarkRanges.size(); batchBegin += landmarksBatchSize)
+  {
+    const int batchSize = static_cast<int>(std::min(landmarksBatchSize, landmarkRanges.size() - batchBegin));
+    batch.assign(batchSize, std::pair<IndexT, sfmData::Landmark>());
+    std::exception_ptr exception;
+
+    #pragma omp parallel for
+    for(int i = 0; i < batchSize; ++i)
+    {
+      try
+      {
+        const auto& range = landmarkRanges[batchBegin + i];
+        JsonParser landmarkParser = parser.subParser(range.first, range.second);
+        parseLandmark(landmarkParser, batch[i].first, batch[i].second, loadObservations, loadFeatures);
+      }
+      catch(...)
+      {
+        #pragma omp critical
+        exception = std::current_exception();
+      }
+    }
+
+    if(exception)
+      std::rethrow_exception(exception);
+
+    // landmarks are written sorted by id
+    for(auto& landmarkPair : batch)
+      landmarks.emplace_hint(landmarks.end(), landmarkPair.first, std::move(landmarkPair.second));
+  }
+}
+
+} // namespace
+
 bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
   const Vec3 version = {1, 0, 0};
@@ -415,31 +1007,48 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
     }
   }
 
-  // structure
-  if(saveStructure && !sfmData.getLandmarks().empty())
-  {
-    bpt::ptree structureTree;
+  // write the json file with the tree,
+  // landmarks are streamed without property tree, with the formatting of bpt::write_json
 
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree, saveObservations, saveFeatures);
+  const bool writeStructure = saveStructure && !sfmData.getLandmarks().empty();
+  const bool writeControlPoints = saveControlPoints && !sfmData.getControlPoints().empty();
 
-    fileTree.add_child("structure", structureTree);
-  }
+  std::ofstream stream(filename);
+  if(!stream)
+    throw bpt::json_parser_error("cannot open file", filename, 0);
 
-  // control points
-  if(saveControlPoints && !sfmData.getControlPoints().empty())
+  stream << "{\n";
+  for(auto it = fileTree.begin(); it != fileTree.end(); ++it)
   {
-    bpt::ptree controlPointTree;
+    stream << "    \"" << bpt::json_parser::create_escapes(it->first) << "\": ";
+    bpt::json_parser::write_json_helper(stream, it->second, 1, true);
+    if(std::next(it) != fileTree.end() || writeStructure || writeControlPoints)
+      stream << ',';
+    stream << '\n';
+  }
 
-    for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
+  // structure
+  if(writeStructure)
+  {
+    stream << "    \"structure\": ";
+    writeLandmarks(stream, sfmData.getLandmarks(), saveObservations, saveFeatures);
+    if(writeControlPoints)
+      stream << ',';
+    stream << '\n';
+  }
 
-    fileTree.add_child("controlPoints", controlPointTree);
+  // control points
+  if(writeControlPoints)
+  {
+    stream << "    \"controlPoints\": ";
+    writeLandmarks(stream, sfmData.getControlPoints(), true, true);
+    stream << '\n';
   }
 
-  // write the json file with the tree
+  stream << '}' << std::endl;
 
-  bpt::write_json(filename, fileTree);
+  if(!stream.good())
+    throw bpt::json_parser_error("write error", filename, 0);
 
   return true;
 }
@@ -458,11 +1067,51 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
   const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
 
-  // main tree
+  // read the whole json file, directly in the document
+  std::string document;
+  {
+    std::ifstream stream(filename, std::ios::binary | std::ios::ate);
+    if(!stream)
+      throw bpt::json_parser_error("cannot open file", filename, 0);
+    document.resize(static_cast<std::size_t>(stream.tellg()));
+    stream.seekg(0);
+    if(!stream.read(&document[0], document.size()))
+      throw bpt::json_parser_error("cannot read file", filename, 0);
+  }
+
+  // main tree, landmarks are parsed in parallel without property tree,
+  // the other top-level values are small and loaded in the tree
   bpt::ptree fileTree;
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  JsonParser parser(document.data(), document.data() + document.size(), document.data(), filename);
+  parser.readObject([&](const std::string& key)
+  {
+    if(key == "structure" && loadStructure)
+    {
+      parseLandmarks(parser, sfmData.getLandmarks(), loadObservations, loadFeatures);
+    }
+    else if(key == "controlPoints" && loadControlPoints)
+    {
+      parseLandmarks(parser, sfmData.getControlPoints(), true, true);
+    }
+    else if(key == "structure" || key == "controlPoints" ||
+            (key == "views" && !loadViews) ||
+            (key == "intrinsics" && !loadIntrinsics) ||
+            ((key == "poses" || key == "rigs") && !loadExtrinsics))
+    {
+      // not requested
+      parser.skipValue();
+    }
+    else
+    {
+      const char* valueBegin = parser.position();
+      parser.skipValue();
+      std::istringstream valueStream(std::string(valueBegin, parser.position()));
+      bpt::ptree valueTree;
+      bpt::read_json(valueStream, valueTree);
+      fileTree.push_back(std::make_pair(key, valueTree));
+    }
+  });
 
   // version
   loadMatrix("version", version, fileTree);
@@ -587,38 +1236,6 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
     }
   }
 
-  // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    sfmData::Landmarks& structure = sfmData.getLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second, loadObservations, loadFeatures);
-
-      structure.emplace(landmarkId, landmark);
-    }
-  }
-
-  // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
-  {
-    sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      controlPoints.emplace(landmarkId, landmark);
-    }
-  }
-
   return true;
 }
 
@@ -8,9 +8,15 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
+#include <clocale>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
 #define BOOST_TEST_MODULE sfmDataIO
@@ -75,9 +81,69 @@ sfmData::SfMData createTestScene(std::size_t viewsCount = 2, std::size_t observa
   return sfmData;
 }
 
+/**
+ * @brief Scene of the JSON fixture written by the property tree based writer.
+ */
+sfmData::SfMData createJsonFixtureScene()
+{
+  sfmData::SfMData sfmData;
+  for(IndexT i = 0; i < 3; ++i)
+  {
+    std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>("dataset/" + std::to_string(i) + ".jpg", i, i % 2, i, 1000, 800);
+    sfmData.views[i] = view;
+    sfmData.setPose(*view, sfmData::CameraPose(geometry::Pose3(RotationAroundY(0.25 * i), Vec3(i, -0.5 * i, 1.0 / 3.0))));
+  }
+  sfmData.views.at(0)->addMetadata("Make", "Canon");
+  sfmData.intrinsics[0] = std::make_shared<camera::Pinhole>(1000, 800, 900.5, 510.25, 390.75);
+  sfmData.intrinsics[1] = std::make_shared<camera::PinholeRadialK3>(1000, 800, 900, 510, 390, 0.1, -0.02, 0.003);
+
+  sfmData.structure[0] = sfmData::Landmark(Vec3(11, 22, 33), feature::EImageDescriberType::SIFT, sfmData::Observations(), image::RGBColor(10, 20, 30));
+  sfmData.structure[0].observations[0] = sfmData::Observation(Vec2(1.5, 2.5), 4, 0.0);
+  sfmData.structure[0].observations[2] = sfmData::Observation(Vec2(-3.125, 1e-3), 7, 2.75);
+  sfmData.structure[1] = sfmData::Landmark(Vec3(0.1, -2.5e-7, 1e12), feature::EImageDescriberType::AKAZE);
+  sfmData.structure[7] = sfmData::Landmark(Vec3(4, 5, 6), feature::EImageDescriberType::SIFT);
+  sfmData.structure[7].observations[1] = sfmData::Observation(Vec2(4.25, 1.0 / 3.0), 6, 1.5);
+  sfmData.control_points[0] = sfmData::Landmark(Vec3(7, 8, 9), feature::EImageDescriberType::UNKNOWN);
+  sfmData.control_points[0].observations[1] = sfmData::Observation(Vec2(8, 9), 0, 0.0);
+
+  return sfmData;
+}
+
+/**
+ * @brief Find a section of a binary SfMData file.
+ * @return the offset of the element count of the section, or std::string::npos
+ */
+std::size_t findBinarySection(const std::string& content, const char* tag)
+{
+  std::size_t pos = 8; // magic and version
+  while(pos + 12 <= content.size())
+  {
+    std::uint64_t sectionSize;
+    std::memcpy(&sectionSize, content.data() + pos + 4, sizeof(sectionSize));
+    if(content.compare(pos, 4, tag) == 0)
+      return pos + 12;
+    pos += 12 + sectionSize;
+  }
+  return std::string::npos;
+}
+
+std::string readFile(const fs::path& filepath)
+{
+  std::ifstream file(filepath.string(), std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+void writeFile(const fs::path& filepath, const std::string& content)
+{
+  std::ofstream file(filepath.string(), std::ios::binary);
+  file << content;
+}
+
 BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"sfm","json"};
+  const std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
   for(int i = 0; i < ext_Type.size(); ++i)
   {
@@ -178,11 +244,226 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_BINARY_JSON_roundtrip) {
+
+  sfmData::SfMData sfmData = createTestScene(4, 3, false);
+  sfmData.intrinsics[1] = std::make_shared<PinholeRadialK3>(1000, 800, 900, 510, 390, 0.1, -0.02, 0.003);
+  sfmData.intrinsics[2] = std::make_shared<EquiDistantRadialK3>(1000, 800, 700, 500, 400, 380, 0.3, 0.2, 0.1);
+  sfmData.views.at(0)->addMetadata("Make", "Canon");
+  sfmData.views.at(1)->setFrameId(12);
+  sfmData.getRigs().emplace(0, sfmData::Rig(2));
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.structure[5] = sfmData::Landmark(Vec3(1, 2, 3), feature::EImageDescriberType::AKAZE);
+  sfmData.structure[5].observations[2] = sfmData::Observation(Vec2(4, 5), 6, 1.5);
+  sfmData.control_points[0] = sfmData::Landmark(Vec3(7, 8, 9), feature::EImageDescriberType::UNKNOWN);
+
+  const fs::path tmpDir = fs::temp_directory_path() / fs::unique_path("sfmDataIO_roundtrip_%%%%-%%%%");
+  fs::create_directories(tmpDir);
+  const std::string jsonFilename = (tmpDir / "ROUNDTRIP.sfm").string();
+  const std::string binaryFilename = (tmpDir / "ROUNDTRIP.sfmb").string();
+  const std::string truncatedFilename = (tmpDir / "TRUNCATED.sfmb").string();
+  const std::string corruptedFilename = (tmpDir / "CORRUPTED.sfmb").string();
+
+  BOOST_CHECK( Save(sfmData, jsonFilename, ALL) );
+  BOOST_CHECK( Save(sfmData, binaryFilename, ALL) );
+
+  const std::vector<ESfMData> flags_parts = {
+    ALL,
+    STRUCTURE,
+    ESfMData(STRUCTURE | OBSERVATIONS),
+    ESfMData(VIEWS | INTRINSICS | EXTRINSICS),
+    ESfMData(EXTRINSICS | CONTROL_POINTS)
+  };
+
+  for(const ESfMData flags_part : flags_parts)
+  {
+    sfmData::SfMData sfmDataJSON;
+    sfmData::SfMData sfmDataBinary;
+    BOOST_CHECK( Load(sfmDataJSON, jsonFilename, flags_part) );
+    BOOST_CHECK( Load(sfmDataBinary, binaryFilename, flags_part) );
+
+    // the binary file loads the same content as the JSON file
+    BOOST_CHECK( sfmDataJSON == sfmDataBinary );
+    BOOST_CHECK_EQUAL( sfmDataJSON.structure.size(), sfmDataBinary.structure.size() );
+    for(const auto& landmarkPair : sfmDataJSON.structure)
+    {
+      const sfmData::Landmark& landmark = sfmDataBinary.structure.at(landmarkPair.first);
+      BOOST_CHECK( landmarkPair.second == landmark );
+      for(const auto& observationPair : landmarkPair.second.observations)
+        BOOST_CHECK_EQUAL( observationPair.second.scale, landmark.observations.at(observationPair.first).scale );
+    }
+  }
+
+  // the binary file round-trip keeps the whole scene
+  sfmData::SfMData sfmDataBinary;
+  BOOST_CHECK( Load(sfmDataBinary, binaryFilename, ALL) );
+  BOOST_CHECK( sfmData == sfmDataBinary );
+
+  // a truncated binary file is rejected, wherever it is cut
+  const std::uintmax_t fileSize = fs::file_size(binaryFilename);
+  for(const ESfMData flags_part : {ALL, ESfMData(VIEWS | INTRINSICS)})
+  {
+    for(std::uintmax_t truncatedSize = 0; truncatedSize < fileSize; ++truncatedSize)
+    {
+      fs::copy_file(binaryFilename, truncatedFilename, fs::copy_option::overwrite_if_exists);
+      fs::resize_file(truncatedFilename, truncatedSize);
+      sfmData::SfMData sfmDataTruncated;
+      BOOST_CHECK_MESSAGE( !Load(sfmDataTruncated, truncatedFilename, flags_part),
+                           "file truncated to " << truncatedSize << " bytes is loaded" );
+    }
+  }
+
+  const std::string content = readFile(binaryFilename);
+  const std::size_t landmarksCountPos = findBinarySection(content, "LMKS");
+  BOOST_REQUIRE( landmarksCountPos != std::string::npos );
+
+  // an element count larger than the section is rejected before any allocation
+  {
+    std::string corrupted = content;
+    const std::uint64_t hugeCount = std::uint64_t(1) << 60;
+    corrupted.replace(landmarksCountPos, sizeof(hugeCount), reinterpret_cast<const char*>(&hugeCount), sizeof(hugeCount));
+    writeFile(corruptedFilename, corrupted);
+    sfmData::SfMData sfmDataCorrupted;
+    BOOST_CHECK( !Load(sfmDataCorrupted, corruptedFilename, ALL) );
+  }
+
+  // duplicate landmark ids are rejected
+  {
+    // LMKS payload: count, descTypes names, ids
+    std::size_t idsPos = landmarksCountPos + sizeof(std::uint64_t);
+    std::uint32_t nbDescTypes;
+    std::memcpy(&nbDescTypes, content.data() + idsPos, sizeof(nbDescTypes));
+    idsPos += sizeof(nbDescTypes);
+    for(std::uint32_t i = 0; i < nbDescTypes; ++i)
+    {
+      std::uint32_t nameSize;
+      std::memcpy(&nameSize, content.data() + idsPos, sizeof(nameSize));
+      idsPos += sizeof(nameSize) + nameSize;
+    }
+
+    std::string corrupted = content;
+    corrupted.replace(idsPos + sizeof(IndexT), sizeof(IndexT), content, idsPos, sizeof(IndexT));
+    writeFile(corruptedFilename, corrupted);
+    sfmData::SfMData sfmDataCorrupted;
+    BOOST_CHECK( !Load(sfmDataCorrupted, corruptedFilename, ALL) );
+  }
+
+  fs::remove_all(tmpDir);
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_streaming) {
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, true);
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.structure[1] = sfmData::Landmark(Vec3(0.1, -2.5e-7, 1e12), feature::EImageDescriberType::AKAZE);
+  sfmData.structure[2] = sfmData::Landmark(Vec3(4, 5, 6), feature::EImageDescriberType::SIFT);
+  sfmData.structure[2].observations[1] = sfmData::Observation(Vec2(4.25, 1.0 / 3.0), 6, 1.5);
+  sfmData.control_points[0] = sfmData::Landmark(Vec3(7, 8, 9), feature::EImageDescriberType::UNKNOWN);
+
+  const std::vector<ESfMData> flags_parts = {
+    ALL,
+    ESfMData(ALL & ~OBSERVATIONS_WITH_FEATURES),
+    ESfMData(VIEWS | STRUCTURE)
+  };
+
+  const fs::path tmpDir = fs::temp_directory_path() / fs::unique_path("sfmDataIO_streaming_%%%%-%%%%");
+  fs::create_directories(tmpDir);
+  const std::string filename = (tmpDir / "STREAMING.sfm").string();
+
+  for(const ESfMData flags_part : flags_parts)
+  {
+    BOOST_CHECK( Save(sfmData, filename, flags_part) );
+
+    // the streamed file is formatted as boost::property_tree writes it
+    std::ifstream fileStream(filename);
+    std::stringstream fileContent;
+    fileContent << fileStream.rdbuf();
+
+    bpt::ptree fileTree;
+    bpt::read_json(filename, fileTree);
+    std::ostringstream treeContent;
+    bpt::write_json(treeContent, fileTree);
+
+    BOOST_CHECK_EQUAL( fileContent.str(), treeContent.str() );
+
+    // the streamed landmarks are the landmarks of the property tree
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, flags_part) );
+
+    if(fileTree.count("structure"))
+    {
+      BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), fileTree.get_child("structure").size() );
+      for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("structure"))
+      {
+        IndexT landmarkId;
+        sfmData::Landmark landmark;
+        const bool loadFeatures = (flags_part & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+        const bool loadObservations = (flags_part & OBSERVATIONS) == OBSERVATIONS;
+        loadLandmark(landmarkId, landmark, landmarkNode.second, loadObservations, loadFeatures);
+        BOOST_CHECK( sfmDataLoad.structure.at(landmarkId) == landmark );
+        BOOST_CHECK( sfmDataLoad.structure.at(landmarkId).X == landmark.X );
+      }
+    }
+    BOOST_CHECK_EQUAL( sfmDataLoad.control_points.size(), (flags_part & CONTROL_POINTS) ? sfmData.control_points.size() : 0 );
+  }
+
+  fs::remove_all(tmpDir);
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_fixture) {
+
+  // file written by the property tree based JSON writer
+  const std::string fixtureFilename = std::string(THIS_SOURCE_DIR) + "/sfmDataIO_test/propertyTreeWriter.sfm";
+  const sfmData::SfMData sfmData = createJsonFixtureScene();
+
+  const fs::path tmpDir = fs::temp_directory_path() / fs::unique_path("sfmDataIO_fixture_%%%%-%%%%");
+  fs::create_directories(tmpDir);
+  const std::string filename = (tmpDir / "FIXTURE.sfm").string();
+
+  // the C locale must not change the numbers, test with a comma decimal separator if available
+  std::vector<std::string> locales = {"C"};
+  for(const char* locale : {"de_DE.UTF-8", "fr_FR.UTF-8", "de_DE", "fr_FR"})
+  {
+    if(std::setlocale(LC_NUMERIC, locale) != nullptr)
+    {
+      locales.push_back(locale);
+      break;
+    }
+  }
+
+  for(const std::string& locale : locales)
+  {
+    std::setlocale(LC_NUMERIC, locale.c_str());
+
+    // the fixture is loaded as written
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, fixtureFilename, ALL) );
+    BOOST_CHECK( sfmDataLoad == sfmData );
+    for(const auto& landmarkPair : sfmData.structure)
+    {
+      BOOST_CHECK( sfmDataLoad.structure.at(landmarkPair.first).X == landmarkPair.second.X );
+      for(const auto& observationPair : landmarkPair.second.observations)
+      {
+        const sfmData::Observation& observation = sfmDataLoad.structure.at(landmarkPair.first).observations.at(observationPair.first);
+        BOOST_CHECK( observation.x == observationPair.second.x );
+        BOOST_CHECK_EQUAL( observation.scale, observationPair.second.scale );
+      }
+    }
+
+    // the scene is written exactly as the fixture
+    BOOST_CHECK( Save(sfmData, filename, ALL) );
+    BOOST_CHECK_MESSAGE( readFile(filename) == readFile(fixtureFilename), "written file differs from the fixture with the locale " << locale );
+  }
+  std::setlocale(LC_NUMERIC, "C");
+
+  fs::remove_all(tmpDir);
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
   const int nbObservationPerView = 100000;
-  std::vector<std::string> ext_Type = {"sfm","json"};
+  std::vector<std::string> ext_Type = {"sfm","json","sfmb"};
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   ext_Type.push_back("abc");
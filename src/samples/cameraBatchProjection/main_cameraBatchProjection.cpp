@@ -0,0 +1,147 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Random 3D points in front of the camera, seen inside the image domain
+ */
+Mat3X generatePoints(const IntrinsicBase& cam, const geometry::Pose3& pose, std::size_t nbPoints)
+{
+  Mat3X pts3D(3, nbPoints);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+  {
+    const Vec2 ptImage = (Vec2::Random() * 0.4 + Vec2(0.5, 0.5)).cwiseProduct(Vec2(cam.w(), cam.h()));
+    const double depth = 1.0 + std::abs(Vec2::Random()(0)) * 10.0;
+    pts3D.col(i) = cam.backproject(ptImage, true, pose, depth);
+  }
+  return pts3D;
+}
+
+/**
+ * @brief Measure the number of projections and undistortions per second
+ *        with the per point and the batch APIs
+ */
+void benchmarkCamera(const std::string& name, const IntrinsicBase& cam, std::size_t nbPoints, std::size_t nbRepetitions)
+{
+  const geometry::Pose3 pose(geometry::randomPose());
+  const Mat3X pts3D = generatePoints(cam, pose, nbPoints);
+  Mat2X pts2D;
+  cam.projectPoints(pose, pts3D, pts2D);
+  double checksum = 0.0;
+
+  system::Timer timer;
+  for(std::size_t r = 0; r < nbRepetitions; ++r)
+  {
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      checksum += cam.project(pose, pts3D.col(i))(0);
+  }
+  const double projectElapsed = timer.elapsed();
+
+  Mat2X batchPts2D;
+  timer.reset();
+  for(std::size_t r = 0; r < nbRepetitions; ++r)
+  {
+    cam.projectPoints(pose, pts3D, batchPts2D);
+    checksum += batchPts2D(0, 0);
+  }
+  const double projectPointsElapsed = timer.elapsed();
+
+  timer.reset();
+  for(std::size_t r = 0; r < nbRepetitions; ++r)
+  {
+    for(Mat2X::Index i = 0; i < pts2D.cols(); ++i)
+      checksum += cam.get_ud_pixel(pts2D.col(i))(0);
+  }
+  const double undistortElapsed = timer.elapsed();
+
+  Mat2X udPts2D;
+  timer.reset();
+  for(std::size_t r = 0; r < nbRepetitions; ++r)
+  {
+    cam.get_ud_pixels(pts2D, udPts2D);
+    checksum += udPts2D(0, 0);
+  }
+  const double undistortBatchElapsed = timer.elapsed();
+
+  const double nbOperations = nbRepetitions * nbPoints;
+  const auto perSecond = [nbOperations](double elapsed) { return nbOperations / std::max(elapsed, 1e-9); };
+
+  ALICEVISION_LOG_INFO(name << " (checksum: " << checksum << ")" << std::endl
+                       << "\t- project per point:     " << perSecond(projectElapsed) << " points/s" << std::endl
+                       << "\t- project batch:         " << perSecond(projectPointsElapsed) << " points/s" << std::endl
+                       << "\t- undistort per point:   " << perSecond(undistortElapsed) << " points/s" << std::endl
+                       << "\t- undistort batch:       " << perSecond(undistortBatchElapsed) << " points/s");
+}
+
+int main(int argc, char** argv)
+{
+  std::size_t nbPoints = 10000;
+  std::size_t nbRepetitions = 20;
+
+  po::options_description allParams("AliceVision Sample cameraBatchProjection\n"
+                                    "Throughput of the per point and batch projection APIs of each camera model");
+  allParams.add_options()
+    ("help,h", "Print the help.")
+    ("nbPoints", po::value<std::size_t>(&nbPoints)->default_value(nbPoints),
+      "Number of points projected in each batch.")
+    ("nbRepetitions", po::value<std::size_t>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of repetitions of each measure.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<std::pair<std::string, std::shared_ptr<IntrinsicBase>>> cameras = {
+    {"Pinhole", std::make_shared<Pinhole>(1000, 1000, 1000, 500, 500)},
+    {"PinholeRadialK1", std::make_shared<PinholeRadialK1>(1000, 1000, 1000, 500, 500, 0.1)},
+    {"PinholeRadialK3", std::make_shared<PinholeRadialK3>(1000, 1000, 1000, 500, 500, -0.245539, 0.255195, 0.163773)},
+    {"PinholeBrownT2", std::make_shared<PinholeBrownT2>(1000, 1000, 1000, 500, 500, -0.054, 0.014, 0.006, 0.001, -0.001)},
+    {"PinholeFisheye", std::make_shared<PinholeFisheye>(1000, 1000, 1000, 500, 500, -0.054, 0.014, 0.006, 0.011)},
+    {"PinholeFisheye1", std::make_shared<PinholeFisheye1>(1000, 1000, 1000, 500, 500, 0.1)},
+    {"EquiDistantRadialK3", std::make_shared<EquiDistantRadialK3>(1000, 800, 800, 500, 400, 0.0, 0.3, 0.2, 0.1)},
+  };
+
+  for(const auto& camera : cameras)
+    benchmarkCamera(camera.first, *camera.second, nbPoints, nbRepetitions);
+
+  return EXIT_SUCCESS;
+}
@@ -132,6 +132,8 @@ int aliceVision_main(int argc, char** argv)
   ALICEVISION_LOG_INFO("Build animated camera(s)...");
 
   image::Image<image::RGBfColor> image, image_ud;
+  // the frames of a video share the same intrinsic: the undistortion is computed once
+  camera::UndistortionMapCache undistortionMaps;
   boost::progress_display progressBar(sfmData.getViews().size());
 
   for(const auto& viewPair : sfmData.getViews())
@@ -162,7 +164,8 @@ int aliceVision_main(int argc, char** argv)
       if(cam->isValid() && cam->hasDistortion())
       {
         // undistort the image and save it
-        camera::UndistortImage(image, cam, image_ud, image::FBLACK, true); // correct principal point
+        const auto undistortionMap = undistortionMaps.get(*cam, image.Width(), image.Height(), true); // correct principal point
+        camera::UndistortImage(image, *undistortionMap, image_ud, image::FBLACK);
         image::writeImage(dstImage, image_ud, image::EImageColorSpace::LINEAR);
       }
       else // (no distortion)
@@ -11,6 +11,7 @@
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
 #include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/localization/OrderedFrameQueue.hpp>
 #include <aliceVision/localization/optimization.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
@@ -37,7 +38,10 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
 #include <aliceVision/sfmDataIO/AlembicExporter.hpp>
@@ -46,7 +50,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 4
 
 using namespace aliceVision;
 
@@ -61,6 +65,18 @@ std::string myToString(std::size_t i, std::size_t zeroPadding)
   return ss.str();
 }
 
+/**
+ * @brief A frame of the media whose features are extracted, waiting for localization.
+ */
+struct QueryFrame
+{
+  std::string imageName;
+  camera::PinholeRadialK3 queryIntrinsics;
+  bool hasIntrinsics = false;
+  std::pair<std::size_t, std::size_t> imageSize;
+  feature::MapRegionsPerDesc queryRegions;
+};
+
 int aliceVision_main(int argc, char** argv)
 {
   /// the calibration file
@@ -104,6 +120,19 @@ int aliceVision_main(int argc, char** argv)
   std::string vocTreeFilepath;
   /// the vocabulary tree weights file
   std::string weightsFilepath;
+  /// the precompiled reconstruction database file
+  std::string reconstructionDatabaseFilepath;
+  /// the precompiled landmarks index file for the Direct algorithm
+  std::string landmarksIndexFilepath;
+  /// number of leaves visited in the landmarks index for each query feature
+  int nbIndexChecks = 128;
+  /// enable/disable the tracking of the frames from the last localized one
+  bool poseTracking = false;
+  /// radius (in pixels) of the search window of the tracking
+  double trackingWindowRadius = 20.0;
+  double trackingMaxDescriptorDistance = 250.0;
+  /// minimum number of inliers for a frame to be localized by tracking
+  std::size_t trackingMinInliers = 30;
   /// Number of previous frame of the sequence to use for matching
   std::size_t nbFrameBufferMatching = 10;
   /// enable/disable the robust matching (geometric validation) when matching query image
@@ -133,6 +162,12 @@ int aliceVision_main(int argc, char** argv)
   /// whether to save visual debug info
   std::string visualDebug = "";
 
+  // pipeline parameters
+  /// maximum number of frames read and not yet localized (1: no pipeline)
+  std::size_t nbFramesInFlight = 1;
+  /// number of threads reading the frames and extracting their features
+  std::size_t nbExtractionThreads = 0;
+
   po::options_description allParams(
       "This program takes as input a media (image, image sequence, video) and a database (vocabulary tree, 3D scene data) \n"
       "and returns for each frame a pose estimation for the camera.");
@@ -167,7 +202,15 @@ int aliceVision_main(int argc, char** argv)
           "Enable/Disable camera intrinsics refinement for each localized image")
       ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax), 
           "Maximum reprojection error (in pixels) allowed for resectioning. If set "
-          "to 0 it lets the ACRansac select an optimal value.");
+          "to 0 it lets the ACRansac select an optimal value.")
+      ("nbFramesInFlight", po::value<std::size_t>(&nbFramesInFlight)->default_value(nbFramesInFlight),
+          "Maximum number of frames read and not yet localized. If greater than 1, "
+          "the frames are read and their features extracted concurrently while the "
+          "previous frames are localized in order.")
+      ("nbExtractionThreads", po::value<std::size_t>(&nbExtractionThreads)->default_value(nbExtractionThreads),
+          "Number of threads reading the frames and extracting their features when "
+          "nbFramesInFlight is greater than 1 (0 = nbFramesInFlight, up to the number of cores). "
+          "Use 1 with GPU feature extractors.");
   
 // voctree specific options
   po::options_description voctreeParams("Parameters specific for the vocabulary tree-based localizer");
@@ -184,8 +227,32 @@ int aliceVision_main(int argc, char** argv)
           "[voctree] Filename for the vocabulary tree")
       ("voctreeWeights", po::value<std::string>(&weightsFilepath), 
           "[voctree] Filename for the vocabulary tree weights")
+      ("reconstructionDatabase", po::value<std::string>(&reconstructionDatabaseFilepath),
+          "[voctree] Filename for the precompiled reconstruction database. It is loaded "
+          "if it exists and matches the inputs, otherwise it is built and saved, so that "
+          "the next localizations skip the loading of the features of the reconstruction.")
       ("algorithm", po::value<std::string>(&algostring)->default_value(algostring), 
-          "[voctree] Algorithm type: FirstBest, AllResults" )
+          "[voctree] Algorithm type: FirstBest, AllResults, Direct" )
+      ("landmarksIndex", po::value<std::string>(&landmarksIndexFilepath),
+          "[voctree] Filename for the precompiled landmarks index used by the Direct "
+          "algorithm. It is loaded if it exists and matches the inputs, otherwise it "
+          "is built and saved.")
+      ("nbIndexChecks", po::value<int>(&nbIndexChecks)->default_value(nbIndexChecks),
+          "[voctree] For algorithm Direct, number of leaves of the landmarks index "
+          "visited for each query feature (higher is more accurate and slower).")
+      ("poseTracking", po::value<bool>(&poseTracking)->default_value(poseTracking),
+          "[voctree] Enable/Disable the tracking of sequential frames: the landmarks of the "
+          "last localized frame are projected with a constant velocity prediction of the pose "
+          "and matched in a small window, the algorithm is only used when the track is lost.")
+      ("trackingWindowRadius", po::value<double>(&trackingWindowRadius)->default_value(trackingWindowRadius),
+          "[voctree] Radius (in pixels) of the search window around the predicted projection "
+          "of the landmarks when poseTracking is enabled.")
+      ("trackingMaxDescriptorDistance", po::value<double>(&trackingMaxDescriptorDistance)->default_value(trackingMaxDescriptorDistance),
+          "[voctree] Maximum descriptor distance of a match found by poseTracking "
+          "(L2 distance for SIFT), it also rejects a single feature in the search window.")
+      ("trackingMinInliers", po::value<std::size_t>(&trackingMinInliers)->default_value(trackingMinInliers),
+          "[voctree] Minimum number of inliers for a frame to be localized by tracking, "
+          "otherwise the track is lost and the frame is localized with the algorithm.")
       ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax), 
           "[voctree] Maximum matching error (in pixels) allowed for image matching with "
           "geometric verification. If set to 0 it lets the ACRansac select "
@@ -342,7 +409,8 @@ int aliceVision_main(int argc, char** argv)
                                                    descriptorsFolder,
                                                    vocTreeFilepath,
                                                    weightsFilepath,
-                                                   matchDescTypes);
+                                                   matchDescTypes,
+                                                   reconstructionDatabaseFilepath);
 
     localizer.reset(tmpLoc);
     
@@ -356,6 +424,18 @@ int aliceVision_main(int argc, char** argv)
     tmpParam->_matchingError = matchingErrorMax;
     tmpParam->_nbFrameBufferMatching = nbFrameBufferMatching;
     tmpParam->_useRobustMatching = robustMatching;
+    tmpParam->_nbIndexChecks = nbIndexChecks;
+    tmpParam->_usePoseTracking = poseTracking;
+    tmpParam->_trackingWindowRadius = trackingWindowRadius;
+    tmpParam->_trackingMaxDescriptorDistance = trackingMaxDescriptorDistance;
+    tmpParam->_trackingMinInliers = trackingMinInliers;
+
+    if(tmpParam->_algorithm == localization::VoctreeLocalizer::Algorithm::Direct &&
+       !tmpLoc->initLandmarksIndex(landmarksIndexFilepath))
+    {
+      ALICEVISION_LOG_ERROR("Cannot initialize the landmarks index for the Direct algorithm.");
+      return EXIT_FAILURE;
+    }
   }
   
   assert(localizer);
@@ -408,32 +488,18 @@ int aliceVision_main(int argc, char** argv)
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
-  
-  while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+
+  // save the result of the current frame
+  const auto addLocalizationResult = [&](const localization::LocalizationResult& localizationResult,
+                                         const camera::PinholeRadialK3& frameIntrinsics)
   {
-    ALICEVISION_COUT("******************************");
-    ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
-    ALICEVISION_COUT("******************************");
-    localization::LocalizationResult localizationResult;
-    auto detect_start = std::chrono::steady_clock::now();
-    localizer->localize(imageGrey, 
-                       param.get(),
-                       hasIntrinsics /*useInputIntrinsics*/,
-                       queryIntrinsics,
-                       localizationResult,
-                       currentImgName);
-    auto detect_end = std::chrono::steady_clock::now();
-    auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
-    stats(detect_elapsed.count());
-    
     vec_localizationResults.emplace_back(localizationResult);
 
     // save data
     if(localizationResult.isValid())
     {
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
-      exporter.addCameraKeyframe(localizationResult.getPose(), &queryIntrinsics, currentImgName, frameCounter, frameCounter);
+      exporter.addCameraKeyframe(localizationResult.getPose(), &frameIntrinsics, currentImgName, frameCounter, frameCounter);
 #endif
       
       goodFrameCounter++;
@@ -447,7 +513,133 @@ int aliceVision_main(int argc, char** argv)
 #endif
     }
     ++frameCounter;
-    feed.goToNextFrame();
+  };
+
+  if(nbFramesInFlight <= 1)
+  {
+    while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+      ALICEVISION_COUT("******************************");
+      localization::LocalizationResult localizationResult;
+      auto detect_start = std::chrono::steady_clock::now();
+      localizer->localize(imageGrey, 
+                         param.get(),
+                         hasIntrinsics /*useInputIntrinsics*/,
+                         queryIntrinsics,
+                         localizationResult,
+                         currentImgName);
+      auto detect_end = std::chrono::steady_clock::now();
+      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+      ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
+      stats(detect_elapsed.count());
+
+      addLocalizationResult(localizationResult, queryIntrinsics);
+      feed.goToNextFrame();
+    }
+  }
+  else
+  {
+    // the frames are read and their features are extracted concurrently,
+    // the matching and the resection are done in the frame order as they
+    // depend on the previous frames (frame buffer matching)
+    if(nbExtractionThreads == 0)
+      nbExtractionThreads = std::min<std::size_t>(nbFramesInFlight, std::max(1u, std::thread::hardware_concurrency()));
+
+    ALICEVISION_COUT("Pipelined localization: " << nbExtractionThreads << " extraction threads, "
+                     << nbFramesInFlight << " frames in flight");
+
+    localization::OrderedFrameQueue<std::unique_ptr<QueryFrame>> frameQueue(nbFramesInFlight, nbExtractionThreads);
+    std::mutex feedMutex;
+    std::size_t nbReadFrames = 0;
+
+    // the first error stops the pipeline and is rethrown once the threads are joined
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    const auto cancel = [&](std::exception_ptr e)
+    {
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if(!error)
+          error = e;
+      }
+      frameQueue.cancel();
+    };
+
+    const auto extract = [&]()
+    {
+      try
+      {
+        const auto imageDescribers = localizer->createImageDescribers();
+        image::Image<float> frameImage;
+
+        while(frameQueue.acquireSlot())
+        {
+          std::unique_ptr<QueryFrame> frame(new QueryFrame());
+          std::size_t frameIndex;
+          {
+            std::lock_guard<std::mutex> lock(feedMutex);
+            if(!feed.readImage(frameImage, frame->queryIntrinsics, frame->imageName, frame->hasIntrinsics))
+            {
+              frameQueue.releaseSlot();
+              break;
+            }
+            frameIndex = nbReadFrames++;
+            feed.goToNextFrame();
+          }
+          frame->imageSize = std::make_pair(frameImage.Width(), frameImage.Height());
+          localizer->extractFeatures(frameImage, param.get(), imageDescribers, frame->queryRegions, frame->imageName);
+          frameQueue.push(frameIndex, std::move(frame));
+        }
+      }
+      catch(...)
+      {
+        cancel(std::current_exception());
+      }
+      frameQueue.producerDone();
+    };
+
+    std::vector<std::thread> extractionThreads;
+    for(std::size_t i = 0; i < nbExtractionThreads; ++i)
+      extractionThreads.emplace_back(extract);
+
+    try
+    {
+      std::unique_ptr<QueryFrame> frame;
+      while(frameQueue.pop(frame))
+      {
+        ALICEVISION_COUT("******************************");
+        ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+        ALICEVISION_COUT("******************************");
+        currentImgName = frame->imageName;
+        localization::LocalizationResult localizationResult;
+        auto detect_start = std::chrono::steady_clock::now();
+        localizer->localize(frame->queryRegions,
+                            frame->imageSize,
+                            param.get(),
+                            frame->hasIntrinsics /*useInputIntrinsics*/,
+                            frame->queryIntrinsics,
+                            localizationResult,
+                            currentImgName);
+        auto detect_end = std::chrono::steady_clock::now();
+        auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+        ALICEVISION_COUT("\nLocalization (without feature extraction) took  " << detect_elapsed.count() << " [ms]");
+        stats(detect_elapsed.count());
+
+        addLocalizationResult(localizationResult, frame->queryIntrinsics);
+      }
+    }
+    catch(...)
+    {
+      cancel(std::current_exception());
+    }
+
+    for(std::thread& thread : extractionThreads)
+      thread.join();
+
+    if(error)
+      std::rethrow_exception(error);
   }
 
   if(wantsJsonOutput)
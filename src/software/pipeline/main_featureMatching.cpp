@@ -106,6 +106,7 @@ int aliceVision_main(int argc, char **argv)
   int rangeSize = 0;
   std::string nearestMatchingMethod = "ANN_L2";
   robustEstimation::ERobustEstimator geometricEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  bool geometricEstimatorSPRT = false;
   double geometricErrorMax = 0.0; //< the maximum reprojection error allowed for image matching with geometric validation
   double knownPosesGeometricErrorMax = 4.0;
   bool savePutativeMatches = false;
@@ -156,6 +157,9 @@ int aliceVision_main(int argc, char **argv)
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
       "* loransac: LO-Ransac (only available for fundamental matrix). Need to set '--geometricError'")
+    ("geometricEstimatorSPRT", po::value<bool>(&geometricEstimatorSPRT)->default_value(geometricEstimatorSPRT),
+      "Reject bad hypotheses of the geometric estimator after a few residuals with a Sequential Probability Ratio Test. "
+      "Faster on pairs with many putative matches.")
     ("geometricError", po::value<double>(&geometricErrorMax)->default_value(geometricErrorMax), 
       "Maximum error (in pixels) allowed for features matching during geometric verification. "
       "If set to 0 it lets the ACRansac select an optimal value.")
@@ -457,10 +461,12 @@ int aliceVision_main(int argc, char **argv)
 
     case EGeometricFilterType::FUNDAMENTAL_MATRIX:
     {
+      GeometricFilterMatrix_F_AC geometricFilter(geometricErrorMax, maxIteration, geometricEstimator);
+      geometricFilter.m_useSPRT = geometricEstimatorSPRT;
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
+        geometricFilter,
         mapPutativesMatches,
         guidedMatching);
     }
@@ -468,10 +474,12 @@ int aliceVision_main(int argc, char **argv)
 
   case EGeometricFilterType::FUNDAMENTAL_WITH_DISTORTION:
   {
+    GeometricFilterMatrix_F_AC geometricFilter(geometricErrorMax, maxIteration, geometricEstimator, true);
+    geometricFilter.m_useSPRT = geometricEstimatorSPRT;
     matchingImageCollection::robustModelEstimation(geometricMatches,
       &sfmData,
       regionPerView,
-      GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, true),
+      geometricFilter,
       mapPutativesMatches,
       guidedMatching);
   }
@@ -479,10 +487,12 @@ int aliceVision_main(int argc, char **argv)
 
     case EGeometricFilterType::ESSENTIAL_MATRIX:
     {
+      GeometricFilterMatrix_E_AC geometricFilter(geometricErrorMax, maxIteration);
+      geometricFilter.m_useSPRT = geometricEstimatorSPRT;
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_E_AC(geometricErrorMax, maxIteration),
+        geometricFilter,
         mapPutativesMatches,
         guidedMatching);
 
@@ -508,10 +518,12 @@ int aliceVision_main(int argc, char **argv)
     case EGeometricFilterType::HOMOGRAPHY_MATRIX:
     {
       const bool onlyGuidedMatching = true;
+      GeometricFilterMatrix_H_AC geometricFilter(geometricErrorMax, maxIteration);
+      geometricFilter.m_useSPRT = geometricEstimatorSPRT;
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_H_AC(geometricErrorMax, maxIteration),
+        geometricFilter,
         mapPutativesMatches, guidedMatching,
         onlyGuidedMatching ? -1.0 : 0.6);
     }
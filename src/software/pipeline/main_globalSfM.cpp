@@ -48,6 +48,7 @@ int aliceVision_main(int argc, char **argv)
   sfm::ERotationAveragingMethod rotationAveragingMethod = sfm::ROTATION_AVERAGING_L2;
   sfm::ETranslationAveragingMethod translationAveragingMethod = sfm::TRANSLATION_AVERAGING_SOFTL1;
   bool lockAllIntrinsics = false;
+  std::size_t partitionedBAMaxClusterSize = 0;
 
   po::options_description allParams("Implementation of the paper\n"
     "\"Global Fusion of Relative Motions for "
@@ -82,7 +83,9 @@ int aliceVision_main(int argc, char **argv)
       "* 2: L2 minimization of sum of squared Chordal distances\n"
       "* 3: L1 soft minimization")
     ("lockAllIntrinsics", po::value<bool>(&lockAllIntrinsics)->default_value(lockAllIntrinsics),
-      "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.");
+      "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.")
+    ("partitionedBAMaxClusterSize", po::value<std::size_t>(&partitionedBAMaxClusterSize)->default_value(partitionedBAMaxClusterSize),
+      "Maximum number of poses per cluster of the partitioned Bundle Adjustment, used for the scenes with more poses (0 to disable).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -195,6 +198,7 @@ int aliceVision_main(int argc, char **argv)
 
   // configure reconstruction parameters
   sfmEngine.setLockAllIntrinsics(lockAllIntrinsics); // TODO: rename param
+  sfmEngine.setPartitionedBAMaxClusterSize(partitionedBAMaxClusterSize);
 
   // configure motion averaging method
   sfmEngine.SetRotationAveragingMethod(sfm::ERotationAveragingMethod(rotationAveragingMethod));
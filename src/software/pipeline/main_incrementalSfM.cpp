@@ -159,6 +159,8 @@ int aliceVision_main(int argc, char **argv)
       "Reprojection error threshold (in pixels) for the localizer estimator (0 for default value according to the estimator).")
     ("localizerEstimatorMaxIterations", po::value<std::size_t>(&sfmParams.localizerEstimatorMaxIterations)->default_value(sfmParams.localizerEstimatorMaxIterations),
       "Max number of RANSAC iterations.")
+    ("localizerEstimatorSPRT", po::value<bool>(&sfmParams.localizerEstimatorSPRT)->default_value(sfmParams.localizerEstimatorSPRT),
+      "Reject bad hypotheses of the localizer estimator after a few residuals with a Sequential Probability Ratio Test.")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
       "Use only matches from the input matchesFolder parameter.\n"
       "Matches folders previously added to the SfMData file will be ignored.")
@@ -9,14 +9,13 @@
 #include <aliceVision/system/main.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/meshDecimation.hpp>
 
 #include <OpenMesh/Core/IO/reader/OBJReader.hh>
 #include <OpenMesh/Core/IO/writer/OBJWriter.hh>
 #include <OpenMesh/Core/IO/MeshIO.hh>
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
-#include <OpenMesh/Core/Geometry/VectorT.hh>
-#include <OpenMesh/Tools/Decimater/DecimaterT.hh>
-#include <OpenMesh/Tools/Decimater/ModQuadricT.hh>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -24,7 +23,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -44,6 +43,7 @@ int aliceVision_main(int argc, char* argv[])
     int minVertices = 0;
     int maxVertices = 0;
     bool flipNormals = false;
+    mesh::DecimationParams decimationParams;
 
     po::options_description allParams("AliceVision meshResampling");
 
@@ -65,7 +65,11 @@ int aliceVision_main(int argc, char* argv[])
         ("maxVertices", po::value<int>(&maxVertices)->default_value(maxVertices),
             "Max number of output vertices.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
-            "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.");
+            "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.")
+        ("clusterSize", po::value<int>(&decimationParams.clusterSize)->default_value(decimationParams.clusterSize),
+            "Approximate number of triangles of the spatial clusters decimated in parallel.")
+        ("maxNbPasses", po::value<int>(&decimationParams.maxNbPasses)->default_value(decimationParams.maxNbPasses),
+            "Maximum number of passes, the clusters are shifted at each pass to decimate their previous borders.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -112,22 +116,37 @@ int aliceVision_main(int argc, char* argv[])
         bfs::create_directory(outDirectory);
 
     // Mesh type
-    typedef OpenMesh::TriMesh_ArrayKernelT<>                      Mesh;
-    // Decimater type
-    typedef OpenMesh::Decimater::DecimaterT< Mesh >               Decimater;
-    // Decimation Module Handle type
-    typedef OpenMesh::Decimater::ModQuadricT< Mesh >::Handle HModQuadric;
-
-    Mesh mesh;
-    if(!OpenMesh::IO::read_mesh(mesh, inputMeshPath.c_str()))
+    typedef OpenMesh::TriMesh_ArrayKernelT<> OMesh;
+
+    OMesh inputMesh;
+    if(!OpenMesh::IO::read_mesh(inputMesh, inputMeshPath.c_str()))
     {
         ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
         return EXIT_FAILURE;
     }
 
+    // the mesh file is read and written with OpenMesh (for all the file formats it supports),
+    // the decimation is done in-process on a mesh::Mesh
+    mesh::Mesh mesh;
+    mesh.pts.reserve(inputMesh.n_vertices());
+    for(OMesh::VertexIter vIt = inputMesh.vertices_begin(); vIt != inputMesh.vertices_end(); ++vIt)
+    {
+        const OMesh::Point& p = inputMesh.point(*vIt);
+        mesh.pts.push_back(Point3d(p[0], p[1], p[2]));
+    }
+    mesh.tris.reserve(inputMesh.n_faces());
+    for(OMesh::FaceIter fIt = inputMesh.faces_begin(); fIt != inputMesh.faces_end(); ++fIt)
+    {
+        mesh::Mesh::triangle t;
+        int k = 0;
+        for(OMesh::FaceVertexIter fvIt = inputMesh.fv_iter(*fIt); fvIt.is_valid() && k < 3; ++fvIt)
+            t.v[k++] = fvIt->idx();
+        mesh.tris.push_back(t);
+    }
+
     ALICEVISION_LOG_INFO("Mesh file: \"" << inputMeshPath << "\" loaded.");
 
-    int nbInputPoints = mesh.n_vertices();
+    int nbInputPoints = mesh.pts.size();
     int nbOutputPoints = 0;
     if(fixedNbVertices != 0)
     {
@@ -151,43 +170,41 @@ int aliceVision_main(int argc, char* argv[])
         }
     }
 
-    ALICEVISION_LOG_INFO("Input mesh: " << nbInputPoints << " vertices and " << mesh.n_faces() << " facets.");
+    ALICEVISION_LOG_INFO("Input mesh: " << nbInputPoints << " vertices and " << mesh.tris.size() << " facets.");
     ALICEVISION_LOG_INFO("Target output mesh: " << nbOutputPoints << " vertices.");
 
-    {
-        // a decimater object, connected to a mesh
-        Decimater   decimater(mesh);
-        // use a quadric module
-        HModQuadric hModQuadric;
-        // register module at the decimater
-        decimater.add(hModQuadric);
-
-        // the way to access the module
-        std::cout << decimater.module(hModQuadric).name() << std::endl;
-
-        /*
-         * since we need exactly one priority module (non-binary)
-         * we have to call set_binary(false) for our priority module
-         * in the case of HModQuadric, unset_max_err() calls set_binary(false) internally
-         */
-        decimater.module(hModQuadric).unset_max_err();
-        // let the decimater initialize the mesh and the modules
-        decimater.initialize();
-        // do decimation
-        size_t removedVertices = decimater.decimate_to(nbOutputPoints);
-        decimater.mesh().garbage_collection();
-    }
-    ALICEVISION_LOG_INFO("Output mesh: " << mesh.n_vertices() << " vertices and " << mesh.n_faces() << " facets.");
+    // as with the previous OpenMesh decimation, the triangles keep the orientation of the input mesh
+    if(flipNormals)
+        ALICEVISION_LOG_WARNING("The flipNormals option is not applied by the decimation.");
+
+    decimationParams.nbTargetPoints = nbOutputPoints;
+    mesh::decimateMesh(mesh, decimationParams);
+
+    ALICEVISION_LOG_INFO("Output mesh: " << mesh.pts.size() << " vertices and " << mesh.tris.size() << " facets.");
 
-    if(mesh.n_faces() == 0)
+    if(mesh.tris.empty())
     {
         ALICEVISION_LOG_ERROR("Failed: the output mesh is empty.");
         return EXIT_FAILURE;
     }
 
+    OMesh outputMesh;
+    std::vector<OMesh::VertexHandle> vertexHandles(mesh.pts.size());
+    for(int i = 0; i < mesh.pts.size(); ++i)
+        vertexHandles[i] = outputMesh.add_vertex(OMesh::Point(mesh.pts[i].x, mesh.pts[i].y, mesh.pts[i].z));
+    int nbRejectedFacets = 0;
+    for(int i = 0; i < mesh.tris.size(); ++i)
+    {
+        const mesh::Mesh::triangle& t = mesh.tris[i];
+        if(!outputMesh.add_face(vertexHandles[t.v[0]], vertexHandles[t.v[1]], vertexHandles[t.v[2]]).is_valid())
+            ++nbRejectedFacets;
+    }
+    if(nbRejectedFacets > 0)
+        ALICEVISION_LOG_WARNING(nbRejectedFacets << " non-manifold facets cannot be written.");
+
     ALICEVISION_LOG_INFO("Save mesh.");
     // Save output mesh
-    if(!OpenMesh::IO::write_mesh(mesh, outputMeshPath))
+    if(!OpenMesh::IO::write_mesh(outputMesh, outputMeshPath))
     {
         ALICEVISION_LOG_ERROR("Failed to save mesh \"" << outputMeshPath << "\".");
         return EXIT_FAILURE;
@@ -18,7 +18,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 3
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -38,6 +38,7 @@ int aliceVision_main(int argc, char* argv[])
 
     int smoothNIter = 10;
     float lambda = 1.0f;
+    float taubinMu = 0.0f;
 
     po::options_description allParams("AliceVision meshFiltering");
 
@@ -46,7 +47,7 @@ int aliceVision_main(int argc, char* argv[])
         ("inputMesh,i", po::value<std::string>(&inputMeshPath)->required(),
             "Input Mesh (OBJ file format).")
         ("outputMesh,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ, PLY or binary .bin file format, deduced from the extension, OBJ for an unknown extension).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -57,7 +58,10 @@ int aliceVision_main(int argc, char* argv[])
         ("iterations", po::value<int>(&smoothNIter)->default_value(smoothNIter),
             "Number of smoothing iterations.")
         ("lambda", po::value<float>(&lambda)->default_value(lambda),
-            "Smoothing size.");
+            "Smoothing size.")
+        ("taubinMu", po::value<float>(&taubinMu)->default_value(taubinMu),
+            "If not zero, use the Taubin lambda/mu smoothing with this inflating step size (mu < -lambda) "
+            "instead of the bi-Laplacian smoothing.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -137,7 +141,10 @@ int aliceVision_main(int argc, char* argv[])
         meOpt.cleanMesh(10);
 
         StaticVectorBool ptsCanMove;
-        meOpt.optimizeSmooth(lambda, smoothNIter, ptsCanMove);
+        if(taubinMu != 0.0f)
+            meOpt.optimizeSmoothTaubin(lambda, taubinMu, smoothNIter, ptsCanMove);
+        else
+            meOpt.optimizeSmooth(lambda, smoothNIter, ptsCanMove);
 
         ALICEVISION_LOG_INFO("Mesh filtering done: " << meOpt.pts.size() << " vertices and " << meOpt.tris.size() << " facets.");
     }
@@ -170,7 +177,7 @@ int aliceVision_main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Save mesh.");
 
     // Save output mesh
-    outMesh.saveToObj(outputMeshPath);
+    outMesh.save(outputMeshPath);
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << outputMeshPath << "\" saved.");
 
@@ -28,7 +28,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 4
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -144,12 +144,16 @@ int aliceVision_main(int argc, char* argv[])
     std::size_t estimateSpaceMinObservations = 3;
     float estimateSpaceMinObservationAngle = 10.0f;
     double universePercentile = 0.999;
+    std::string delaunayAlgorithm = "BDEL";
     int maxPtsPerVoxel = 6000000;
     bool meshingFromDepthMaps = true;
     bool estimateSpaceFromSfM = true;
     bool addLandmarksToTheDensePointCloud = false;
     bool saveRawDensePointCloud = false;
     bool colorizeOutput = false;
+    float partitioningOverlap = 0.05f;
+    int rangeStart = -1;
+    int rangeSize = 1;
 
     fuseCut::FuseParams fuseParams;
 
@@ -190,12 +194,22 @@ int aliceVision_main(int argc, char* argv[])
         ("addLandmarksToTheDensePointCloud", po::value<bool>(&addLandmarksToTheDensePointCloud)->default_value(addLandmarksToTheDensePointCloud),
             "Add SfM Landmarks into the dense point cloud (created from depth maps). If only the SfM is provided in input, SfM landmarks will be used regardless of this option.")
         ("colorizeOutput", po::value<bool>(&colorizeOutput)->default_value(colorizeOutput),
-            "Whether to colorize output dense point cloud and mesh.");
+            "Whether to colorize output dense point cloud and mesh.")
+        ("partitioningOverlap", po::value<float>(&partitioningOverlap)->default_value(partitioningOverlap),
+            "Partitioning 'auto': overlap between neighboring voxels, relative to the voxel size (saved with the reconstruction plan).")
+        ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+            "Partitioning 'auto': mesh a sub-range of the voxels from index rangeStart to rangeStart+rangeSize, "
+            "without stitching the voxels meshes. The ranges can run concurrently once the reconstruction plan is computed "
+            "(rangeStart=0 and rangeSize=0 only computes the plan). A final call without range stitches the meshes.")
+        ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+            "Range size.");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
         ("universePercentile", po::value<double>(&universePercentile)->default_value(universePercentile),
             "universe percentile")
+        ("delaunayAlgorithm", po::value<std::string>(&delaunayAlgorithm)->default_value(delaunayAlgorithm),
+            "Geogram Delaunay algorithm: BDEL (sequential, reproducible) or PDEL (multithreaded, the result may differ between runs).")
         ("estimateSpaceMinObservations", po::value<std::size_t>(&estimateSpaceMinObservations)->default_value(estimateSpaceMinObservations),
             "Minimum number of observations for SfM space estimation.")
         ("estimateSpaceMinObservationAngle", po::value<float>(&estimateSpaceMinObservationAngle)->default_value(estimateSpaceMinObservationAngle),
@@ -289,6 +303,7 @@ int aliceVision_main(int argc, char* argv[])
     mvsUtils::MultiViewParams mp(sfmData, "", "", depthMapsFolder, meshingFromDepthMaps);
 
     mp.userParams.put("LargeScale.universePercentile", universePercentile);
+    mp.userParams.put("delaunaycut.delaunayAlgorithm", delaunayAlgorithm);
 
     int ocTreeDim = mp.userParams.get<int>("LargeScale.gridLevel0", 1024);
     const auto baseDir = mp.userParams.get<std::string>("LargeScale.baseDirName", "root01024");
@@ -314,27 +329,71 @@ int aliceVision_main(int argc, char* argv[])
                 case ePartitioningAuto:
                 {
                     ALICEVISION_LOG_INFO("Meshing mode: regular Grid, partitioning: auto.");
+                    float inflateFactor = 1.0f + partitioningOverlap;
                     fuseCut::LargeScale lsbase(&mp, tmpDirectory.string() + "/");
-                    lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                     std::string voxelsArrayFileName = lsbase.spaceFolderName + "hexahsToReconstruct.bin";
                     StaticVector<Point3d>* voxelsArray = nullptr;
                     if(fs::exists(voxelsArrayFileName))
                     {
                         // If already computed reload it.
                         ALICEVISION_LOG_INFO("Voxels array already computed, reload from file: " << voxelsArrayFileName);
+                        lsbase.loadSpaceFromFile();
                         voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+                        // the stitching has to use the overlap of the existing plan
+                        float planInflateFactor = 0.0f;
+                        if(!fuseCut::loadVoxelsArrayInflateFactor(voxelsArrayFileName, planInflateFactor))
+                        {
+                            ALICEVISION_LOG_ERROR("The voxels array has no partitioning overlap, remove it to compute the reconstruction plan again: "
+                                                  << voxelsArrayFileName);
+                            delete voxelsArray;
+                            return EXIT_FAILURE;
+                        }
+                        if(planInflateFactor != inflateFactor)
+                            ALICEVISION_LOG_WARNING("The voxels array has been computed with partitioningOverlap="
+                                                    << planInflateFactor - 1.0f << ", the given partitioningOverlap is ignored.");
+                        inflateFactor = planInflateFactor;
                     }
                     else
                     {
+                        // concurrent ranges would compute the same space in the same folder
+                        if(rangeStart != -1 && rangeSize > 0)
+                        {
+                            ALICEVISION_LOG_ERROR("The reconstruction plan has to be computed before meshing ranges of voxels "
+                                                  "(use rangeStart=0 and rangeSize=0).");
+                            return EXIT_FAILURE;
+                        }
+                        lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                         ALICEVISION_LOG_INFO("Compute voxels array.");
                         fuseCut::ReconstructionPlan rp(lsbase.dimensions, &lsbase.space[0], lsbase.mp, lsbase.spaceVoxelsFolderName);
-                        voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints);
+                        voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints, inflateFactor);
                         saveArrayToFile<Point3d>(voxelsArrayFileName, voxelsArray);
+                        fuseCut::saveVoxelsArrayInflateFactor(voxelsArrayFileName, inflateFactor);
+                    }
+                    const int nbVoxels = voxelsArray->size() / 8;
+                    ALICEVISION_LOG_INFO("Reconstruction plan: " << nbVoxels << " voxels.");
+
+                    if(rangeStart != -1)
+                    {
+                        if(rangeStart < 0 || rangeSize < 0 || rangeStart > nbVoxels)
+                        {
+                            ALICEVISION_LOG_ERROR("Range is incorrect");
+                            delete voxelsArray;
+                            return EXIT_FAILURE;
+                        }
+                        ALICEVISION_LOG_DEBUG("Range to compute: rangeStart=" << rangeStart << ", rangeSize=" << rangeSize);
+                        fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase, rangeStart, rangeSize);
+                        delete voxelsArray;
+                        ALICEVISION_LOG_INFO("Voxels range meshed in (s): " + std::to_string(timer.elapsed()));
+                        return EXIT_SUCCESS;
                     }
+
+                    // mesh the voxels not meshed by range jobs
                     fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase);
-                    // Join meshes and ptsCams
-                    mesh = fuseCut::joinMeshes(voxelsArrayFileName, &lsbase);
-                    fuseCut::loadLargeScalePtsCams(lsbase.getRecsDirs(voxelsArray), ptsCams);
+                    // Stitch meshes and ptsCams
+                    const Point3d spaceSteps = lsbase.getSpaceSteps();
+                    const double weldDist = 2.0 * std::max(spaceSteps.x, std::max(spaceSteps.y, spaceSteps.z));
+                    mesh = fuseCut::stitchMeshes(lsbase.getRecsDirs(voxelsArray), *voxelsArray, inflateFactor, weldDist, ptsCams);
+                    delete voxelsArray;
                     break;
                 }
                 case ePartitioningSingleBlock:
@@ -528,7 +587,7 @@ int aliceVision_main(int argc, char* argv[])
     sfmDataIO::Save(densePointCloud, outputDensePointCloud, sfmDataIO::ESfMData::ALL_DENSE);
 
     ALICEVISION_LOG_INFO("Save obj mesh file.");
-    mesh->saveToObj(outputMesh);
+    mesh->save(outputMesh);
     delete mesh;
 
 
@@ -8,9 +8,11 @@
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/main.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
 
 #include <boost/program_options.hpp>
@@ -19,7 +21,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <set>
 #include <iterator>
@@ -28,7 +37,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -40,6 +49,230 @@ using namespace aliceVision::sfmDataIO;
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
+namespace {
+
+/**
+ * @brief Memory budget shared by the images in flight in the pipeline.
+ * A job larger than the whole budget is admitted alone.
+ */
+class MemoryBudget
+{
+public:
+  explicit MemoryBudget(std::size_t maxBytes)
+    : _maxBytes(maxBytes)
+  {}
+
+  /// wait until the bytes fit in the budget, return false if the pipeline is cancelled
+  bool acquire(std::size_t bytes)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _released.wait(lock, [&]{ return _cancelled || _usedBytes == 0 || _usedBytes + bytes <= _maxBytes; });
+    if(_cancelled)
+      return false;
+    _usedBytes += bytes;
+    return true;
+  }
+
+  void release(std::size_t bytes)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _usedBytes -= bytes;
+    }
+    _released.notify_all();
+  }
+
+  void cancel()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cancelled = true;
+    }
+    _released.notify_all();
+  }
+
+private:
+  const std::size_t _maxBytes;
+  std::size_t _usedBytes = 0;
+  bool _cancelled = false;
+  std::mutex _mutex;
+  std::condition_variable _released;
+};
+
+/**
+ * @brief Queue between two stages of the pipeline.
+ * The queue is closed once all the producers are done, pop returns false when it is closed and empty.
+ */
+template <typename T>
+class StageQueue
+{
+public:
+  explicit StageQueue(int nbProducers)
+    : _nbProducers(nbProducers)
+  {}
+
+  void push(T item)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_cancelled)
+        return;
+      _items.push_back(std::move(item));
+    }
+    _pushed.notify_one();
+  }
+
+  bool pop(T& item)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _pushed.wait(lock, [&]{ return _cancelled || !_items.empty() || _nbProducers == 0; });
+    if(_cancelled || _items.empty())
+      return false;
+    item = std::move(_items.front());
+    _items.pop_front();
+    return true;
+  }
+
+  /// called by each producer when it has no more items
+  void producerDone()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_nbProducers;
+    }
+    _pushed.notify_all();
+  }
+
+  /// drop the pending items and close the queue
+  void cancel()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _items.clear();
+      _cancelled = true;
+    }
+    _pushed.notify_all();
+  }
+
+private:
+  int _nbProducers;
+  bool _cancelled = false;
+  std::deque<T> _items;
+  std::mutex _mutex;
+  std::condition_variable _pushed;
+};
+
+/**
+ * @brief An image going through the decode, compute and encode stages.
+ */
+struct ViewJob
+{
+  IndexT viewId;
+  const View* view;
+  const IntrinsicBase* cam;
+  bool undistort;
+  float exposureCompensation;
+  std::string dstColorImage;
+  oiio::ParamValueList metadata;
+  Image<RGBfColor> image;
+  Image<RGBfColor> image_ud;
+  /// bytes acquired in the memory budget
+  std::size_t memSize;
+};
+
+/**
+ * @brief Get the camera projection data in text files and/or in the image metadata.
+ * @return false if the camera is not a pinhole camera
+ */
+bool exportCamera(const SfMData& sfmData, const View& view, const std::string& outFolder, const std::string& baseFilename,
+                  bool saveMetadata, bool saveMatricesFiles, oiio::ParamValueList& metadata)
+{
+  // get camera pose / projection
+  const Pose3 pose = sfmData.getPose(view).getTransform();
+
+  std::shared_ptr<camera::IntrinsicBase> cam = sfmData.getIntrinsics().at(view.getIntrinsicId());
+  std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
+  if (!camPinHole) {
+    ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
+    return false;
+  }
+
+  Mat34 P = camPinHole->getProjectiveEquivalent(pose);
+
+  // get camera intrinsics matrices
+  const Mat3 K = camPinHole->K();
+  const Mat3& R = pose.rotation();
+  const Vec3& t = pose.translation();
+
+  if(saveMatricesFiles)
+  {
+    std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
+    fileP << std::setprecision(10)
+         << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
+         << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
+         << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
+    fileP.close();
+
+    std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
+    fileKRt << std::setprecision(10)
+         << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
+         << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
+         << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
+         << "\n"
+         << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
+         << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
+         << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
+         << "\n"
+         << t(0) << " " << t(1) << " " << t(2) << "\n";
+    fileKRt.close();
+  }
+
+  if(saveMetadata)
+  {
+    // convert to 44 matix
+    Mat4 projectionMatrix;
+    projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
+                        P(1, 0), P(1, 1), P(1, 2), P(1, 3),
+                        P(2, 0), P(2, 1), P(2, 2), P(2, 3),
+                              0,       0,       0,       1;
+
+    // convert matrices to rowMajor
+    std::vector<double> vP(projectionMatrix.size());
+    std::vector<double> vK(K.size());
+    std::vector<double> vR(R.size());
+
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+    Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
+    Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
+    Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
+
+    // add metadata
+    metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+    metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
+    metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
+  }
+  return true;
+}
+
+} // namespace
+
+/**
+ * @brief Pipeline parameters: number of threads of each stage and memory budget of the images in flight.
+ */
+struct PipelineParams
+{
+  /// threads reading the source images
+  int nbDecodeThreads = 0;
+  /// threads applying the exposure compensation and the undistortion (each one uses its share of the cores)
+  int nbComputeThreads = 0;
+  /// threads writing the output images
+  int nbEncodeThreads = 0;
+  /// maximum memory used by the images in flight and the undistortion maps in MB (0: half of the free RAM)
+  int maxMemory = 0;
+};
+
 bool prepareDenseScene(const SfMData& sfmData,
                        const std::vector<std::string>& imagesFolders,
                        int beginIndex,
@@ -48,7 +281,8 @@ bool prepareDenseScene(const SfMData& sfmData,
                        image::EImageFileType outputFileType,
                        bool saveMetadata,
                        bool saveMatricesFiles,
-                       bool evCorrection)
+                       bool evCorrection,
+                       const PipelineParams& pipelineParams)
 {
   // defined view Ids
   std::set<IndexT> viewIds;
@@ -84,153 +318,210 @@ bool prepareDenseScene(const SfMData& sfmData,
   const float medianCameraExposure = sfmData.getMedianCameraExposureSetting();
   ALICEVISION_LOG_INFO("Median Camera Exposure: " << medianCameraExposure << ", Median EV: " << std::log2(1.0f/medianCameraExposure));
 
-#pragma omp parallel for num_threads(3)
-  for(int i = 0; i < viewIds.size(); ++i)
+  // pipeline sizes: by default, the decode and encode threads take a quarter of the cores each
+  // and the compute threads share the remaining cores
+  const int nbCores = std::max(1, omp_get_max_threads());
+  const int nbDecodeThreads = (pipelineParams.nbDecodeThreads > 0) ? pipelineParams.nbDecodeThreads : std::max(1, nbCores / 4);
+  const int nbComputeThreads = (pipelineParams.nbComputeThreads > 0) ? pipelineParams.nbComputeThreads : 1;
+  const int nbEncodeThreads = (pipelineParams.nbEncodeThreads > 0) ? pipelineParams.nbEncodeThreads : std::max(1, nbCores / 4);
+  const int nbCoresPerComputeThread = std::max(1, (nbCores - nbDecodeThreads - nbEncodeThreads) / nbComputeThreads);
+  const std::size_t maxMemory = (pipelineParams.maxMemory > 0) ? std::size_t(pipelineParams.maxMemory) * 1024 * 1024
+                                                                : system::getMemoryInfo().freeRam / 2;
+  // a quarter of the memory for the undistortion maps, the rest for the images in flight
+  const std::size_t maxMapsMemory = maxMemory / 4;
+  const std::size_t maxImagesMemory = maxMemory - maxMapsMemory;
+
+  ALICEVISION_LOG_INFO("Pipeline: " << nbDecodeThreads << " decode, " << nbComputeThreads << " compute (" << nbCoresPerComputeThread << " cores each), "
+                       << nbEncodeThreads << " encode threads, " << maxImagesMemory / (1024 * 1024) << " MB for the images in flight, "
+                       << maxMapsMemory / (1024 * 1024) << " MB for the undistortion maps.");
+
+  // undistortion maps shared by the views of the same intrinsic
+  UndistortionMapCache undistortionMaps(1, maxMapsMemory);
+
+  const std::vector<IndexT> viewIdsVec(viewIds.begin(), viewIds.end());
+  std::atomic<std::size_t> nextView(0);
+
+  MemoryBudget memoryBudget(maxImagesMemory);
+  StageQueue<std::unique_ptr<ViewJob>> computeQueue(nbDecodeThreads);
+  StageQueue<std::unique_ptr<ViewJob>> encodeQueue(nbComputeThreads);
+  std::mutex progressMutex;
+  const auto advanceProgress = [&]()
   {
-    auto itView = viewIds.begin();
-    std::advance(itView, i);
-
-    const IndexT viewId = *itView;
-    const View* view = sfmData.getViews().at(viewId).get();
-
-    Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
-
-    //we have a valid view with a corresponding camera & pose
-    const std::string baseFilename = std::to_string(viewId);
-
-    // get metadata from source image to be sure we get all metadata. We don't use the metadatas from the Views inside the SfMData to avoid type conversion problems with string maps.
-    std::string srcImage = view->getImagePath();
-    oiio::ParamValueList metadata = image::readImageMetadata(srcImage);
+    std::lock_guard<std::mutex> lock(progressMutex);
+    ++progressBar;
+  };
 
-    // export camera
-    if(saveMetadata || saveMatricesFiles)
+  // the first error stops all the stages and is rethrown once they are joined
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  const auto cancel = [&](std::exception_ptr e)
+  {
     {
-      // get camera pose / projection
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-
-      std::shared_ptr<camera::IntrinsicBase> cam = iterIntrinsic->second;
-      std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-      if (!camPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
-        continue;
-      }
-
-      Mat34 P = camPinHole->getProjectiveEquivalent(pose);
-
-      // get camera intrinsics matrices
-      const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
-      const Mat3& R = pose.rotation();
-      const Vec3& t = pose.translation();
-
-      if(saveMatricesFiles)
-      {
-        std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
-        fileP << std::setprecision(10)
-             << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
-             << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
-             << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
-        fileP.close();
-
-        std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
-        fileKRt << std::setprecision(10)
-             << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
-             << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
-             << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
-             << "\n"
-             << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
-             << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
-             << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
-             << "\n"
-             << t(0) << " " << t(1) << " " << t(2) << "\n";
-        fileKRt.close();
-      }
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if(!error)
+        error = e;
+    }
+    memoryBudget.cancel();
+    computeQueue.cancel();
+    encodeQueue.cancel();
+  };
 
-      if(saveMetadata)
+  // read the source image and prepare its metadata
+  const auto decode = [&]()
+  {
+    try
+    {
+      for(std::size_t i = nextView++; i < viewIdsVec.size(); i = nextView++)
       {
-        // convert to 44 matix
-        Mat4 projectionMatrix;
-        projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
-                            P(1, 0), P(1, 1), P(1, 2), P(1, 3),
-                            P(2, 0), P(2, 1), P(2, 2), P(2, 3),
-                                  0,       0,       0,       1;
-
-        // convert matrices to rowMajor
-        std::vector<double> vP(projectionMatrix.size());
-        std::vector<double> vK(K.size());
-        std::vector<double> vR(R.size());
-
-        typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
-        Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
-        Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
-        Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
-
-        // add metadata
-        metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
-        metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
+        const IndexT viewId = viewIdsVec[i];
+        const View* view = sfmData.getViews().at(viewId).get();
+        const IntrinsicBase* cam = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
+
+        std::unique_ptr<ViewJob> job(new ViewJob());
+        job->viewId = viewId;
+        job->view = view;
+        job->cam = cam;
+        job->undistort = cam->isValid() && cam->hasDistortion();
+
+        //we have a valid view with a corresponding camera & pose
+        const std::string baseFilename = std::to_string(viewId);
+
+        // get metadata from source image to be sure we get all metadata. We don't use the metadatas from the Views inside the SfMData to avoid type conversion problems with string maps.
+        std::string srcImage = view->getImagePath();
+        int width = 0;
+        int height = 0;
+        job->metadata = image::readImageMetadata(srcImage, width, height);
+
+        // export camera
+        if((saveMetadata || saveMatricesFiles) &&
+           !exportCamera(sfmData, *view, outFolder, baseFilename, saveMetadata, saveMatricesFiles, job->metadata))
+        {
+          advanceProgress();
+          continue;
+        }
+
+        if(!imagesFolders.empty())
+        {
+            std::vector<std::string> paths = sfmDataIO::viewPathsFromFolders(*view, imagesFolders);
+
+            // if path was not found
+            if(paths.empty())
+            {
+                throw std::runtime_error("Cannot find view '" + std::to_string(view->getViewId()) + "' image file in given folder(s)");
+            }
+            else if(paths.size() > 1)
+            {
+                throw std::runtime_error( "Ambiguous case: Multiple source image files found in given folder(s) for the view '" +
+                    std::to_string(view->getViewId()) + "'.");
+            }
+
+            srcImage = paths[0];
+
+            // the image size is read from the file that is decoded
+            image::readImageMetadata(srcImage, width, height);
+        }
+        job->dstColorImage = (fs::path(outFolder) / (baseFilename + "." + image::EImageFileType_enumToString(outputFileType))).string();
+
+        // the source image and the undistorted image stay in memory until the encoding is done
+        job->memSize = std::size_t(width) * height * sizeof(RGBfColor) * (job->undistort ? 2 : 1);
+        if(!memoryBudget.acquire(job->memSize))
+          break;
+
+        readImage(srcImage, job->image, image::EImageColorSpace::LINEAR);
+
+        // add exposure values to images metadata
+        const float cameraExposure = view->getCameraExposureSetting();
+        const float ev = std::log2(1.0 / cameraExposure);
+        job->exposureCompensation = medianCameraExposure / cameraExposure;
+        job->metadata.push_back(oiio::ParamValue("AliceVision:EV", ev));
+        job->metadata.push_back(oiio::ParamValue("AliceVision:EVComp", job->exposureCompensation));
+
+        if(evCorrection)
+          ALICEVISION_LOG_INFO("View: " << viewId << ", Ev: " << ev << ", Ev compensation: " << job->exposureCompensation);
+
+        computeQueue.push(std::move(job));
       }
     }
+    catch(...)
+    {
+      cancel(std::current_exception());
+    }
+    computeQueue.producerDone();
+  };
 
-    // export undistort image
-    {      
-      if(!imagesFolders.empty())
+  // exposure correction and undistortion, parallelized over the cores of the thread
+  const auto compute = [&]()
+  {
+    omp_set_num_threads(nbCoresPerComputeThread);
+    try
+    {
+      std::unique_ptr<ViewJob> job;
+      while(computeQueue.pop(job))
       {
-          std::vector<std::string> paths = sfmDataIO::viewPathsFromFolders(*view, imagesFolders);
-
-          // if path was not found
-          if(paths.empty())
-          {
-              throw std::runtime_error("Cannot find view '" + std::to_string(view->getViewId()) + "' image file in given folder(s)");
-          }
-          else if(paths.size() > 1)
-          {
-              throw std::runtime_error( "Ambiguous case: Multiple source image files found in given folder(s) for the view '" + 
-                  std::to_string(view->getViewId()) + "'.");
-          }
-
-          srcImage = paths[0];
-      }
-      const std::string dstColorImage = (fs::path(outFolder) / (baseFilename + "." + image::EImageFileType_enumToString(outputFileType))).string();
-      const IntrinsicBase* cam = iterIntrinsic->second.get();
-      Image<RGBfColor> image, image_ud;
-
-      readImage(srcImage, image, image::EImageColorSpace::LINEAR);
+        Image<RGBfColor>& image = job->image;
 
-      // add exposure values to images metadata
-      float cameraExposure = view->getCameraExposureSetting();
-      float ev = std::log2(1.0 / cameraExposure);
-      float exposureCompensation = medianCameraExposure / cameraExposure;
-      metadata.push_back(oiio::ParamValue("AliceVision:EV", ev));
-      metadata.push_back(oiio::ParamValue("AliceVision:EVComp", exposureCompensation));
+        //exposure correction
+        if(evCorrection)
+        {
+          const float exposureCompensation = job->exposureCompensation;
+          #pragma omp parallel for
+          for(int pix = 0; pix < image.Width() * image.Height(); ++pix)
+            image(pix) = image(pix) * exposureCompensation;
+        }
+
+        // undistort
+        if(job->undistort)
+        {
+          const auto undistortionMap = undistortionMaps.get(*job->cam, image.Width(), image.Height());
+          UndistortImage(image, *undistortionMap, job->image_ud, FBLACK);
+          image = Image<RGBfColor>();
+        }
+
+        encodeQueue.push(std::move(job));
+      }
+    }
+    catch(...)
+    {
+      cancel(std::current_exception());
+    }
+    encodeQueue.producerDone();
+  };
 
-      //exposure correction
-      if(evCorrection)
+  // write the output images, the memory of the job is released after the writing
+  const auto encode = [&]()
+  {
+    try
+    {
+      std::unique_ptr<ViewJob> job;
+      while(encodeQueue.pop(job))
       {
-          ALICEVISION_LOG_INFO("View: " << viewId << ", Ev: " << ev << ", Ev compensation: " << exposureCompensation);
+        writeImage(job->dstColorImage, job->undistort ? job->image_ud : job->image, image::EImageColorSpace::AUTO, job->metadata);
 
-          for(int pix = 0; pix < image.Width() * image.Height(); ++pix)
-              image(pix) = image(pix) * exposureCompensation;
+        const std::size_t memSize = job->memSize;
+        job.reset();
+        memoryBudget.release(memSize);
 
-      }
-      
-      // undistort
-      if(cam->isValid() && cam->hasDistortion())
-      {
-        // undistort the image and save it
-        UndistortImage(image, cam, image_ud, FBLACK);
-        writeImage(dstColorImage, image_ud, image::EImageColorSpace::AUTO, metadata);
-      }
-      else
-      {
-        writeImage(dstColorImage, image, image::EImageColorSpace::AUTO, metadata);
+        advanceProgress();
       }
     }
+    catch(...)
+    {
+      cancel(std::current_exception());
+    }
+  };
 
-    #pragma omp critical
-    ++progressBar;
-  }
+  std::vector<std::thread> threads;
+  for(int i = 0; i < nbDecodeThreads; ++i)
+    threads.emplace_back(decode);
+  for(int i = 0; i < nbComputeThreads; ++i)
+    threads.emplace_back(compute);
+  for(int i = 0; i < nbEncodeThreads; ++i)
+    threads.emplace_back(encode);
+  for(std::thread& thread : threads)
+    thread.join();
+
+  if(error)
+    std::rethrow_exception(error);
 
   return true;
 }
@@ -249,6 +540,7 @@ int aliceVision_main(int argc, char *argv[])
   bool saveMetadata = true;
   bool saveMatricesTxtFiles = false;
   bool evCorrection = false;
+  PipelineParams pipelineParams;
 
   po::options_description allParams("AliceVision prepareDenseScene");
 
@@ -275,7 +567,15 @@ int aliceVision_main(int argc, char *argv[])
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("evCorrection", po::value<bool>(&evCorrection)->default_value(evCorrection),
-      "Correct exposure value.");
+      "Correct exposure value.")
+    ("nbDecodeThreads", po::value<int>(&pipelineParams.nbDecodeThreads)->default_value(pipelineParams.nbDecodeThreads),
+      "Number of threads reading the source images (0: a quarter of the cores, at least 1).")
+    ("nbComputeThreads", po::value<int>(&pipelineParams.nbComputeThreads)->default_value(pipelineParams.nbComputeThreads),
+      "Number of threads applying the exposure correction and the undistortion, the cores not used by the decode and encode threads are shared between them (0: 1).")
+    ("nbEncodeThreads", po::value<int>(&pipelineParams.nbEncodeThreads)->default_value(pipelineParams.nbEncodeThreads),
+      "Number of threads writing the output images (0: a quarter of the cores, at least 1).")
+    ("maxMemory", po::value<int>(&pipelineParams.maxMemory)->default_value(pipelineParams.maxMemory),
+      "Maximum memory used by the images in flight and the undistortion maps, in MB (0: half of the free RAM).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -353,7 +653,7 @@ int aliceVision_main(int argc, char *argv[])
   }
 
   // export
-  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection))
+  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection, pipelineParams))
     return EXIT_SUCCESS;
 
   return EXIT_FAILURE;
@@ -6,6 +6,7 @@
 
 #include <aliceVision/config.hpp>
 #include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/localization/OrderedFrameQueue.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
@@ -35,7 +36,11 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
 #include <aliceVision/sfmDataIO/AlembicExporter.hpp>
@@ -44,7 +49,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -59,6 +64,15 @@ std::string myToString(std::size_t i, std::size_t zeroPadding)
   return ss.str();
 }
 
+/**
+ * @brief A frame of the rig whose features are extracted for each camera, waiting for localization.
+ */
+struct RigFrame
+{
+  std::vector<camera::PinholeRadialK3> vec_queryIntrinsics;
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
+  std::vector<feature::MapRegionsPerDesc> vec_queryRegions;
+};
 
 int aliceVision_main(int argc, char** argv)
 {
@@ -95,6 +109,10 @@ int aliceVision_main(int argc, char** argv)
   double matchingErrorMax = 4.0;
   /// the maximum angular error allowed for rig resectioning (in degrees)
   double angularThreshold = 0.1;
+  /// the maximum number of rig frames read and not yet localized
+  std::size_t nbFramesInFlight = 1;
+  /// the number of threads reading the rig frames and extracting their features
+  std::size_t nbExtractionThreads = 0;
 
 
   // parameters for voctree localizer
@@ -104,6 +122,8 @@ int aliceVision_main(int argc, char** argv)
   std::string vocTreeFilepath;
   /// the vocabulary tree weights file
   std::string weightsFilepath;
+  /// the precompiled reconstruction database file
+  std::string reconstructionDatabaseFilepath;
   /// the localization algorithm to use for the voctree localizer
   std::string algostring = "AllResults";
   /// number of documents to search when querying the voctree
@@ -160,7 +180,15 @@ int aliceVision_main(int argc, char** argv)
           "library has not been built with openGV.")
       ("angularThreshold", po::value<double>(&angularThreshold)->default_value(angularThreshold), 
           "The maximum angular threshold in degrees between feature bearing vector and 3D "
-          "point direction. Used only with the opengv method.");
+          "point direction. Used only with the opengv method.")
+      ("nbFramesInFlight", po::value<std::size_t>(&nbFramesInFlight)->default_value(nbFramesInFlight),
+          "Maximum number of rig frames read and not yet localized. If greater than 1, "
+          "the rig frames are read and their features extracted concurrently while the "
+          "previous rig frames are localized in order.")
+      ("nbExtractionThreads", po::value<std::size_t>(&nbExtractionThreads)->default_value(nbExtractionThreads),
+          "Number of threads reading the rig frames and extracting their features when "
+          "nbFramesInFlight is greater than 1 (0 = nbFramesInFlight, up to the number of cores). "
+          "Use 1 with GPU feature extractors.");
   
   // parameters for voctree localizer
     po::options_description voctreeParams("Parameters specific for the vocabulary tree-based localizer");
@@ -169,6 +197,10 @@ int aliceVision_main(int argc, char** argv)
           "[voctree] Filename for the vocabulary tree")
       ("voctreeWeights", po::value<std::string>(&weightsFilepath),
           "[voctree] Filename for the vocabulary tree weights")
+      ("reconstructionDatabase", po::value<std::string>(&reconstructionDatabaseFilepath),
+          "[voctree] Filename for the precompiled reconstruction database. It is loaded "
+          "if it exists and matches the inputs, otherwise it is built and saved, so that "
+          "the next localizations skip the loading of the features of the reconstruction.")
       ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
           "[voctree] Algorithm type: {FirstBest,AllResults}" )
       ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
@@ -275,7 +307,8 @@ int aliceVision_main(int argc, char** argv)
                                                             descriptorsFolder,
                                                             vocTreeFilepath,
                                                             weightsFilepath,
-                                                            matchDescTypes
+                                                            matchDescTypes,
+                                                            reconstructionDatabaseFilepath
                                                             );
     localizer.reset(tmpLoc);
     
@@ -361,7 +394,6 @@ int aliceVision_main(int argc, char** argv)
   }
 
   
-  bool haveImage = true;
   std::size_t frameCounter = 0;
   std::size_t numLocalizedFrames = 0;
   
@@ -378,23 +410,20 @@ int aliceVision_main(int argc, char** argv)
 
   // store the result
   std::vector< std::vector<localization::LocalizationResult> > rigResultPerFrame;
-  
-  while(haveImage)
+
+  // read the image and the associated internal parameters of each camera for the next frame,
+  // it returns false when no more images are available
+  const auto readRigFrame = [&](std::vector<image::Image<float> >& vec_imageGrey,
+                                std::vector<camera::PinholeRadialK3 >& vec_queryIntrinsics)
   {
-    // @fixme It's better to have arrays of pointers...
-    std::vector<image::Image<float> > vec_imageGrey;
-    std::vector<camera::PinholeRadialK3 > vec_queryIntrinsics;
-    vec_imageGrey.reserve(numCameras);
-    vec_queryIntrinsics.reserve(numCameras);
-           
-    // for each camera get the image and the associated internal parameters
+    vec_imageGrey.resize(numCameras);
+    vec_queryIntrinsics.resize(numCameras);
+
     for(std::size_t idCamera = 0; idCamera < numCameras; ++idCamera)
     {
-      image::Image<float> imageGrey;
-      camera::PinholeRadialK3 queryIntrinsics;
       bool hasIntrinsics = false;
       std::string currentImgName;
-      haveImage = feeders[idCamera]->readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics);
+      const bool haveImage = feeders[idCamera]->readImage(vec_imageGrey[idCamera], vec_queryIntrinsics[idCamera], currentImgName, hasIntrinsics);
       feeders[idCamera]->goToNextFrame();
 
       if(!haveImage)
@@ -403,46 +432,27 @@ int aliceVision_main(int argc, char** argv)
         {
           // this is quite odd, it means that eg the fist camera has an image but
           // one of the others has not image
-          ALICEVISION_CERR("This is weird... Camera " << idCamera << " seems not to have any available images while some other cameras do...");
-          return EXIT_FAILURE;  // a bit harsh but if we are here it's cheesy to say the less
+          throw std::runtime_error("Camera " + std::to_string(idCamera) + " seems not to have any available "
+                                   "images while some other cameras do.");
         }
-        break;
+        return false;
       }
       
       // for now let's suppose that the cameras are calibrated internally too
       if(!hasIntrinsics)
       {
-        ALICEVISION_CERR("For now only internally calibrated cameras are supported!"
-                << "\nCamera " << idCamera << " does not have calibration for image " << currentImgName);
-        return EXIT_FAILURE;  // a bit harsh but if we are here it's cheesy to say the less
+        throw std::runtime_error("For now only internally calibrated cameras are supported! Camera " +
+                                 std::to_string(idCamera) + " does not have calibration for image " + currentImgName);
       }
-      
-      vec_imageGrey.push_back(imageGrey);
-      vec_queryIntrinsics.push_back(queryIntrinsics);
-    }
-    
-    if(!haveImage)
-    {
-      // no more images are available
-      break;
     }
-    
-    ALICEVISION_COUT("******************************");
-    ALICEVISION_COUT("FRAME " << myToString(frameCounter, 4));
-    ALICEVISION_COUT("******************************");
-    auto detect_start = std::chrono::steady_clock::now();
-    std::vector<localization::LocalizationResult> localizationResults;
-    const bool isLocalized = localizer->localizeRig(vec_imageGrey,
-                                                    param.get(),
-                                                    vec_queryIntrinsics,
-                                                    vec_subPoses,
-                                                    rigPose,
-                                                    localizationResults);
-    auto detect_end = std::chrono::steady_clock::now();
-    auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    ALICEVISION_COUT("Localization took  " << detect_elapsed.count() << " [ms]");
-    stats(detect_elapsed.count());
-    
+    return true;
+  };
+
+  // save the result of the current frame
+  const auto addRigResult = [&](bool isLocalized,
+                                const std::vector<localization::LocalizationResult>& localizationResults,
+                                const std::vector<camera::PinholeRadialK3 >& vec_queryIntrinsics)
+  {
     rigResultPerFrame.push_back(localizationResults);
     
     if(isLocalized)
@@ -478,6 +488,141 @@ int aliceVision_main(int argc, char** argv)
     }
 
     ++frameCounter;
+  };
+
+  if(nbFramesInFlight <= 1)
+  {
+    // @fixme It's better to have arrays of pointers...
+    std::vector<image::Image<float> > vec_imageGrey;
+    std::vector<camera::PinholeRadialK3 > vec_queryIntrinsics;
+
+    while(readRigFrame(vec_imageGrey, vec_queryIntrinsics))
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter, 4));
+      ALICEVISION_COUT("******************************");
+      auto detect_start = std::chrono::steady_clock::now();
+      std::vector<localization::LocalizationResult> localizationResults;
+      // the features of the cameras are extracted concurrently
+      const bool isLocalized = localizer->localizeRig(vec_imageGrey,
+                                                      param.get(),
+                                                      vec_queryIntrinsics,
+                                                      vec_subPoses,
+                                                      rigPose,
+                                                      localizationResults);
+      auto detect_end = std::chrono::steady_clock::now();
+      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+      ALICEVISION_COUT("Localization took  " << detect_elapsed.count() << " [ms]");
+      stats(detect_elapsed.count());
+
+      addRigResult(isLocalized, localizationResults, vec_queryIntrinsics);
+    }
+  }
+  else
+  {
+    // the rig frames are read and their features are extracted concurrently,
+    // the rig resection is done in the frame order as the matching
+    // depends on the previous frames (frame buffer matching)
+    if(nbExtractionThreads == 0)
+      nbExtractionThreads = std::min<std::size_t>(nbFramesInFlight, std::max(1u, std::thread::hardware_concurrency()));
+
+    ALICEVISION_COUT("Pipelined localization: " << nbExtractionThreads << " extraction threads, "
+                     << nbFramesInFlight << " rig frames in flight");
+
+    localization::OrderedFrameQueue<std::unique_ptr<RigFrame>> frameQueue(nbFramesInFlight, nbExtractionThreads);
+    std::mutex feedMutex;
+    std::size_t nbReadFrames = 0;
+
+    // the first error stops the pipeline and is rethrown once the threads are joined
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    const auto cancel = [&](std::exception_ptr e)
+    {
+      {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if(!error)
+          error = e;
+      }
+      frameQueue.cancel();
+    };
+
+    const auto extract = [&]()
+    {
+      try
+      {
+        const auto imageDescribers = localizer->createImageDescribers();
+        std::vector<image::Image<float> > vec_imageGrey;
+
+        while(frameQueue.acquireSlot())
+        {
+          std::unique_ptr<RigFrame> frame(new RigFrame());
+          std::size_t frameIndex;
+          {
+            std::lock_guard<std::mutex> lock(feedMutex);
+            if(!readRigFrame(vec_imageGrey, frame->vec_queryIntrinsics))
+            {
+              frameQueue.releaseSlot();
+              break;
+            }
+            frameIndex = nbReadFrames++;
+          }
+          frame->vec_imageSize.resize(numCameras);
+          frame->vec_queryRegions.resize(numCameras);
+          for(std::size_t idCamera = 0; idCamera < numCameras; ++idCamera)
+          {
+            frame->vec_imageSize[idCamera] = std::make_pair(vec_imageGrey[idCamera].Width(), vec_imageGrey[idCamera].Height());
+            localizer->extractFeatures(vec_imageGrey[idCamera], param.get(), imageDescribers, frame->vec_queryRegions[idCamera]);
+          }
+          frameQueue.push(frameIndex, std::move(frame));
+        }
+      }
+      catch(...)
+      {
+        cancel(std::current_exception());
+      }
+      frameQueue.producerDone();
+    };
+
+    std::vector<std::thread> extractionThreads;
+    for(std::size_t i = 0; i < nbExtractionThreads; ++i)
+      extractionThreads.emplace_back(extract);
+
+    try
+    {
+      std::unique_ptr<RigFrame> frame;
+      while(frameQueue.pop(frame))
+      {
+        ALICEVISION_COUT("******************************");
+        ALICEVISION_COUT("FRAME " << myToString(frameCounter, 4));
+        ALICEVISION_COUT("******************************");
+        auto detect_start = std::chrono::steady_clock::now();
+        std::vector<localization::LocalizationResult> localizationResults;
+        // the cameras are matched concurrently
+        const bool isLocalized = localizer->localizeRig(frame->vec_queryRegions,
+                                                        frame->vec_imageSize,
+                                                        param.get(),
+                                                        frame->vec_queryIntrinsics,
+                                                        vec_subPoses,
+                                                        rigPose,
+                                                        localizationResults);
+        auto detect_end = std::chrono::steady_clock::now();
+        auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+        ALICEVISION_COUT("Localization (without feature extraction) took  " << detect_elapsed.count() << " [ms]");
+        stats(detect_elapsed.count());
+
+        addRigResult(isLocalized, localizationResults, frame->vec_queryIntrinsics);
+      }
+    }
+    catch(...)
+    {
+      cancel(std::current_exception());
+    }
+
+    for(std::thread& thread : extractionThreads)
+      thread.join();
+
+    if(error)
+      std::rethrow_exception(error);
   }
   
   // print out some time stats
@@ -653,7 +653,7 @@ int aliceVision_main(int argc, char * argv[])
 
     // Check if sfmInputDataFilename exist and is recognized as sfm data file
     const std::string inputExt = boost::to_lower_copy(fs::path(inputExpression).extension().string());
-    static const std::array<std::string, 2> sfmSupportedExtensions = {".sfm", ".abc"};
+    static const std::array<std::string, 3> sfmSupportedExtensions = {".sfm", ".sfmb", ".abc"};
     if(!inputExpression.empty() && std::find(sfmSupportedExtensions.begin(), sfmSupportedExtensions.end(), inputExt) != sfmSupportedExtensions.end())
     {
         sfmData::SfMData sfmData;